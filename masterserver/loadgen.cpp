@@ -0,0 +1,473 @@
+//-----------------------------------------------------------------------------
+//
+// Skulltag Master Server Source
+// Copyright (C) 2004-2005 Brad Carney
+// Copyright (C) 2007-2012 Skulltag Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+// Filename: loadgen.cpp
+//
+// Description: Synthetic load generator for the master server. It registers
+// a large number of fake servers and floods the master with launcher queries
+// over the loopback interface, so that the master's throughput can be
+// measured. Every fake server and launcher gets its own address in 127.0.0.0/8,
+// so this only works under Linux.
+//
+//-----------------------------------------------------------------------------
+
+#include "../src/networkheaders.h"
+#include "../src/networkshared.h"
+#include "../src/huffman/huffman.h"
+#include <poll.h>
+#include <sys/time.h>
+
+//*****************************************************************************
+//	DEFINES
+
+// Port the fake servers and launchers send from.
+#define	LOADGEN_PORT					15301
+
+// Revision the fake servers claim to be built with (it must support split ban lists).
+#define	LOADGEN_SERVER_REVISION			3100
+
+// Seconds between two heartbeats of a fake server.
+#define	LOADGEN_HEARTBEAT_INTERVAL		30
+
+// Seconds after which an unregistered fake server tries again.
+#define	LOADGEN_REGISTER_RETRY			5
+
+//*****************************************************************************
+//	STRUCTURES
+
+typedef struct
+{
+	// Has the master sent us the ban list, i.e. are we on its list?
+	bool			bRegistered;
+
+	// Time (in ms) of the next heartbeat or registration attempt.
+	long long		llNextChallenge;
+
+} FAKESERVER_s;
+
+typedef struct
+{
+	unsigned long	ulQueries;
+	unsigned long	ulListParts;
+	unsigned long	ulCompleteLists;
+	unsigned long	ulListedServers;
+	unsigned long	ulIgnored;
+	unsigned long	ulOther;
+
+} LOADGENSTATS_s;
+
+//*****************************************************************************
+//	VARIABLES
+
+static	int						g_Socket;
+static	struct sockaddr_in		g_MasterAddress;
+static	std::vector<FAKESERVER_s>	g_FakeServers;
+static	unsigned int			g_uiNumRegistered = 0;
+static	LOADGENSTATS_s			g_Stats;
+static	NETBUFFER_s				g_Buffer;
+static	UCHAR					g_ucEncoded[MAX_UDP_PACKET * 2];
+static	UCHAR					g_ucDecoded[MAX_UDP_PACKET * 3];
+
+//*****************************************************************************
+//	FUNCTIONS
+
+static long long loadgen_GetTimeMS( void )
+{
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return ( static_cast<long long>( tv.tv_sec ) * 1000 + tv.tv_usec / 1000 );
+}
+
+//*****************************************************************************
+//
+// Fake server i lives on 127.10.0.1 and following, launcher i on 127.100.0.1 and following.
+static in_addr_t loadgen_FakeAddress( const unsigned int uiBase, const unsigned int uiIdx )
+{
+	const unsigned int uiHost = uiIdx + 1;
+	return htonl(( 127 << 24 ) | (( uiBase + ( uiHost >> 16 )) << 16 ) | ((( uiHost >> 8 ) & 255 ) << 8 ) | ( uiHost & 255 ));
+}
+
+//*****************************************************************************
+//
+static int loadgen_FakeServerIndex( const in_addr_t Address )
+{
+	const unsigned int uiAddress = ntohl( Address );
+	const unsigned int uiBase = ( uiAddress >> 16 ) & 255;
+
+	if (( uiBase < 10 ) || ( uiBase >= 100 ))
+		return -1;
+
+	const unsigned int uiIdx = ((( uiBase - 10 ) << 16 ) | ( uiAddress & 0xFFFF )) - 1;
+	return ( uiIdx < g_FakeServers.size( )) ? static_cast<int>( uiIdx ) : -1;
+}
+
+//*****************************************************************************
+//
+// Sends the contents of g_Buffer to the master, pretending to come from the given address.
+static void loadgen_Send( const in_addr_t SourceAddress )
+{
+	int iNumBytes = sizeof( g_ucEncoded );
+	HUFFMAN_Encode( g_Buffer.pbData, g_ucEncoded, NETWORK_CalcBufferSize( &g_Buffer ), &iNumBytes );
+
+	struct iovec	IOVec;
+	IOVec.iov_base = g_ucEncoded;
+	IOVec.iov_len = iNumBytes;
+
+	char			acControl[CMSG_SPACE( sizeof( struct in_pktinfo ))];
+	struct msghdr	Message;
+	memset( &Message, 0, sizeof( Message ));
+	memset( acControl, 0, sizeof( acControl ));
+	Message.msg_name = &g_MasterAddress;
+	Message.msg_namelen = sizeof( g_MasterAddress );
+	Message.msg_iov = &IOVec;
+	Message.msg_iovlen = 1;
+	Message.msg_control = acControl;
+	Message.msg_controllen = sizeof( acControl );
+
+	// The source address is chosen through IP_PKTINFO, every loopback address is ours.
+	struct cmsghdr *pControl = CMSG_FIRSTHDR( &Message );
+	pControl->cmsg_level = IPPROTO_IP;
+	pControl->cmsg_type = IP_PKTINFO;
+	pControl->cmsg_len = CMSG_LEN( sizeof( struct in_pktinfo ));
+	reinterpret_cast<struct in_pktinfo *>( CMSG_DATA( pControl ))->ipi_spec_dst.s_addr = SourceAddress;
+
+	sendmsg( g_Socket, &Message, 0 );
+}
+
+//*****************************************************************************
+//
+static void loadgen_SendServerChallenge( const unsigned int uiServer )
+{
+	char szVerification[32];
+	sprintf( szVerification, "loadgen%u", uiServer );
+
+	NETWORK_ClearBuffer( &g_Buffer );
+	NETWORK_WriteLong( &g_Buffer.ByteStream, SERVER_MASTER_CHALLENGE );
+	NETWORK_WriteString( &g_Buffer.ByteStream, szVerification );
+	NETWORK_WriteByte( &g_Buffer.ByteStream, 1 );
+	NETWORK_WriteLong( &g_Buffer.ByteStream, LOADGEN_SERVER_REVISION );
+	loadgen_Send( loadgen_FakeAddress( 10, uiServer ));
+}
+
+//*****************************************************************************
+//
+static void loadgen_SendLauncherChallenge( const unsigned int uiLauncher )
+{
+	NETWORK_ClearBuffer( &g_Buffer );
+	NETWORK_WriteLong( &g_Buffer.ByteStream, LAUNCHER_MASTER_CHALLENGE );
+	NETWORK_WriteShort( &g_Buffer.ByteStream, MASTER_SERVER_VERSION );
+	loadgen_Send( loadgen_FakeAddress( 100, uiLauncher ));
+	g_Stats.ulQueries++;
+}
+
+//*****************************************************************************
+//
+static void loadgen_ParseServerPacket( const unsigned int uiServer, BYTESTREAM_s *pByteStream )
+{
+	const int iCommand = NETWORK_ReadByte( pByteStream );
+
+	// The master wants to verify that we are really the server that sent the challenge.
+	if ( iCommand == MASTER_SERVER_VERIFICATION )
+	{
+		const std::string Verification = NETWORK_ReadString( pByteStream );
+		const int iVerificationInt = NETWORK_ReadLong( pByteStream );
+
+		NETWORK_ClearBuffer( &g_Buffer );
+		NETWORK_WriteLong( &g_Buffer.ByteStream, SERVER_MASTER_VERIFICATION );
+		NETWORK_WriteString( &g_Buffer.ByteStream, Verification.c_str( ));
+		NETWORK_WriteLong( &g_Buffer.ByteStream, iVerificationInt );
+		loadgen_Send( loadgen_FakeAddress( 10, uiServer ));
+	}
+	// We made it onto the list. Acknowledge every part of the ban list, duplicates don't hurt.
+	else if ( iCommand == MASTER_SERVER_BANLISTPART )
+	{
+		const std::string Verification = NETWORK_ReadString( pByteStream );
+
+		NETWORK_ClearBuffer( &g_Buffer );
+		NETWORK_WriteLong( &g_Buffer.ByteStream, SERVER_MASTER_BANLIST_RECEIPT );
+		NETWORK_WriteString( &g_Buffer.ByteStream, Verification.c_str( ));
+		loadgen_Send( loadgen_FakeAddress( 10, uiServer ));
+
+		if ( g_FakeServers[uiServer].bRegistered == false )
+		{
+			g_FakeServers[uiServer].bRegistered = true;
+			g_uiNumRegistered++;
+		}
+	}
+}
+
+//*****************************************************************************
+//
+static void loadgen_ParseLauncherPacket( BYTESTREAM_s *pByteStream, const int iNumBytes )
+{
+	switch ( NETWORK_ReadLong( pByteStream ))
+	{
+	case MSC_BEGINSERVERLISTPART:
+
+		g_Stats.ulListParts++;
+		if ( g_ucDecoded[iNumBytes - 1] == MSC_ENDSERVERLIST )
+			g_Stats.ulCompleteLists++;
+
+		// Count the servers, so that we know the lists are complete.
+		NETWORK_ReadByte( pByteStream );
+		if ( NETWORK_ReadByte( pByteStream ) == MSC_SERVERBLOCK )
+		{
+			int iNumPorts;
+			while (( iNumPorts = NETWORK_ReadByte( pByteStream )) > 0 )
+			{
+				NETWORK_ReadLong( pByteStream );
+				for ( int i = 0; i < iNumPorts; ++i )
+					NETWORK_ReadShort( pByteStream );
+				g_Stats.ulListedServers += iNumPorts;
+			}
+		}
+		break;
+	case MSC_REQUESTIGNORED:
+
+		g_Stats.ulIgnored++;
+		break;
+	default:
+
+		g_Stats.ulOther++;
+		break;
+	}
+}
+
+//*****************************************************************************
+//
+static void loadgen_ReceivePackets( void )
+{
+	while ( true )
+	{
+		struct sockaddr_in	From;
+		struct iovec		IOVec;
+		char				acControl[CMSG_SPACE( sizeof( struct in_pktinfo ))];
+		struct msghdr		Message;
+
+		IOVec.iov_base = g_ucEncoded;
+		IOVec.iov_len = sizeof( g_ucEncoded );
+		memset( &Message, 0, sizeof( Message ));
+		Message.msg_name = &From;
+		Message.msg_namelen = sizeof( From );
+		Message.msg_iov = &IOVec;
+		Message.msg_iovlen = 1;
+		Message.msg_control = acControl;
+		Message.msg_controllen = sizeof( acControl );
+
+		const int iNumBytes = recvmsg( g_Socket, &Message, MSG_DONTWAIT );
+		if ( iNumBytes <= 0 )
+			return;
+
+		// Find out which of our addresses the packet was sent to.
+		in_addr_t Destination = 0;
+		for ( struct cmsghdr *pControl = CMSG_FIRSTHDR( &Message ); pControl; pControl = CMSG_NXTHDR( &Message, pControl ))
+		{
+			if (( pControl->cmsg_level == IPPROTO_IP ) && ( pControl->cmsg_type == IP_PKTINFO ))
+				Destination = reinterpret_cast<struct in_pktinfo *>( CMSG_DATA( pControl ))->ipi_addr.s_addr;
+		}
+
+		int iNumDecoded = sizeof( g_ucDecoded );
+		HUFFMAN_Decode( g_ucEncoded, g_ucDecoded, iNumBytes, &iNumDecoded );
+		if ( iNumDecoded <= 0 )
+			continue;
+
+		BYTESTREAM_s ByteStream;
+		memset( &ByteStream, 0, sizeof( ByteStream ));
+		ByteStream.pbStream = g_ucDecoded;
+		ByteStream.pbStreamEnd = g_ucDecoded + iNumDecoded;
+
+		const int iServer = loadgen_FakeServerIndex( Destination );
+		if ( iServer != -1 )
+			loadgen_ParseServerPacket( iServer, &ByteStream );
+		else
+			loadgen_ParseLauncherPacket( &ByteStream, iNumDecoded );
+	}
+}
+
+//*****************************************************************************
+//
+int main( int argc, char **argv )
+{
+	const char		*pszMaster = "127.0.0.1";
+	unsigned int	uiNumServers = 10000;
+	unsigned int	uiQueriesPerSecond = 100000;
+	unsigned int	uiNumLaunchers = 100000;
+	unsigned int	uiSeconds = 60;
+
+	for ( int i = 1; i + 1 < argc; i += 2 )
+	{
+		if ( stricmp( argv[i], "-master" ) == 0 )
+			pszMaster = argv[i + 1];
+		else if ( stricmp( argv[i], "-servers" ) == 0 )
+			uiNumServers = atoi( argv[i + 1] );
+		else if ( stricmp( argv[i], "-queries" ) == 0 )
+			uiQueriesPerSecond = atoi( argv[i + 1] );
+		else if ( stricmp( argv[i], "-launchers" ) == 0 )
+			uiNumLaunchers = atoi( argv[i + 1] );
+		else if ( stricmp( argv[i], "-seconds" ) == 0 )
+			uiSeconds = atoi( argv[i + 1] );
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [-master <ip>] [-servers <n>] [-queries <per second>] [-launchers <n>] [-seconds <n>]\n";
+			return ( 1 );
+		}
+	}
+
+	if (( uiNumServers > 90 * 65536 - 1 ) || ( uiNumLaunchers == 0 ) || ( uiNumLaunchers > 100 * 65536 - 1 ))
+	{
+		std::cerr << "Too many servers or launchers.\n";
+		return ( 1 );
+	}
+
+	HUFFMAN_Construct( );
+	NETWORK_InitBuffer( &g_Buffer, MAX_UDP_PACKET, BUFFERTYPE_WRITE );
+
+	memset( &g_MasterAddress, 0, sizeof( g_MasterAddress ));
+	g_MasterAddress.sin_family = AF_INET;
+	g_MasterAddress.sin_addr.s_addr = inet_addr( pszMaster );
+	g_MasterAddress.sin_port = htons( DEFAULT_MASTER_PORT );
+
+	g_Socket = socket( PF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	const int iEnable = 1;
+	const int iBufferSize = 16 * 1024 * 1024;
+	setsockopt( g_Socket, IPPROTO_IP, IP_PKTINFO, &iEnable, sizeof( iEnable ));
+	setsockopt( g_Socket, SOL_SOCKET, SO_RCVBUF, &iBufferSize, sizeof( iBufferSize ));
+	setsockopt( g_Socket, SOL_SOCKET, SO_SNDBUF, &iBufferSize, sizeof( iBufferSize ));
+
+	struct sockaddr_in	LocalAddress;
+	memset( &LocalAddress, 0, sizeof( LocalAddress ));
+	LocalAddress.sin_family = AF_INET;
+	LocalAddress.sin_addr.s_addr = INADDR_ANY;
+	LocalAddress.sin_port = htons( LOADGEN_PORT );
+	if ( bind( g_Socket, reinterpret_cast<struct sockaddr *>( &LocalAddress ), sizeof( LocalAddress )) == -1 )
+	{
+		std::cerr << "Couldn't bind to port " << LOADGEN_PORT << ": " << strerror( errno ) << "\n";
+		return ( 1 );
+	}
+
+	// Spread the registrations and with them the heartbeats over the first seconds.
+	const long long	llStartTime = loadgen_GetTimeMS( );
+	g_FakeServers.resize( uiNumServers );
+	for ( unsigned int i = 0; i < uiNumServers; ++i )
+	{
+		g_FakeServers[i].bRegistered = false;
+		g_FakeServers[i].llNextChallenge = llStartTime + ( 2000LL * i ) / uiNumServers;
+	}
+
+	std::cerr << "Registering " << uiNumServers << " servers, then sending " << uiQueriesPerSecond << " queries per second from "
+		<< uiNumLaunchers << " launchers for " << uiSeconds << " seconds.\n";
+
+	unsigned int	uiNextServer = 0;
+	unsigned int	uiNextLauncher = 0;
+	unsigned long	ulQueriesDue = 0;
+	long long		llQueryStartTime = 0;
+	long long		llNextReport = llStartTime + 1000;
+	long long		llEndTime = 0;
+	LOADGENSTATS_s	LastStats;
+	memset( &LastStats, 0, sizeof( LastStats ));
+
+	while (( llEndTime == 0 ) || ( loadgen_GetTimeMS( ) < llEndTime ))
+	{
+		const long long llNow = loadgen_GetTimeMS( );
+
+		// Heartbeats and registration attempts. They are sorted by time because they are spread evenly.
+		for ( unsigned int i = 0; ( i < uiNumServers ) && ( g_FakeServers[uiNextServer].llNextChallenge <= llNow ); ++i )
+		{
+			FAKESERVER_s &Server = g_FakeServers[uiNextServer];
+			loadgen_SendServerChallenge( uiNextServer );
+			Server.llNextChallenge += 1000LL * ( Server.bRegistered ? LOADGEN_HEARTBEAT_INTERVAL : LOADGEN_REGISTER_RETRY );
+			uiNextServer = ( uiNextServer + 1 ) % uiNumServers;
+		}
+
+		// Start querying once all servers are on the list (or we waited long enough).
+		if (( llQueryStartTime == 0 ) && (( g_uiNumRegistered == uiNumServers ) || ( llNow - llStartTime > 20000 )))
+		{
+			llQueryStartTime = llNow;
+			llEndTime = llNow + 1000LL * uiSeconds;
+			std::cerr << g_uiNumRegistered << " servers registered after " << ( llNow - llStartTime ) << " ms, starting queries.\n";
+		}
+
+		if ( llQueryStartTime != 0 )
+		{
+			const unsigned long ulTarget = static_cast<unsigned long>(( llNow - llQueryStartTime ) * uiQueriesPerSecond / 1000 );
+			for ( ; ulQueriesDue < ulTarget; ++ulQueriesDue )
+			{
+				loadgen_SendLauncherChallenge( uiNextLauncher );
+				uiNextLauncher = ( uiNextLauncher + 1 ) % uiNumLaunchers;
+
+				// Don't starve the receiving side.
+				if (( ulQueriesDue & 255 ) == 255 )
+					loadgen_ReceivePackets( );
+			}
+		}
+
+		loadgen_ReceivePackets( );
+
+		if ( llNow >= llNextReport )
+		{
+			const unsigned long ulCompleteLists = g_Stats.ulCompleteLists - LastStats.ulCompleteLists;
+			printf( "%3llds: %u servers registered, %lu queries, %lu list parts, %lu complete lists (%lu servers each), %lu ignored, %lu other\n",
+				( llNow - llStartTime ) / 1000, g_uiNumRegistered,
+				g_Stats.ulQueries - LastStats.ulQueries, g_Stats.ulListParts - LastStats.ulListParts, ulCompleteLists,
+				( ulCompleteLists > 0 ) ? ( g_Stats.ulListedServers - LastStats.ulListedServers ) / ulCompleteLists : 0,
+				g_Stats.ulIgnored - LastStats.ulIgnored, g_Stats.ulOther - LastStats.ulOther );
+			fflush( stdout );
+			LastStats = g_Stats;
+			llNextReport += 1000;
+		}
+
+		struct pollfd PollFD;
+		PollFD.fd = g_Socket;
+		PollFD.events = POLLIN;
+		poll( &PollFD, 1, 1 );
+	}
+
+	const double dSeconds = uiSeconds > 0 ? uiSeconds : 1;
+	printf( "Total: %lu queries (%.0f/s), %lu complete lists (%.0f/s), %lu list parts, %lu ignored, %lu other\n",
+		g_Stats.ulQueries, g_Stats.ulQueries / dSeconds, g_Stats.ulCompleteLists, g_Stats.ulCompleteLists / dSeconds,
+		g_Stats.ulListParts, g_Stats.ulIgnored, g_Stats.ulOther );
+
+	NETWORK_FreeBuffer( &g_Buffer );
+	close( g_Socket );
+	return ( 0 );
+}
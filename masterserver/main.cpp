@@ -53,8 +53,9 @@
 #include "svnrevision.h"
 #include "network.h"
 #include "main.h"
+#include "serverlist.h"
 #include <sstream>
-#include <set>
+#include <algorithm>
 
 // [BB] Needed for I_GetTime.
 #ifdef _MSC_VER
@@ -67,24 +68,19 @@
 //*****************************************************************************
 //	VARIABLES
 
-// [BB] Comparision function, necessary to put SERVER_s entries into a std::set.
-class SERVERCompFunc
-{
-public:
-	bool operator()(SERVER_s s1, SERVER_s s2) const
-	{
-		// [BB] NETWORK_AddressToString uses a static char array to generate the string, so we
-		// need to cache the string conversion of the first string when comparing to two.
-		// Note: Because we need a "<" comparison and not a "!=" comparison we can't use
-		// NETWORK_CompareAddress.
-		std::string address1 = NETWORK_AddressToString ( s1.Address );
-		return ( stricmp ( address1.c_str(), NETWORK_AddressToString ( s2.Address ) ) < 0 );
-	}
-};
-
 // Global server list.
-static	std::set<SERVER_s, SERVERCompFunc> g_Servers;
-static	std::set<SERVER_s, SERVERCompFunc> g_UnverifiedServers;
+static	ServerList				g_Servers;
+static	ServerList				g_UnverifiedServers;
+
+// The server list as we send it to launchers, already Huffman encoded. It's rebuilt
+// when the list changed, i.e. when g_Servers.getGeneration( ) differs.
+static	std::vector<std::vector<UCHAR> >	g_ServerListPackets;
+static	std::vector<UCHAR>		g_OldFormatServerListPacket;
+static	unsigned long			g_ulServerListPacketsGeneration;
+static	bool					g_bServerListPacketsValid = false;
+
+// Are there servers that need to be sent the ban list?
+static	bool					g_bBanlistsPending = false;
 
 // Message buffer we write our commands to.
 static	NETBUFFER_s				g_MessageBuffer;
@@ -220,7 +216,7 @@ int I_GetTime (void)
 
 //*****************************************************************************
 //
-void MASTERSERVER_SendBanlistToServer( const SERVER_s &Server )
+void MASTERSERVER_SendBanlistToServer( SERVER_s &Server )
 {
 	// [BB] If the server supports it, potentially split the ban list over multiple packets.
 	if ( Server.iServerRevision >= 2907 )
@@ -361,11 +357,12 @@ void MASTERSERVER_InitializeBans( void )
 	if ( BannedIPsChanged || BannedIPExemptionsChanged )
 	{
 		// [BB] The ban list was changed, so no server has the latest list anymore.
-		for( std::set<SERVER_s, SERVERCompFunc>::iterator it = g_Servers.begin(); it != g_Servers.end(); ++it )
+		for ( unsigned int i = 0; i < g_Servers.size( ); ++i )
 		{
-			it->bHasLatestBanList = false;
-			it->bVerifiedLatestBanList = false;
+			g_Servers[i].bHasLatestBanList = false;
+			g_Servers[i].bVerifiedLatestBanList = false;
 		}
+		g_bBanlistsPending = true;
 
 		std::cerr << "Ban lists were changed since last refresh\n";
 	}
@@ -384,23 +381,108 @@ void MASTERSERVER_InitializeBans( void )
 
 //*****************************************************************************
 //
-void MASTERSERVER_AddServer( const SERVER_s &Server, std::set<SERVER_s, SERVERCompFunc> &ServerSet )
+void MASTERSERVER_AddServer( const SERVER_s &Server, ServerList &List )
 {
-	std::set<SERVER_s, SERVERCompFunc>::iterator addedServer = ServerSet.insert ( Server ).first;
+	SERVER_s *pAddedServer = List.add( Server, g_lCurrentTime );
 
-	if ( addedServer == ServerSet.end() )
-		printf( "ERROR: Adding new entry to the set failed. This should not happen!\n" );
+	if ( &List == &g_Servers )
+	{
+		printf( "+ Adding %s (revision %d) to the server list.\n", NETWORK_AddressToString( pAddedServer->Address ), pAddedServer->iServerRevision );
+		MASTERSERVER_SendBanlistToServer( *pAddedServer );
+	}
 	else
+		printf( "+ Adding %s (revision %d) to the verification list.\n", NETWORK_AddressToString( pAddedServer->Address ), pAddedServer->iServerRevision );
+}
+
+//*****************************************************************************
+//
+static bool masterserver_CompareServerAddresses( const NETADDRESS_s &Address1, const NETADDRESS_s &Address2 )
+{
+	const int iResult = memcmp( Address1.abIP, Address2.abIP, sizeof( Address1.abIP ));
+	if ( iResult != 0 )
+		return ( iResult < 0 );
+
+	return ( ntohs( Address1.usPort ) < ntohs( Address2.usPort ));
+}
+
+//*****************************************************************************
+//
+void MASTERSERVER_UpdateServerListPackets( void )
+{
+	if ( g_bServerListPacketsValid && ( g_ulServerListPacketsGeneration == g_Servers.getGeneration( )))
+		return;
+
+	// [BB] Possibly omit servers that don't enforce our ban list.
+	std::vector<NETADDRESS_s> ShownServers;
+	for ( unsigned int i = 0; i < g_Servers.size( ); ++i )
+	{
+		if ( ( g_Servers[i].bEnforcesBanList == true ) || ( g_bHideBanIgnoringServers == false ) )
+			ShownServers.push_back( g_Servers[i].Address );
+	}
+
+	// Servers on the same IP have to be next to each other, since they are sent in one block.
+	std::sort( ShownServers.begin( ), ShownServers.end( ), masterserver_CompareServerAddresses );
+
+	// The list for old launchers (LAUNCHER_SERVER_CHALLENGE).
+	NETWORK_ClearBuffer( &g_MessageBuffer );
+	NETWORK_WriteLong( &g_MessageBuffer.ByteStream, MSC_BEGINSERVERLIST );
+	for ( unsigned int i = 0; i < ShownServers.size( ); ++i )
+		MASTERSERVER_SendServerIPToLauncher ( ShownServers[i], &g_MessageBuffer.ByteStream );
+
+	// Tell the launcher that we're done sending servers.
+	NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_ENDSERVERLIST );
+	NETWORK_EncodePacket( &g_MessageBuffer, g_OldFormatServerListPacket );
+
+	// The list split into parts (LAUNCHER_MASTER_CHALLENGE).
+	const unsigned long ulMaxPacketSize = 1024;
+	unsigned long ulPacketNum = 0;
+
+	g_ServerListPackets.clear( );
+	NETWORK_ClearBuffer( &g_MessageBuffer );
+	NETWORK_WriteLong( &g_MessageBuffer.ByteStream, MSC_BEGINSERVERLISTPART );
+	NETWORK_WriteByte( &g_MessageBuffer.ByteStream, ulPacketNum );
+	NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_SERVERBLOCK );
+	unsigned long ulSizeOfPacket = 6; // 4 (MSC_BEGINSERVERLISTPART) + 1 (0) + 1 (MSC_SERVERBLOCK)
+
+	unsigned int i = 0;
+	while ( i < ShownServers.size( ) )
 	{
-		addedServer->lLastReceived = g_lCurrentTime;						
-		if ( &ServerSet == &g_Servers )
+		NETADDRESS_s serverAddress = ShownServers[i];
+		std::vector<USHORT> serverPortList;
+
+		do {
+			serverPortList.push_back ( ShownServers[i].usPort );
+			++i;
+		} while ( ( i < ShownServers.size( ) ) && NETWORK_CompareAddress( ShownServers[i], serverAddress, true ) );
+
+		const unsigned long ulServerBlockNetSize = MASTERSERVER_CalcServerIPBlockNetSize( serverAddress, serverPortList );
+
+		// [BB] If sending this block would cause the current packet to exceed ulMaxPacketSize ...
+		if ( ulSizeOfPacket + ulServerBlockNetSize > ulMaxPacketSize - 1 )
 		{
-			printf( "+ Adding %s (revision %d) to the server list.\n", NETWORK_AddressToString( addedServer->Address ), addedServer->iServerRevision );
-			MASTERSERVER_SendBanlistToServer( *addedServer );
+			// [BB] ... close the current packet and start a new one.
+			NETWORK_WriteByte( &g_MessageBuffer.ByteStream, 0 ); // [BB] Terminate MSC_SERVERBLOCK by sending 0 ports.
+			NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_ENDSERVERLISTPART );
+			g_ServerListPackets.push_back( std::vector<UCHAR>( ));
+			NETWORK_EncodePacket( &g_MessageBuffer, g_ServerListPackets.back( ));
+
+			NETWORK_ClearBuffer( &g_MessageBuffer );
+			++ulPacketNum;
+			ulSizeOfPacket = 5;
+			NETWORK_WriteLong( &g_MessageBuffer.ByteStream, MSC_BEGINSERVERLISTPART );
+			NETWORK_WriteByte( &g_MessageBuffer.ByteStream, ulPacketNum );
+			NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_SERVERBLOCK );
 		}
-		else
-			printf( "+ Adding %s (revision %d) to the verification list.\n", NETWORK_AddressToString( addedServer->Address ), addedServer->iServerRevision );
+		ulSizeOfPacket += ulServerBlockNetSize;
+		MASTERSERVER_SendServerIPBlockToLauncher ( serverAddress, serverPortList, &g_MessageBuffer.ByteStream );
 	}
+	NETWORK_WriteByte( &g_MessageBuffer.ByteStream, 0 ); // [BB] Terminate MSC_SERVERBLOCK by sending 0 ports.
+	NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_ENDSERVERLIST );
+	g_ServerListPackets.push_back( std::vector<UCHAR>( ));
+	NETWORK_EncodePacket( &g_MessageBuffer, g_ServerListPackets.back( ));
+
+	g_ulServerListPacketsGeneration = g_Servers.getGeneration( );
+	g_bServerListPacketsValid = true;
 }
 
 //*****************************************************************************
@@ -463,19 +545,13 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 			newServer.bNewFormatServer = ( temp != -1 );
 			newServer.iServerRevision = ( ( pByteStream->pbStreamEnd - pByteStream->pbStream ) >= 4 ) ? NETWORK_ReadLong( pByteStream ) : NETWORK_ReadShort( pByteStream );
 
-			std::set<SERVER_s, SERVERCompFunc>::iterator currentServer = g_Servers.find ( newServer );
+			SERVER_s *pCurrentServer = g_Servers.find ( newServer.Address );
 
 			// This is a new server; add it to the list.
-			if ( currentServer == g_Servers.end() )
+			if ( pCurrentServer == NULL )
 			{
-				unsigned int iNumOtherServers = 0;
-
 				// First count the number of servers from this IP.
-				for( std::set<SERVER_s, SERVERCompFunc>::const_iterator it = g_Servers.begin(); it != g_Servers.end(); ++it )
-				{
-					if ( NETWORK_CompareAddress( it->Address, AddressFrom, true ))
-						iNumOtherServers++;
-				}
+				const unsigned int iNumOtherServers = g_Servers.numServersOnIP( AddressFrom );
 
 				if ( iNumOtherServers >= 10 && !g_MultiServerExceptions.isIPInList( AddressFrom ))
 					printf( "* More than 10 servers received from %s. Ignoring request...\n", NETWORK_AddressToString( AddressFrom ));
@@ -484,9 +560,8 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 					// [BB] 3021 is 98d, don't put those servers on the list.
 					if ( ( newServer.bNewFormatServer ) && ( newServer.iServerRevision != 3021 ) )
 					{
-						std::set<SERVER_s, SERVERCompFunc>::iterator currentUnverifiedServer = g_UnverifiedServers.find ( newServer );
 						// [BB] This is a new server, but we still need to verify it.
-						if ( currentUnverifiedServer == g_UnverifiedServers.end() )
+						if ( g_UnverifiedServers.find ( newServer.Address ) == NULL )
 						{
 							srand ( time(NULL) );
 							newServer.ServerVerificationInt = rand() + rand() * rand() + rand() * rand() * rand();
@@ -509,11 +584,15 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 			else
 			{
 				// [BB] Only if the verification string matches.
-				if ( stricmp ( currentServer->MasterBanlistVerificationString.c_str(), newServer.MasterBanlistVerificationString.c_str() ) == 0 )
+				if ( stricmp ( pCurrentServer->MasterBanlistVerificationString.c_str(), newServer.MasterBanlistVerificationString.c_str() ) == 0 )
 				{
-					currentServer->lLastReceived = g_lCurrentTime;
+					pCurrentServer->lLastReceived = g_lCurrentTime;
 					// [BB] The server possibly changed the ban setting, so update it.
-					currentServer->bEnforcesBanList = newServer.bEnforcesBanList;
+					if ( pCurrentServer->bEnforcesBanList != newServer.bEnforcesBanList )
+					{
+						pCurrentServer->bEnforcesBanList = newServer.bEnforcesBanList;
+						g_Servers.markChanged( );
+					}
 				}
 			}
 
@@ -529,17 +608,17 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 			newServer.MasterBanlistVerificationString = NETWORK_ReadString( pByteStream );
 			newServer.ServerVerificationInt = NETWORK_ReadLong( pByteStream );
 
-			std::set<SERVER_s, SERVERCompFunc>::iterator currentServer = g_UnverifiedServers.find ( newServer );
+			SERVER_s *pCurrentServer = g_UnverifiedServers.find ( newServer.Address );
 
 			// [BB] Apparently, we didn't request any verification from this server, so ignore it.
-			if ( currentServer == g_UnverifiedServers.end() )
+			if ( pCurrentServer == NULL )
 				return;
 
-			if ( ( stricmp ( newServer.MasterBanlistVerificationString.c_str(), currentServer->MasterBanlistVerificationString.c_str() ) == 0 )
-				&& ( newServer.ServerVerificationInt == currentServer->ServerVerificationInt ) )
+			if ( ( stricmp ( newServer.MasterBanlistVerificationString.c_str(), pCurrentServer->MasterBanlistVerificationString.c_str() ) == 0 )
+				&& ( newServer.ServerVerificationInt == pCurrentServer->ServerVerificationInt ) )
 			{
-				MASTERSERVER_AddServer( *currentServer, g_Servers );
-				g_UnverifiedServers.erase ( currentServer );
+				MASTERSERVER_AddServer( *pCurrentServer, g_Servers );
+				g_UnverifiedServers.remove ( newServer.Address );
 			}
 			return;
 		}
@@ -549,15 +628,15 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 			server.Address = AddressFrom;
 			server.MasterBanlistVerificationString = NETWORK_ReadString( pByteStream );
 
-			std::set<SERVER_s, SERVERCompFunc>::iterator currentServer = g_Servers.find ( server );
+			SERVER_s *pCurrentServer = g_Servers.find ( server.Address );
 
 			// [BB] We don't know the server. Just ignore it.
-			if ( currentServer == g_Servers.end() )
+			if ( pCurrentServer == NULL )
 				return;
 
-			if ( stricmp ( server.MasterBanlistVerificationString.c_str(), currentServer->MasterBanlistVerificationString.c_str() ) == 0 )
+			if ( stricmp ( server.MasterBanlistVerificationString.c_str(), pCurrentServer->MasterBanlistVerificationString.c_str() ) == 0 )
 			{
-				currentServer->bVerifiedLatestBanList = true;
+				pCurrentServer->bVerifiedLatestBanList = true;
 				std::cerr << NETWORK_AddressToString ( AddressFrom ) << " acknowledged receipt of the banlist.\n";
 			}
 		}
@@ -598,78 +677,17 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 			// Wait 10 seconds before sending this IP the server list again.
 			g_queryIPQueue.addAddress( AddressFrom, g_lCurrentTime, &std::cerr );
 
-			switch ( lCommand )
-			{
-			case LAUNCHER_SERVER_CHALLENGE:
-				// Send the list of servers.
-				NETWORK_WriteLong( &g_MessageBuffer.ByteStream, MSC_BEGINSERVERLIST );
-				for( std::set<SERVER_s, SERVERCompFunc>::const_iterator it = g_Servers.begin(); it != g_Servers.end(); ++it )
-				{
-					// [BB] Possibly omit servers that don't enforce our ban list.
-					if ( ( it->bEnforcesBanList == true ) || ( g_bHideBanIgnoringServers == false ) )
-						MASTERSERVER_SendServerIPToLauncher ( it->Address, &g_MessageBuffer.ByteStream );
-				}
-
-				// Tell the launcher that we're done sending servers.
-				NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_ENDSERVERLIST );
-
-				// Send the launcher our packet.
-				NETWORK_LaunchPacket( &g_MessageBuffer, AddressFrom );
-				return;
-
-			case LAUNCHER_MASTER_CHALLENGE:
-
-				const unsigned long ulMaxPacketSize = 1024;
-				unsigned long ulPacketNum = 0;
-
-				std::set<SERVER_s, SERVERCompFunc>::const_iterator it = g_Servers.begin();
-
-				NETWORK_WriteLong( &g_MessageBuffer.ByteStream, MSC_BEGINSERVERLISTPART );
-				NETWORK_WriteByte( &g_MessageBuffer.ByteStream, ulPacketNum );
-				NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_SERVERBLOCK );
-				unsigned long ulSizeOfPacket = 6; // 4 (MSC_BEGINSERVERLISTPART) + 1 (0) + 1 (MSC_SERVERBLOCK)
-
-				while ( it != g_Servers.end() )
-				{
-					NETADDRESS_s serverAddress = it->Address;
-					std::vector<USHORT> serverPortList;
-
-					do {
-						// [BB] Possibly omit servers that don't enforce our ban list.
-						if ( ( it->bEnforcesBanList == true ) || ( g_bHideBanIgnoringServers == false ) )
-							serverPortList.push_back ( it->Address.usPort );
-						++it;
-					} while ( ( it != g_Servers.end() ) && NETWORK_CompareAddress( it->Address, serverAddress, true ) );
-
-					// [BB] All servers on this IP ignore the list, nothing to send.
-					if ( serverPortList.size() == 0 )
-						continue;
-
-					const unsigned long ulServerBlockNetSize = MASTERSERVER_CalcServerIPBlockNetSize( serverAddress, serverPortList );
+			// The list only needs to be serialized again if it changed since the last launcher asked for it.
+			MASTERSERVER_UpdateServerListPackets( );
 
-					// [BB] If sending this block would cause the current packet to exceed ulMaxPacketSize ...
-					if ( ulSizeOfPacket + ulServerBlockNetSize > ulMaxPacketSize - 1 )
-					{
-						// [BB] ... close the current packet and start a new one.
-						NETWORK_WriteByte( &g_MessageBuffer.ByteStream, 0 ); // [BB] Terminate MSC_SERVERBLOCK by sending 0 ports.
-						NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_ENDSERVERLISTPART );
-						NETWORK_LaunchPacket( &g_MessageBuffer, AddressFrom );
-
-						NETWORK_ClearBuffer( &g_MessageBuffer );
-						++ulPacketNum;
-						ulSizeOfPacket = 5;
-						NETWORK_WriteLong( &g_MessageBuffer.ByteStream, MSC_BEGINSERVERLISTPART );
-						NETWORK_WriteByte( &g_MessageBuffer.ByteStream, ulPacketNum );
-						NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_SERVERBLOCK );
-					}
-					ulSizeOfPacket += ulServerBlockNetSize;
-					MASTERSERVER_SendServerIPBlockToLauncher ( serverAddress, serverPortList, &g_MessageBuffer.ByteStream );
-				}
-				NETWORK_WriteByte( &g_MessageBuffer.ByteStream, 0 ); // [BB] Terminate MSC_SERVERBLOCK by sending 0 ports.
-				NETWORK_WriteByte( &g_MessageBuffer.ByteStream, MSC_ENDSERVERLIST );
-				NETWORK_LaunchPacket( &g_MessageBuffer, AddressFrom );
-				return;
+			if ( lCommand == LAUNCHER_SERVER_CHALLENGE )
+				NETWORK_LaunchEncodedPacket( g_OldFormatServerListPacket, AddressFrom );
+			else
+			{
+				for ( unsigned int i = 0; i < g_ServerListPackets.size( ); ++i )
+					NETWORK_LaunchEncodedPacket( g_ServerListPackets[i], AddressFrom );
 			}
+			return;
 		}
 	}
 
@@ -679,32 +697,13 @@ void MASTERSERVER_ParseCommands( BYTESTREAM_s *pByteStream )
 
 //*****************************************************************************
 //
-void MASTERSERVER_CheckTimeouts( std::set<SERVER_s, SERVERCompFunc> &ServerSet )
+void MASTERSERVER_CheckTimeouts( ServerList &List )
 {
-	// [BB] Because we are erasing entries from the set, the iterator has to be incremented inside
-	// the loop, depending on whether and element was erased or not.
-	for( std::set<SERVER_s, SERVERCompFunc>::iterator it = ServerSet.begin(); it != ServerSet.end(); )
-	{
-		// If the server has timed out, make it an open slot!
-		if (( g_lCurrentTime - it->lLastReceived ) >= 60 )
-		{
-			printf( "- %server at %s timed out.\n", ( &ServerSet == &g_UnverifiedServers ) ? "Unverified s" : "S", NETWORK_AddressToString( it->Address ));
-			// [BB] The standard does not require set::erase to return the incremented operator,
-			// that's why we must use the post increment operator here.
-			ServerSet.erase ( it++ );
-			continue;
-		}
-		else
-		{
-			// [BB] If the server doesn't have the latest ban list, send it now.
-			// This construction has the drawback that all servers are updated at once.
-			// Possibly it will be necessary to do this differently.
-			if ( it->bHasLatestBanList == false )
-				MASTERSERVER_SendBanlistToServer( *it );
+	std::vector<SERVER_s> TimedOut;
+	List.removeTimedOutServers( g_lCurrentTime, TimedOut );
 
-			++it;
-		}
-	}
+	for ( unsigned int i = 0; i < TimedOut.size( ); ++i )
+		printf( "- %server at %s timed out.\n", ( &List == &g_UnverifiedServers ) ? "Unverified s" : "S", NETWORK_AddressToString( TimedOut[i].Address ));
 }
 
 //*****************************************************************************
@@ -713,6 +712,19 @@ void MASTERSERVER_CheckTimeouts( void )
 {
 	MASTERSERVER_CheckTimeouts ( g_Servers );
 	MASTERSERVER_CheckTimeouts ( g_UnverifiedServers );
+
+	// [BB] If a server doesn't have the latest ban list, send it now.
+	// This construction has the drawback that all servers are updated at once.
+	// Possibly it will be necessary to do this differently.
+	if ( g_bBanlistsPending )
+	{
+		for ( unsigned int i = 0; i < g_Servers.size( ); ++i )
+		{
+			if ( g_Servers[i].bHasLatestBanList == false )
+				MASTERSERVER_SendBanlistToServer( g_Servers[i] );
+		}
+		g_bBanlistsPending = false;
+	}
 }
 
 //*****************************************************************************
@@ -780,12 +792,13 @@ int main( int argc, char **argv )
 
 		if ( g_lCurrentTime > lastBanlistVerificationTimeout + 10 )
 		{
-			for( std::set<SERVER_s, SERVERCompFunc>::iterator it = g_Servers.begin(); it != g_Servers.end(); ++it )
+			for ( unsigned int i = 0; i < g_Servers.size( ); ++i )
 			{
-				if ( ( it->bVerifiedLatestBanList == false ) && ( it->bNewFormatServer == true ) )
+				if ( ( g_Servers[i].bVerifiedLatestBanList == false ) && ( g_Servers[i].bNewFormatServer == true ) )
 				{
-					it->bHasLatestBanList = false;
-					std::cerr << "No receipt received from " << NETWORK_AddressToString ( it->Address ) << ". Resending banlist.\n";
+					g_Servers[i].bHasLatestBanList = false;
+					g_bBanlistsPending = true;
+					std::cerr << "No receipt received from " << NETWORK_AddressToString ( g_Servers[i].Address ) << ". Resending banlist.\n";
 				}
 			}
 			lastBanlistVerificationTimeout = g_lCurrentTime;
@@ -61,6 +61,9 @@ typedef int32_t __int32;
 // This is the maximum number of servers we can store in our list. Hopefully ST won't grow so big that this number can't hold them all!
 #define	MAX_SERVERS						512
 
+// Number of seconds after which a server we haven't heard of is removed from the list.
+#define	SERVER_TIMEOUT					60
+
 //*****************************************************************************
 //	STRUCTURES
 
@@ -69,21 +72,20 @@ typedef struct
 	// The IP address of this server.
 	NETADDRESS_s	Address;
 
-	// [BB] lLastReceived and bHasLatestBanList don't affect the ordering in the set we are going to
-	// organize the servers in. Thus we can mark them as mutable, which in turn allows us to change
-	// both values using the set iterators.
-
 	// The last time we heard from this server (used for timeouts).
-	mutable long	lLastReceived;
+	long			lLastReceived;
+
+	// The time of the pending timeout check of this server in the server list's timer wheel.
+	long			lTimeoutCheck;
 
 	// [BB] Does the server have the latest version of the holy banlist?
-	mutable bool	bHasLatestBanList;
+	bool			bHasLatestBanList;
 
 	// [BB] Did the server acknowledge the receipt the holy banlist?
-	mutable bool	bVerifiedLatestBanList;
+	bool			bVerifiedLatestBanList;
 
 	// [BB] Does the server enforce the holy banlist locally?
-	mutable bool	bEnforcesBanList;
+	bool			bEnforcesBanList;
 
 	// [BB] Is the server using the latest Skulltag version
 	bool	bNewFormatServer;
@@ -57,6 +57,9 @@
 
 #include <ctype.h>
 #include <math.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
 #include "../src/huffman/huffman.h"
 #include "network.h"
@@ -79,12 +82,28 @@ static	USHORT			g_usLocalPort;
 // Buffer for the Huffman encoding.
 static	UCHAR			g_ucHuffmanBuffer[131072];
 
+#ifdef __linux__
+// Number of datagrams that are fetched from the socket with a single system call.
+#define	RECEIVE_BATCH_SIZE		64
+
+// The datagrams of the last batch and where they came from.
+static	UCHAR				g_aucReceiveBuffers[RECEIVE_BATCH_SIZE][MAX_UDP_PACKET];
+static	struct sockaddr_in	g_aReceiveFrom[RECEIVE_BATCH_SIZE];
+static	struct iovec		g_aReceiveIOVecs[RECEIVE_BATCH_SIZE];
+static	struct mmsghdr		g_aReceiveHeaders[RECEIVE_BATCH_SIZE];
+
+// Number of datagrams in the last batch, and how many of them were handed out already.
+static	int					g_iReceiveBatchSize = 0;
+static	int					g_iReceiveBatchPos = 0;
+#endif
+
 //*****************************************************************************
 //	PROTOTYPES
 
 static	void			network_Error( const char *pszError );
 static	SOCKET			network_AllocateSocket( void );
 static	bool			network_BindSocketToPort( SOCKET Socket, ULONG ulInAddr, USHORT usPort, bool bReUse );
+static	void			network_SendDatagram( const UCHAR *pucData, INT iNumBytes, NETADDRESS_s Address );
 
 //*****************************************************************************
 //	FUNCTIONS
@@ -201,6 +220,52 @@ int NETWORK_GetPackets( void )
 	LONG				lNumBytes;
 	INT					iDecodedNumBytes = sizeof(g_ucHuffmanBuffer);
 	struct sockaddr_in	SocketFrom;
+	UCHAR				*pucReceived = g_ucHuffmanBuffer;
+
+#ifdef __linux__
+	// Fetch a whole batch of datagrams with one system call and hand them out one by one.
+	while ( true )
+	{
+		if ( g_iReceiveBatchPos == g_iReceiveBatchSize )
+		{
+			g_iReceiveBatchPos = g_iReceiveBatchSize = 0;
+
+			for ( int i = 0; i < RECEIVE_BATCH_SIZE; ++i )
+			{
+				g_aReceiveIOVecs[i].iov_base = g_aucReceiveBuffers[i];
+				g_aReceiveIOVecs[i].iov_len = MAX_UDP_PACKET;
+				memset( &g_aReceiveHeaders[i], 0, sizeof( g_aReceiveHeaders[i] ));
+				g_aReceiveHeaders[i].msg_hdr.msg_name = &g_aReceiveFrom[i];
+				g_aReceiveHeaders[i].msg_hdr.msg_namelen = sizeof( g_aReceiveFrom[i] );
+				g_aReceiveHeaders[i].msg_hdr.msg_iov = &g_aReceiveIOVecs[i];
+				g_aReceiveHeaders[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			const int iNumReceived = recvmmsg( g_NetworkSocket, g_aReceiveHeaders, RECEIVE_BATCH_SIZE, MSG_DONTWAIT, NULL );
+			if ( iNumReceived == -1 )
+			{
+				if (( errno != EWOULDBLOCK ) && ( errno != EAGAIN ) && ( errno != ECONNREFUSED ))
+					printf( "NETWORK_GetPackets: WARNING!: Error #%d: %s\n", errno, strerror( errno ));
+				return ( 0 );
+			}
+			if ( iNumReceived == 0 )
+				return ( 0 );
+
+			g_iReceiveBatchSize = iNumReceived;
+		}
+
+		const int iIdx = g_iReceiveBatchPos++;
+
+		// Skip datagrams that didn't fit into the buffer, no legal packet is that large.
+		if ( g_aReceiveHeaders[iIdx].msg_hdr.msg_flags & MSG_TRUNC )
+			continue;
+
+		pucReceived = g_aucReceiveBuffers[iIdx];
+		lNumBytes = g_aReceiveHeaders[iIdx].msg_len;
+		SocketFrom = g_aReceiveFrom[iIdx];
+		break;
+	}
+#else
 	INT					iSocketFromLength;
 
     iSocketFromLength = sizeof( SocketFrom );
@@ -243,6 +308,7 @@ int NETWORK_GetPackets( void )
         return ( false );
 #endif
     }
+#endif
 
 	// No packets or an error, so don't process anything.
 	if ( lNumBytes <= 0 )
@@ -253,7 +319,7 @@ int NETWORK_GetPackets( void )
 		return ( 0 );
 
 	// Decode the huffman-encoded message we received.
-	HUFFMAN_Decode( g_ucHuffmanBuffer, (unsigned char *)g_NetworkMessage.pbData, lNumBytes, &iDecodedNumBytes );
+	HUFFMAN_Decode( pucReceived, (unsigned char *)g_NetworkMessage.pbData, lNumBytes, &iDecodedNumBytes );
 	g_NetworkMessage.ulCurrentSize = iDecodedNumBytes;
 	g_NetworkMessage.ByteStream.pbStream = g_NetworkMessage.pbData;
 	g_NetworkMessage.ByteStream.pbStreamEnd = g_NetworkMessage.ByteStream.pbStream + g_NetworkMessage.ulCurrentSize;
@@ -275,9 +341,7 @@ NETADDRESS_s NETWORK_GetFromAddress( void )
 //
 void NETWORK_LaunchPacket( NETBUFFER_s *pBuffer, NETADDRESS_s Address )
 {
-	LONG				lNumBytes;
 	INT					iNumBytesOut = sizeof(g_ucHuffmanBuffer);
-	struct sockaddr_in	SocketAddress;
 
 	pBuffer->ulCurrentSize = NETWORK_CalcBufferSize( pBuffer );
 
@@ -285,54 +349,45 @@ void NETWORK_LaunchPacket( NETBUFFER_s *pBuffer, NETADDRESS_s Address )
 	if ( pBuffer->ulCurrentSize == 0 )
 		return;
 
-	// Convert the IP address to a socket address.
-	NETWORK_NetAddressToSocketAddress( Address, SocketAddress );
-
 	HUFFMAN_Encode( (unsigned char *)pBuffer->pbData, g_ucHuffmanBuffer, pBuffer->ulCurrentSize, &iNumBytesOut );
+	network_SendDatagram( g_ucHuffmanBuffer, iNumBytesOut, Address );
+}
 
-	lNumBytes = sendto( g_NetworkSocket, (const char*)g_ucHuffmanBuffer, iNumBytesOut, 0, (struct sockaddr *)&SocketAddress, sizeof( SocketAddress ));
-
-	// If sendto returns -1, there was an error.
-	if ( lNumBytes == -1 )
-	{
-#ifdef __WIN32__
-		INT	iError = WSAGetLastError( );
-
-		// Wouldblock is silent.
-		if ( iError == WSAEWOULDBLOCK )
-			return;
+//*****************************************************************************
+//
+void NETWORK_EncodePacket( NETBUFFER_s *pBuffer, std::vector<UCHAR> &Encoded )
+{
+	INT		iNumBytesOut = sizeof(g_ucHuffmanBuffer);
 
-		switch ( iError )
-		{
-		case WSAEACCES:
+	Encoded.clear( );
+	pBuffer->ulCurrentSize = NETWORK_CalcBufferSize( pBuffer );
+	if ( pBuffer->ulCurrentSize == 0 )
+		return;
 
-			printf( "NETWORK_LaunchPacket: Error #%d, WSAEACCES: Permission denied for address: %s\n", iError, NETWORK_AddressToString( Address ));
-			return;
-		case WSAEADDRNOTAVAIL:
+	HUFFMAN_Encode( (unsigned char *)pBuffer->pbData, g_ucHuffmanBuffer, pBuffer->ulCurrentSize, &iNumBytesOut );
+	Encoded.assign( g_ucHuffmanBuffer, g_ucHuffmanBuffer + iNumBytesOut );
+}
 
-			printf( "NETWORK_LaunchPacket: Error #%d, WSAEADDRENOTAVAIL: Address %s not available\n", iError, NETWORK_AddressToString( Address ));
-			return;
-		case WSAEHOSTUNREACH:
+//*****************************************************************************
+//
+void NETWORK_LaunchEncodedPacket( const std::vector<UCHAR> &Encoded, NETADDRESS_s Address )
+{
+	// Nothing to do.
+	if ( Encoded.empty( ))
+		return;
 
-			printf( "NETWORK_LaunchPacket: Error #%d, WSAEHOSTUNREACH: Address %s unreachable\n", iError, NETWORK_AddressToString( Address ));
-			return;				
-		default:
+	network_SendDatagram( &Encoded[0], static_cast<INT>( Encoded.size( )), Address );
+}
 
-			printf( "NETWORK_LaunchPacket: Error #%d\n", iError );
-			return;
-		}
+//*****************************************************************************
+//
+bool NETWORK_HasPendingPackets( void )
+{
+#ifdef __linux__
+	return ( g_iReceiveBatchPos < g_iReceiveBatchSize );
 #else
-	if ( errno == EWOULDBLOCK )
-return;
-
-          if ( errno == ECONNREFUSED )
-              return;
-
-		printf( "NETWORK_LaunchPacket: %s\n", strerror( errno ));
-		printf( "NETWORK_LaunchPacket: Address %s\n", NETWORK_AddressToString( Address ));
-
+	return ( false );
 #endif
-	}
 }
 
 //*****************************************************************************
@@ -465,6 +520,61 @@ bool network_BindSocketToPort( SOCKET Socket, ULONG ulInAddr, USHORT usPort, boo
 	return ( true );
 }
 
+//*****************************************************************************
+//
+static void network_SendDatagram( const UCHAR *pucData, INT iNumBytes, NETADDRESS_s Address )
+{
+	LONG				lNumBytes;
+	struct sockaddr_in	SocketAddress;
+
+	// Convert the IP address to a socket address.
+	NETWORK_NetAddressToSocketAddress( Address, SocketAddress );
+
+	lNumBytes = sendto( g_NetworkSocket, (const char*)pucData, iNumBytes, 0, (struct sockaddr *)&SocketAddress, sizeof( SocketAddress ));
+
+	// If sendto returns -1, there was an error.
+	if ( lNumBytes == -1 )
+	{
+#ifdef __WIN32__
+		INT	iError = WSAGetLastError( );
+
+		// Wouldblock is silent.
+		if ( iError == WSAEWOULDBLOCK )
+			return;
+
+		switch ( iError )
+		{
+		case WSAEACCES:
+
+			printf( "NETWORK_LaunchPacket: Error #%d, WSAEACCES: Permission denied for address: %s\n", iError, NETWORK_AddressToString( Address ));
+			return;
+		case WSAEADDRNOTAVAIL:
+
+			printf( "NETWORK_LaunchPacket: Error #%d, WSAEADDRENOTAVAIL: Address %s not available\n", iError, NETWORK_AddressToString( Address ));
+			return;
+		case WSAEHOSTUNREACH:
+
+			printf( "NETWORK_LaunchPacket: Error #%d, WSAEHOSTUNREACH: Address %s unreachable\n", iError, NETWORK_AddressToString( Address ));
+			return;				
+		default:
+
+			printf( "NETWORK_LaunchPacket: Error #%d\n", iError );
+			return;
+		}
+#else
+	if ( errno == EWOULDBLOCK )
+return;
+
+          if ( errno == ECONNREFUSED )
+              return;
+
+		printf( "NETWORK_LaunchPacket: %s\n", strerror( errno ));
+		printf( "NETWORK_LaunchPacket: Address %s\n", NETWORK_AddressToString( Address ));
+
+#endif
+	}
+}
+
 
 #ifndef	WIN32
 extern int	stdin_ready;
@@ -488,6 +598,67 @@ void I_DoSelect (void)
     if (select (static_cast<int>(g_NetworkSocket)+1, &fdset, NULL, NULL, &timeout) == -1)
         return;
 #else
+	// Don't wait if there are still datagrams left from the last batch.
+	if ( NETWORK_HasPendingPackets( ))
+	{
+		stdin_ready = 0;
+		return;
+	}
+
+#ifdef __linux__
+	// Wait with epoll, which doesn't need to hand the set of descriptors to the kernel on every call.
+	static int	s_iEpollFD = -1;
+	static bool	s_bStdinRegistered = false;
+
+	if ( s_iEpollFD == -1 )
+	{
+		s_iEpollFD = epoll_create( 2 );
+		if ( s_iEpollFD != -1 )
+		{
+			struct epoll_event	Event;
+			memset( &Event, 0, sizeof( Event ));
+			Event.events = EPOLLIN;
+			Event.data.fd = g_NetworkSocket;
+			if ( epoll_ctl( s_iEpollFD, EPOLL_CTL_ADD, g_NetworkSocket, &Event ) == -1 )
+			{
+				close( s_iEpollFD );
+				s_iEpollFD = -2;
+			}
+		}
+		else
+			s_iEpollFD = -2;
+	}
+
+	if ( s_iEpollFD >= 0 )
+	{
+		// Watch stdin as long as we want input from it. Files can't be watched, epoll_ctl fails for them.
+		if ( do_stdin && ( s_bStdinRegistered == false ))
+		{
+			struct epoll_event	Event;
+			memset( &Event, 0, sizeof( Event ));
+			Event.events = EPOLLIN;
+			Event.data.fd = 0;
+			s_bStdinRegistered = ( epoll_ctl( s_iEpollFD, EPOLL_CTL_ADD, 0, &Event ) == 0 );
+		}
+		else if (( do_stdin == false ) && s_bStdinRegistered )
+		{
+			epoll_ctl( s_iEpollFD, EPOLL_CTL_DEL, 0, NULL );
+			s_bStdinRegistered = false;
+		}
+
+		struct epoll_event	Events[2];
+		const int			iNumEvents = epoll_wait( s_iEpollFD, Events, 2, 1000 );
+
+		stdin_ready = 0;
+		for ( int i = 0; i < iNumEvents; ++i )
+		{
+			if ( Events[i].data.fd == 0 )
+				stdin_ready = 1;
+		}
+		return;
+	}
+#endif
+
     struct timeval   timeout;
     fd_set           fdset;
 
@@ -73,6 +73,9 @@ int				NETWORK_GetPackets( void );
 int				NETWORK_GetLANPackets( void );
 NETADDRESS_s	NETWORK_GetFromAddress( void );
 void			NETWORK_LaunchPacket( NETBUFFER_s *pBuffer, NETADDRESS_s Address );
+void			NETWORK_EncodePacket( NETBUFFER_s *pBuffer, std::vector<UCHAR> &Encoded );
+void			NETWORK_LaunchEncodedPacket( const std::vector<UCHAR> &Encoded, NETADDRESS_s Address );
+bool			NETWORK_HasPendingPackets( void );
 char			*NETWORK_AddressToString( NETADDRESS_s Address );
 char			*NETWORK_AddressToStringIgnorePort( NETADDRESS_s Address );
 void			NETWORK_NetAddressToSocketAddress( NETADDRESS_s &Address, struct sockaddr_in &SocketAddress );
@@ -0,0 +1,286 @@
+//-----------------------------------------------------------------------------
+//
+// Skulltag Master Server Source
+// Copyright (C) 2004-2005 Brad Carney
+// Copyright (C) 2007-2012 Skulltag Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+// Filename: serverlist.cpp
+//
+// Description: The list of registered servers, indexed by address, and the
+// timer wheel that times them out.
+//
+//-----------------------------------------------------------------------------
+
+#include "../src/networkheaders.h"
+#include "../src/networkshared.h"
+#include "serverlist.h"
+
+//*****************************************************************************
+//	FUNCTIONS
+
+//=============================================================================
+//
+// find
+//
+// Returns the server with the given address (including the port) or NULL.
+// The pointer is only valid until the next server is added or removed.
+//
+//=============================================================================
+
+SERVER_s *ServerList::find( const NETADDRESS_s &Address )
+{
+	const int iSlot = findSlot( Address );
+	return ( iSlot == -1 ) ? NULL : &_servers[_index[iSlot]];
+}
+
+//=============================================================================
+//
+// add
+//
+// Adds a server that isn't on the list yet and returns it. The pointer is only
+// valid until the next server is added or removed.
+//
+//=============================================================================
+
+SERVER_s *ServerList::add( const SERVER_s &Server, const long lCurrentTime )
+{
+	SERVER_s *pServer = find( Server.Address );
+	if ( pServer )
+		return pServer;
+
+	// Keep the index at most half full, so that probe sequences stay short.
+	if ( 2 * ( _servers.size( ) + 1 ) > _index.size( ))
+	{
+		_index.assign( 2 * _index.size( ), -1 );
+		for ( unsigned int i = 0; i < _servers.size( ); ++i )
+			insertIntoIndex( i );
+	}
+
+	_servers.push_back( Server );
+	insertIntoIndex( static_cast<int>( _servers.size( )) - 1 );
+	++_numServersOnIP[ipOf( Server.Address )];
+	++_ulGeneration;
+
+	pServer = &_servers.back( );
+	pServer->lLastReceived = lCurrentTime;
+	scheduleTimeoutCheck( *pServer, lCurrentTime + SERVER_TIMEOUT );
+	return pServer;
+}
+
+//=============================================================================
+//
+// remove
+//
+// Removes the server with the given address. Its slot in the array is filled
+// with the last server.
+//
+//=============================================================================
+
+void ServerList::remove( const NETADDRESS_s &Address )
+{
+	const int iSlot = findSlot( Address );
+	if ( iSlot == -1 )
+		return;
+
+	const int iServerIdx = _index[iSlot];
+	removeFromIndex( iSlot );
+
+	std::map<ULONG, unsigned int>::iterator it = _numServersOnIP.find( ipOf( Address ));
+	if (( it != _numServersOnIP.end( )) && ( --it->second == 0 ))
+		_numServersOnIP.erase( it );
+
+	const int iLastIdx = static_cast<int>( _servers.size( )) - 1;
+	if ( iServerIdx != iLastIdx )
+	{
+		_index[findSlot( _servers[iLastIdx].Address )] = iServerIdx;
+		_servers[iServerIdx] = _servers[iLastIdx];
+	}
+	_servers.pop_back( );
+	++_ulGeneration;
+}
+
+//=============================================================================
+//
+// numServersOnIP
+//
+// Returns how many servers on the list share the IP of the given address.
+//
+//=============================================================================
+
+unsigned int ServerList::numServersOnIP( const NETADDRESS_s &Address ) const
+{
+	std::map<ULONG, unsigned int>::const_iterator it = _numServersOnIP.find( ipOf( Address ));
+	return ( it == _numServersOnIP.end( )) ? 0 : it->second;
+}
+
+//=============================================================================
+//
+// removeTimedOutServers
+//
+// Advances the timer wheel to the current time. Servers we haven't heard of in
+// SERVER_TIMEOUT seconds are removed and appended to TimedOut. Servers that sent
+// a heartbeat in the meantime get a new check when they would time out.
+//
+//=============================================================================
+
+void ServerList::removeTimedOutServers( const long lCurrentTime, std::vector<SERVER_s> &TimedOut )
+{
+	// If we didn't get here for a whole revolution, every slot needs to be looked at once.
+	long lTime = _lWheelTime + 1;
+	if ( lCurrentTime - _lWheelTime > static_cast<long>( TIMER_WHEEL_SLOTS ))
+		lTime = lCurrentTime - TIMER_WHEEL_SLOTS + 1;
+
+	for ( ; lTime <= lCurrentTime; ++lTime )
+	{
+		std::vector<TIMEOUTCHECK_t> &Slot = _timerWheel[lTime & ( TIMER_WHEEL_SLOTS - 1 )];
+		std::vector<TIMEOUTCHECK_t> Checks;
+		Checks.swap( Slot );
+
+		for ( unsigned int i = 0; i < Checks.size( ); ++i )
+		{
+			// This check is due in a later revolution.
+			if ( Checks[i].lTime > lCurrentTime )
+			{
+				Slot.push_back( Checks[i] );
+				continue;
+			}
+
+			// The server is gone or has been scheduled anew since this check was made.
+			SERVER_s *pServer = find( Checks[i].Address );
+			if (( pServer == NULL ) || ( pServer->lTimeoutCheck != Checks[i].lTime ))
+				continue;
+
+			if (( lCurrentTime - pServer->lLastReceived ) >= SERVER_TIMEOUT )
+			{
+				TimedOut.push_back( *pServer );
+				remove( Checks[i].Address );
+			}
+			else
+				scheduleTimeoutCheck( *pServer, pServer->lLastReceived + SERVER_TIMEOUT );
+		}
+	}
+
+	if ( lCurrentTime > _lWheelTime )
+		_lWheelTime = lCurrentTime;
+}
+
+//*****************************************************************************
+//
+ULONG ServerList::ipOf( const NETADDRESS_s &Address )
+{
+	return ( Address.abIP[0] << 24 ) | ( Address.abIP[1] << 16 ) | ( Address.abIP[2] << 8 ) | Address.abIP[3];
+}
+
+//*****************************************************************************
+//
+unsigned int ServerList::hashAddress( const NETADDRESS_s &Address ) const
+{
+	unsigned int uiHash = static_cast<unsigned int>( ipOf( Address ));
+	uiHash = ( uiHash * 2654435761u ) ^ ( Address.usPort * 40503u );
+	uiHash ^= uiHash >> 15;
+	uiHash *= 2246822519u;
+	uiHash ^= uiHash >> 13;
+	return ( uiHash & ( _index.size( ) - 1 ));
+}
+
+//*****************************************************************************
+//
+int ServerList::findSlot( const NETADDRESS_s &Address ) const
+{
+	const unsigned int uiMask = static_cast<unsigned int>( _index.size( )) - 1;
+
+	for ( unsigned int uiSlot = hashAddress( Address ); _index[uiSlot] != -1; uiSlot = ( uiSlot + 1 ) & uiMask )
+	{
+		if ( NETWORK_CompareAddress( _servers[_index[uiSlot]].Address, Address, false ))
+			return uiSlot;
+	}
+
+	return -1;
+}
+
+//*****************************************************************************
+//
+void ServerList::insertIntoIndex( const int iServerIdx )
+{
+	const unsigned int uiMask = static_cast<unsigned int>( _index.size( )) - 1;
+	unsigned int uiSlot = hashAddress( _servers[iServerIdx].Address );
+
+	while ( _index[uiSlot] != -1 )
+		uiSlot = ( uiSlot + 1 ) & uiMask;
+
+	_index[uiSlot] = iServerIdx;
+}
+
+//*****************************************************************************
+//
+void ServerList::removeFromIndex( const unsigned int uiSlot )
+{
+	const unsigned int uiMask = static_cast<unsigned int>( _index.size( )) - 1;
+	unsigned int uiHole = uiSlot;
+
+	_index[uiHole] = -1;
+
+	// Move the following entries of the probe sequence back, unless that would put them in front
+	// of their home slot. Then no tombstones are needed.
+	for ( unsigned int uiNext = ( uiHole + 1 ) & uiMask; _index[uiNext] != -1; uiNext = ( uiNext + 1 ) & uiMask )
+	{
+		const unsigned int uiHome = hashAddress( _servers[_index[uiNext]].Address );
+		const bool bHomeBetween = ( uiHole <= uiNext ) ? (( uiHole < uiHome ) && ( uiHome <= uiNext )) : (( uiHole < uiHome ) || ( uiHome <= uiNext ));
+
+		if ( bHomeBetween )
+			continue;
+
+		_index[uiHole] = _index[uiNext];
+		_index[uiNext] = -1;
+		uiHole = uiNext;
+	}
+}
+
+//*****************************************************************************
+//
+void ServerList::scheduleTimeoutCheck( SERVER_s &Server, const long lTime )
+{
+	TIMEOUTCHECK_t Check;
+	Check.Address = Server.Address;
+	Check.lTime = lTime;
+
+	Server.lTimeoutCheck = lTime;
+	_timerWheel[lTime & ( TIMER_WHEEL_SLOTS - 1 )].push_back( Check );
+}
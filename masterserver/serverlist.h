@@ -0,0 +1,128 @@
+//-----------------------------------------------------------------------------
+//
+// Skulltag Master Server Source
+// Copyright (C) 2004-2005 Brad Carney
+// Copyright (C) 2007-2012 Skulltag Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+// Filename: serverlist.h
+//
+// Description: The list of registered servers, indexed by address, and the
+// timer wheel that times them out.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __SERVERLIST_H__
+#define __SERVERLIST_H__
+
+#include <vector>
+#include <map>
+#include "main.h"
+
+//==========================================================================
+//
+// ServerList
+//
+// Stores the servers in an array and finds them through an open-addressed
+// hash table keyed by their address. Timeouts are tracked by a timer wheel
+// with one slot per second, so only the servers that might have timed out
+// are looked at.
+//
+//==========================================================================
+
+class ServerList
+{
+	//*************************************************************************
+	typedef struct
+	{
+		// Address of the server to check.
+		NETADDRESS_s		Address;
+
+		// The second the check is due.
+		long				lTime;
+
+	} TIMEOUTCHECK_t;
+
+	// Number of slots in the timer wheel, must be a power of two larger than SERVER_TIMEOUT.
+	static const unsigned int	TIMER_WHEEL_SLOTS = 64;
+
+	std::vector<SERVER_s>			_servers;
+
+	// Index into _servers for each slot, -1 if the slot is empty. The size is a power of two.
+	std::vector<int>				_index;
+
+	// Number of servers on each IP (in host byte order).
+	std::map<ULONG, unsigned int>	_numServersOnIP;
+
+	std::vector<TIMEOUTCHECK_t>		_timerWheel[TIMER_WHEEL_SLOTS];
+
+	// The last second the timer wheel was advanced to.
+	long							_lWheelTime;
+
+	// Incremented whenever the list changes in a way that matters to launchers.
+	unsigned long					_ulGeneration;
+
+//*************************************************************************
+public:
+	ServerList( ) : _index( 64, -1 ), _lWheelTime( 0 ), _ulGeneration( 0 ) { }
+
+	SERVER_s		*find( const NETADDRESS_s &Address );
+	SERVER_s		*add( const SERVER_s &Server, const long lCurrentTime );
+	void			remove( const NETADDRESS_s &Address );
+	unsigned int	numServersOnIP( const NETADDRESS_s &Address ) const;
+	void			removeTimedOutServers( const long lCurrentTime, std::vector<SERVER_s> &TimedOut );
+
+	unsigned int	size( ) const { return static_cast<unsigned int>( _servers.size( )); }
+	SERVER_s		&operator[]( const unsigned int uiIdx ) { return _servers[uiIdx]; }
+	const SERVER_s	&operator[]( const unsigned int uiIdx ) const { return _servers[uiIdx]; }
+
+	unsigned long	getGeneration( ) const { return _ulGeneration; }
+	void			markChanged( ) { ++_ulGeneration; }
+
+//*************************************************************************
+private:
+	static ULONG	ipOf( const NETADDRESS_s &Address );
+	unsigned int	hashAddress( const NETADDRESS_s &Address ) const;
+	int				findSlot( const NETADDRESS_s &Address ) const;
+	void			insertIntoIndex( const int iServerIdx );
+	void			removeFromIndex( const unsigned int uiSlot );
+	void			scheduleTimeoutCheck( SERVER_s &Server, const long lTime );
+};
+
+#endif	// __SERVERLIST_H__
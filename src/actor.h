@@ -498,19 +498,41 @@ enum EBounceType
 };
 
 // [RH] Like msecnode_t, but for the blockmap
+// An actor keeps one of these for every block it is linked into. The block
+// itself only holds an FBlockEntry, so that searches can walk the actors
+// of a block without chasing pointers.
 struct FBlockNode
 {
-	AActor *Me;						// actor this node references
 	int BlockIndex;					// index into blocklinks for the block this node is in
-	FBlockNode **PrevActor;			// previous actor in this block
-	FBlockNode *NextActor;			// next actor in this block
-	FBlockNode **PrevBlock;			// previous block this actor is in
+	int EntryIndex;					// index of the actor's entry in that block
 	FBlockNode *NextBlock;			// next block this actor is in
+	unsigned int Generation;		// blockmap this node was created for
 
-	static FBlockNode *Create (AActor *who, int x, int y);
+	static FBlockNode *Create (AActor *who, int index);
 	void Release ();
 
 	static FBlockNode *FreeBlocks;
+	static unsigned int CurrentGeneration;
+};
+
+// An actor's entry in a block. Where the actor was linked and how big it was
+// is kept here, so searches can check these before touching the actor, which
+// is far bigger and rarely in the cache.
+struct FBlockEntry
+{
+	AActor *Me;						// NULL while the actor is between unlinking and relinking
+	fixed_t X, Y;
+	fixed_t Radius;
+	FBlockNode *Node;				// NULL if the entry was removed while the blockmap was locked
+};
+
+struct FBlockCell
+{
+	TArray<FBlockEntry> Things;
+	unsigned int Stamp;				// last relink that found this block still covered
+	int Removed;					// entries waiting to be compacted
+
+	FBlockCell() : Stamp(0), Removed(0) {}
 };
 
 class FDecalBase;
@@ -986,6 +1008,8 @@ public:
 	void LinkToWorld (bool buggy=false);
 	void LinkToWorld (sector_t *sector);
 	void UnlinkFromWorld ();
+	void LinkToBlockmap ();
+	void ReleaseBlockNodes ();
 	void AdjustFloorClip ();
 	void SetOrigin (fixed_t x, fixed_t y, fixed_t z);
 	bool InStateSequence(FState * newstate, FState * basestate);
@@ -1115,6 +1139,11 @@ inline T *Spawn (fixed_t x, fixed_t y, fixed_t z, replace_t allowreplacement)
 void	ACTOR_ClearNetIDList( );
 // [BB] Rebuild the global list of used / free NetIDs from scratch.
 void	ACTOR_RebuildNetIDList( void );
+void	ACTOR_AssignNetID( AActor *pActor, LONG lNetID );
+void	ACTOR_ReleaseNetID( AActor *pActor );
+AActor	*ACTOR_FindThingByNetID( LONG lNetID );
+ULONG	ACTOR_GetNetIDHandle( const AActor *pActor );
+AActor	*ACTOR_FindThingByNetIDHandle( ULONG ulHandle );
 
 #define	MAX_NETID				32768
 
@@ -1127,6 +1156,14 @@ typedef struct
 	// If this node is occupied, this is the actor occupying it.
 	AActor	*pActor;
 
+	// Incremented every time the node is freed. Together with the ID, this makes up a
+	// handle that becomes invalid once the actor is gone, even if the ID is reused.
+	USHORT	usGeneration;
+
+	// Neighbors in the list of free nodes (-1 if there is none).
+	LONG	lPrevFree;
+	LONG	lNextFree;
+
 } NETIDNODE_t;
 
 extern	NETIDNODE_t		g_NetIDList[MAX_NETID];
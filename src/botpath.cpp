@@ -233,47 +233,51 @@ bool P_BlockThingsIterator (int x, int y, bool(*func)(AActor*), TArray<AActor *>
 	}
 	else
 	{
-		FBlockNode *block;
+		FBlockmapLock lock;
 		int index = y*bmapwidth + x;
+		FBlockCell *cell = &blocklinks[index];
+		int entry;
 
+		// Entries are checked from the newest one down.
 		if (actor == NULL)
 		{
-			block = blocklinks[index];
+			entry = (int)cell->Things.Size() - 1;
 		}
 		else
 		{
-			block = actor->BlockNode;
-			while (block != NULL && block->BlockIndex != index)
+			FBlockNode *block = actor->BlockNode;
+			while (block != NULL && (block->BlockIndex != index || block->Generation != FBlockNode::CurrentGeneration))
 			{
 				block = block->NextBlock;
 			}
-			if (block != NULL)
-			{
-				block = block->NextActor;
-			}
+			entry = (block != NULL) ? block->EntryIndex - 1 : -1;
 		}
-		while (block != NULL)
+		for (; entry >= 0; --entry)
 		{
-			FBlockNode *next = block->NextActor;
+			AActor *me = cell->Things[entry].Me;
 			int i;
 
+			if (me == NULL)
+			{
+				continue;
+			}
+
 			// Don't recheck things that were already checked
 			for (i = (int)checkarray.Size() - 1; i >= 0; --i)
 			{
-				if (checkarray[i] == block->Me)
+				if (checkarray[i] == me)
 				{
 					break;
 				}
 			}
 			if (i < 0)
 			{
-				checkarray.Push (block->Me);
-				if (!func (block->Me))
+				checkarray.Push (me);
+				if (!func (me))
 				{
 					return false;
 				}
 			}
-			block = next;
 		}
 	}
 	return true;
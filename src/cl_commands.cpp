@@ -593,3 +593,12 @@ void CLIENTCOMMANDS_Linetarget( AActor* mobj )
 	NETWORK_WriteByte( &CLIENT_GetLocalBuffer( )->ByteStream, CLC_LINETARGET );
 	NETWORK_WriteShort( &CLIENT_GetLocalBuffer( )->ByteStream, mobj->lNetID );
 }
+
+//*****************************************************************************
+//
+void CLIENTCOMMANDS_AckMoveSnapshot( ULONG ulSequence, bool bMissingBase )
+{
+	NETWORK_WriteByte( &CLIENT_GetLocalBuffer( )->ByteStream, CLC_ACKMOVESNAPSHOT );
+	NETWORK_WriteByte( &CLIENT_GetLocalBuffer( )->ByteStream, ulSequence );
+	NETWORK_WriteByte( &CLIENT_GetLocalBuffer( )->ByteStream, bMissingBase );
+}
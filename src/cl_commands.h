@@ -96,5 +96,6 @@ void	CLIENTCOMMANDS_Puke ( LONG lScript, int args[3] );
 void	CLIENTCOMMANDS_MorphCheat ( const char *pszMorphClass );
 void	CLIENTCOMMANDS_FullUpdateReceived ( void );
 void	CLIENTCOMMANDS_Linetarget( AActor* mobj );
+void	CLIENTCOMMANDS_AckMoveSnapshot( ULONG ulSequence, bool bMissingBase );
 
 #endif	// __CL_COMMANDS_H__
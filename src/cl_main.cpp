@@ -161,6 +161,8 @@ static	void	client_EndSnapshot( BYTESTREAM_s *pByteStream );
 // Player functions.
 static	void	client_SpawnPlayer( BYTESTREAM_s *pByteStream, bool bMorph = false );
 static	void	client_MovePlayer( BYTESTREAM_s *pByteStream );
+static	void	client_MovePlayerDelta( BYTESTREAM_s *pByteStream );
+static	void	client_ResetMoveSnapshots( void );
 static	void	client_DamagePlayer( BYTESTREAM_s *pByteStream );
 static	void	client_KillPlayer( BYTESTREAM_s *pByteStream );
 static	void	client_SetPlayerHealth( BYTESTREAM_s *pByteStream );
@@ -526,6 +528,19 @@ static	LONG				g_lHighestReceivedSequence;
 // Delay for sending a request missing packets.
 static	LONG				g_lMissingPacketTicks;
 
+// The player states the server sent us with the last MOVESNAPSHOT_BACKUP move snapshots.
+// The server encodes SVC2_MOVEPLAYERDELTA against these.
+static	MOVESNAPSHOTPLAYER_s	g_MoveSnapshots[MOVESNAPSHOT_BACKUP][MAXPLAYERS];
+
+// The (lowest byte of the) sequence of the snapshot stored in each slot of g_MoveSnapshots.
+static	LONG				g_lMoveSnapshotSequence[MOVESNAPSHOT_BACKUP];
+
+// The last move snapshot we acknowledged.
+static	LONG				g_lLastAckedMoveSnapshot;
+
+// The last move snapshot we told the server that we couldn't decode.
+static	LONG				g_lLastMissingMoveSnapshot;
+
 // Debugging variables.
 static	LONG				g_lLastCmd;
 
@@ -918,6 +933,8 @@ void CLIENT_AttemptConnection( void )
 
 	g_lMissingPacketTicks = 0;
 
+	client_ResetMoveSnapshots( );
+
 	 // Send connection signal to the server.
 	NETWORK_WriteByte( &g_LocalBuffer.ByteStream, CLCC_ATTEMPTCONNECTION );
 	NETWORK_WriteString( &g_LocalBuffer.ByteStream, DOTVERSIONSTR );
@@ -1233,8 +1250,9 @@ void CLIENT_CheckForMissingPackets( void )
 		NETWORK_WriteLong( &g_LocalBuffer.ByteStream, -1 );
 	}
 
-	// Don't send out a request for the missing packets for another 1/4 second.
-	g_lMissingPacketTicks = ( TICRATE / 4 );
+	// Don't send out a request for the missing packets before the server could have answered,
+	// but wait no longer than 1/4 second. The server ignores requests for packets it just resent.
+	g_lMissingPacketTicks = clamp<LONG>( static_cast<LONG>( players[consoleplayer].ulPing ) * TICRATE / 1000 + 1, 1, TICRATE / 4 );
 }
 
 //*****************************************************************************
@@ -2804,6 +2822,10 @@ void CLIENT_ProcessCommand( LONG lCommand, BYTESTREAM_s *pByteStream )
 				client_BuildStair( pByteStream );
 				break;
 
+			case SVC2_MOVEPLAYERDELTA:
+				client_MovePlayerDelta( pByteStream );
+				break;
+
 			default:
 				sprintf( szString, "CLIENT_ParsePacket: Illegible server message: %d\nLast command: %d\n", static_cast<int> (lExtCommand), static_cast<int> (g_lLastCmd) );
 				CLIENT_QuitNetworkGame( szString );
@@ -3103,12 +3125,7 @@ AActor *CLIENT_SpawnThing( const PClass *pType, fixed_t X, fixed_t Y, fixed_t Z,
 	pActor = Spawn( pType, X, Y, Z, NO_REPLACE );
 	if ( pActor )
 	{
-		pActor->lNetID = lNetID;
-		if ( lNetID != -1 )
-		{
-			g_NetIDList[lNetID].bFree = false;
-			g_NetIDList[lNetID].pActor = pActor;
-		}
+		ACTOR_AssignNetID( pActor, lNetID );
 
 		pActor->SpawnPoint[0] = X;
 		pActor->SpawnPoint[1] = Y;
@@ -3183,12 +3200,7 @@ void CLIENT_SpawnMissile( const PClass *pType, fixed_t X, fixed_t Y, fixed_t Z,
 	// Derive the thing's angle from its momentum.
 	pActor->angle = R_PointToAngle2( 0, 0, MomX, MomY );
 
-	pActor->lNetID = lNetID;
-	if ( lNetID != -1 )
-	{
-		g_NetIDList[lNetID].bFree = false;
-		g_NetIDList[lNetID].pActor = pActor;
-	}
+	ACTOR_AssignNetID( pActor, lNetID );
 
 	// Play the seesound if this missile has one.
 	if ( pActor->SeeSound )
@@ -3300,13 +3312,7 @@ void CLIENT_DisplayMOTD( void )
 //
 AActor *CLIENT_FindThingByNetID( LONG lNetID )
 {
-	if (( lNetID < 0 ) || ( lNetID >= 65536 ))
-		return ( NULL );
-
-	if (( g_NetIDList[lNetID].bFree == false ) && ( g_NetIDList[lNetID].pActor ))
-		return ( g_NetIDList[lNetID].pActor );
-
-    return ( NULL );
+	return ( ACTOR_FindThingByNetID( lNetID ));
 }
 
 //*****************************************************************************
@@ -3871,9 +3877,8 @@ static void client_SpawnPlayer( BYTESTREAM_s *pByteStream, bool bMorph )
 			return;
 		}
 */
+		// Destroying the actor also frees its net ID.
 		g_NetIDList[lID].pActor->Destroy( );
-		g_NetIDList[lID].pActor = NULL;
-		g_NetIDList[lID].bFree = true;
 	}
 
 	// [BB] Remember if we were already ignoring WeaponSelect commands. If so, the server
@@ -3979,12 +3984,7 @@ static void client_SpawnPlayer( BYTESTREAM_s *pByteStream, bool bMorph )
 		players[consoleplayer].camera = pPlayer->mo;
 
 	// Set the network ID.
-	pPlayer->mo->lNetID = lID;
-	if ( lID != -1 )
-	{
-		g_NetIDList[lID].bFree = false;
-		g_NetIDList[lID].pActor = pPlayer->mo;
-	}
+	ACTOR_AssignNetID( pPlayer->mo, lID );
 
 	// Set the spectator variables [after G_PlayerReborn so our data doesn't get lost] [BB] Why?.
 	// [BB] To properly handle that spectators don't get default inventory, we need to set this
@@ -4230,54 +4230,29 @@ static void client_SpawnPlayer( BYTESTREAM_s *pByteStream, bool bMorph )
 
 //*****************************************************************************
 //
-static void client_MovePlayer( BYTESTREAM_s *pByteStream )
+static void client_ResetMoveSnapshots( void )
 {
-	ULONG		ulPlayer;
-	bool		bVisible;
-	fixed_t		X = 0;
-	fixed_t		Y = 0;
-	fixed_t		Z = 0;
-	angle_t		Angle = 0;
-	fixed_t		MomX = 0;
-	fixed_t		MomY = 0;
-	fixed_t		MomZ = 0;
-	bool		bCrouching = false;
-
-	// Read in the player number.
-	ulPlayer = NETWORK_ReadByte( pByteStream );
-
-	// Is this player visible? If not, there's no other information to read in.
-	ULONG ulFlags = NETWORK_ReadByte( pByteStream );
-	bVisible = ( ulFlags & PLAYER_VISIBLE );
-
-	// The server only sends position, angle, etc. information if the player is actually
-	// visible to us.
-	if ( bVisible )
+	for ( ULONG ulIdx = 0; ulIdx < MOVESNAPSHOT_BACKUP; ulIdx++ )
 	{
-		// Read in the player's XYZ position.
-		// [BB] The x/y position has to be sent at full precision.
-		X = NETWORK_ReadLong( pByteStream );
-		Y = NETWORK_ReadLong( pByteStream );
-		Z = NETWORK_ReadShort( pByteStream ) << FRACBITS;
-
-		// Read in the player's angle.
-		Angle = NETWORK_ReadLong( pByteStream );
-
-		// Read in the player's XYZ momentum.
-		MomX = NETWORK_ReadShort( pByteStream ) << FRACBITS;
-		MomY = NETWORK_ReadShort( pByteStream ) << FRACBITS;
-		MomZ = NETWORK_ReadShort( pByteStream ) << FRACBITS;
-
-		// Read in whether or not the player's crouching.
-		bCrouching = !!NETWORK_ReadByte( pByteStream );
+		g_lMoveSnapshotSequence[ulIdx] = -1;
+		for ( ULONG ulPlayer = 0; ulPlayer < MAXPLAYERS; ulPlayer++ )
+			g_MoveSnapshots[ulIdx][ulPlayer].bValid = false;
 	}
 
+	g_lLastAckedMoveSnapshot = -1;
+	g_lLastMissingMoveSnapshot = -1;
+}
+
+//*****************************************************************************
+//
+static void client_ApplyPlayerMove( ULONG ulPlayer, ULONG ulFlags, fixed_t X, fixed_t Y, fixed_t Z, angle_t Angle, fixed_t MomX, fixed_t MomY, fixed_t MomZ, bool bCrouching )
+{
 	// Check to make sure everything is valid. If not, break out.
 	if (( PLAYER_IsValidPlayer( ulPlayer ) == false ) || ( players[ulPlayer].mo == NULL ) || ( gamestate != GS_LEVEL ))
 		return;
 
 	// If we're not allowed to know the player's location, then just make him invisible.
-	if ( bVisible == false )
+	if (( ulFlags & PLAYER_VISIBLE ) == false )
 	{
 		players[ulPlayer].mo->renderflags |= RF_INVISIBLE;
 
@@ -4327,6 +4302,171 @@ static void client_MovePlayer( BYTESTREAM_s *pByteStream )
 		players[ulPlayer].cmd.ucmd.buttons &= ~BT_ALTATTACK;
 }
 
+//*****************************************************************************
+//
+static void client_MovePlayer( BYTESTREAM_s *pByteStream )
+{
+	ULONG		ulPlayer;
+	bool		bVisible;
+	fixed_t		X = 0;
+	fixed_t		Y = 0;
+	fixed_t		Z = 0;
+	angle_t		Angle = 0;
+	fixed_t		MomX = 0;
+	fixed_t		MomY = 0;
+	fixed_t		MomZ = 0;
+	bool		bCrouching = false;
+
+	// Read in the player number.
+	ulPlayer = NETWORK_ReadByte( pByteStream );
+
+	// Is this player visible? If not, there's no other information to read in.
+	ULONG ulFlags = NETWORK_ReadByte( pByteStream );
+	bVisible = ( ulFlags & PLAYER_VISIBLE );
+
+	// The server only sends position, angle, etc. information if the player is actually
+	// visible to us.
+	if ( bVisible )
+	{
+		// Read in the player's XYZ position.
+		// [BB] The x/y position has to be sent at full precision.
+		X = NETWORK_ReadLong( pByteStream );
+		Y = NETWORK_ReadLong( pByteStream );
+		Z = NETWORK_ReadShort( pByteStream ) << FRACBITS;
+
+		// Read in the player's angle.
+		Angle = NETWORK_ReadLong( pByteStream );
+
+		// Read in the player's XYZ momentum.
+		MomX = NETWORK_ReadShort( pByteStream ) << FRACBITS;
+		MomY = NETWORK_ReadShort( pByteStream ) << FRACBITS;
+		MomZ = NETWORK_ReadShort( pByteStream ) << FRACBITS;
+
+		// Read in whether or not the player's crouching.
+		bCrouching = !!NETWORK_ReadByte( pByteStream );
+	}
+
+	client_ApplyPlayerMove( ulPlayer, ulFlags, X, Y, Z, Angle, MomX, MomY, MomZ, bCrouching );
+}
+
+//*****************************************************************************
+//
+// Reads an X/Y delta of SVC2_MOVEPLAYERDELTA: the lowest byte first, then the upper
+// (signed) 16 bits.
+static fixed_t client_ReadMoveDeltaXY( BYTESTREAM_s *pByteStream )
+{
+	const int	iLow = NETWORK_ReadByte( pByteStream );
+
+	return ( NETWORK_ReadShort( pByteStream ) * 256 + iLow );
+}
+
+//*****************************************************************************
+//
+static void client_MovePlayerDelta( BYTESTREAM_s *pByteStream )
+{
+	static const MOVESNAPSHOTPLAYER_s	EmptyState = { false, 0, 0, 0, 0, 0, 0, 0, false };
+	const MOVESNAPSHOTPLAYER_s			*pBase = NULL;
+	MOVESNAPSHOTPLAYER_s				State;
+
+	// Read in the player number, the flags and the snapshot this update belongs to.
+	const ULONG ulPlayer = NETWORK_ReadByte( pByteStream );
+	const ULONG ulFlags = NETWORK_ReadByte( pByteStream );
+	const ULONG ulSequence = NETWORK_ReadByte( pByteStream );
+
+	// The age of the snapshot this was encoded against. Zero means the full state was sent.
+	const ULONG ulAge = ( ulFlags >> MOVEDELTA_AGE_SHIFT );
+
+	if ( ulAge == 0 )
+	{
+		State.X = NETWORK_ReadLong( pByteStream );
+		State.Y = NETWORK_ReadLong( pByteStream );
+		State.sZ = NETWORK_ReadShort( pByteStream );
+		State.Angle = NETWORK_ReadLong( pByteStream );
+		State.sMomX = NETWORK_ReadShort( pByteStream );
+		State.sMomY = NETWORK_ReadShort( pByteStream );
+		State.sMomZ = NETWORK_ReadShort( pByteStream );
+		State.bCrouching = !!NETWORK_ReadByte( pByteStream );
+	}
+	else
+	{
+		const ULONG ulBaseSequence = ( ulSequence - ulAge ) & 0xFF;
+		const ULONG ulBaseSlot = ulBaseSequence % MOVESNAPSHOT_BACKUP;
+
+		if (( ulPlayer < MAXPLAYERS ) &&
+			( g_lMoveSnapshotSequence[ulBaseSlot] == static_cast<LONG>( ulBaseSequence )) &&
+			g_MoveSnapshots[ulBaseSlot][ulPlayer].bValid )
+		{
+			pBase = &g_MoveSnapshots[ulBaseSlot][ulPlayer];
+		}
+
+		// Even if we don't know the base, we have to fully parse the delta.
+		// Otherwise we can't continue parsing the packet.
+		State = ( pBase != NULL ) ? *pBase : EmptyState;
+
+		const ULONG ulBits = NETWORK_ReadByte( pByteStream );
+		if ( ulBits & MOVEDELTA_X )
+			State.X += client_ReadMoveDeltaXY( pByteStream );
+		if ( ulBits & MOVEDELTA_Y )
+			State.Y += client_ReadMoveDeltaXY( pByteStream );
+		if ( ulBits & MOVEDELTA_Z )
+			State.sZ += static_cast<SBYTE>( NETWORK_ReadByte( pByteStream ));
+		if ( ulBits & MOVEDELTA_ANGLE )
+			State.Angle = static_cast<angle_t>( static_cast<USHORT>( NETWORK_ReadShort( pByteStream ))) << 16;
+		if ( ulBits & MOVEDELTA_MOMX )
+			State.sMomX += static_cast<SBYTE>( NETWORK_ReadByte( pByteStream ));
+		if ( ulBits & MOVEDELTA_MOMY )
+			State.sMomY += static_cast<SBYTE>( NETWORK_ReadByte( pByteStream ));
+		if ( ulBits & MOVEDELTA_MOMZ )
+			State.sMomZ += static_cast<SBYTE>( NETWORK_ReadByte( pByteStream ));
+		State.bCrouching = !!( ulBits & MOVEDELTA_CROUCHING );
+	}
+	State.bValid = true;
+
+	if ( ulPlayer >= MAXPLAYERS )
+		return;
+
+	// If this slot already holds a newer snapshot, this update arrived way too late.
+	const ULONG ulSlot = ulSequence % MOVESNAPSHOT_BACKUP;
+	if ( g_lMoveSnapshotSequence[ulSlot] != static_cast<LONG>( ulSequence ))
+	{
+		if ( g_lMoveSnapshotSequence[ulSlot] != -1 )
+		{
+			const ULONG ulNewer = ( g_lMoveSnapshotSequence[ulSlot] - ulSequence ) & 0xFF;
+			if (( ulNewer > 0 ) && ( ulNewer < 128 ))
+				return;
+		}
+
+		// Forget the snapshot that used this slot before.
+		g_lMoveSnapshotSequence[ulSlot] = ulSequence;
+		for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+			g_MoveSnapshots[ulSlot][ulIdx].bValid = false;
+	}
+
+	// We don't know the state the server encoded this against (we probably missed a packet).
+	// Ask the server to send full states again.
+	if (( ulAge != 0 ) && ( pBase == NULL ))
+	{
+		if ( g_lLastMissingMoveSnapshot != static_cast<LONG>( ulSequence ))
+		{
+			CLIENTCOMMANDS_AckMoveSnapshot( ulSequence, true );
+			g_lLastMissingMoveSnapshot = ulSequence;
+		}
+		return;
+	}
+
+	g_MoveSnapshots[ulSlot][ulPlayer] = State;
+
+	// Let the server know that it can encode against this snapshot.
+	if ( g_lLastAckedMoveSnapshot != static_cast<LONG>( ulSequence ))
+	{
+		CLIENTCOMMANDS_AckMoveSnapshot( ulSequence, false );
+		g_lLastAckedMoveSnapshot = ulSequence;
+	}
+
+	client_ApplyPlayerMove( ulPlayer, ulFlags, State.X, State.Y, State.sZ << FRACBITS, State.Angle,
+		State.sMomX << FRACBITS, State.sMomY << FRACBITS, State.sMomZ << FRACBITS, State.bCrouching );
+}
+
 //*****************************************************************************
 //
 static void client_DamagePlayer( BYTESTREAM_s *pByteStream )
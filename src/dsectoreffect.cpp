@@ -168,6 +168,7 @@ DMover::EResult DMover::MovePlane (fixed_t speed, fixed_t dest, int crush,
 		m_Sector->bFloorHeightChange = true;
 	else
 		m_Sector->bCeilingHeightChange = true;
+	SERVER_LEVELCHANGES_MarkSector( m_Sector->sectornum );
 
 	switch (floorOrCeiling)
 	{
@@ -45,6 +45,12 @@
 // [BB] New #includes.
 #include "cl_demo.h"
 #include "doomstat.h"
+#include "sv_profiler.h"
+#include "c_dispatch.h"
+#include "d_player.h"
+#include "a_pickups.h"
+#include "dsectoreffect.h"
+#include "templates.h"
 
 
 static cycle_t ThinkCycles;
@@ -57,6 +63,20 @@ FThinkerList DThinker::Thinkers[MAX_STATNUM+2];
 FThinkerList DThinker::FreshThinkers[MAX_STATNUM+1];
 bool DThinker::bSerialOverride = false;
 
+TArray<FThinkerClassList *> DThinker::ClassLists;
+FThinkerClassList DThinker::UnsortedThinkers;
+
+// The class lists of a type and all its descendants
+struct FThinkerDescendants
+{
+	const PClass *Type;
+	TArray<FThinkerClassList *> Lists;
+	unsigned int NumChecked;	// How many of DThinker::ClassLists have been looked at
+};
+
+static TMap<const PClass *, FThinkerClassList *> ClassListsByType;
+static TMap<const PClass *, FThinkerDescendants *> DescendantsByType;
+
 void FThinkerList::AddTail(DThinker *thinker)
 {
 	assert(thinker->PrevThinker == NULL && thinker->NextThinker == NULL);
@@ -186,10 +206,12 @@ void DThinker::SerializeAll(FArchive &arc, bool hubLoad)
 					else if (thinker->ObjectFlags & OF_JustSpawned)
 					{
 						FreshThinkers[stat].AddTail(thinker);
+						thinker->StatNum = stat;
 					}
 					else
 					{
 						Thinkers[stat].AddTail(thinker);
+						thinker->StatNum = stat;
 					}
 					arc << thinker;
 				}
@@ -210,27 +232,44 @@ DThinker::DThinker (int statnum) throw()
 {
 	NextThinker = NULL;
 	PrevThinker = NULL;
+	NextOfClass = NULL;
+	PrevOfClass = NULL;
+	ClassList = NULL;
+	LinkToClassList (&UnsortedThinkers);
+
+	if ((unsigned)statnum > MAX_STATNUM)
+	{
+		statnum = MAX_STATNUM;
+	}
+	StatNum = statnum;
+
 	if (bSerialOverride)
 	{ // The serializer will insert us into the right list
 		return;
 	}
 
 	ObjectFlags |= OF_JustSpawned;
-	if ((unsigned)statnum > MAX_STATNUM)
-	{
-		statnum = MAX_STATNUM;
-	}
 	FreshThinkers[statnum].AddTail (this);
 }
 
 DThinker::DThinker(no_link_type foo) throw()
 {
 	foo;	// Avoid unused argument warnings.
+	NextThinker = NULL;
+	PrevThinker = NULL;
+	NextOfClass = NULL;
+	PrevOfClass = NULL;
+	ClassList = NULL;
+	StatNum = MAX_STATNUM;
 }
 
 DThinker::~DThinker ()
 {
 	assert(NextThinker == NULL && PrevThinker == NULL);
+	if (ClassList != NULL)
+	{
+		UnlinkFromClassList();
+	}
 }
 
 void DThinker::Destroy ()
@@ -241,9 +280,93 @@ void DThinker::Destroy ()
 	{
 		Remove();
 	}
+	if (ClassList != NULL)
+	{
+		UnlinkFromClassList();
+	}
 	Super::Destroy();
 }
 
+void DThinker::LinkToClassList (FThinkerClassList *list)
+{
+	assert(ClassList == NULL);
+	ClassList = list;
+	PrevOfClass = list->Tail;
+	NextOfClass = NULL;
+	if (list->Tail != NULL)
+	{
+		list->Tail->NextOfClass = this;
+	}
+	else
+	{
+		list->Head = this;
+	}
+	list->Tail = this;
+	list->Count++;
+}
+
+void DThinker::UnlinkFromClassList ()
+{
+	if (PrevOfClass != NULL)
+	{
+		PrevOfClass->NextOfClass = NextOfClass;
+	}
+	else
+	{
+		ClassList->Head = NextOfClass;
+	}
+	if (NextOfClass != NULL)
+	{
+		NextOfClass->PrevOfClass = PrevOfClass;
+	}
+	else
+	{
+		ClassList->Tail = PrevOfClass;
+	}
+	ClassList->Count--;
+	ClassList = NULL;
+	PrevOfClass = NULL;
+	// NextOfClass is left alone, so that an iterator that is standing on this
+	// thinker can still find the rest of the list.
+}
+
+// Moves all thinkers created since the last call into the lists of their classes.
+void DThinker::SortNewThinkers ()
+{
+	while (UnsortedThinkers.Head != NULL)
+	{
+		DThinker *thinker = UnsortedThinkers.Head;
+		const PClass *type = thinker->GetClass();
+		FThinkerClassList **list = ClassListsByType.CheckKey(type);
+
+		if (list == NULL)
+		{
+			FThinkerClassList *newlist = new FThinkerClassList;
+			newlist->Type = type;
+			newlist->Head = newlist->Tail = NULL;
+			newlist->Count = 0;
+			ClassLists.Push(newlist);
+			list = &ClassListsByType.Insert(type, newlist);
+		}
+		thinker->UnlinkFromClassList();
+		thinker->LinkToClassList(*list);
+	}
+}
+
+// Adds the class lists that were created since the descendants were last
+// updated and belong to the type.
+void DThinker::UpdateDescendants (FThinkerDescendants *descendants)
+{
+	for (; descendants->NumChecked < ClassLists.Size(); descendants->NumChecked++)
+	{
+		FThinkerClassList *list = ClassLists[descendants->NumChecked];
+		if (list->Type->IsDescendantOf(descendants->Type))
+		{
+			descendants->Lists.Push(list);
+		}
+	}
+}
+
 void DThinker::Remove()
 {
 	if (this == NextToThink)
@@ -300,6 +423,7 @@ void DThinker::ChangeStatNum (int statnum)
 		statnum = MAX_STATNUM;
 	}
 	Remove();
+	StatNum = statnum;
 	if ((ObjectFlags & OF_JustSpawned) && statnum >= STAT_FIRST_THINKING)
 	{
 		list = &FreshThinkers[statnum];
@@ -402,6 +526,7 @@ void DThinker::DestroyMostThinkersInList (FThinkerList &list, int stat)
 				// I can keep my debug assertions that all thinkers are either
 				// euthanizing or in a list.
 				Thinkers[MAX_STATNUM+1].AddTail(probe);
+				probe->StatNum = MAX_STATNUM+1;
 			}
 		}
 	}
@@ -414,6 +539,10 @@ void DThinker::RunThinkers ()
 	ThinkCycles.Reset();
 
 	ThinkCycles.Clock();
+	SERVER_PROFILER_Clock( PROFILERPHASE_THINKERS );
+
+	// Everything spawned since the last time has been constructed completely by now.
+	SortNewThinkers ();
 
 	// Tick every thinker left from last time
 	for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
@@ -431,6 +560,7 @@ void DThinker::RunThinkers ()
 		}
 	} while (count != 0);
 
+	SERVER_PROFILER_Unclock( PROFILERPHASE_THINKERS );
 	ThinkCycles.Unclock();
 }
 
@@ -468,8 +598,7 @@ int DThinker::TickThinkers (FThinkerList *list, FThinkerList *dest)
 			// [BC] Don't tick the consoleplayer's actor in client
 			// mode, because that's done in the main prediction function
 			if (((( NETWORK_GetState( ) != NETSTATE_CLIENT ) && ( CLIENTDEMO_IsPlaying( ) == false ))) ||
-				( node->IsKindOf( RUNTIME_CLASS( AActor )) == false ) ||
-				( static_cast<AActor *>( node ) != players[consoleplayer].mo ))
+				( node != players[consoleplayer].mo ))
 			{
 				node->Tick ();
 			}
@@ -506,8 +635,34 @@ FThinkerIterator::FThinkerIterator (const PClass *type, int statnum)
 		m_SearchStats = false;
 	}
 	m_ParentType = type;
-	m_CurrThinker = DThinker::Thinkers[m_Stat].GetHead();
-	m_SearchingFresh = false;
+
+	// Walk the statnum lists, so the thinkers come in the order they think in.
+	m_ByClass = false;
+	m_Descendants = NULL;
+	Reinit();
+}
+
+FThinkerIterator::FThinkerIterator (const PClass *type, EByClass)
+{
+	m_Stat = STAT_FIRST_THINKING;
+	m_SearchStats = true;
+	m_ParentType = type;
+
+	m_ByClass = type != NULL;
+	m_Descendants = NULL;
+	if (m_ByClass)
+	{
+		FThinkerDescendants **descendants = DescendantsByType.CheckKey(type);
+		if (descendants == NULL)
+		{
+			FThinkerDescendants *newdescendants = new FThinkerDescendants;
+			newdescendants->Type = type;
+			newdescendants->NumChecked = 0;
+			descendants = &DescendantsByType.Insert(type, newdescendants);
+		}
+		m_Descendants = *descendants;
+	}
+	Reinit();
 }
 
 FThinkerIterator::FThinkerIterator (const PClass *type, int statnum, DThinker *prev)
@@ -523,6 +678,8 @@ FThinkerIterator::FThinkerIterator (const PClass *type, int statnum, DThinker *p
 		m_SearchStats = false;
 	}
 	m_ParentType = type;
+	m_ByClass = false;
+	m_Descendants = NULL;
 	if (prev == NULL || (prev->NextThinker->ObjectFlags & OF_Sentinel))
 	{
 		Reinit();
@@ -536,16 +693,66 @@ FThinkerIterator::FThinkerIterator (const PClass *type, int statnum, DThinker *p
 
 void FThinkerIterator::Reinit ()
 {
+	if (m_ByClass)
+	{
+		m_CurrThinker = NULL;
+		m_ListIndex = 0;
+		m_SearchingUnsorted = false;
+		return;
+	}
 	m_CurrThinker = DThinker::Thinkers[m_Stat].GetHead();
 	m_SearchingFresh = false;
 }
 
+// Walks the lists of all classes that descend from the type, followed by the
+// thinkers that haven't been sorted yet.
+DThinker *FThinkerIterator::NextByClass ()
+{
+	for (;;)
+	{
+		while (m_CurrThinker != NULL)
+		{
+			DThinker *thinker = m_CurrThinker;
+			m_CurrThinker = thinker->NextOfClass;
+
+			if ((thinker->ObjectFlags & OF_EuthanizeMe) ||
+				thinker->StatNum < STAT_FIRST_THINKING || thinker->StatNum > MAX_STATNUM)
+			{
+				continue;
+			}
+			if (!m_SearchingUnsorted || thinker->IsKindOf(m_ParentType))
+			{
+				return thinker;
+			}
+		}
+		if (m_SearchingUnsorted)
+		{
+			return NULL;
+		}
+
+		DThinker::UpdateDescendants(m_Descendants);
+		if (m_ListIndex < m_Descendants->Lists.Size())
+		{
+			m_CurrThinker = m_Descendants->Lists[m_ListIndex++]->Head;
+		}
+		else
+		{
+			m_CurrThinker = DThinker::UnsortedThinkers.Head;
+			m_SearchingUnsorted = true;
+		}
+	}
+}
+
 DThinker *FThinkerIterator::Next ()
 {
 	if (m_ParentType == NULL)
 	{
 		return NULL;
 	}
+	if (m_ByClass)
+	{
+		return NextByClass();
+	}
 	do
 	{
 		do
@@ -587,3 +794,67 @@ ADD_STAT (think)
 	out.Format ("Think time = %04.1f ms", ThinkCycles.TimeMS());
 	return out;
 }
+
+// Compares iterating over some classes through the class lists with checking
+// every thinker in the statnum lists, like TThinkerIterator does.
+CCMD (thinkerbench)
+{
+	static const PClass *const types[] =
+	{
+		RUNTIME_CLASS(AActor),
+		RUNTIME_CLASS(APlayerPawn),
+		RUNTIME_CLASS(AInventory),
+		RUNTIME_CLASS(DSectorEffect),
+		RUNTIME_CLASS(DPolyAction),
+	};
+	const int runs = argv.argc() > 1 ? MAX (1, atoi (argv[1])) : 100;
+
+	int total = 0;
+	FThinkerIterator all (RUNTIME_CLASS(DThinker));
+	while (all.Next() != NULL)
+	{
+		total++;
+	}
+	Printf ("%d thinkers, %d runs each\n", total, runs);
+
+	double classtotal = 0, scantotal = 0;
+
+	for (size_t i = 0; i < countof(types); ++i)
+	{
+		cycle_t classcycles, scancycles;
+		int count = 0;
+
+		classcycles.Reset();
+		classcycles.Clock();
+		for (int run = 0; run < runs; ++run)
+		{
+			TThinkerClassIterator<DThinker> it (types[i]);
+			count = 0;
+			while (it.Next() != NULL)
+			{
+				count++;
+			}
+		}
+		classcycles.Unclock();
+
+		scancycles.Reset();
+		scancycles.Clock();
+		for (int run = 0; run < runs; ++run)
+		{
+			FThinkerIterator it (types[i]);
+			while (it.Next() != NULL)
+			{
+			}
+		}
+		scancycles.Unclock();
+
+		double classtime = classcycles.TimeMS() * 1000 / runs;
+		double scantime = scancycles.TimeMS() * 1000 / runs;
+
+		Printf ("%s: %d found, %.2f us by class, %.2f us by scanning (%.1fx)\n", types[i]->TypeName.GetChars(),
+			count, classtime, scantime, classtime > 0 ? scantime / classtime : 0.);
+		classtotal += classtime;
+		scantotal += scantime;
+	}
+	Printf ("Total: %.2f us by class, %.2f us by scanning per run\n", classtotal, scantotal);
+}
@@ -36,6 +36,7 @@
 
 #include <stdlib.h>
 #include "dobject.h"
+#include "tarray.h"
 
 class AActor;
 class player_t;
@@ -43,6 +44,7 @@ struct pspdef_s;
 struct FState;
 
 class FThinkerIterator;
+struct FThinkerDescendants;
 
 enum { MAX_STATNUM = 127 };
 
@@ -58,6 +60,16 @@ struct FThinkerList
 	DThinker *Sentinel;
 };
 
+// Linked list of the thinkers of exactly one class, so that iterating over a
+// class doesn't have to look at every thinker.
+struct FThinkerClassList
+{
+	const PClass *Type;
+	DThinker *Head;
+	DThinker *Tail;
+	int Count;
+};
+
 class DThinker : public DObject
 {
 	DECLARE_CLASS (DThinker, DObject)
@@ -89,15 +101,30 @@ private:
 	static void SaveList(FArchive &arc, DThinker *node);
 	void Remove();
 
+	static void SortNewThinkers ();
+	static void UpdateDescendants (FThinkerDescendants *descendants);
+	void LinkToClassList (FThinkerClassList *list);
+	void UnlinkFromClassList ();
+
 	static FThinkerList Thinkers[MAX_STATNUM+2];		// Current thinkers
 	static FThinkerList FreshThinkers[MAX_STATNUM+1];	// Newly created thinkers
 	static bool bSerialOverride;
 
+	// A thinker's class isn't known for sure until it's been constructed
+	// completely, so new thinkers are only sorted into the lists of their
+	// classes when the thinkers are run next.
+	static TArray<FThinkerClassList *> ClassLists;
+	static FThinkerClassList UnsortedThinkers;
+
 	friend struct FThinkerList;
 	friend class FThinkerIterator;
 	friend class DObject;
 
 	DThinker *NextThinker, *PrevThinker;
+
+	DThinker *NextOfClass, *PrevOfClass;
+	FThinkerClassList *ClassList;
+	BYTE StatNum;
 };
 
 class FThinkerIterator
@@ -110,6 +137,18 @@ private:
 	bool m_SearchStats;
 	bool m_SearchingFresh;
 
+	// TThinkerClassIterator walks the class lists instead of the statnums.
+	bool m_ByClass;
+	bool m_SearchingUnsorted;
+	FThinkerDescendants *m_Descendants;
+	unsigned int m_ListIndex;
+
+	DThinker *NextByClass ();
+
+protected:
+	enum EByClass { BY_CLASS };
+	FThinkerIterator (const PClass *type, EByClass);
+
 public:
 	FThinkerIterator (const PClass *type, int statnum=MAX_STATNUM+1);
 	FThinkerIterator (const PClass *type, int statnum, DThinker *prev);
@@ -144,4 +183,23 @@ public:
 	}
 };
 
+// Finds the same thinkers as a TThinkerIterator over all statnums, but only
+// looks at the thinkers of the type's classes. They come grouped by class,
+// not in the order they think in, so only use this where the order doesn't
+// matter to the game.
+template <class T> class TThinkerClassIterator : public FThinkerIterator
+{
+public:
+	TThinkerClassIterator () : FThinkerIterator (RUNTIME_CLASS(T), BY_CLASS)
+	{
+	}
+	TThinkerClassIterator (const PClass *subclass) : FThinkerIterator (subclass, BY_CLASS)
+	{
+	}
+	T *Next ()
+	{
+		return static_cast<T *>(FThinkerIterator::Next ());
+	}
+};
+
 #endif //__DTHINKER_H__
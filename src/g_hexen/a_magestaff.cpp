@@ -278,16 +278,18 @@ DEFINE_ACTION_FUNCTION(AActor, A_MStaffTrack)
 
 static AActor *FrontBlockCheck (AActor *mo, int index)
 {
-	FBlockNode *link;
+	FBlockCell *cell = &blocklinks[index];
 
-	for (link = blocklinks[index]; link != NULL; link = link->NextActor)
+	for (int i = (int)cell->Things.Size() - 1; i >= 0; --i)
 	{
-		if (link->Me != mo)
+		AActor *link = cell->Things[i].Me;
+
+		if (link != NULL && link != mo)
 		{
-			if (P_PointOnDivlineSide (link->Me->x, link->Me->y, &BlockCheckLine) == 0 &&
-				mo->IsOkayToAttack (link->Me))
+			if (P_PointOnDivlineSide (link->x, link->y, &BlockCheckLine) == 0 &&
+				mo->IsOkayToAttack (link))
 			{
-				return link->Me;
+				return link;
 			}
 		}
 	}
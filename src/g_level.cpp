@@ -1886,9 +1886,7 @@ void G_FinishTravel ()
 			pawn->SetState(pawn->SpawnState);
 
 			// [BC]
-			pawn->lNetID = lSavedNetID;
-			g_NetIDList[pawn->lNetID].bFree = false;
-			g_NetIDList[pawn->lNetID].pActor = pawn;
+			ACTOR_AssignNetID( pawn, lSavedNetID );
 
 			for (inv = pawn->Inventory; inv != NULL; inv = inv->Inventory)
 			{
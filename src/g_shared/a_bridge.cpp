@@ -59,6 +59,8 @@ void ACustomBridge::BeginPlay ()
 		height = args[1] ? args[1] << FRACBITS : 4 * FRACUNIT;
 		RenderStyle = STYLE_Normal;
 	}
+	// The bridge was linked with its default radius.
+	LinkToBlockmap ();
 }
 
 // Action functions for the non-Doom bridge --------------------------------
@@ -161,7 +163,10 @@ void AInvisibleBridge::BeginPlay ()
 {
 	Super::BeginPlay ();
 	if (args[0])
+	{
 		radius = args[0] << FRACBITS;
+		LinkToBlockmap ();
+	}
 	if (args[1])
 		height = args[1] << FRACBITS;
 }
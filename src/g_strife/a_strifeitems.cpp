@@ -34,6 +34,7 @@ DEFINE_ACTION_FUNCTION(AActor, A_RemoveForceField)
 			line->special = 0;
 			sides[line->sidenum[0]].SetTexture(side_t::mid, FNullTextureID());
 			sides[line->sidenum[1]].SetTexture(side_t::mid, FNullTextureID());
+			SERVER_LEVELCHANGES_MarkLine( ULONG( line - lines ));
 		}
 	}
 }
@@ -94,6 +94,7 @@ DEFINE_ACTION_FUNCTION(AActor, A_LightGoesOut)
 
 	newheight = sec->FindLowestFloorSurrounding (&spot);
 	sec->floorplane.d = sec->floorplane.PointToDist (spot, newheight);
+	P_InvalidateSightCache ();
 
 	for (int i = 0; i < 8; ++i)
 	{
@@ -72,6 +72,7 @@ namespace skulltag {
 		// recursive Huffman tree builder.
 		buildTree( root, treeData, 0, dataLength, codeTable, 256 );
 		huffResourceOwner = true;
+		buildTables();
 	}
 	
 
@@ -88,6 +89,7 @@ namespace skulltag {
 		root = treeRootNode;
 		codeTable = leafCodeTable;
 		huffResourceOwner = false;
+		buildTables();
 	}
 	
 	/** Checks the ownership state of this HuffmanCodec's resources.
@@ -103,6 +105,53 @@ namespace skulltag {
 		reverseBits = false;
 		expandable = true;
 		huffResourceOwner = false;
+		decodeTable = 0;
+		decodeBits = 0;
+		encodeTable = 0;
+		useTables = false;
+	}
+
+	/** Builds the encoding and decoding lookup tables from the Huffman tree. <br>
+	 * Both tables work on the bit order the data has on the wire when reverseBits is true,
+	 * i.e. the first bit of a byte is its least significant one. */
+	void HuffmanCodec::buildTables(){
+		int longestCode = 0;
+		maxCodeLength( root, longestCode );
+
+		// The 32 bit buffers used by encode() and decode() need room for a code plus 7 bits.
+		if ( (root == 0) || (root->branch == 0) || (longestCode > 24) ) return;
+
+		// Each code gets its bits in output order, i.e. reversed.
+		encodeTable = new EncodeEntry[256];
+		for ( int i = 0; i < 256; i++ ){
+			encodeTable[i].code = 0;
+			encodeTable[i].bitCount = 0;
+			if ( codeTable[i] == 0 ) continue;
+			for ( int bit = 0; bit < codeTable[i]->bitCount; bit++ ){
+				if ( codeTable[i]->code & (1 << bit) )
+					encodeTable[i].code |= 1 << (codeTable[i]->bitCount - 1 - bit);
+			}
+			encodeTable[i].bitCount = codeTable[i]->bitCount;
+		}
+
+		// Resolve every possible window of decodeBits bits to the code it starts with. Codes
+		// longer than the window store the node the walk has to continue at.
+		decodeBits = (longestCode < 12) ? longestCode : 12;
+		if ( decodeBits < 1 ) decodeBits = 1;
+		decodeTable = new DecodeEntry[1 << decodeBits];
+		for ( int window = 0; window < (1 << decodeBits); window++ ){
+			HuffmanNode * node = root;
+			int bit = 0;
+			while ( (bit < decodeBits) && (node->branch != 0) ){
+				node = &(node->branch[ (window >> bit) & 0x01 ]);
+				bit++;
+			}
+			decodeTable[window].bitCount = bit;
+			decodeTable[window].value = (node->branch == 0) ? (node->value & 0xff) : -1;
+			decodeTable[window].node = node;
+		}
+
+		useTables = true;
 	}
 	
 	/** Increases a codeLength up to the longest Huffman code bit length found in the node or any of its children. <br>
@@ -208,7 +257,7 @@ namespace skulltag {
 
 	/** Decodes data read from an input buffer and stores the result in the output buffer.
 	 * @return number of bytes stored in the output buffer or -1 if an error occurs while encoding. */
-	int HuffmanCodec::encode(
+	int HuffmanCodec::encodeWithTree(
 		unsigned char const * const input,	/**< in: pointer to the first byte to encode. */
 		unsigned char * const output,		/**< out: pointer to an output buffer to store data. */
 		int const &inLength,				/**< in: number of bytes of input buffer to encoded. */
@@ -238,11 +287,11 @@ namespace skulltag {
 		}
 
 		return bytesWritten;
-	} // end function encode
+	} // end function encodeWithTree
 
 	/** Decodes data read from an input buffer and stores the result in the output buffer.
 	 * @return number of bytes stored in the output buffer or -1 if an error occurs while decoding. */
-	int HuffmanCodec::decode(
+	int HuffmanCodec::decodeWithTree(
 		unsigned char const * const input,	/**< in: pointer to data that needs decoding. */
 		unsigned char * const output,		/**< out: pointer to output buffer to store decoded data. */
 		int const &inLength,				/**< in: number of bytes of input buffer to read. */
@@ -284,6 +333,124 @@ namespace skulltag {
 			bitsAvailable--;	// decrement total bits left
 		}
 
+		return wIndex;
+	} // end function decodeWithTree
+
+	/** Encodes data read from an input buffer and stores the result in the output buffer. <br>
+	 * Uses the code lookup table and a 32 bit buffer instead of a BitWriter.
+	 * @return number of bytes stored in the output buffer or -1 if an error occurs while encoding. */
+	int HuffmanCodec::encode(
+		unsigned char const * const input,	/**< in: pointer to the first byte to encode. */
+		unsigned char * const output,		/**< out: pointer to an output buffer to store data. */
+		int const &inLength,				/**< in: number of bytes of input buffer to encoded. */
+		int const &outLength				/**< in: maximum length of data to output. */
+	) const {
+		if ( !useTables ) return encodeWithTree( input, output, inLength, outLength );
+
+		// if not expandable Limit output to input length.
+		int maxBytes = outLength;
+		if ( !expandable && ((inLength + 1) < outLength) ) maxBytes = inLength + 1;
+		// Without room for the padding signal only empty input can be "encoded".
+		if ( maxBytes < 1 ) return (inLength > 0) ? -1 : 0;
+
+		unsigned int bits = 0;	// pending bits, the next bit to output is the least significant one.
+		int bitCount = 0;		// number of pending bits.
+		int wIndex = 1;			// write index of output buffer, index 0 holds the padding signal.
+
+		for ( int i = 0; i < inLength; i++ ){
+			EncodeEntry const &entry = encodeTable[ 0xff & input[i] ];
+			if ( entry.bitCount == 0 ) return -1;
+			bits |= entry.code << bitCount;
+			bitCount += entry.bitCount;
+
+			// Output all full bytes.
+			while ( bitCount >= 8 ){
+				if ( wIndex >= maxBytes ) return -1;
+				output[ wIndex++ ] = (unsigned char)(bits & 0xff);
+				bits >>= 8;
+				bitCount -= 8;
+			}
+		}
+
+		// Pad the last byte with zeros.
+		int padding = 0;
+		if ( bitCount > 0 ){
+			if ( wIndex >= maxBytes ) return -1;
+			output[ wIndex++ ] = (unsigned char)(bits & 0xff);
+			padding = 8 - bitCount;
+		}
+		output[0] = (unsigned char)padding;
+
+		// The table produces reversed bytes, restore the standard bit order if needed.
+		if ( !reverseBits ) for ( int i = 1; i < wIndex; i++ ){
+			output[i] = reverseMap[ 0xff & output[i] ];
+		}
+
+		return wIndex;
+	} // end function encode
+
+	/** Decodes data read from an input buffer and stores the result in the output buffer. <br>
+	 * Decodes a whole code per lookup in decodeTable, only codes longer than decodeBits walk the tree.
+	 * @return number of bytes stored in the output buffer or -1 if an error occurs while decoding. */
+	int HuffmanCodec::decode(
+		unsigned char const * const input,	/**< in: pointer to data that needs decoding. */
+		unsigned char * const output,		/**< out: pointer to output buffer to store decoded data. */
+		int const &inLength,				/**< in: number of bytes of input buffer to read. */
+		int const &outLength				/**< in: maximum length of data to output. */
+	){
+		if ( !useTables ) return decodeWithTree( input, output, inLength, outLength );
+
+		if ( inLength < 1 ) return 0;
+		int bitsAvailable = ((inLength-1) << 3) - (0xff & input[0]);
+		int rIndex = 1;			// read index of input buffer.
+		int wIndex = 0;			// write index of output buffer.
+		unsigned int bits = 0;	// bits read ahead, the next bit is the least significant one.
+		int bitCount = 0;		// number of bits read ahead.
+		unsigned int const windowMask = (1 << decodeBits) - 1;
+
+		while ( bitsAvailable > 0 ){
+
+			// Read ahead as many bytes as fit into the bit buffer.
+			while ( (bitCount <= 24) && (rIndex < inLength) ){
+				unsigned int byte = 0xff & input[rIndex++];
+				if ( !reverseBits ) byte = reverseMap[ byte ];
+				bits |= byte << bitCount;
+				bitCount += 8;
+			}
+
+			DecodeEntry const &entry = decodeTable[ bits & windowMask ];
+
+			// The last code is incomplete, stop here.
+			if ( entry.bitCount > bitsAvailable ) break;
+
+			bits >>= entry.bitCount;
+			bitCount -= entry.bitCount;
+			bitsAvailable -= entry.bitCount;
+
+			int value = entry.value;
+			if ( value < 0 ){
+				// The code is longer than the table window, walk the rest of the tree.
+				HuffmanNode * node = entry.node;
+				while ( node->branch != 0 ){
+					if ( bitsAvailable <= 0 ) return wIndex;
+					if ( bitCount <= 0 ){
+						bits = 0xff & input[rIndex++];
+						if ( !reverseBits ) bits = reverseMap[ bits ];
+						bitCount = 8;
+					}
+					node = &(node->branch[ bits & 0x01 ]);
+					bits >>= 1;
+					bitCount--;
+					bitsAvailable--;
+				}
+				value = node->value & 0xff;
+			}
+
+			// buffer overflow prevention
+			if ( wIndex >= outLength ) return wIndex;
+			output[ wIndex++ ] = (unsigned char)value;
+		}
+
 		return wIndex;
 	} // end function decode
 
@@ -301,6 +468,8 @@ namespace skulltag {
 	/** Destructor - frees resources. */
 	HuffmanCodec::~HuffmanCodec() {
 		delete writer;
+		delete[] encodeTable;
+		delete[] decodeTable;
 		//check for resource ownership before deletion
 		if ( huffmanResourceOwner() ){
 			delete[] codeTable;
@@ -325,5 +494,9 @@ namespace skulltag {
 	 * @return	 true: data expansion is allowed.  false: data is not allowed to expand. */
 	bool HuffmanCodec::allowExpansion(){ return expandable; }
 
+	/** Check whether encode() and decode() use the lookup tables.
+	 * @return	 true: both only read shared data.  false: they walk the tree through the shared BitWriter. */
+	bool HuffmanCodec::usesTables() const { return useTables; }
+
 
 }; // end namespace skulltag
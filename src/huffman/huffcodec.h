@@ -67,6 +67,31 @@ namespace skulltag {
 		/** Number of bits the shortest huffman code in the tree has. */
 		int shortestCode;	
 
+		/** Entry of the decoding lookup table, indexed by the next decodeBits bits of input. */
+		struct DecodeEntry {
+			int value;				/**< the decoded value or -1 if the code is longer than decodeBits. */
+			int bitCount;			/**< number of bits the code (or the table lookup) consumes. */
+			HuffmanNode * node;		/**< node to continue the tree walk at if value is -1. */
+		};
+
+		/** Entry of the encoding lookup table, indexed by the value to encode. */
+		struct EncodeEntry {
+			unsigned int code;		/**< the Huffman code with its bits in the order they are output. */
+			int bitCount;			/**< number of bits in the Huffman code or 0 if the value has no code. */
+		};
+
+		/** Lookup table that decodes up to decodeBits bits at once. */
+		DecodeEntry * decodeTable;
+
+		/** Number of input bits used to index decodeTable. */
+		int decodeBits;
+
+		/** Lookup table with the (bit order adjusted) Huffman code of each byte value. */
+		EncodeEntry * encodeTable;
+
+		/** When false the tree is unsuitable for the lookup tables and encode / decode walk the tree. */
+		bool useTables;
+
 	public:	
 
 		/** Creates a new HuffmanCodec from the Huffman tree data.
@@ -104,6 +129,26 @@ namespace skulltag {
 			int const &outLength				/**< in: maximum length of data to output. */
 		);
 
+		/** Encodes data like encode(), but walks the code table one code at a time through a BitWriter
+		 * instead of using the lookup tables. Produces the exact same output as encode().
+		 * @return number of bytes stored in the output buffer or -1 if an error occurs while encoding. */
+		int encodeWithTree(
+			unsigned char const * const input,	/**< in: pointer to the first byte to encode. */
+			unsigned char * const output,		/**< out: pointer to an output buffer to store data. */
+			int const &inLength,				/**< in: number of bytes of input buffer to encoded. */
+			int const &outLength				/**< in: maximum length of data to output. */
+		) const;
+
+		/** Decodes data like decode(), but walks the Huffman tree bit by bit instead of using the
+		 * lookup table. Produces the exact same output as decode().
+		 * @return number of bytes stored in the output buffer or -1 if an error occurs while decoding. */
+		int decodeWithTree(
+			unsigned char const * const input,	/**< in: pointer to data that needs decoding. */
+			unsigned char * const output,		/**< out: pointer to output buffer to store decoded data. */
+			int const &inLength,				/**< in: number of bytes of input buffer to read. */
+			int const &outLength				/**< in: maximum length of data to output. */
+		);
+
 		/** Enables or Disables backwards bit ordering of bytes.
 		 * @param backwards  "true" enables reversed bit order bytes, "false" uses standard byte bit ordering. */
 		void reversedBytes( bool backwards );
@@ -120,6 +165,10 @@ namespace skulltag {
 		 * @return	 true: data expansion is allowed.  false: data is not allowed to expand. */
 		bool allowExpansion();
 
+		/** Check whether encode() and decode() use the lookup tables.
+		 * @return	 true: both only read shared data.  false: they walk the tree through the shared BitWriter. */
+		bool usesTables() const;
+
 		/** Sets the ownership of this HuffmanCodec's resources.
 		* @param ownsResources	When false the tree will not be released upon destruction of this HuffmanCodec.
 		* 						When true deleting this HuffmanCodec will cause the Huffman tree to be released. */
@@ -176,6 +225,9 @@ namespace skulltag {
 		/** Perform initialization procedures common to all constructors. */
 		void init();
 
+		/** Builds the encoding and decoding lookup tables from the Huffman tree. */
+		void buildTables();
+
 	}; // end class Huffman Codec.
 } // end namespace skulltag
 
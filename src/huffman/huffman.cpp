@@ -89,6 +89,11 @@ void HUFFMAN_Construct(){
 	atterm( HUFFMAN_Destruct );
 }
 
+/** Returns the HuffmanCodec used by HUFFMAN_Encode and HUFFMAN_Decode. */
+HuffmanCodec * HUFFMAN_GetCodec(){
+	return __codec;
+}
+
 /** Releases resources allocated by the HuffmanCodec. */
 void HUFFMAN_Destruct(){
 	delete __codec;
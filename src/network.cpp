@@ -60,6 +60,12 @@
 #endif
 #endif
 
+// Event driven waiting for the server main loop.
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -69,6 +75,7 @@
 #include <list>
 #include "../GeoIP/GeoIP.h"
 
+#include "c_cvars.h"
 #include "c_dispatch.h"
 #include "cl_demo.h"
 #include "cl_main.h"
@@ -145,6 +152,103 @@ static	TArray<const PClass*> g_ActorNetworkIndexClassPointerMap;
 // [BB]
 static GeoIP * g_GeoIPDB = NULL;
 
+// Number of packets NETWORK_LaunchPacket collects before sending them at once.
+#define	NETWORK_SEND_BATCH_SIZE		64
+
+// A Huffman encoded packet waiting to be sent in a batch.
+typedef struct
+{
+	// [BB] HUFFMAN_Encode never expands the data by more than one byte.
+	UCHAR				abData[MAX_UDP_PACKET + 1];
+	INT					iSize;
+	struct sockaddr_in	SocketAddress;
+	NETADDRESS_s		Address;
+
+} BATCHEDPACKET_s;
+
+// Are outgoing packets collected in g_pSendBatch instead of being sent right away?
+static	bool				g_bBatchingPackets = false;
+static	BATCHEDPACKET_s		*g_pSendBatch = NULL;
+static	ULONG				g_ulNumBatchedPackets = 0;
+
+// How many batched packets we've sent and how many send calls this took.
+static	QWORD				g_qwNumBatchedPacketsSent = 0;
+static	QWORD				g_qwNumSendCalls = 0;
+
+#ifdef __linux__
+// Number of packets NETWORK_GetPackets drains from the socket with one recvmmsg call.
+#define	NETWORK_RECEIVE_BATCH_SIZE	32
+
+// Number of buckets of the receive batch size histogram (1, 2-3, 4-7, ..., 32).
+#define	NETWORK_RECEIVE_HISTOGRAM_SIZE	6
+
+// A raw packet waiting in the receive ring.
+typedef struct
+{
+	// Anything that doesn't fit into the network message buffer is ignored anyway.
+	UCHAR				abData[(MAX_UDP_PACKET * 8) / 3 + 1];
+	LONG				lSize;
+	bool				bTruncated;
+	struct sockaddr_in	SocketFrom;
+
+} RECEIVEDPACKET_s;
+
+// Packets drained from the socket, but not yet handled by NETWORK_GetPackets.
+static	RECEIVEDPACKET_s	*g_pReceiveRing = NULL;
+static	ULONG				g_ulNextReceivedPacket = 0;
+static	ULONG				g_ulNumReceivedPackets = 0;
+
+// How many packets we received per recvmmsg call.
+static	QWORD				g_aqwReceiveBatchHistogram[NETWORK_RECEIVE_HISTOGRAM_SIZE];
+static	QWORD				g_qwNumBatchedPacketsReceived = 0;
+
+// epoll instance and tic timer used by NETWORK_WaitForEvents.
+static	int				g_EpollFD = -1;
+static	int				g_TimerFD = -1;
+
+// Is stdin something epoll can't watch (e.g. a regular file)? Then it's always ready.
+static	bool			g_bStdinAlwaysReady = false;
+
+// Is stdin registered with g_EpollFD?
+static	bool			g_bStdinWatched = false;
+#endif
+
+// Number of outgoing packets the link emulator can hold back at once.
+#define	NETWORK_EMULATED_QUEUE_SIZE	1024
+
+// An outgoing, Huffman encoded packet held back by the link emulator.
+typedef struct
+{
+	UCHAR			abData[MAX_UDP_PACKET + 1];
+	ULONG			ulSize;
+	NETADDRESS_s	Address;
+
+	// Time (in ms) at which the packet is sent.
+	unsigned int	uReleaseTime;
+
+} EMULATEDPACKET_s;
+
+// Packets held back by the link emulator, in the order they are sent.
+static	EMULATEDPACKET_s	*g_pEmulatedPackets = NULL;
+static	ULONG				g_ulFirstEmulatedPacket = 0;
+static	ULONG				g_ulNumEmulatedPackets = 0;
+
+// Are the held back packets being sent right now? They must not be held back again.
+static	bool				g_bReleasingEmulatedPackets = false;
+
+// How many outgoing packets the link emulator dropped and delayed.
+static	QWORD				g_qwNumEmulatedLosses = 0;
+static	QWORD				g_qwNumEmulatedDelays = 0;
+
+//*****************************************************************************
+//	CONSOLE VARIABLES
+
+// Percentage of outgoing packets that are dropped to emulate a lossy link.
+CVAR( Float, net_emulatedloss, 0.0f, CVAR_NOSETBYACS )
+
+// Delay (in ms) that is added to all outgoing packets to emulate a slow link.
+CVAR( Int, net_emulatedlatency, 0, CVAR_NOSETBYACS )
+
 //*****************************************************************************
 //	PROTOTYPES
 
@@ -153,6 +257,14 @@ static	void			network_Error( const char *pszError );
 static	SOCKET			network_AllocateSocket( void );
 static	bool			network_BindSocketToPort( SOCKET Socket, ULONG ulInAddr, USHORT usPort, bool bReUse );
 static	bool			network_GenerateLumpMD5HashAndWarnIfNeeded( const int LumpNum, const char *LumpName, FString &MD5Hash );
+static	void			network_SendPacketBatch( void );
+static	void			network_ReportSendError( NETADDRESS_s Address );
+static	void			network_ReportReceiveError( void );
+static	bool			network_EmulateLink( const UCHAR *pucData, INT iSize, NETADDRESS_s Address );
+static	void			network_ReleaseEmulatedPackets( void );
+#ifdef __linux__
+static	bool			network_ReceivePacketBatch( void );
+#endif
 
 //*****************************************************************************
 //	FUNCTIONS
@@ -452,6 +564,21 @@ void NETWORK_Destruct( void )
 	// Free the network message buffer.
 	NETWORK_FreeBuffer( &g_NetworkMessage );
 
+	// Close the event waiting descriptors.
+	NETWORK_DestructEventWait( );
+
+	delete[] g_pSendBatch;
+	g_pSendBatch = NULL;
+
+	delete[] g_pEmulatedPackets;
+	g_pEmulatedPackets = NULL;
+	g_ulNumEmulatedPackets = 0;
+
+#ifdef __linux__
+	delete[] g_pReceiveRing;
+	g_pReceiveRing = NULL;
+#endif
+
 	// [BB] Delete the GeoIP database.
 	GeoIP_delete ( g_GeoIPDB );
 }
@@ -463,67 +590,79 @@ int NETWORK_GetPackets( void )
 	LONG				lNumBytes;
 	INT					iDecodedNumBytes = sizeof(g_ucHuffmanBuffer);
 	struct sockaddr_in	SocketFrom;
-	INT					iSocketFromLength;
-
-	iSocketFromLength = sizeof( SocketFrom );
+	UCHAR				*pbReceived;
 
 	// [BB] If the socket is invalid, there is no point in trying to use it.
 	if ( g_NetworkSocket == INVALID_SOCKET )
 		return ( 0 );
 
-#ifdef	WIN32
-	lNumBytes = recvfrom( g_NetworkSocket, (char *)g_ucHuffmanBuffer, sizeof( g_ucHuffmanBuffer ), 0, (struct sockaddr *)&SocketFrom, &iSocketFromLength );
-#else
-	lNumBytes = recvfrom( g_NetworkSocket, (char *)g_ucHuffmanBuffer, sizeof( g_ucHuffmanBuffer ), 0, (struct sockaddr *)&SocketFrom, (socklen_t *)&iSocketFromLength );
-#endif
+	// Send the packets the link emulator held back long enough.
+	network_ReleaseEmulatedPackets( );
 
-	// If the number of bytes returned is -1, an error has occured.
-	if ( lNumBytes == -1 ) 
-	{ 
-#ifdef __WIN32__
-		errno = WSAGetLastError( );
-
-		if ( errno == WSAEWOULDBLOCK )
-			return ( false );
+	// Skip over packets we can't use. Returning 0 for them would make the caller think
+	// there is nothing left, and leave the good packets behind them waiting.
+	for ( ;; )
+	{
+#ifdef __linux__
+		// Take the next packet from the receive ring. If we handled all of them, drain
+		// the socket again.
+		if ( g_ulNextReceivedPacket == g_ulNumReceivedPackets )
+		{
+			if ( network_ReceivePacketBatch( ) == false )
+				return ( 0 );
+		}
 
-		// Connection reset by peer. Doesn't mean anything to the server.
-		if ( errno == WSAECONNRESET )
-			return ( false );
+		RECEIVEDPACKET_s *pPacket = &g_pReceiveRing[g_ulNextReceivedPacket++];
+		pbReceived = pPacket->abData;
+		lNumBytes = pPacket->lSize;
+		SocketFrom = pPacket->SocketFrom;
 
-		if ( errno == WSAEMSGSIZE )
+		// The packet didn't fit into the ring slot. Such a packet would be ignored anyway.
+		if ( pPacket->bTruncated )
 		{
-			Printf( "NETWORK_GetPackets:  WARNING! Oversize packet from %s\n", NETWORK_AddressToString( g_AddressFrom ));
-			return ( false );
+			if ( NETWORK_GetState( ) == NETSTATE_SERVER )
+				SERVER_STATISTIC_AddToInboundDataTransfer( lNumBytes );
+			continue;
 		}
+#else
+		INT					iSocketFromLength;
 
-		Printf( "NETWORK_GetPackets: WARNING!: Error #%d: %s\n", errno, strerror( errno ));
-		return ( false );
+		iSocketFromLength = sizeof( SocketFrom );
+		pbReceived = g_ucHuffmanBuffer;
+
+#ifdef	WIN32
+		lNumBytes = recvfrom( g_NetworkSocket, (char *)g_ucHuffmanBuffer, sizeof( g_ucHuffmanBuffer ), 0, (struct sockaddr *)&SocketFrom, &iSocketFromLength );
 #else
-		if ( errno == EWOULDBLOCK )
-			return ( false );
+		lNumBytes = recvfrom( g_NetworkSocket, (char *)g_ucHuffmanBuffer, sizeof( g_ucHuffmanBuffer ), 0, (struct sockaddr *)&SocketFrom, (socklen_t *)&iSocketFromLength );
+#endif
 
-		if ( errno == ECONNREFUSED )
+		// If the number of bytes returned is -1, an error has occured.
+		if ( lNumBytes == -1 ) 
+		{ 
+			network_ReportReceiveError( );
 			return ( false );
-
-		Printf( "NETWORK_GetPackets: WARNING!: Error #%d: %s\n", errno, strerror( errno ));
-		return ( false );
+		}
 #endif
-	}
 
-	// No packets or an error, so don't process anything.
-	if ( lNumBytes <= 0 )
-		return ( 0 );
+		// An empty datagram, there's nothing to process.
+		if ( lNumBytes <= 0 )
+			continue;
 
-	// Record this for our statistics window.
-	if ( NETWORK_GetState( ) == NETSTATE_SERVER )
-		SERVER_STATISTIC_AddToInboundDataTransfer( lNumBytes );
+		// Record this for our statistics window.
+		if ( NETWORK_GetState( ) == NETSTATE_SERVER )
+			SERVER_STATISTIC_AddToInboundDataTransfer( lNumBytes );
 
-	// If the number of bytes we're receiving exceeds our buffer size, ignore the packet.
-	if ( lNumBytes >= static_cast<LONG>(g_NetworkMessage.ulMaxSize) )
-		return ( 0 );
+		// If the number of bytes we're receiving exceeds our buffer size, ignore the packet.
+		if ( lNumBytes >= static_cast<LONG>(g_NetworkMessage.ulMaxSize) )
+			continue;
+
+		// Decode the huffman-encoded message we received. Nothing comes out if it's garbage.
+		iDecodedNumBytes = sizeof(g_ucHuffmanBuffer);
+		HUFFMAN_Decode( pbReceived, (unsigned char *)g_NetworkMessage.pbData, lNumBytes, &iDecodedNumBytes );
+		if ( iDecodedNumBytes > 0 )
+			break;
+	}
 
-	// Decode the huffman-encoded message we received.
-	HUFFMAN_Decode( g_ucHuffmanBuffer, (unsigned char *)g_NetworkMessage.pbData, lNumBytes, &iDecodedNumBytes );
 	g_NetworkMessage.ulCurrentSize = iDecodedNumBytes;
 	g_NetworkMessage.ByteStream.pbStream = g_NetworkMessage.pbData;
 	g_NetworkMessage.ByteStream.pbStreamEnd = g_NetworkMessage.ByteStream.pbStream + g_NetworkMessage.ulCurrentSize;
@@ -534,6 +673,95 @@ int NETWORK_GetPackets( void )
 	return ( g_NetworkMessage.ulCurrentSize );
 }
 
+//*****************************************************************************
+//
+#ifdef __linux__
+static bool network_ReceivePacketBatch( void )
+{
+	struct mmsghdr	aMessages[NETWORK_RECEIVE_BATCH_SIZE];
+	struct iovec	aIOVecs[NETWORK_RECEIVE_BATCH_SIZE];
+	LONG			lNumPackets;
+	ULONG			ulIdx;
+	ULONG			ulBucket;
+
+	if ( g_pReceiveRing == NULL )
+		g_pReceiveRing = new RECEIVEDPACKET_s[NETWORK_RECEIVE_BATCH_SIZE];
+
+	g_ulNextReceivedPacket = 0;
+	g_ulNumReceivedPackets = 0;
+
+	memset( aMessages, 0, sizeof( aMessages ));
+	for ( ulIdx = 0; ulIdx < NETWORK_RECEIVE_BATCH_SIZE; ulIdx++ )
+	{
+		aIOVecs[ulIdx].iov_base = g_pReceiveRing[ulIdx].abData;
+		aIOVecs[ulIdx].iov_len = sizeof( g_pReceiveRing[ulIdx].abData );
+		aMessages[ulIdx].msg_hdr.msg_name = &g_pReceiveRing[ulIdx].SocketFrom;
+		aMessages[ulIdx].msg_hdr.msg_namelen = sizeof( g_pReceiveRing[ulIdx].SocketFrom );
+		aMessages[ulIdx].msg_hdr.msg_iov = &aIOVecs[ulIdx];
+		aMessages[ulIdx].msg_hdr.msg_iovlen = 1;
+	}
+
+	lNumPackets = recvmmsg( g_NetworkSocket, aMessages, NETWORK_RECEIVE_BATCH_SIZE, MSG_DONTWAIT, NULL );
+
+	// If the number of packets returned is -1, an error has occured.
+	if ( lNumPackets == -1 )
+	{
+		network_ReportReceiveError( );
+		return ( false );
+	}
+
+	if ( lNumPackets <= 0 )
+		return ( false );
+
+	for ( ulIdx = 0; ulIdx < static_cast<ULONG>( lNumPackets ); ulIdx++ )
+	{
+		g_pReceiveRing[ulIdx].lSize = aMessages[ulIdx].msg_len;
+		g_pReceiveRing[ulIdx].bTruncated = !!( aMessages[ulIdx].msg_hdr.msg_flags & MSG_TRUNC );
+	}
+	g_ulNumReceivedPackets = lNumPackets;
+
+	// Sort the batch size into the histogram: 1, 2-3, 4-7, ...
+	for ( ulBucket = 0; ( 2UL << ulBucket ) <= g_ulNumReceivedPackets; ulBucket++ )
+		;
+	g_aqwReceiveBatchHistogram[ulBucket]++;
+	g_qwNumBatchedPacketsReceived += g_ulNumReceivedPackets;
+
+	return ( true );
+}
+#endif
+
+//*****************************************************************************
+//
+static void network_ReportReceiveError( void )
+{
+#ifdef __WIN32__
+	errno = WSAGetLastError( );
+
+	if ( errno == WSAEWOULDBLOCK )
+		return;
+
+	// Connection reset by peer. Doesn't mean anything to the server.
+	if ( errno == WSAECONNRESET )
+		return;
+
+	if ( errno == WSAEMSGSIZE )
+	{
+		Printf( "NETWORK_GetPackets:  WARNING! Oversize packet from %s\n", NETWORK_AddressToString( g_AddressFrom ));
+		return;
+	}
+
+	Printf( "NETWORK_GetPackets: WARNING!: Error #%d: %s\n", errno, strerror( errno ));
+#else
+	if ( errno == EWOULDBLOCK )
+		return;
+
+	if ( errno == ECONNREFUSED )
+		return;
+
+	Printf( "NETWORK_GetPackets: WARNING!: Error #%d: %s\n", errno, strerror( errno ));
+#endif
+}
+
 //*****************************************************************************
 //
 int NETWORK_GetLANPackets( void )
@@ -623,68 +851,294 @@ NETADDRESS_s NETWORK_GetFromAddress( void )
 //
 void NETWORK_LaunchPacket( NETBUFFER_s *pBuffer, NETADDRESS_s Address )
 {
-	LONG				lNumBytes;
-	INT					iNumBytesOut = sizeof(g_ucHuffmanBuffer);
-	struct sockaddr_in	SocketAddress;
+	UCHAR	*pucEncoded = g_ucHuffmanBuffer;
+	INT		iNumBytesOut = sizeof( g_ucHuffmanBuffer );
+
+	// If we are collecting packets, encode this one right into the next free batch slot.
+	if ( g_bBatchingPackets )
+	{
+		pucEncoded = g_pSendBatch[g_ulNumBatchedPackets].abData;
+		iNumBytesOut = sizeof( g_pSendBatch[g_ulNumBatchedPackets].abData );
+	}
+
+	iNumBytesOut = NETWORK_EncodePacket( pBuffer, pucEncoded, iNumBytesOut );
+	NETWORK_LaunchEncodedPacket( pucEncoded, iNumBytesOut, Address );
+}
+
+//*****************************************************************************
+//
+// Only touches the given buffers and, if the Huffman codec uses its lookup tables, the
+// tables, so it may be called from several threads at once then (see sendworkers_Start).
+// Returns the size of the encoded packet, or 0 if there is nothing to send or the
+// output buffer is too small.
+INT NETWORK_EncodePacket( NETBUFFER_s *pBuffer, UCHAR *pucOutput, INT iMaxSize )
+{
+	INT		iNumBytesOut = iMaxSize;
 
 	pBuffer->ulCurrentSize = NETWORK_CalcBufferSize( pBuffer );
 
 	// Nothing to do.
 	if ( pBuffer->ulCurrentSize == 0 )
+		return ( 0 );
+
+	HUFFMAN_Encode( (unsigned char *)pBuffer->pbData, pucOutput, pBuffer->ulCurrentSize, &iNumBytesOut );
+	return ( iNumBytesOut );
+}
+
+//*****************************************************************************
+//
+void NETWORK_LaunchEncodedPacket( const UCHAR *pucData, INT iSize, NETADDRESS_s Address )
+{
+	LONG				lNumBytes;
+	struct sockaddr_in	SocketAddress;
+
+	// Nothing to do.
+	if ( iSize <= 0 )
+		return;
+
+	// The link emulator may drop the packet or send it later.
+	if ( network_EmulateLink( pucData, iSize, Address ))
 		return;
 
 	// Convert the IP address to a socket address.
 	NETWORK_NetAddressToSocketAddress( Address, SocketAddress );
 
-	HUFFMAN_Encode( (unsigned char *)pBuffer->pbData, g_ucHuffmanBuffer, pBuffer->ulCurrentSize, &iNumBytesOut );
+	// If we are collecting packets, put this one into the next free batch slot.
+	// It's sent together with the others in network_SendPacketBatch.
+	if ( g_bBatchingPackets )
+	{
+		BATCHEDPACKET_s	*pPacket = &g_pSendBatch[g_ulNumBatchedPackets];
+
+		if ( static_cast<size_t>( iSize ) <= sizeof( pPacket->abData ))
+		{
+			if ( pucData != pPacket->abData )
+				memcpy( pPacket->abData, pucData, iSize );
+
+			pPacket->iSize = iSize;
+			pPacket->SocketAddress = SocketAddress;
+			pPacket->Address = Address;
+
+			if ( ++g_ulNumBatchedPackets == NETWORK_SEND_BATCH_SIZE )
+				network_SendPacketBatch( );
+			return;
+		}
+
+		// Too big for a batch slot. Keep the order and send it on its own.
+		network_SendPacketBatch( );
+	}
 
-	lNumBytes = sendto( g_NetworkSocket, (const char*)g_ucHuffmanBuffer, iNumBytesOut, 0, (struct sockaddr *)&SocketAddress, sizeof( SocketAddress ));
+	lNumBytes = sendto( g_NetworkSocket, (const char*)pucData, iSize, 0, (struct sockaddr *)&SocketAddress, sizeof( SocketAddress ));
 
 	// If sendto returns -1, there was an error.
 	if ( lNumBytes == -1 )
 	{
-#ifdef __WIN32__
-		INT	iError = WSAGetLastError( );
+		network_ReportSendError( Address );
+		return;
+	}
 
-		// Wouldblock is silent.
-		if ( iError == WSAEWOULDBLOCK )
-			return;
+	// Record this for our statistics window.
+	if ( NETWORK_GetState( ) == NETSTATE_SERVER )
+		SERVER_STATISTIC_AddToOutboundDataTransfer( lNumBytes );
+}
 
-		switch ( iError )
-		{
-		case WSAEACCES:
+//*****************************************************************************
+//
+void NETWORK_BeginPacketBatch( void )
+{
+	// [BB] If the socket is invalid, there is no point in trying to use it.
+	if ( g_NetworkSocket == INVALID_SOCKET )
+		return;
 
-			Printf( "NETWORK_LaunchPacket: Error #%d, WSAEACCES: Permission denied for address: %s\n", iError, NETWORK_AddressToString( Address ));
-			return;
-		case WSAEADDRNOTAVAIL:
+	if ( g_pSendBatch == NULL )
+		g_pSendBatch = new BATCHEDPACKET_s[NETWORK_SEND_BATCH_SIZE];
 
-			Printf( "NETWORK_LaunchPacket: Error #%d, WSAEADDRENOTAVAIL: Address %s not available\n", iError, NETWORK_AddressToString( Address ));
-			return;
-		case WSAEHOSTUNREACH:
+	g_bBatchingPackets = true;
+}
 
-			Printf( "NETWORK_LaunchPacket: Error #%d, WSAEHOSTUNREACH: Address %s unreachable\n", iError, NETWORK_AddressToString( Address ));
-			return;				
-		default:
+//*****************************************************************************
+//
+void NETWORK_EndPacketBatch( void )
+{
+	if ( g_bBatchingPackets == false )
+		return;
 
-			Printf( "NETWORK_LaunchPacket: Error #%d\n", iError );
-			return;
+	network_SendPacketBatch( );
+	g_bBatchingPackets = false;
+}
+
+//*****************************************************************************
+//
+static void network_SendPacketBatch( void )
+{
+	ULONG	ulIdx;
+
+	if ( g_ulNumBatchedPackets == 0 )
+		return;
+
+#ifdef __linux__
+	struct mmsghdr	aMessages[NETWORK_SEND_BATCH_SIZE];
+	struct iovec	aIOVecs[NETWORK_SEND_BATCH_SIZE];
+	LONG			lResult;
+
+	memset( aMessages, 0, sizeof( aMessages[0] ) * g_ulNumBatchedPackets );
+	for ( ulIdx = 0; ulIdx < g_ulNumBatchedPackets; ulIdx++ )
+	{
+		aIOVecs[ulIdx].iov_base = g_pSendBatch[ulIdx].abData;
+		aIOVecs[ulIdx].iov_len = g_pSendBatch[ulIdx].iSize;
+		aMessages[ulIdx].msg_hdr.msg_name = &g_pSendBatch[ulIdx].SocketAddress;
+		aMessages[ulIdx].msg_hdr.msg_namelen = sizeof( g_pSendBatch[ulIdx].SocketAddress );
+		aMessages[ulIdx].msg_hdr.msg_iov = &aIOVecs[ulIdx];
+		aMessages[ulIdx].msg_hdr.msg_iovlen = 1;
+	}
+
+	ulIdx = 0;
+	while ( ulIdx < g_ulNumBatchedPackets )
+	{
+		lResult = sendmmsg( g_NetworkSocket, &aMessages[ulIdx], g_ulNumBatchedPackets - ulIdx, 0 );
+		g_qwNumSendCalls++;
+
+		// sendmmsg only fails if the very first message couldn't be sent. Drop that one,
+		// just like sendto would, and continue with the rest.
+		if ( lResult == -1 )
+		{
+			network_ReportSendError( g_pSendBatch[ulIdx].Address );
+			ulIdx++;
+			continue;
 		}
-#else
-	if ( errno == EWOULDBLOCK )
-return;
 
-          if ( errno == ECONNREFUSED )
-              return;
+		for ( LONG lSent = 0; lSent < lResult; lSent++, ulIdx++ )
+		{
+			// Record this for our statistics window.
+			if ( NETWORK_GetState( ) == NETSTATE_SERVER )
+				SERVER_STATISTIC_AddToOutboundDataTransfer( aMessages[ulIdx].msg_len );
+		}
+	}
+#else
+	for ( ulIdx = 0; ulIdx < g_ulNumBatchedPackets; ulIdx++ )
+	{
+		LONG lNumBytes = sendto( g_NetworkSocket, (const char*)g_pSendBatch[ulIdx].abData, g_pSendBatch[ulIdx].iSize, 0, (struct sockaddr *)&g_pSendBatch[ulIdx].SocketAddress, sizeof( g_pSendBatch[ulIdx].SocketAddress ));
+		g_qwNumSendCalls++;
 
-		Printf( "NETWORK_LaunchPacket: %s\n", strerror( errno ));
-		Printf( "NETWORK_LaunchPacket: Address %s\n", NETWORK_AddressToString( Address ));
+		if ( lNumBytes == -1 )
+		{
+			network_ReportSendError( g_pSendBatch[ulIdx].Address );
+			continue;
+		}
 
+		// Record this for our statistics window.
+		if ( NETWORK_GetState( ) == NETSTATE_SERVER )
+			SERVER_STATISTIC_AddToOutboundDataTransfer( lNumBytes );
+	}
 #endif
+
+	g_qwNumBatchedPacketsSent += g_ulNumBatchedPackets;
+	g_ulNumBatchedPackets = 0;
+}
+
+//*****************************************************************************
+//
+// Returns true if the packet was dropped or held back and must not be sent now.
+static bool network_EmulateLink( const UCHAR *pucData, INT iSize, NETADDRESS_s Address )
+{
+	if ( g_bReleasingEmulatedPackets )
+		return ( false );
+
+	if (( net_emulatedloss > 0 ) && ( M_Random( 10000 ) < net_emulatedloss * 100 ))
+	{
+		g_qwNumEmulatedLosses++;
+		return ( true );
 	}
 
-	// Record this for our statistics window.
-	if ( NETWORK_GetState( ) == NETSTATE_SERVER )
-		SERVER_STATISTIC_AddToOutboundDataTransfer( lNumBytes );
+	if ( net_emulatedlatency <= 0 )
+		return ( false );
+
+	// If the queue is full, the emulated link is congested and loses the packet.
+	if (( g_ulNumEmulatedPackets == NETWORK_EMULATED_QUEUE_SIZE ) || ( static_cast<size_t>( iSize ) > sizeof( g_pEmulatedPackets->abData )))
+	{
+		g_qwNumEmulatedLosses++;
+		return ( true );
+	}
+
+	if ( g_pEmulatedPackets == NULL )
+		g_pEmulatedPackets = new EMULATEDPACKET_s[NETWORK_EMULATED_QUEUE_SIZE];
+
+	EMULATEDPACKET_s *pPacket = &g_pEmulatedPackets[( g_ulFirstEmulatedPacket + g_ulNumEmulatedPackets ) % NETWORK_EMULATED_QUEUE_SIZE];
+	memcpy( pPacket->abData, pucData, iSize );
+	pPacket->ulSize = iSize;
+	pPacket->Address = Address;
+	pPacket->uReleaseTime = I_MSTime( ) + net_emulatedlatency;
+	g_ulNumEmulatedPackets++;
+	g_qwNumEmulatedDelays++;
+
+	return ( true );
+}
+
+//*****************************************************************************
+//
+static void network_ReleaseEmulatedPackets( void )
+{
+	if ( g_ulNumEmulatedPackets == 0 )
+		return;
+
+	const unsigned int uNow = I_MSTime( );
+
+	g_bReleasingEmulatedPackets = true;
+	while ( g_ulNumEmulatedPackets > 0 )
+	{
+		EMULATEDPACKET_s *pPacket = &g_pEmulatedPackets[g_ulFirstEmulatedPacket];
+
+		// All packets are delayed equally, so the later ones aren't due either.
+		if ( static_cast<int>( uNow - pPacket->uReleaseTime ) < 0 )
+			break;
+
+		NETWORK_LaunchEncodedPacket( pPacket->abData, pPacket->ulSize, pPacket->Address );
+
+		g_ulFirstEmulatedPacket = ( g_ulFirstEmulatedPacket + 1 ) % NETWORK_EMULATED_QUEUE_SIZE;
+		g_ulNumEmulatedPackets--;
+	}
+	g_bReleasingEmulatedPackets = false;
+}
+
+//*****************************************************************************
+//
+static void network_ReportSendError( NETADDRESS_s Address )
+{
+#ifdef __WIN32__
+	INT	iError = WSAGetLastError( );
+
+	// Wouldblock is silent.
+	if ( iError == WSAEWOULDBLOCK )
+		return;
+
+	switch ( iError )
+	{
+	case WSAEACCES:
+
+		Printf( "NETWORK_LaunchPacket: Error #%d, WSAEACCES: Permission denied for address: %s\n", iError, NETWORK_AddressToString( Address ));
+		return;
+	case WSAEADDRNOTAVAIL:
+
+		Printf( "NETWORK_LaunchPacket: Error #%d, WSAEADDRENOTAVAIL: Address %s not available\n", iError, NETWORK_AddressToString( Address ));
+		return;
+	case WSAEHOSTUNREACH:
+
+		Printf( "NETWORK_LaunchPacket: Error #%d, WSAEHOSTUNREACH: Address %s unreachable\n", iError, NETWORK_AddressToString( Address ));
+		return;				
+	default:
+
+		Printf( "NETWORK_LaunchPacket: Error #%d\n", iError );
+		return;
+	}
+#else
+	if ( errno == EWOULDBLOCK )
+		return;
+
+	if ( errno == ECONNREFUSED )
+		return;
+
+	Printf( "NETWORK_LaunchPacket: %s\n", strerror( errno ));
+	Printf( "NETWORK_LaunchPacket: Address %s\n", NETWORK_AddressToString( Address ));
+#endif
 }
 
 //*****************************************************************************
@@ -1317,6 +1771,185 @@ void I_DoSelect (void)
 #endif
 } 
 
+//*****************************************************************************
+//
+bool NETWORK_InitEventWait( void )
+{
+#ifdef __linux__
+	struct epoll_event	Event;
+
+	// Already set up.
+	if ( g_EpollFD != -1 )
+		return ( true );
+
+	// [BB] If the socket is invalid, there is nothing to wait for.
+	if ( g_NetworkSocket == INVALID_SOCKET )
+		return ( false );
+
+	g_EpollFD = epoll_create( 4 );
+	if ( g_EpollFD == -1 )
+	{
+		Printf( "NETWORK_InitEventWait: epoll_create: %s\n", strerror( errno ));
+		return ( false );
+	}
+
+	g_TimerFD = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK );
+	if ( g_TimerFD == -1 )
+	{
+		Printf( "NETWORK_InitEventWait: timerfd_create: %s\n", strerror( errno ));
+		NETWORK_DestructEventWait( );
+		return ( false );
+	}
+
+	memset( &Event, 0, sizeof( Event ));
+	Event.events = EPOLLIN;
+
+	Event.data.fd = g_NetworkSocket;
+	if ( epoll_ctl( g_EpollFD, EPOLL_CTL_ADD, g_NetworkSocket, &Event ) == -1 )
+	{
+		Printf( "NETWORK_InitEventWait: epoll_ctl: %s\n", strerror( errno ));
+		NETWORK_DestructEventWait( );
+		return ( false );
+	}
+
+	Event.data.fd = g_TimerFD;
+	if ( epoll_ctl( g_EpollFD, EPOLL_CTL_ADD, g_TimerFD, &Event ) == -1 )
+	{
+		Printf( "NETWORK_InitEventWait: epoll_ctl: %s\n", strerror( errno ));
+		NETWORK_DestructEventWait( );
+		return ( false );
+	}
+
+	// The console input is optional. epoll refuses regular files, select considers them
+	// always readable, so emulate that.
+	g_bStdinAlwaysReady = false;
+	g_bStdinWatched = false;
+	if ( do_stdin )
+	{
+		Event.data.fd = 0;
+		if ( epoll_ctl( g_EpollFD, EPOLL_CTL_ADD, 0, &Event ) == -1 )
+			g_bStdinAlwaysReady = ( errno == EPERM );
+		else
+			g_bStdinWatched = true;
+	}
+
+	return ( true );
+#else
+	return ( false );
+#endif
+}
+
+//*****************************************************************************
+//
+void NETWORK_DestructEventWait( void )
+{
+#ifdef __linux__
+	if ( g_TimerFD != -1 )
+	{
+		close( g_TimerFD );
+		g_TimerFD = -1;
+	}
+
+	if ( g_EpollFD != -1 )
+	{
+		close( g_EpollFD );
+		g_EpollFD = -1;
+	}
+
+	g_bStdinWatched = false;
+#endif
+}
+
+//*****************************************************************************
+//
+bool NETWORK_IsEventWaitActive( void )
+{
+#ifdef __linux__
+	return ( g_EpollFD != -1 );
+#else
+	return ( false );
+#endif
+}
+
+//*****************************************************************************
+//
+#ifdef __linux__
+static void NETWORK_StopWatchingStdin( void )
+{
+	epoll_ctl( g_EpollFD, EPOLL_CTL_DEL, 0, NULL );
+	g_bStdinWatched = false;
+	Printf( "Console input closed, no longer reading it.\n" );
+}
+#endif
+
+//*****************************************************************************
+//
+// Blocks until a packet arrives, the console has input or ulTimeoutUS microseconds
+// have passed. Returns a combination of the NETEVENT_* flags. NETWORK_InitEventWait
+// must have succeeded before this is called.
+ULONG NETWORK_WaitForEvents( ULONG ulTimeoutUS )
+{
+	ULONG	ulEvents = 0;
+
+#ifdef __linux__
+	struct itimerspec	Timer;
+	struct epoll_event	aEvents[3];
+	LONG				lNumEvents;
+	uint64_t			ullExpirations;
+
+	// Arm the timer. A zero value would disarm it instead.
+	memset( &Timer, 0, sizeof( Timer ));
+	Timer.it_value.tv_sec = ulTimeoutUS / 1000000;
+	Timer.it_value.tv_nsec = ( ulTimeoutUS % 1000000 ) * 1000;
+	if ( ulTimeoutUS == 0 )
+		Timer.it_value.tv_nsec = 1;
+	timerfd_settime( g_TimerFD, 0, &Timer, NULL );
+
+	// I_ConsoleInput clears do_stdin when it reads end of file. stdin would stay readable
+	// forever then, so stop watching it.
+	if ( g_bStdinWatched && ( do_stdin == false ))
+		NETWORK_StopWatchingStdin( );
+
+	lNumEvents = epoll_wait( g_EpollFD, aEvents, countof( aEvents ), -1 );
+
+	// Interrupted by a signal. The caller has to check the time anyway, so just return.
+	if ( lNumEvents == -1 )
+		return ( 0 );
+
+	for ( LONG lIdx = 0; lIdx < lNumEvents; lIdx++ )
+	{
+		if ( aEvents[lIdx].data.fd == g_NetworkSocket )
+			ulEvents |= NETEVENT_PACKETS;
+		else if ( aEvents[lIdx].data.fd == g_TimerFD )
+		{
+			// Acknowledge the expiration so that the descriptor isn't readable anymore.
+			if ( read( g_TimerFD, &ullExpirations, sizeof( ullExpirations )) == sizeof( ullExpirations ))
+				ulEvents |= NETEVENT_TIMER;
+		}
+		else if ( aEvents[lIdx].data.fd == 0 )
+		{
+			// The other end hung up or broke, there is nothing left to read. If there
+			// is still input, read it first, I_ConsoleInput notices the end of file then.
+			if (( aEvents[lIdx].events & EPOLLERR ) ||
+				(( aEvents[lIdx].events & ( EPOLLHUP|EPOLLIN )) == EPOLLHUP ))
+			{
+				do_stdin = 0;
+				NETWORK_StopWatchingStdin( );
+				continue;
+			}
+
+			stdin_ready = 1;
+			ulEvents |= NETEVENT_CONSOLE;
+		}
+	}
+
+	if ( g_bStdinAlwaysReady && do_stdin )
+		stdin_ready = 1;
+#endif
+
+	return ( ulEvents );
+}
+
 //*****************************************************************************
 // [BB] Let Skulltag's existing code use ZDoom's MD5 code.
 void CMD5Checksum::GetMD5(const BYTE* pBuf, UINT nLength, FString &OutString)
@@ -1380,6 +2013,39 @@ CCMD( netstate )
 	}
 }
 
+//*****************************************************************************
+//
+CCMD( netemulatorstats )
+{
+	Printf( "Emulated loss: %.1f%%, latency: %d ms\n", static_cast<float>( net_emulatedloss ), static_cast<int>( net_emulatedlatency ));
+	Printf( "Packets dropped: %llu\n", static_cast<unsigned long long>( g_qwNumEmulatedLosses ));
+	Printf( "Packets delayed: %llu (%lu waiting)\n", static_cast<unsigned long long>( g_qwNumEmulatedDelays ), g_ulNumEmulatedPackets );
+}
+
+//*****************************************************************************
+//
+CCMD( netbatchstats )
+{
+	Printf( "Batched packets sent: %llu\n", static_cast<unsigned long long>( g_qwNumBatchedPacketsSent ));
+	Printf( "Send calls needed: %llu\n", static_cast<unsigned long long>( g_qwNumSendCalls ));
+	Printf( "Send calls saved: %llu\n", static_cast<unsigned long long>( g_qwNumBatchedPacketsSent - g_qwNumSendCalls ));
+
+#ifdef __linux__
+	Printf( "Batched packets received: %llu\n", static_cast<unsigned long long>( g_qwNumBatchedPacketsReceived ));
+	Printf( "Receive batch sizes:\n" );
+	for ( ULONG ulBucket = 0; ulBucket < NETWORK_RECEIVE_HISTOGRAM_SIZE; ulBucket++ )
+	{
+		const ULONG ulMin = 1 << ulBucket;
+		const ULONG ulMax = MIN<ULONG>(( 2 << ulBucket ) - 1, NETWORK_RECEIVE_BATCH_SIZE );
+
+		if ( ulMin == ulMax )
+			Printf( "  %2lu:    %llu\n", ulMin, static_cast<unsigned long long>( g_aqwReceiveBatchHistogram[ulBucket] ));
+		else
+			Printf( "  %2lu-%2lu: %llu\n", ulMin, ulMax, static_cast<unsigned long long>( g_aqwReceiveBatchHistogram[ulBucket] ));
+	}
+#endif
+}
+
 #ifdef	_DEBUG
 // DEBUG FUNCTION!
 void NETWORK_FillBufferWithShit( BYTESTREAM_s *pByteStream, ULONG ulSize )
@@ -89,6 +89,27 @@ enum
 	PLAYER_ALTATTACK	= 1 << 2,
 };
 
+// Fields present in a SVC2_MOVEPLAYERDELTA message that is encoded against an earlier
+// snapshot. Fields that didn't change are not sent.
+enum
+{
+	MOVEDELTA_X			= 1 << 0,
+	MOVEDELTA_Y			= 1 << 1,
+	MOVEDELTA_Z			= 1 << 2,
+	MOVEDELTA_ANGLE		= 1 << 3,
+	MOVEDELTA_MOMX		= 1 << 4,
+	MOVEDELTA_MOMY		= 1 << 5,
+	MOVEDELTA_MOMZ		= 1 << 6,
+	MOVEDELTA_CROUCHING	= 1 << 7,
+};
+
+// The X/Y deltas are sent as 24 bit fixed point numbers, so they are exact as long as
+// the player moved less than 128 map units. Otherwise the full state is sent.
+#define	MOVEDELTA_XY_LIMIT		( 1 << 23 )
+
+// The base age is sent in the upper bits of the MovePlayer flags byte.
+#define	MOVEDELTA_AGE_SHIFT		4
+
 /* [BB] This is not used anywhere anymore.
 // Should we use huffman compression?
 #define	USE_HUFFMAN_COMPRESSION
@@ -311,6 +332,7 @@ enum
 	CLC_MORPHEX,
 	CLC_FULLUPDATE,
 	CLC_LINETARGET,
+	CLC_ACKMOVESNAPSHOT,
 
 	NUM_CLIENT_COMMANDS
 
@@ -332,6 +354,10 @@ int				NETWORK_GetPackets( void );
 int				NETWORK_GetLANPackets( void );
 NETADDRESS_s	NETWORK_GetFromAddress( void );
 void			NETWORK_LaunchPacket( NETBUFFER_s *pBuffer, NETADDRESS_s Address );
+INT				NETWORK_EncodePacket( NETBUFFER_s *pBuffer, UCHAR *pucOutput, INT iMaxSize );
+void			NETWORK_LaunchEncodedPacket( const UCHAR *pucData, INT iSize, NETADDRESS_s Address );
+void			NETWORK_BeginPacketBatch( void );
+void			NETWORK_EndPacketBatch( void );
 const char		*NETWORK_AddressToString( NETADDRESS_s Address );
 const char		*NETWORK_AddressToStringIgnorePort( NETADDRESS_s Address );
 void			NETWORK_SetAddressPort( NETADDRESS_s &Address, USHORT usPort );
@@ -388,6 +414,19 @@ void			NETWORK_SetState( LONG lState );
 
 void			I_DoSelect( void );
 
+// Event driven waiting for the server main loop (only available under Linux).
+enum
+{
+	NETEVENT_PACKETS	= 1 << 0,
+	NETEVENT_TIMER		= 1 << 1,
+	NETEVENT_CONSOLE	= 1 << 2,
+};
+
+bool			NETWORK_InitEventWait( void );
+void			NETWORK_DestructEventWait( void );
+bool			NETWORK_IsEventWaitActive( void );
+ULONG			NETWORK_WaitForEvents( ULONG ulTimeoutUS );
+
 // DEBUG FUNCTION!
 #ifdef	_DEBUG
 void	NETWORK_FillBufferWithShit( NETBUFFER_s *pBuffer, ULONG ulSize );
@@ -65,6 +65,19 @@ struct ltstr
 std::map<const char*, int, ltstr> g_actorTrafficMap;
 std::map<int, int> g_ACSScriptTrafficMap;
 
+// Traffic caused by player movement updates, split into updates sent in full and
+// updates encoded against an earlier snapshot.
+static QWORD g_qwNumFullMovePlayer = 0;
+static QWORD g_qwFullMovePlayerBytes = 0;
+static QWORD g_qwNumDeltaMovePlayer = 0;
+static QWORD g_qwDeltaMovePlayerBytes = 0;
+static SQWORD g_sqwMovePlayerBytesSaved = 0;
+
+// Position updates each client did not get because the actor was irrelevant to it,
+// and what it cost to resync those actors later.
+static QWORD g_qwRelevanceSkippedBytes[MAXPLAYERS];
+static QWORD g_qwRelevanceResyncBytes[MAXPLAYERS];
+
 CVAR( Bool, sv_measureoutboundtraffic, false, 0 )
 
 //*****************************************************************************
@@ -93,12 +106,55 @@ void NETTRAFFIC_AddACSScriptTraffic ( const int ScriptNum, const int BytesUsed )
 	g_ACSScriptTrafficMap [ ScriptNum ] += BytesUsed;
 }
 
+//*****************************************************************************
+//
+void NETTRAFFIC_AddMovePlayerTraffic ( const bool bDelta, const int BytesUsed, const int BytesWithoutDelta )
+{
+	if ( ( NETWORK_GetState( ) != NETSTATE_SERVER ) || ( sv_measureoutboundtraffic == false ) )
+		return;
+
+	if ( bDelta )
+	{
+		g_qwNumDeltaMovePlayer++;
+		g_qwDeltaMovePlayerBytes += BytesUsed;
+	}
+	else
+	{
+		g_qwNumFullMovePlayer++;
+		g_qwFullMovePlayerBytes += BytesUsed;
+	}
+	g_sqwMovePlayerBytesSaved += BytesWithoutDelta - BytesUsed;
+}
+
+//*****************************************************************************
+//
+void NETTRAFFIC_AddRelevanceTraffic ( const ULONG ulClient, const bool bSkipped, const int Bytes )
+{
+	if ( ulClient >= MAXPLAYERS )
+		return;
+
+	if ( ( NETWORK_GetState( ) != NETSTATE_SERVER ) || ( sv_measureoutboundtraffic == false ) )
+		return;
+
+	if ( bSkipped )
+		g_qwRelevanceSkippedBytes[ulClient] += Bytes;
+	else
+		g_qwRelevanceResyncBytes[ulClient] += Bytes;
+}
+
 //*****************************************************************************
 //
 void NETTRAFFIC_Reset ( )
 {
 	g_actorTrafficMap.clear();
 	g_ACSScriptTrafficMap.clear();
+	g_qwNumFullMovePlayer = 0;
+	g_qwFullMovePlayerBytes = 0;
+	g_qwNumDeltaMovePlayer = 0;
+	g_qwDeltaMovePlayerBytes = 0;
+	g_sqwMovePlayerBytesSaved = 0;
+	memset( g_qwRelevanceSkippedBytes, 0, sizeof( g_qwRelevanceSkippedBytes ));
+	memset( g_qwRelevanceResyncBytes, 0, sizeof( g_qwRelevanceResyncBytes ));
 }
 
 //*****************************************************************************
@@ -116,6 +172,21 @@ CCMD( dumptrafficmeasure )
 	Printf ( "\nNetwork traffic (in bytes) caused by ACS scripts:\n" );
 	for ( std::map<int, int>::const_iterator it = g_ACSScriptTrafficMap.begin(); it != g_ACSScriptTrafficMap.end(); ++it )
 		Printf ( "Script %d: %d\n", (*it).first, (*it).second );
+
+	Printf ( "\nNetwork traffic (in bytes) caused by player movement:\n" );
+	Printf ( "Full updates: %llu (%llu bytes)\n", static_cast<unsigned long long>( g_qwNumFullMovePlayer ), static_cast<unsigned long long>( g_qwFullMovePlayerBytes ) );
+	Printf ( "Delta updates: %llu (%llu bytes)\n", static_cast<unsigned long long>( g_qwNumDeltaMovePlayer ), static_cast<unsigned long long>( g_qwDeltaMovePlayerBytes ) );
+	Printf ( "Saved by delta encoding: %lld\n", static_cast<long long>( g_sqwMovePlayerBytesSaved ) );
+
+	Printf ( "\nPosition updates skipped by relevance filtering (skipped / resync bytes):\n" );
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+	{
+		if (( g_qwRelevanceSkippedBytes[ulIdx] == 0 ) && ( g_qwRelevanceResyncBytes[ulIdx] == 0 ))
+			continue;
+
+		Printf ( "%s: %llu / %llu\n", SERVER_IsValidClient( ulIdx ) ? players[ulIdx].userinfo.netname : "(disconnected)",
+			static_cast<unsigned long long>( g_qwRelevanceSkippedBytes[ulIdx] ), static_cast<unsigned long long>( g_qwRelevanceResyncBytes[ulIdx] ) );
+	}
 }
 
 //*****************************************************************************
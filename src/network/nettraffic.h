@@ -52,6 +52,8 @@
 
 void	NETTRAFFIC_AddActorTraffic ( const AActor* pActor, const int BytesUsed );
 void	NETTRAFFIC_AddACSScriptTraffic ( const int ScriptNum, const int BytesUsed );
+void	NETTRAFFIC_AddMovePlayerTraffic ( const bool bDelta, const int BytesUsed, const int BytesWithoutDelta );
+void	NETTRAFFIC_AddRelevanceTraffic ( const ULONG ulClient, const bool bSkipped, const int Bytes );
 void	NETTRAFFIC_Reset ( );
 
 #endif	// __NETTRAFFIC_H__
@@ -334,6 +334,7 @@ BEGIN_ENUM( SVC2 )
 	ENUM_ELEMENT ( SVC2_SETCVAR ),
 	ENUM_ELEMENT ( SVC2_STOPPOLYOBJSOUND ),
 	ENUM_ELEMENT ( SVC2_BUILDSTAIR ),
+	ENUM_ELEMENT ( SVC2_MOVEPLAYERDELTA ),
 
 	ENUM_ELEMENT ( NUM_SVC2_COMMANDS ),
 }
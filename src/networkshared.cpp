@@ -899,6 +899,7 @@ bool IPList::clearAndLoadFromFile( const char *Filename )
 	IPFileParser parser( 65536 );
 
 	success = parser.parseIPList( Filename, _ipVector );
+	_lookupTablesValid = false;
 	if ( !success )
 		_error = parser.getErrorMessage();
 
@@ -948,9 +949,129 @@ void IPList::removeExpiredEntries( void )
 	}
 }
 
+//*****************************************************************************
+//
+// Converts an octet of an IP string to a number. Only succeeds for the way NETWORK_AddressToIPStringArray
+// writes numbers (no leading zeros), since only those can be equal to the octet of an actual address.
+static bool network_ParseIPOctet( const char *pszOctet, BYTE &bOctet )
+{
+	int iValue = 0;
+	int iLength = 0;
+
+	for ( ; pszOctet[iLength] != 0; iLength++ )
+	{
+		if (( iLength >= 3 ) || ( isdigit( static_cast<unsigned char>( pszOctet[iLength] )) == false ))
+			return false;
+
+		iValue = iValue * 10 + ( pszOctet[iLength] - '0' );
+	}
+
+	if (( iLength == 0 ) || ( iValue > 255 ) || (( iLength > 1 ) && ( pszOctet[0] == '0' )))
+		return false;
+
+	bOctet = static_cast<BYTE>( iValue );
+	return true;
+}
+
+//*****************************************************************************
+//
+void IPList::buildLookupTables( ) const
+{
+	for ( ULONG ulTable = 0; ulTable < 16; ulTable++ )
+		_lookupTables[ulTable].clear();
+
+	for ( ULONG ulIdx = 0; ulIdx < _ipVector.size(); ulIdx++ )
+	{
+		ULONG ulTable = 0;
+		ULONG ulAddress = 0;
+		bool bMatchable = true;
+
+		for ( ULONG ulOctet = 0; ulOctet < 4; ulOctet++ )
+		{
+			BYTE bOctet = 0;
+
+			ulAddress <<= 8;
+
+			if ( _ipVector[ulIdx].szIP[ulOctet][0] == '*' )
+				ulTable |= 1 << ulOctet;
+			else if ( network_ParseIPOctet( _ipVector[ulIdx].szIP[ulOctet], bOctet ))
+				ulAddress |= bOctet;
+			// This entry can't match any address.
+			else
+				bMatchable = false;
+		}
+
+		if ( bMatchable )
+			_lookupTables[ulTable].push_back( std::make_pair( ulAddress, ulIdx ));
+	}
+
+	for ( ULONG ulTable = 0; ulTable < 16; ulTable++ )
+	{
+		LookupTable &table = _lookupTables[ulTable];
+
+		// Sort by address, then by index, and only keep the first entry for each address.
+		std::sort( table.begin(), table.end() );
+
+		ULONG ulNumUnique = 0;
+		for ( ULONG ulIdx = 0; ulIdx < table.size(); ulIdx++ )
+		{
+			if (( ulNumUnique == 0 ) || ( table[ulNumUnique - 1].first != table[ulIdx].first ))
+				table[ulNumUnique++] = table[ulIdx];
+		}
+		table.resize( ulNumUnique );
+	}
+
+	_lookupTablesValid = true;
+}
+
+//*****************************************************************************
+//
+ULONG IPList::lookup( const BYTE *pbIP ) const
+{
+	if ( _lookupTablesValid == false )
+		buildLookupTables( );
+
+	ULONG ulFirstIdx = size();
+
+	for ( ULONG ulTable = 0; ulTable < 16; ulTable++ )
+	{
+		const LookupTable &table = _lookupTables[ulTable];
+
+		if ( table.empty() )
+			continue;
+
+		// Clear the octets this table has wildcards for.
+		ULONG ulAddress = 0;
+		for ( ULONG ulOctet = 0; ulOctet < 4; ulOctet++ )
+			ulAddress = ( ulAddress << 8 ) | (( ulTable & ( 1 << ulOctet )) ? 0 : pbIP[ulOctet] );
+
+		LookupTable::const_iterator it = std::lower_bound( table.begin(), table.end(), std::make_pair( ulAddress, static_cast<ULONG>( 0 )));
+		if (( it != table.end() ) && ( it->first == ulAddress ) && ( it->second < ulFirstIdx ))
+			ulFirstIdx = it->second;
+	}
+
+	return ( ulFirstIdx );
+}
+
 //*****************************************************************************
 //
 ULONG IPList::getFirstMatchingEntryIndex( const IPStringArray &szAddress ) const
+{
+	BYTE abIP[4];
+
+	for ( ULONG ulOctet = 0; ulOctet < 4; ulOctet++ )
+	{
+		// Addresses not written like NETWORK_AddressToIPStringArray does are compared string by string.
+		if ( network_ParseIPOctet( szAddress[ulOctet], abIP[ulOctet] ) == false )
+			return getFirstMatchingEntryIndexLinear( szAddress );
+	}
+
+	return lookup( abIP );
+}
+
+//*****************************************************************************
+//
+ULONG IPList::getFirstMatchingEntryIndexLinear( const IPStringArray &szAddress ) const
 {
 	for ( ULONG ulIdx = 0; ulIdx < _ipVector.size(); ulIdx++ )
 	{
@@ -970,9 +1091,7 @@ ULONG IPList::getFirstMatchingEntryIndex( const IPStringArray &szAddress ) const
 //
 ULONG IPList::getFirstMatchingEntryIndex( const NETADDRESS_s &Address ) const
 {
-	IPStringArray szAddress;
-	NETWORK_AddressToIPStringArray( Address, szAddress );
-	return getFirstMatchingEntryIndex( szAddress );
+	return lookup( Address.abIP );
 }
 
 //*****************************************************************************
@@ -986,9 +1105,7 @@ bool IPList::isIPInList( const IPStringArray &szAddress ) const
 //
 bool IPList::isIPInList( const NETADDRESS_s &Address ) const
 {
-	IPStringArray szAddress;
-	NETWORK_AddressToIPStringArray( Address, szAddress );
-	return isIPInList( szAddress );
+	return ( getFirstMatchingEntryIndex( Address ) != size() );
 }
 
 //*****************************************************************************
@@ -1166,6 +1283,7 @@ void IPList::addEntry( const char *pszIP0, const char *pszIP1, const char *pszIP
 	newIPEntry.szComment[127] = 0;
 	newIPEntry.tExpirationDate = tExpiration;
 	_ipVector.push_back( newIPEntry );
+	_lookupTablesValid = false;
 
 	// Finally, append the IP to the file.
 	if ( (pFile = fopen( _filename.c_str(), "a" )) )
@@ -1239,6 +1357,7 @@ void IPList::removeEntry( ULONG ulEntryIdx )
 			_ipVector[ulIdx] = _ipVector[ulIdx+1];
 
 	_ipVector.pop_back();
+	_lookupTablesValid = false;
 	rewriteListToFile ();
 }
 
@@ -1328,6 +1447,7 @@ struct ASCENDINGIPSORT_S
 void IPList::sort()
 {
 	std::sort( _ipVector.begin(), _ipVector.end(), ASCENDINGIPSORT_S() );
+	_lookupTablesValid = false;
 }
 
 //=============================================================================
@@ -348,11 +348,22 @@ class IPList
 	std::string						_filename;
 	std::string						_error;
 
+	// Lookup tables built from _ipVector, one for each combination of wildcard octets.
+	// Each maps the address (with the wildcard octets cleared) to the index of the first
+	// entry matching it and is sorted by address. They are rebuilt when needed after the
+	// entries were changed.
+	typedef std::vector<std::pair<ULONG, ULONG> >	LookupTable;
+	mutable LookupTable				_lookupTables[16];
+	mutable bool					_lookupTablesValid;
+
 //*************************************************************************
 public:
+	IPList( ) : _lookupTablesValid( false ) { }
+
 	bool			clearAndLoadFromFile( const char *Filename );
 	ULONG			getFirstMatchingEntryIndex( const IPStringArray &szAddress ) const;
 	ULONG			getFirstMatchingEntryIndex( const NETADDRESS_s &Address ) const;
+	ULONG			getFirstMatchingEntryIndexLinear( const IPStringArray &szAddress ) const;
 	bool			isIPInList( const IPStringArray &szAddress ) const;
 	bool			isIPInList( const NETADDRESS_s &Address ) const;
 	ULONG			doesEntryExist( const char *pszIP0, const char *pszIP1, const char *pszIP2, const char *pszIP3 ) const;
@@ -371,15 +382,18 @@ public:
 	void			removeExpiredEntries( void ); // [RC]
 
 	unsigned int	size() const { return static_cast<unsigned int>( _ipVector.size( )); }
-	void			clear() { _ipVector.clear(); }
-	void			push_back ( IPADDRESSBAN_s &IP ) { _ipVector.push_back(IP); }
+	void			clear() { _ipVector.clear(); _lookupTablesValid = false; }
+	void			push_back ( IPADDRESSBAN_s &IP ) { _ipVector.push_back(IP); _lookupTablesValid = false; }
 	const char*		getErrorMessage() const { return _error.c_str(); }
 	
-	std::vector<IPADDRESSBAN_s>&	getVector() { return _ipVector; }
+	// The caller may change the entries, so the lookup tables have to be rebuilt.
+	std::vector<IPADDRESSBAN_s>&	getVector() { _lookupTablesValid = false; return _ipVector; }
 
 //*************************************************************************
 private:
 	bool rewriteListToFile ();
+	void buildLookupTables () const;
+	ULONG lookup ( const BYTE *pbIP ) const;
 };
 
 //==========================================================================
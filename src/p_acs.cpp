@@ -83,6 +83,7 @@
 #include "sv_commands.h"
 #include "network/nettraffic.h"
 #include "cl_commands.h"
+#include "sv_profiler.h"
 
 #include "g_shared/a_pickups.h"
 
@@ -2183,12 +2184,14 @@ void DACSThinker::Tick ()
 {
 	DLevelScript *script = Scripts;
 
+	SERVER_PROFILER_Clock( PROFILERPHASE_ACS );
 	while (script)
 	{
 		DLevelScript *next = script->next;
 		script->RunScript ();
 		script = next;
 	}
+	SERVER_PROFILER_Unclock( PROFILERPHASE_ACS );
 
 	ACS_StringsOnTheFly.Clear();
 
@@ -2508,6 +2511,7 @@ void DLevelScript::ChangeFlat (int tag, int name, bool floorOrCeiling)
 
 		// [BC] Also, mark this sector as having its flat changed.
 		sectors[secnum].bFlatChange = true;
+		SERVER_LEVELCHANGES_MarkSector( secnum );
 	}
 }
 
@@ -2554,6 +2558,7 @@ void DLevelScript::SetLineTexture (int lineid, int side, int position, int name)
 				ulShift += 3;
 
 			lines[linenum].ulTexChangeFlags |= 1 << ulShift;
+			SERVER_LEVELCHANGES_MarkLine( linenum );
 /*
 			if (( 1 << ulShift ) == TEXCHANGE_FRONTTOP )
 				Printf( "FRONT TOP: %d\n", linenum );
@@ -2628,6 +2633,7 @@ void DLevelScript::ReplaceTextures (int fromnamei, int tonamei, int flags)
 					if ( (int)lines[wal->linenum].sidenum[1] == i )
 						ulShift += 3;
 					lines[wal->linenum].ulTexChangeFlags |= 1 << ulShift;
+					SERVER_LEVELCHANGES_MarkLine( wal->linenum );
 				}
 			}
 		}
@@ -2647,6 +2653,7 @@ void DLevelScript::ReplaceTextures (int fromnamei, int tonamei, int flags)
 
 				// [BB] Mark this sector as having its flat changed.
 				sec->bFlatChange = true;
+				SERVER_LEVELCHANGES_MarkSector( sec->sectornum );
 			}
 			if (!(flags & NOT_CEILING) && sec->GetTexture(sector_t::ceiling) == picnum1)	
 			{
@@ -2654,6 +2661,7 @@ void DLevelScript::ReplaceTextures (int fromnamei, int tonamei, int flags)
 
 				// [BB] Mark this sector as having its flat changed.
 				sec->bFlatChange = true;
+				SERVER_LEVELCHANGES_MarkSector( sec->sectornum );
 			}
 		}
 	}
@@ -5928,6 +5936,7 @@ int DLevelScript::RunScript ()
 						SERVERCOMMANDS_SetSomeLineFlags( line );
 				}
 
+				P_InvalidateSightCache ();
 				sp -= 2;
 			}
 			break;
@@ -5942,6 +5951,7 @@ int DLevelScript::RunScript ()
 						lines[line].flags |= ML_BLOCKMONSTERS;
 					else
 						lines[line].flags &= ~ML_BLOCKMONSTERS;
+					SERVER_LEVELCHANGES_MarkLine( line );
 				}
 
 				sp -= 2;
@@ -5962,6 +5972,7 @@ int DLevelScript::RunScript ()
 					line->args[3] = STACK(2);
 					line->args[4] = STACK(1);
 				}
+				P_InvalidateSightCache ();
 				sp -= 7;
 			}
 			break;
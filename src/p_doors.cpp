@@ -868,6 +868,8 @@ void DAnimatedDoor::Tick ()
 				// [BC] Mark this line's textures as having been changed.
 				m_Line1->ulTexChangeFlags |= TEXCHANGE_FRONTMEDIUM|TEXCHANGE_BACKMEDIUM;
 				m_Line2->ulTexChangeFlags |= TEXCHANGE_FRONTMEDIUM|TEXCHANGE_BACKMEDIUM;
+				SERVER_LEVELCHANGES_MarkLine( ULONG( m_Line1 - lines ));
+				SERVER_LEVELCHANGES_MarkLine( ULONG( m_Line2 - lines ));
 
 				// [BC] If we're the server, tell clients that these lines' texture
 				// has changed.
@@ -920,6 +922,8 @@ void DAnimatedDoor::Tick ()
 				// [BC] Mark this line's textures as having been changed.
 				m_Line1->ulTexChangeFlags |= TEXCHANGE_FRONTMEDIUM|TEXCHANGE_BACKMEDIUM;
 				m_Line2->ulTexChangeFlags |= TEXCHANGE_FRONTMEDIUM|TEXCHANGE_BACKMEDIUM;
+				SERVER_LEVELCHANGES_MarkLine( ULONG( m_Line1 - lines ));
+				SERVER_LEVELCHANGES_MarkLine( ULONG( m_Line2 - lines ));
 
 				// [BC] If we're the server, tell clients that these lines' texture
 				// has changed.
@@ -1009,6 +1013,8 @@ DAnimatedDoor::DAnimatedDoor (sector_t *sec, line_t *line, int speed, int delay)
 	// [BC] Mark this line's textures as having been changed.
 	m_Line1->ulTexChangeFlags |= TEXCHANGE_FRONTMEDIUM|TEXCHANGE_BACKMEDIUM;
 	m_Line2->ulTexChangeFlags |= TEXCHANGE_FRONTMEDIUM|TEXCHANGE_BACKMEDIUM;
+	SERVER_LEVELCHANGES_MarkLine( ULONG( m_Line1 - lines ));
+	SERVER_LEVELCHANGES_MarkLine( ULONG( m_Line2 - lines ));
 
 	// [BC] If we're the server, tell clients that these lines' texture
 	// has changed.
@@ -1191,13 +1191,16 @@ bool P_LookForMonsters (AActor *actor)
 
 AActor *LookForTIDinBlock (AActor *lookee, int index)
 {
-	FBlockNode *block;
+	FBlockCell *cell = &blocklinks[index];
 	AActor *link;
 	AActor *other;
 	
-	for (block = blocklinks[index]; block != NULL; block = block->NextActor)
+	for (int i = (int)cell->Things.Size() - 1; i >= 0; --i)
 	{
-		link = block->Me;
+		link = cell->Things[i].Me;
+
+		if (link == NULL)
+			continue;			// being relinked
 
         if (!(link->flags & MF_SHOOTABLE))
 			continue;			// not shootable (observer or dead)
@@ -1393,13 +1396,16 @@ bool P_LookForTID (AActor *actor, INTBOOL allaround)
 
 AActor *LookForEnemiesInBlock (AActor *lookee, int index)
 {
-	FBlockNode *block;
+	FBlockCell *cell = &blocklinks[index];
 	AActor *link;
 	AActor *other;
 	
-	for (block = blocklinks[index]; block != NULL; block = block->NextActor)
+	for (int i = (int)cell->Things.Size() - 1; i >= 0; --i)
 	{
-		link = block->Me;
+		link = cell->Things[i].Me;
+
+		if (link == NULL)
+			continue;			// being relinked
 
         if (!(link->flags & MF_SHOOTABLE))
 			continue;			// not shootable (observer or dead)
@@ -2571,6 +2577,7 @@ static bool P_CheckForResurrection(AActor *self, bool usevilestates)
 			
 			corpsehit->height = info->height;	// [RH] Use real mobj height
 			corpsehit->radius = info->radius;	// [RH] Use real radius
+			corpsehit->LinkToBlockmap ();
 			/*
 			// Make raised corpses look ghostly
 			if (corpsehit->alpha > TRANSLUC50)
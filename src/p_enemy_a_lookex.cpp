@@ -41,15 +41,18 @@ static FRandom pr_skiptarget("SkipTargetEx");
 
 AActor *LookForTIDinBlockEx (AActor *lookee, int index)
 {
-	FBlockNode *block;
+	FBlockCell *cell = &blocklinks[index];
 	AActor *link;
 	AActor *other;
 	fixed_t 	dist;
 	angle_t		an;
 	
-	for (block = blocklinks[index]; block != NULL; block = block->NextActor)
+	for (int i = (int)cell->Things.Size() - 1; i >= 0; --i)
 	{
-		link = block->Me;
+		link = cell->Things[i].Me;
+
+		if (link == NULL)
+			continue;			// being relinked
 
         if (!(link->flags & MF_SHOOTABLE))
 			continue;			// not shootable (observer or dead)
@@ -140,15 +143,18 @@ AActor *LookForTIDinBlockEx (AActor *lookee, int index)
 
 AActor *LookForEnemiesInBlockEx (AActor *lookee, int index)
 {
-	FBlockNode *block;
+	FBlockCell *cell = &blocklinks[index];
 	AActor *link;
 	AActor *other;
 	fixed_t 	dist;
 	angle_t		an;
 	
-	for (block = blocklinks[index]; block != NULL; block = block->NextActor)
+	for (int i = (int)cell->Things.Size() - 1; i >= 0; --i)
 	{
-		link = block->Me;
+		link = cell->Things[i].Me;
+
+		if (link == NULL)
+			continue;			// being relinked
 
         if (!(link->flags & MF_SHOOTABLE))
 			continue;			// not shootable (observer or dead)
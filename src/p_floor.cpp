@@ -274,6 +274,7 @@ void DFloor::Tick ()
 
 					// [BC] Also, mark this sector as having its flat changed.
 					m_Sector->bFlatChange = true;
+					SERVER_LEVELCHANGES_MarkSector( ULONG( m_Sector - sectors ));
 					break;
 				default:
 					break;
@@ -297,6 +298,7 @@ void DFloor::Tick ()
 
 					// [BC] Also, mark this sector as having its flat changed.
 					m_Sector->bFlatChange = true;
+					SERVER_LEVELCHANGES_MarkSector( ULONG( m_Sector - sectors ));
 					break;
 				default:
 					break;
@@ -803,6 +805,7 @@ manual_floor:
 
 				// [BC] Also, mark this sector as having its flat changed.
 				sec->bFlatChange = true;
+				SERVER_LEVELCHANGES_MarkSector( ULONG( sec - sectors ));
 
 				sec->special = (sec->special & SECRET_MASK) | (line->frontsector->special & ~SECRET_MASK);
 			}
@@ -836,6 +839,7 @@ manual_floor:
 
 				// [BC] Also, mark this sector as having its flat changed.
 				sec->bFlatChange = true;
+				SERVER_LEVELCHANGES_MarkSector( ULONG( sec - sectors ));
 			}
 			break;
 
@@ -997,6 +1001,7 @@ bool EV_DoChange (line_t *line, EChange changetype, int tag)
 
 				// [BC] Also, mark this sector as having its flat changed.
 				sec->bFlatChange = true;
+				SERVER_LEVELCHANGES_MarkSector( ULONG( sec - sectors ));
 			}
 			break;
 		case numChangeOnly:
@@ -1012,6 +1017,7 @@ bool EV_DoChange (line_t *line, EChange changetype, int tag)
 
 				// [BC] Also, mark this sector as having its flat changed.
 				sec->bFlatChange = true;
+				SERVER_LEVELCHANGES_MarkSector( ULONG( sec - sectors ));
 			}
 			break;
 		default:
@@ -1577,6 +1583,7 @@ void DWaggleBase::DoWaggle (bool ceiling)
 		// Why do we need these bools anyway? Wouldn't it be better to check the current
 		// ceiling/floor values agains the saved intial values?
 		m_Sector->bCeilingHeightChange = true;
+		SERVER_LEVELCHANGES_MarkSector( ULONG( m_Sector - sectors ));
 	}
 	else
 	{
@@ -1584,6 +1591,7 @@ void DWaggleBase::DoWaggle (bool ceiling)
 		pos = sector_t::floor;
 		// [BB] The floor is going to be moved in here. Is this the best place to put this?
 		m_Sector->bFloorHeightChange = true;
+		SERVER_LEVELCHANGES_MarkSector( ULONG( m_Sector - sectors ));
 	}
 
 	switch (m_State)
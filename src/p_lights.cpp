@@ -425,6 +425,7 @@ void EV_TurnTagLightsOff (int tag)
 		// [BC] Flag the sector as having its light level altered. That way, when clients
 		// connect, we can tell them about the updated light level.
 		sector->bLightChange = true;
+		SERVER_LEVELCHANGES_MarkSector( sector->sectornum );
 
 		// [BC] If we're the server, tell clients about the light level change.
 		if ( NETWORK_GetState( ) == NETSTATE_SERVER )
@@ -470,6 +471,7 @@ void EV_LightTurnOn (int tag, int bright)
 		// [BC] Flag the sector as having its light level altered. That way, when clients
 		// connect, we can tell them about the updated light level.
 		sector->bLightChange = true;
+		SERVER_LEVELCHANGES_MarkSector( sector->sectornum );
 
 		// [BC] If we're the server, tell clients about the light level change.
 		if ( NETWORK_GetState( ) == NETSTATE_SERVER )
@@ -538,6 +540,7 @@ void EV_LightChange (int tag, int value)
 		// [BC] Flag the sector as having its light level altered. That way, when clients
 		// connect, we can tell them about the updated light level.
 		sectors[secnum].bLightChange = true;
+		SERVER_LEVELCHANGES_MarkSector( secnum );
 
 		// [BC] If we're the server, tell clients about the light level change.
 		if ( NETWORK_GetState( ) == NETSTATE_SERVER )
@@ -635,6 +638,7 @@ void DGlow2::Tick ()
 			// [BC] Flag the sector as having its light level altered. That way, when clients
 			// connect, we can tell them about the updated light level.
 			m_Sector->bLightChange = true;
+			SERVER_LEVELCHANGES_MarkSector( m_Sector->sectornum );
 
 			// [BC] If we're the server, tell clients about the light level change.
 			if ( NETWORK_GetState( ) == NETSTATE_SERVER )
@@ -728,6 +732,7 @@ void EV_StartLightFading (int tag, int value, int tics)
 			{
 				sec->lightlevel = value;
 				sec->bLightChange = true;
+				SERVER_LEVELCHANGES_MarkSector( sec->sectornum );
 
 				// [CK] Since we know it's instant, this is a simple light level
 				// change and not a fade.
@@ -867,6 +872,7 @@ void EV_StopLightEffect (int tag)
 			// [BC] Since this sector's light level most likely changed, mark it as such so
 			// that we can tell clients when they come in.
 			effect->GetSector( )->bLightChange = true;
+			SERVER_LEVELCHANGES_MarkSector( effect->GetSector( )->sectornum );
 
 			// [BC] If we're the server, tell clients to stop this light effect.
 			if ( NETWORK_GetState( ) == NETSTATE_SERVER )
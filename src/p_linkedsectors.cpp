@@ -99,6 +99,7 @@ static bool MoveCeiling(sector_t *sector, int crush, fixed_t move)
 
 	// [BB] Ceiling height was changed.
 	sector->bCeilingHeightChange = true;
+	SERVER_LEVELCHANGES_MarkSector( sector->sectornum );
 
 	if (P_ChangeSector(sector, crush, move, 1, true)) return false;
 
@@ -117,6 +118,7 @@ static bool MoveFloor(sector_t *sector, int crush, fixed_t move)
 
 	// [BB] Floor height was changed.
 	sector->bFloorHeightChange = true;
+	SERVER_LEVELCHANGES_MarkSector( sector->sectornum );
 
 	if (P_ChangeSector(sector, crush, move, 0, true)) return false;
 
@@ -1502,6 +1502,7 @@ FUNC(LS_Thing_SpawnFacing)
 		thing->height = oldheight;
 		return false;
 	}
+	thing->LinkToBlockmap ();
 
 	S_Sound (thing, CHAN_BODY, "vile/raise", 1, ATTN_IDLE);
 	
@@ -2716,6 +2717,7 @@ FUNC(LS_Line_SetBlocking)
 		if ( NETWORK_GetState() == NETSTATE_SERVER )
 			SERVERCOMMANDS_SetSomeLineFlags( line );
 	}
+	P_InvalidateSightCache ();
 	return true;
 }
 
@@ -3224,11 +3226,13 @@ FUNC(LS_ClearForceField)
 			{
 				line->flags &= ~(ML_BLOCKING|ML_BLOCKEVERYTHING);
 				line->special = 0;
+				P_InvalidateSightCache ();
 				sides[line->sidenum[0]].SetTexture(side_t::mid, FNullTextureID());
 				sides[line->sidenum[1]].SetTexture(side_t::mid, FNullTextureID());
 
 				// [BC] Mark this line's texture change flags.
 				line->ulTexChangeFlags |= TEXCHANGE_FRONTMEDIUM|TEXCHANGE_BACKMEDIUM;
+				SERVER_LEVELCHANGES_MarkLine( ULONG( line - lines ));
 
 				// [BC] If we're the server, tell clients that this line's textures and
 				// blocking status have been altered.
@@ -3250,6 +3254,7 @@ FUNC(LS_GlassBreak)
 	bool quest1, quest2;
 
 	ln->flags &= ~(ML_BLOCKING|ML_BLOCKEVERYTHING);
+	P_InvalidateSightCache ();
 
 	// [BC] If we're the server, update this line's blocking.
 	if ( NETWORK_GetState( ) == NETSTATE_SERVER )
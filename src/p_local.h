@@ -286,6 +286,25 @@ public:
 	void Reset() { StartBlock(minx, miny); }
 };
 
+// While the blockmap is locked, actors that leave a block only leave a hole
+// in it, so that loops over a block's entries can relink or destroy actors
+// without having entries move under them. The holes are closed up when the
+// last lock goes away.
+extern int BlockmapLocks;
+void P_CompactBlockmap ();
+
+class FBlockmapLock
+{
+public:
+	FBlockmapLock() { ++BlockmapLocks; }
+	~FBlockmapLock() { if (--BlockmapLocks == 0) P_CompactBlockmap(); }
+
+private:
+	// A copy would release the lock a second time.
+	FBlockmapLock(const FBlockmapLock &);
+	FBlockmapLock &operator= (const FBlockmapLock &);
+};
+
 class FBlockThingsIterator
 {
 	int minx, maxx;
@@ -293,7 +312,14 @@ class FBlockThingsIterator
 
 	int curx, cury;
 
-	FBlockNode *block;
+	FBlockCell *cell;
+	int index;
+	FBlockmapLock lock;
+
+	// Only return actors whose boxes overlap this one?
+	bool clipped;
+	fixed_t clipleft, clipright;
+	fixed_t clipbottom, cliptop;
 
 	int Buckets[32];
 
@@ -320,7 +346,7 @@ class FBlockThingsIterator
 
 public:
 	FBlockThingsIterator(int minx, int miny, int maxx, int maxy);
-	FBlockThingsIterator(const FBoundingBox &box);
+	FBlockThingsIterator(const FBoundingBox &box, bool clip = false);
 	AActor *Next();
 	void Reset() { StartBlock(minx, miny); }
 };
@@ -419,6 +445,7 @@ void	P_OldSlideMove (AActor* mo);
 bool	P_BounceWall (AActor *mo);
 bool	P_CheckSight (const AActor* t1, const AActor* t2, int flags=0);
 void	P_ResetSightCounters (bool full);
+void	P_InvalidateSightCache ();
 void	P_ResetSpawnCounters( void );
 void	P_UseLines (player_t* player);
 //void	P_UseItems (player_t* player);
@@ -480,7 +507,7 @@ extern int				bmapwidth;
 extern int				bmapheight; 	// in mapblocks
 extern fixed_t			bmaporgx;
 extern fixed_t			bmaporgy;		// origin of block map
-extern FBlockNode**		blocklinks; 	// for thing chains
+extern FBlockCell*		blocklinks; 	// for thing chains
 
 
 
@@ -349,7 +349,7 @@ bool P_TeleportMove (AActor *thing, fixed_t x, fixed_t y, fixed_t z, bool telefr
 
 	if (tmf.touchmidtex) tmf.dropoffz = tmf.floorz;
 
-	FBlockThingsIterator it2(FBoundingBox(x, y, thing->radius));
+	FBlockThingsIterator it2(FBoundingBox(x, y, thing->radius), true);
 	AActor *th;
 
 	while ((th = it2.Next()))
@@ -435,7 +435,7 @@ void P_PlayerStartStomp (AActor *actor)
 		return;
 
 	AActor *th;
-	FBlockThingsIterator it(FBoundingBox(actor->x, actor->y, actor->radius));
+	FBlockThingsIterator it(FBoundingBox(actor->x, actor->y, actor->radius), true);
 
 	while ((th = it.Next()))
 	{
@@ -1671,7 +1671,7 @@ bool P_CheckPosition (AActor *thing, fixed_t x, fixed_t y, FCheckPosition &tm)
 	FBoundingBox box(x, y, thing->radius);
 
 	{
-		FBlockThingsIterator it2(box);
+		FBlockThingsIterator it2(box, true);
 		AActor *th;
 		while ((th = it2.Next()))
 		{
@@ -1819,7 +1819,7 @@ bool P_TestMobjZ (AActor *actor, bool quick, AActor **pOnmobj)
 		return true;
 	}
 
-	FBlockThingsIterator it(FBoundingBox(actor->x, actor->y, actor->radius));
+	FBlockThingsIterator it(FBoundingBox(actor->x, actor->y, actor->radius), true);
 	AActor *thing;
 
 	while ((thing = it.Next()))
@@ -3889,7 +3889,7 @@ fixed_t P_AimLineAttack (AActor *t1, angle_t angle, fixed_t distance, AActor **p
 	aim_t aim;
 
 	// [Spleen]
-	UNLAGGED_Reconcile( t1 );
+	UNLAGGED_ReconcileLine( t1, angle, distance );
 
 	angle >>= ANGLETOFINESHIFT;
 	aim.shootthing = t1;
@@ -4060,7 +4060,7 @@ AActor *P_LineAttack (AActor *t1, angle_t angle, fixed_t distance,
 	vz = -finesine[pitch];
 
 	// [Spleen]
-	UNLAGGED_Reconcile( t1 );
+	UNLAGGED_ReconcileLine( t1, srcangle, distance );
 
 	shootz = t1->z - t1->floorclip + (t1->height>>1);
 	if (t1->player != NULL)
@@ -4520,8 +4520,8 @@ void P_RailAttack (AActor *source, int damage, int offset, int color1, int color
 	FTraceResults trace;
 	fixed_t shootz;
 
-	// [Spleen]
-	UNLAGGED_Reconcile( source );
+	// [Spleen] The rail starts offset units to the side of the source.
+	UNLAGGED_ReconcileLine( source, source->angle, 8192*FRACUNIT, abs( offset ) << FRACBITS );
 
 	if (puffclass == NULL) puffclass = PClass::FindClass(NAME_BulletPuff);
 
@@ -5293,7 +5293,7 @@ void P_RadiusAttack (AActor *bombspot, AActor *bombsource, int bombdamage, int b
 	float bombdamagefloat = (float)bombdamage;
 	FVector3 bombvec(FIXED2FLOAT(bombspot->x), FIXED2FLOAT(bombspot->y), FIXED2FLOAT(bombspot->z));
 
-	FBlockThingsIterator it(FBoundingBox(bombspot->x, bombspot->y, bombdistance<<FRACBITS));
+	FBlockThingsIterator it(FBoundingBox(bombspot->x, bombspot->y, bombdistance<<FRACBITS), true);
 	AActor *thing;
 
 	while ((thing = it.Next()))
@@ -5607,7 +5607,7 @@ void P_FindAboveIntersectors (AActor *actor)
 
 
 	AActor *thing;
-	FBlockThingsIterator it(FBoundingBox(actor->x, actor->y, actor->radius));
+	FBlockThingsIterator it(FBoundingBox(actor->x, actor->y, actor->radius), true);
 	while ((thing = it.Next()))
 	{
 		if (!thing->intersects(actor))
@@ -5649,7 +5649,7 @@ void P_FindBelowIntersectors (AActor *actor)
 		return;
 
 	AActor *thing;
-	FBlockThingsIterator it(FBoundingBox(actor->x, actor->y, actor->radius));
+	FBlockThingsIterator it(FBoundingBox(actor->x, actor->y, actor->radius), true);
 	while ((thing = it.Next()))
 	{
 		if (!thing->intersects(actor))
@@ -5739,6 +5739,7 @@ void P_DoCrunch (AActor *thing, FChangePosition *cpos)
 			thing->flags &= ~MF_SOLID;
 			thing->flags3 |= MF3_DONTGIB;
 			thing->height = thing->radius = 0;
+			thing->LinkToBlockmap ();
 			thing->SetState (state);
 			return;
 		}
@@ -5768,6 +5769,7 @@ void P_DoCrunch (AActor *thing, FChangePosition *cpos)
 				thing->flags &= ~MF_SOLID;
 				thing->flags3 |= MF3_DONTGIB;
 				thing->height = thing->radius = 0;
+				thing->LinkToBlockmap ();
 				return;
 			}
 
@@ -5778,6 +5780,7 @@ void P_DoCrunch (AActor *thing, FChangePosition *cpos)
 				gib->alpha = thing->alpha;
 				gib->height = 0;
 				gib->radius = 0;
+				gib->LinkToBlockmap ();
 
 				// [BB] Apparently Skulltag always has let the clients spawn the gibs.
 				// Whether or not this is intentional, if the clients spawn the gibs on
@@ -6192,6 +6195,8 @@ bool P_ChangeSector (sector_t *sector, int crunch, int amt, int floorOrCeil, boo
 	cpos.movemidtex = false;
 	cpos.sector = sector;
 
+	P_InvalidateSightCache ();
+
 #ifdef _3DFLOORS
 	// Also process all sectors that have 3D floors transferred from the
 	// changed sector.
@@ -35,12 +35,21 @@
 #include "doomstat.h"
 #include "p_local.h"
 #include "p_3dmidtex.h"
+#include "c_dispatch.h"
+// [BB] network.h has to be included before stats.h under Linux.
+#include "network.h"
+#include "stats.h"
 
 // State.
 #include "r_state.h"
 #include "templates.h"
 
 static AActor *RoughBlockCheck (AActor *mo, int index);
+static void P_RemoveBlockEntry (FBlockNode *block);
+
+int BlockmapLocks;
+static TArray<int> DirtyBlocks;			// blocks with entries removed while locked
+static unsigned int BlockLinkStamp;
 
 
 //==========================================================================
@@ -310,23 +319,45 @@ void AActor::UnlinkFromWorld ()
 	if (!(flags & MF_NOBLOCKMAP))
 	{
 		// [RH] Unlink from all blocks this actor uses
-		FBlockNode *block = this->BlockNode;
-
-		while (block != NULL)
+		// The entries stay where they are until LinkToWorld finds out which
+		// blocks the actor is still in. Nearly every unlink is followed by a
+		// relink close to where the actor was, so most of them are kept.
+		for (FBlockNode *block = BlockNode; block != NULL; block = block->NextBlock)
 		{
-			if (block->NextActor != NULL)
+			if (block->Generation == FBlockNode::CurrentGeneration)
 			{
-				block->NextActor->PrevActor = block->PrevActor;
+				blocklinks[block->BlockIndex].Things[block->EntryIndex].Me = NULL;
 			}
-			*(block->PrevActor) = block->NextActor;
-			FBlockNode *next = block->NextBlock;
-			block->Release ();
-			block = next;
 		}
-		BlockNode = NULL;
 	}
 }
 
+//==========================================================================
+//
+// AActor :: ReleaseBlockNodes
+//
+// Takes the actor out of every block it still has an entry in, whether
+// it is linked or only waiting to be relinked.
+//
+//==========================================================================
+
+void AActor::ReleaseBlockNodes ()
+{
+	FBlockNode *block = BlockNode;
+
+	while (block != NULL)
+	{
+		FBlockNode *next = block->NextBlock;
+		if (block->Generation == FBlockNode::CurrentGeneration)
+		{
+			P_RemoveBlockEntry (block);
+		}
+		block->Release ();
+		block = next;
+	}
+	BlockNode = NULL;
+}
+
 
 //==========================================================================
 //
@@ -393,47 +424,106 @@ void AActor::LinkToWorld (sector_t *sec)
 		sector_list = NULL;		// clear for next time
     }
 
-	
+	LinkToBlockmap ();
+}
+
+//==========================================================================
+//
+// AActor :: LinkToBlockmap
+//
+// The blockmap part of LinkToWorld. Block searches go by the position and
+// radius the actor's entries remember, so this must also be called when
+// the radius of a linked actor is changed without relinking it.
+//
+//==========================================================================
+
+void AActor::LinkToBlockmap ()
+{
 	// link into blockmap (inert things don't need to be in the blockmap)
+	// [RH] Link into every block this actor touches, not just the center one
+	int x1 = 0, x2 = -1;
+	int y1 = 0, y2 = -1;
+
 	if ( !(flags & MF_NOBLOCKMAP) )
 	{
-		int x1 = GetSafeBlockX(x - radius - bmaporgx);
-		int x2 = GetSafeBlockX(x + radius - bmaporgx);
-		int y1 = GetSafeBlockY(y - radius - bmaporgy);
-		int y2 = GetSafeBlockY(y + radius - bmaporgy);
-
-		if (x1 >= bmapwidth || x2 < 0 || y1 >= bmapheight || y2 < 0)
-		{ // thing is off the map
-			BlockNode = NULL;
+		x1 = GetSafeBlockX(x - radius - bmaporgx);
+		x2 = GetSafeBlockX(x + radius - bmaporgx);
+		y1 = GetSafeBlockY(y - radius - bmaporgy);
+		y2 = GetSafeBlockY(y + radius - bmaporgy);
+
+		// A thing that is off the map ends up with an empty range here.
+		x1 = MAX (0, x1);
+		y1 = MAX (0, y1);
+		x2 = MIN (bmapwidth - 1, x2);
+		y2 = MIN (bmapheight - 1, y2);
+	}
+	if (BlockNode == NULL && (x1 > x2 || y1 > y2))
+	{
+		return;
+	}
+
+	if (++BlockLinkStamp == 0)
+	{ // Don't let a block from four billion links ago look like it was just kept.
+		for (int i = bmapwidth*bmapheight-1; i >= 0; --i)
+		{
+			blocklinks[i].Stamp = 0;
 		}
-		else
-        { // [RH] Link into every block this actor touches, not just the center one
-			FBlockNode **alink = &this->BlockNode;
-			x1 = MAX (0, x1);
-			y1 = MAX (0, y1);
-			x2 = MIN (bmapwidth - 1, x2);
-			y2 = MIN (bmapheight - 1, y2);
-			for (int y = y1; y <= y2; ++y)
-			{
-				for (int x = x1; x <= x2; ++x)
-				{
-					FBlockNode **link = &blocklinks[y*bmapwidth + x];
-					FBlockNode *node = FBlockNode::Create (this, x, y);
+		BlockLinkStamp = 1;
+	}
 
-					// Link in to block
-					if ((node->NextActor = *link) != NULL)
-					{
-						(*link)->PrevActor = &node->NextActor;
-					}
-					node->PrevActor = link;
-					*link = node;
-
-					// Link in to actor
-					node->PrevBlock = alink;
-					node->NextBlock = NULL;
-					(*alink) = node;
-					alink = &node->NextBlock;
+	// Keep the entries in the blocks the actor is still in, and drop the
+	// ones it has moved out of. The entries may also be left over from
+	// before the actor got the MF_NOBLOCKMAP flag, or from another level
+	// if it travelled here.
+	FBlockNode **alink = &this->BlockNode;
+	FBlockNode *block;
+
+	while ((block = *alink) != NULL)
+	{
+		if (block->Generation == FBlockNode::CurrentGeneration)
+		{
+			int bx = block->BlockIndex % bmapwidth;
+			int by = block->BlockIndex / bmapwidth;
+
+			if (bx >= x1 && bx <= x2 && by >= y1 && by <= y2)
+			{
+				FBlockCell *cell = &blocklinks[block->BlockIndex];
+
+				if ((unsigned int)block->EntryIndex + 1 != cell->Things.Size())
+				{ // Block searches find the most recently linked things first,
+				  // so the entry has to move to the end of the block.
+					FBlockEntry moved = cell->Things[block->EntryIndex];
+					P_RemoveBlockEntry (block);
+					block->EntryIndex = cell->Things.Push (moved);
 				}
+				FBlockEntry *entry = &cell->Things[block->EntryIndex];
+
+				entry->Me = this;
+				entry->X = x;
+				entry->Y = y;
+				entry->Radius = radius;
+				cell->Stamp = BlockLinkStamp;
+				alink = &block->NextBlock;
+				continue;
+			}
+			P_RemoveBlockEntry (block);
+		}
+		*alink = block->NextBlock;
+		block->Release ();
+	}
+
+	// Then enter the blocks it wasn't in yet.
+	for (int by = y1; by <= y2; ++by)
+	{
+		for (int bx = x1; bx <= x2; ++bx)
+		{
+			int index = by*bmapwidth + bx;
+
+			if (blocklinks[index].Stamp != BlockLinkStamp)
+			{
+				block = FBlockNode::Create (this, index);
+				*alink = block;
+				alink = &block->NextBlock;
 			}
 		}
 	}
@@ -618,10 +708,12 @@ void AActor::SetOrigin (fixed_t ix, fixed_t iy, fixed_t iz)
 }
 
 FBlockNode *FBlockNode::FreeBlocks = NULL;
+unsigned int FBlockNode::CurrentGeneration;
 
-FBlockNode *FBlockNode::Create (AActor *who, int x, int y)
+FBlockNode *FBlockNode::Create (AActor *who, int index)
 {
 	FBlockNode *block;
+	FBlockEntry entry;
 
 	if (FreeBlocks != NULL)
 	{
@@ -632,12 +724,15 @@ FBlockNode *FBlockNode::Create (AActor *who, int x, int y)
 	{
 		block = new FBlockNode;
 	}
-	block->BlockIndex = x + y*bmapwidth;
-	block->Me = who;
-	block->NextActor = NULL;
-	block->PrevActor = NULL;
-	block->PrevBlock = NULL;
+	entry.Me = who;
+	entry.X = who->x;
+	entry.Y = who->y;
+	entry.Radius = who->radius;
+	entry.Node = block;
+	block->BlockIndex = index;
+	block->EntryIndex = blocklinks[index].Things.Push (entry);
 	block->NextBlock = NULL;
+	block->Generation = CurrentGeneration;
 	return block;
 }
 
@@ -647,6 +742,86 @@ void FBlockNode::Release ()
 	FreeBlocks = this;
 }
 
+//==========================================================================
+//
+// P_RemoveBlockEntry
+//
+// Takes the node's entry out of its block. The entries after it move
+// down, so the block stays in linking order. If the blockmap is locked,
+// the entry is only blanked, and P_CompactBlockmap gets rid of it later.
+//
+//==========================================================================
+
+static void P_RemoveBlockEntry (FBlockNode *block)
+{
+	FBlockCell *cell = &blocklinks[block->BlockIndex];
+	FBlockEntry *entry = &cell->Things[block->EntryIndex];
+
+	if (BlockmapLocks > 0)
+	{
+		entry->Me = NULL;
+		entry->Node = NULL;
+		if (cell->Removed++ == 0)
+		{
+			DirtyBlocks.Push (block->BlockIndex);
+		}
+	}
+	else
+	{
+		cell->Things.Delete (block->EntryIndex);
+		for (unsigned int i = block->EntryIndex; i < cell->Things.Size(); ++i)
+		{
+			cell->Things[i].Node->EntryIndex = i;
+		}
+	}
+}
+
+//==========================================================================
+//
+// P_CompactBlockmap
+//
+// Closes the holes that were left in the blocks while the blockmap was
+// locked. The remaining entries keep their order.
+//
+//==========================================================================
+
+void P_CompactBlockmap ()
+{
+	if (blocklinks != NULL)
+	{
+		for (unsigned int i = 0; i < DirtyBlocks.Size(); ++i)
+		{
+			if (DirtyBlocks[i] >= bmapwidth*bmapheight)
+			{ // from a level that is gone now
+				continue;
+			}
+
+			FBlockCell *cell = &blocklinks[DirtyBlocks[i]];
+			unsigned int j = 0;
+
+			if (cell->Removed == 0)
+			{
+				continue;
+			}
+			for (unsigned int k = 0; k < cell->Things.Size(); ++k)
+			{
+				if (cell->Things[k].Node != NULL)
+				{
+					if (j != k)
+					{
+						cell->Things[j] = cell->Things[k];
+						cell->Things[j].Node->EntryIndex = j;
+					}
+					++j;
+				}
+			}
+			cell->Things.Resize (j);
+			cell->Removed = 0;
+		}
+	}
+	DirtyBlocks.Clear ();
+}
+
 //
 // BLOCK MAP ITERATORS
 // For each line/thing in the given mapblock,
@@ -796,8 +971,10 @@ FBlockThingsIterator::FBlockThingsIterator()
 {
 	minx = maxx = 0;
 	miny = maxy = 0;
+	clipped = false;
 	ClearHash();
-	block = NULL;
+	cell = NULL;
+	index = 0;
 }
 
 FBlockThingsIterator::FBlockThingsIterator(int _minx, int _miny, int _maxx, int _maxy)
@@ -807,17 +984,32 @@ FBlockThingsIterator::FBlockThingsIterator(int _minx, int _miny, int _maxx, int
 	maxx = _maxx;
 	miny = _miny;
 	maxy = _maxy;
+	clipped = false;
 	ClearHash();
 	Reset();
 }
 
-FBlockThingsIterator::FBlockThingsIterator(const FBoundingBox &box)
+//===========================================================================
+//
+// With clip set, only the actors whose boxes overlap the given box are
+// returned, i.e. those that AActor::intersects would accept. This is decided
+// with the position and radius the actor was linked with, so the actors
+// that are out of reach never need to be touched.
+//
+//===========================================================================
+
+FBlockThingsIterator::FBlockThingsIterator(const FBoundingBox &box, bool clip)
 : DynHash(0)
 {
 	maxy = GetSafeBlockY(box.Top() - bmaporgy);
 	miny = GetSafeBlockY(box.Bottom() - bmaporgy);
 	maxx = GetSafeBlockX(box.Right() - bmaporgx);
 	minx = GetSafeBlockX(box.Left() - bmaporgx);
+	clipped = clip;
+	clipleft = box.Left();
+	clipright = box.Right();
+	clipbottom = box.Bottom();
+	cliptop = box.Top();
 	ClearHash();
 	Reset();
 }
@@ -847,12 +1039,15 @@ void FBlockThingsIterator::StartBlock(int x, int y)
 	cury = y; 
 	if (x >= 0 && y >= 0 && x < bmapwidth && y <bmapheight)
 	{
-		block = blocklinks[y*bmapwidth + x];
+		// The newest entries are at the end.
+		cell = &blocklinks[y*bmapwidth + x];
+		index = cell->Things.Size();
 	}
 	else
 	{
 		// invalid block
-		block = NULL;
+		cell = NULL;
+		index = 0;
 	}
 }
 
@@ -879,16 +1074,25 @@ AActor *FBlockThingsIterator::Next()
 {
 	for (;;)
 	{
-		while (block != NULL)
+		while (index > 0)
 		{
-			AActor *me = block->Me;
-			FBlockNode *mynode = block;
+			const FBlockEntry *link = &cell->Things[--index];
+			AActor *me = link->Me;
 			HashEntry *entry;
 			int i;
 
-			block = block->NextActor;
+			if (me == NULL)
+			{ // removed, or waiting to be relinked
+				continue;
+			}
+			if (clipped &&
+				(link->X + link->Radius <= clipleft || link->X - link->Radius >= clipright ||
+				 link->Y + link->Radius <= clipbottom || link->Y - link->Radius >= cliptop))
+			{ // Every block of this actor has the same box, so this can't let it through later.
+				continue;
+			}
 			// Don't recheck things that were already checked
-			if (mynode->NextBlock == NULL && mynode->PrevBlock == &me->BlockNode)
+			if (link->Node->NextBlock == NULL && me->BlockNode == link->Node)
 			{ // This actor doesn't span blocks, so we know it can only ever be checked once.
 				return me;
 			}
@@ -1425,17 +1629,109 @@ AActor *P_BlockmapSearch (AActor *mo, int distance, AActor *(*check)(AActor*, in
 
 static AActor *RoughBlockCheck (AActor *mo, int index)
 {
-	FBlockNode *link;
+	FBlockCell *cell = &blocklinks[index];
 
-	for (link = blocklinks[index]; link != NULL; link = link->NextActor)
+	for (int i = (int)cell->Things.Size() - 1; i >= 0; --i)
 	{
-		if (link->Me != mo)
+		AActor *link = cell->Things[i].Me;
+
+		if (link != NULL && link != mo)
 		{
-			if (mo->IsOkayToAttack (link->Me))
+			if (mo->IsOkayToAttack (link))
 			{
-				return link->Me;
+				return link;
 			}
 		}
 	}
 	return NULL;
 }
+
+//===========================================================================
+//
+// CCMD blockbench
+//
+// Times a P_CheckPosition-like search around every actor in the blockmap.
+// Once the block entries reject the actors out of reach, once the actors
+// are looked at for that, like the searches did before.
+//
+//===========================================================================
+
+CCMD (blockbench)
+{
+	const int runs = argv.argc() > 1 ? MAX (1, atoi (argv[1])) : 10;
+	TThinkerIterator<AActor> it;
+	TArray<AActor *> things;
+	AActor *mo;
+
+	while ((mo = it.Next()) != NULL)
+	{
+		if (mo->BlockNode != NULL)
+		{
+			things.Push (mo);
+		}
+	}
+	if (things.Size() == 0)
+	{
+		Printf ("There are no actors in the blockmap.\n");
+		return;
+	}
+
+	cycle_t clipcycles, checkcycles;
+	int clipfound = 0, checkfound = 0;
+
+	clipcycles.Reset();
+	clipcycles.Clock();
+	for (int run = 0; run < runs; ++run)
+	{
+		for (unsigned int i = 0; i < things.Size(); ++i)
+		{
+			mo = things[i];
+			FBlockThingsIterator it2(FBoundingBox(mo->x, mo->y, mo->radius), true);
+			AActor *th;
+
+			while ((th = it2.Next()) != NULL)
+			{
+				if (th != mo)
+				{
+					clipfound++;
+				}
+			}
+		}
+	}
+	clipcycles.Unclock();
+
+	checkcycles.Reset();
+	checkcycles.Clock();
+	for (int run = 0; run < runs; ++run)
+	{
+		for (unsigned int i = 0; i < things.Size(); ++i)
+		{
+			mo = things[i];
+			FBlockThingsIterator it2(FBoundingBox(mo->x, mo->y, mo->radius));
+			AActor *th;
+
+			while ((th = it2.Next()) != NULL)
+			{
+				fixed_t blockdist = th->radius + mo->radius;
+
+				if (abs(th->x - mo->x) >= blockdist || abs(th->y - mo->y) >= blockdist)
+				{
+					continue;
+				}
+				if (th != mo)
+				{
+					checkfound++;
+				}
+			}
+		}
+	}
+	checkcycles.Unclock();
+
+	double cliptime = clipcycles.TimeMS() / runs;
+	double checktime = checkcycles.TimeMS() / runs;
+
+	Printf ("%u actors, %d runs\n", things.Size(), runs);
+	Printf ("Filtered by the block entries: %.3f ms per run, %d found\n", cliptime, clipfound / runs);
+	Printf ("Filtered by the actors: %.3f ms per run, %d found (%.1fx)\n", checktime, checkfound / runs,
+		cliptime > 0 ? checktime / cliptime : 0.);
+}
@@ -123,7 +123,20 @@ static FRandom pr_multiclasschoice ("MultiClassChoice");
 static FRandom pr_rockettrail("RocketTrail");
 
 /*static*/	NETIDNODE_t	g_NetIDList[MAX_NETID];
-static	ULONG		g_ulFirstFreeNetID = 1;
+
+// The free network IDs in the order they were freed. New IDs are taken from the front
+// and freed ones are put at the back, so that an ID is reused as late as possible.
+static	LONG		g_lFirstFreeNetID = -1;
+static	LONG		g_lLastFreeNetID = -1;
+static	bool		g_bNetIDListInitialized = false;
+
+// Statistics about the network IDs, see the netidstats command.
+static	ULONG		g_ulNetIDsInUse = 0;
+static	ULONG		g_ulMaxNetIDsInUse = 0;
+static	QWORD		g_qwNetIDsAcquired = 0;
+static	QWORD		g_qwNetIDsReused = 0;
+static	QWORD		g_qwNetIDsReleased = 0;
+static	QWORD		g_qwStaleNetIDReferences = 0;
 
 static	LONG	g_lSpawnCount = 0;
 static	cycle_t	g_SpawnCycles;
@@ -4148,19 +4161,68 @@ bool AActor::UpdateWaterLevel (fixed_t oldz, bool dosplash)
 
 //==========================================================================
 //
+//*****************************************************************************
+//
+static void actor_LinkFreeNetID( LONG lNetID )
+{
+	// [BB] ID zero is reserved and never handed out.
+	if ( lNetID == 0 )
+		return;
+
+	g_NetIDList[lNetID].lPrevFree = g_lLastFreeNetID;
+	g_NetIDList[lNetID].lNextFree = -1;
+
+	if ( g_lLastFreeNetID != -1 )
+		g_NetIDList[g_lLastFreeNetID].lNextFree = lNetID;
+	else
+		g_lFirstFreeNetID = lNetID;
+
+	g_lLastFreeNetID = lNetID;
+}
+
+//*****************************************************************************
+//
+static void actor_UnlinkFreeNetID( LONG lNetID )
+{
+	if ( lNetID == 0 )
+		return;
+
+	NETIDNODE_t *pNode = &g_NetIDList[lNetID];
+
+	if ( pNode->lPrevFree != -1 )
+		g_NetIDList[pNode->lPrevFree].lNextFree = pNode->lNextFree;
+	else
+		g_lFirstFreeNetID = pNode->lNextFree;
+
+	if ( pNode->lNextFree != -1 )
+		g_NetIDList[pNode->lNextFree].lPrevFree = pNode->lPrevFree;
+	else
+		g_lLastFreeNetID = pNode->lPrevFree;
+
+	pNode->lPrevFree = pNode->lNextFree = -1;
+}
+
 //*****************************************************************************
 //
 void ACTOR_ClearNetIDList( void )
 {
 	ULONG	ulIdx;
 
+	g_lFirstFreeNetID = g_lLastFreeNetID = -1;
+
 	for ( ulIdx = 0; ulIdx < MAX_NETID; ulIdx++ )
 	{
+		// Invalidate the handles of the actors that had an ID.
+		if ( g_NetIDList[ulIdx].bFree == false )
+			g_NetIDList[ulIdx].usGeneration++;
+
 		g_NetIDList[ulIdx].bFree = true;
 		g_NetIDList[ulIdx].pActor = NULL;
+		actor_LinkFreeNetID( ulIdx );
 	}
 
-	g_ulFirstFreeNetID = 1;
+	g_ulNetIDsInUse = 0;
+	g_bNetIDListInitialized = true;
 }
 
 //*****************************************************************************
@@ -4176,10 +4238,7 @@ void ACTOR_RebuildNetIDList( void )
 	while ( (pActor = it.Next()) )
 	{
 		if (( pActor->lNetID > 0 ) && ( pActor->lNetID < MAX_NETID ))
-		{
-			g_NetIDList[pActor->lNetID].bFree = false;
-			g_NetIDList[pActor->lNetID].pActor = pActor;
-		}
+			ACTOR_AssignNetID( pActor, pActor->lNetID );
 	}
 }
 
@@ -4189,50 +4248,152 @@ void CountActors ( ); // [BB]
 
 ULONG ACTOR_GetNewNetID( void )
 {
-	ULONG	ulID;
+	if ( g_bNetIDListInitialized == false )
+		ACTOR_ClearNetIDList( );
 
-	// Actor's network ID is the first availible net ID.
-	ulID = g_ulFirstFreeNetID;
+	// Actor's network ID is the ID that has been free for the longest time.
+	if ( g_lFirstFreeNetID == -1 )
+	{
+		// [BB] In case there is no free netID, the server has to abort the current game.
+		if ( NETWORK_GetState( ) == NETSTATE_SERVER )
+		{
+			// [BB] We can only spawn (MAX_NETID-1) actors with netID, because ID zero is reserved.
+			Printf( "ACTOR_GetNewNetID: Network ID limit reached (>=%d actors)\n", MAX_NETID - 1 );
+			CountActors ( );
+			I_Error ("Network ID limit reached (>=%d actors)!\n", MAX_NETID - 1 );
+		}
 
-	do
+		return ( 0 );
+	}
+
+	return ( g_lFirstFreeNetID );
+}
+
+//*****************************************************************************
+//
+void ACTOR_AssignNetID( AActor *pActor, LONG lNetID )
+{
+	pActor->lNetID = lNetID;
+
+	if (( lNetID < 0 ) || ( lNetID >= MAX_NETID ))
+		return;
+
+	if ( g_bNetIDListInitialized == false )
+		ACTOR_ClearNetIDList( );
+
+	NETIDNODE_t *pNode = &g_NetIDList[lNetID];
+
+	if ( pNode->bFree )
 	{
-		g_ulFirstFreeNetID++;
-		if ( g_ulFirstFreeNetID >= MAX_NETID )
-			g_ulFirstFreeNetID = 1;
+		actor_UnlinkFreeNetID( lNetID );
+		pNode->bFree = false;
 
-		if ( g_ulFirstFreeNetID == ulID )
-		{
-			// [BB] In case there is no free netID, the server has to abort the current game.
-			if ( NETWORK_GetState( ) == NETSTATE_SERVER )
-			{
-				// [BB] We can only spawn (MAX_NETID-2) actors with netID, because ID zero is reserved and
-				// we already check that a new ID for the next actor is available when assign a net ID.
-				Printf( "ACTOR_GetNewNetID: Network ID limit reached (>=%d actors)\n", MAX_NETID - 1 );
-				CountActors ( );
-				I_Error ("Network ID limit reached (>=%d actors)!\n", MAX_NETID - 1 );
-			}
+		g_qwNetIDsAcquired++;
+		if ( pNode->usGeneration > 0 )
+			g_qwNetIDsReused++;
+		g_ulNetIDsInUse++;
+		g_ulMaxNetIDsInUse = MAX( g_ulMaxNetIDsInUse, g_ulNetIDsInUse );
+	}
+	// The ID is given to another actor before the old one released it (a client may be told
+	// about a new actor before the old one is deleted). Old handles must not find the new actor.
+	else if ( pNode->pActor != pActor )
+	{
+		pNode->usGeneration++;
+		g_qwStaleNetIDReferences++;
+	}
 
-			return ( 0 );
-		}
-	} while ( g_NetIDList[g_ulFirstFreeNetID].bFree == false );
+	pNode->pActor = pActor;
+}
 
-	return ( ulID );
+//*****************************************************************************
+//
+void ACTOR_ReleaseNetID( AActor *pActor )
+{
+	const LONG lNetID = pActor->lNetID;
+
+	pActor->lNetID = -1;
+
+	// [BB] Actors may have lNetID == -1.
+	if (( lNetID < 0 ) || ( lNetID >= MAX_NETID ))
+		return;
+
+	NETIDNODE_t *pNode = &g_NetIDList[lNetID];
+
+	// The ID already belongs to another actor, don't take it away from it.
+	if ( pNode->bFree || ( pNode->pActor != pActor ))
+	{
+		if ( pNode->pActor != NULL )
+			g_qwStaleNetIDReferences++;
+		return;
+	}
+
+	pNode->bFree = true;
+	pNode->pActor = NULL;
+	pNode->usGeneration++;
+	actor_LinkFreeNetID( lNetID );
+
+	g_qwNetIDsReleased++;
+	g_ulNetIDsInUse--;
 }
 
-// [BB] AActor::FreeNetID
+//*****************************************************************************
 //
-//==========================================================================
+AActor *ACTOR_FindThingByNetID( LONG lNetID )
+{
+	if (( lNetID < 0 ) || ( lNetID >= MAX_NETID ))
+		return ( NULL );
 
-void AActor::FreeNetID ()
+	const NETIDNODE_t *pNode = &g_NetIDList[lNetID];
+
+	if (( pNode->bFree ) || ( pNode->pActor == NULL ))
+		return ( NULL );
+
+	// The actor doesn't think it has this ID (anymore).
+	if ( pNode->pActor->lNetID != lNetID )
+	{
+		g_qwStaleNetIDReferences++;
+		return ( NULL );
+	}
+
+	return ( pNode->pActor );
+}
+
+//*****************************************************************************
+//
+ULONG ACTOR_GetNetIDHandle( const AActor *pActor )
+{
+	if (( pActor == NULL ) || ( pActor->lNetID <= 0 ) || ( pActor->lNetID >= MAX_NETID ))
+		return ( 0 );
+
+	return (( static_cast<ULONG>( g_NetIDList[pActor->lNetID].usGeneration ) << 16 ) | pActor->lNetID );
+}
+
+//*****************************************************************************
+//
+AActor *ACTOR_FindThingByNetIDHandle( ULONG ulHandle )
 {
-	// [BB] Actors may have lNetID == -1. 
-	if ( ( lNetID >= 0 ) && ( lNetID < MAX_NETID ) )
+	const LONG lNetID = ulHandle & 0xFFFF;
+
+	if (( lNetID <= 0 ) || ( lNetID >= MAX_NETID ))
+		return ( NULL );
+
+	// The actor that had this ID is gone.
+	if ( g_NetIDList[lNetID].usGeneration != ( ulHandle >> 16 ))
 	{
-		g_NetIDList[lNetID].bFree = true;
-		g_NetIDList[lNetID].pActor = NULL;
+		g_qwStaleNetIDReferences++;
+		return ( NULL );
 	}
 
-	lNetID = -1;
+	return ( ACTOR_FindThingByNetID( lNetID ));
+}
+
+// [BB] AActor::FreeNetID
+//
+//==========================================================================
+
+void AActor::FreeNetID ()
+{
+	ACTOR_ReleaseNetID( this );
 }
 
 //==========================================================================
@@ -4426,9 +4587,7 @@ AActor *AActor::StaticSpawn (const PClass *type, fixed_t ix, fixed_t iy, fixed_t
 		( NETWORK_GetState( ) != NETSTATE_CLIENT ) &&
 		( CLIENTDEMO_IsPlaying( ) == false ))
 	{
-		actor->lNetID = ACTOR_GetNewNetID( );
-		g_NetIDList[actor->lNetID].pActor = actor;
-		g_NetIDList[actor->lNetID].bFree = false;
+		ACTOR_AssignNetID( actor, ACTOR_GetNewNetID( ));
 	}
 	else
 		actor->lNetID = -1;
@@ -4608,14 +4767,7 @@ bool AActor::IsActive( void )
 void AActor::Destroy ()
 {
 	// [BC] Free it's network ID.
-	// [BB] Actors may have lNetID == -1. 
-	if ( ( lNetID >= 0 ) && ( lNetID < MAX_NETID ) )
-	{
-		g_NetIDList[lNetID].bFree = true;
-		g_NetIDList[lNetID].pActor = NULL;
-	}
-
-	lNetID = -1;
+	ACTOR_ReleaseNetID( this );
 
 	// [BB] If this is a monster corpse, we potentially have to NULL out the reference to it.
 	if ( invasion )
@@ -4633,6 +4785,7 @@ void AActor::Destroy ()
 	// unlink from sector and block lists
 	UnlinkFromWorld ();
 	flags |= MF_NOSECTOR|MF_NOBLOCKMAP;
+	ReleaseBlockNodes ();
 
 	// Delete all nodes on the current sector_list			phares 3/16/98
 	P_DelSector_List();
@@ -5740,9 +5893,7 @@ AActor *P_SpawnPuff (AActor *source, const PClass *pufftype, fixed_t x, fixed_t
 		{
 			if ( puff->lNetID == -1 )
 			{
-				puff->lNetID = ACTOR_GetNewNetID( );
-				g_NetIDList[puff->lNetID].pActor = puff;
-				g_NetIDList[puff->lNetID].bFree = false;
+				ACTOR_AssignNetID( puff, ACTOR_GetNewNetID( ));
 			}
 
 			SERVERCOMMANDS_SpawnThing( puff );
@@ -6988,6 +7139,14 @@ CCMD( dumpactors )
 		Printf( "%s (%d, %d)\n", pActor->GetClass( )->TypeName.GetChars( ), pActor->x >> FRACBITS, pActor->y >> FRACBITS );
 }
 
+CCMD( netidstats )
+{
+	Printf( "%lu network IDs in use (at most %lu), %d free.\n", g_ulNetIDsInUse, g_ulMaxNetIDsInUse, static_cast<int>( MAX_NETID - 1 - g_ulNetIDsInUse ));
+	Printf( "%llu acquired (%llu reused), %llu released.\n", static_cast<unsigned long long>( g_qwNetIDsAcquired ),
+		static_cast<unsigned long long>( g_qwNetIDsReused ), static_cast<unsigned long long>( g_qwNetIDsReleased ));
+	Printf( "%llu stale references caught.\n", static_cast<unsigned long long>( g_qwStaleNetIDReferences ));
+}
+
 CCMD( respawnactors )
 {
 	AActor						*pActor;
@@ -459,6 +459,7 @@ manual_plat:
 
 				// [BC] Also, mark this sector as having its flat changed.
 				sec->bFlatChange = true;
+				SERVER_LEVELCHANGES_MarkSector( ULONG( sec - sectors ));
 			}
 			if (change == 1)
 				sec->special &= SECRET_MASK;	// Stop damage and other stuff, if any
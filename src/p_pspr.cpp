@@ -817,7 +817,7 @@ angle_t P_BulletSlope (AActor *mo, AActor **pLineTarget)
 	AActor *linetarget;
 
 	// [Spleen]
-	UNLAGGED_Reconcile( mo );
+	UNLAGGED_ReconcileRange( mo, 16*64*FRACUNIT );
 	UNLAGGED_AddReconciliationBlocker( );
 
 	// see which target is to be aimed at
@@ -0,0 +1,504 @@
+//-----------------------------------------------------------------------------
+//
+// Skulltag Source
+// Copyright (C) 2007-2012 Skulltag Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+//
+// Filename: p_rejectbuilder.cpp
+//
+// Description: Builds a REJECT table for maps that don't come with one.
+//
+// Two sectors can only see each other if a straight line leads from one to the
+// other that only crosses two-sided lines. For every sector, the builder
+// follows the two-sided lines ("portals") out of it and only continues through
+// the part of a portal that a straight line through the first portal can reach.
+// The window is narrowed by the lines of the first and the current portal and
+// the two lines that separate them, which is a superset of what an exact test
+// allows. Heights, flags and polyobjects are ignored, since they can change.
+// So the table is conservative: if two sectors are rejected, P_CheckSight could
+// never have found a line of sight between them.
+//
+// Building the table for large maps takes a while, so it's cached on disk under
+// the map's checksum.
+//
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+
+#include "c_cvars.h"
+#include "cmdlib.h"
+#include "doomstat.h"
+#include "i_system.h"
+#include "p_local.h"
+#include "p_setup.h"
+#include "r_state.h"
+#include "version.h"
+
+//*****************************************************************************
+//	DEFINES
+
+// Changing the builder invalidates the cached tables.
+#define	REJECTCACHE_MAGIC		"REJ1"
+
+// Number of portals a sector may look through before we give up and let it see
+// everything it's connected to.
+#define	REJECTBUILDER_BUDGET	16384
+
+// Points this close to a line (in map units times the line's length) count as on it.
+#define	REJECTBUILDER_EPSILON	0.01
+
+//*****************************************************************************
+//	TYPES
+
+// A two-sided line seen from one of its sides.
+typedef struct
+{
+	double			dX1, dY1;
+	double			dX2, dY2;
+
+	// The sector the portal leads out of and the one it leads into.
+	int				iFromSector;
+	int				iToSector;
+
+	int				iLine;
+
+	// Sign of the cross product of the points on the far side of the portal.
+	double			dFarSide;
+
+} REJECTPORTAL_s;
+
+//*****************************************************************************
+typedef struct
+{
+	double			dX1, dY1;
+	double			dX2, dY2;
+
+} REJECTWINDOW_s;
+
+//*****************************************************************************
+//	VARIABLES
+
+static	TArray<REJECTPORTAL_s>	g_Portals;
+
+// The portals leading out of each sector.
+static	TArray<int>				g_SectorPortalStart;
+static	TArray<int>				g_SectorPortals;
+
+// Lines the current chain of portals already crossed. A straight line crosses each
+// line only once.
+static	TArray<bool>			g_LineOnStack;
+
+// Sectors that can be seen from the current source sector.
+static	BYTE					*g_pbVisible;
+static	ULONG					g_ulBudget;
+
+//*****************************************************************************
+//	CONSOLE VARIABLES
+
+// Build a REJECT table for maps that don't have one.
+CVAR( Bool, reject_build, true, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+// Where the built REJECT tables are cached (empty = default location).
+CVAR( String, reject_cachedir, "", CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+//*****************************************************************************
+//	FUNCTIONS
+
+static double rejectbuilder_Side( double dX1, double dY1, double dX2, double dY2, double dX, double dY )
+{
+	return (( dX2 - dX1 ) * ( dY - dY1 ) - ( dY2 - dY1 ) * ( dX - dX1 ));
+}
+
+//*****************************************************************************
+//
+// Cuts off the part of the window whose side of the given line has the wrong sign.
+// Returns false if nothing is left.
+static bool rejectbuilder_ClipWindow( REJECTWINDOW_s &Window, double dX1, double dY1, double dX2, double dY2, double dSign )
+{
+	const double dSide1 = dSign * rejectbuilder_Side( dX1, dY1, dX2, dY2, Window.dX1, Window.dY1 );
+	const double dSide2 = dSign * rejectbuilder_Side( dX1, dY1, dX2, dY2, Window.dX2, Window.dY2 );
+
+	if (( dSide1 >= -REJECTBUILDER_EPSILON ) && ( dSide2 >= -REJECTBUILDER_EPSILON ))
+		return ( true );
+
+	if (( dSide1 < -REJECTBUILDER_EPSILON ) && ( dSide2 < -REJECTBUILDER_EPSILON ))
+		return ( false );
+
+	const double dFrac = dSide1 / ( dSide1 - dSide2 );
+	const double dX = Window.dX1 + ( Window.dX2 - Window.dX1 ) * dFrac;
+	const double dY = Window.dY1 + ( Window.dY2 - Window.dY1 ) * dFrac;
+
+	if ( dSide1 < -REJECTBUILDER_EPSILON )
+	{
+		Window.dX1 = dX;
+		Window.dY1 = dY;
+	}
+	else
+	{
+		Window.dX2 = dX;
+		Window.dY2 = dY;
+	}
+
+	return ( true );
+}
+
+//*****************************************************************************
+//
+// Cuts off the part of the window that no straight line through the source and the pass
+// window can reach. These lines are bounded by the two lines that go through an end of
+// the source and an end of the pass window and have the source and the pass on
+// different sides.
+static bool rejectbuilder_ClipToSeparators( REJECTWINDOW_s &Window, const REJECTWINDOW_s &Source, const REJECTWINDOW_s &Pass )
+{
+	const double adSourceX[2] = { Source.dX1, Source.dX2 };
+	const double adSourceY[2] = { Source.dY1, Source.dY2 };
+	const double adPassX[2] = { Pass.dX1, Pass.dX2 };
+	const double adPassY[2] = { Pass.dY1, Pass.dY2 };
+
+	for ( int iSource = 0; iSource < 2; iSource++ )
+	{
+		for ( int iPass = 0; iPass < 2; iPass++ )
+		{
+			const double dX1 = adSourceX[iSource];
+			const double dY1 = adSourceY[iSource];
+			const double dX2 = adPassX[iPass];
+			const double dY2 = adPassY[iPass];
+
+			const double dSourceSide = rejectbuilder_Side( dX1, dY1, dX2, dY2, adSourceX[!iSource], adSourceY[!iSource] );
+			const double dPassSide = rejectbuilder_Side( dX1, dY1, dX2, dY2, adPassX[!iPass], adPassY[!iPass] );
+
+			// Degenerate cases don't give a usable separator. Skipping them only lets
+			// us see more.
+			if (( fabs( dSourceSide ) <= REJECTBUILDER_EPSILON ) || ( fabs( dPassSide ) <= REJECTBUILDER_EPSILON ))
+				continue;
+
+			if (( dSourceSide > 0 ) == ( dPassSide > 0 ))
+				continue;
+
+			if ( rejectbuilder_ClipWindow( Window, dX1, dY1, dX2, dY2, ( dPassSide > 0 ) ? 1.0 : -1.0 ) == false )
+				return ( false );
+		}
+	}
+
+	return ( true );
+}
+
+//*****************************************************************************
+//
+static void rejectbuilder_SetVisible( int iSector )
+{
+	g_pbVisible[iSector >> 3] |= ( 1 << ( iSector & 7 ));
+}
+
+//*****************************************************************************
+//
+// Looks through all portals leading out of the sector behind pPass.
+static void rejectbuilder_Flood( const REJECTPORTAL_s *pSource, const REJECTPORTAL_s *pPass, const REJECTWINDOW_s &PassWindow )
+{
+	const REJECTWINDOW_s	SourceWindow = { pSource->dX1, pSource->dY1, pSource->dX2, pSource->dY2 };
+
+	for ( int iIdx = g_SectorPortalStart[pPass->iToSector]; iIdx < g_SectorPortalStart[pPass->iToSector + 1]; iIdx++ )
+	{
+		const REJECTPORTAL_s	*pPortal = &g_Portals[g_SectorPortals[iIdx]];
+		REJECTWINDOW_s			Window = { pPortal->dX1, pPortal->dY1, pPortal->dX2, pPortal->dY2 };
+
+		if ( g_ulBudget == 0 )
+			return;
+
+		if ( g_LineOnStack[pPortal->iLine] )
+			continue;
+
+		// Once a line of sight crossed a portal, it stays on the portal's far side.
+		if ( rejectbuilder_ClipWindow( Window, pSource->dX1, pSource->dY1, pSource->dX2, pSource->dY2, pSource->dFarSide ) == false )
+			continue;
+		if ( rejectbuilder_ClipWindow( Window, pPass->dX1, pPass->dY1, pPass->dX2, pPass->dY2, pPass->dFarSide ) == false )
+			continue;
+		if (( pPass != pSource ) && ( rejectbuilder_ClipToSeparators( Window, SourceWindow, PassWindow ) == false ))
+			continue;
+
+		g_ulBudget--;
+		rejectbuilder_SetVisible( pPortal->iToSector );
+
+		g_LineOnStack[pPortal->iLine] = true;
+		rejectbuilder_Flood( pSource, pPortal, Window );
+		g_LineOnStack[pPortal->iLine] = false;
+	}
+}
+
+//*****************************************************************************
+//
+static void rejectbuilder_AddPortal( line_t *pLine, sector_t *pFrom, sector_t *pTo, double dFarSide )
+{
+	REJECTPORTAL_s	Portal;
+
+	Portal.dX1 = pLine->v1->x / 65536.0;
+	Portal.dY1 = pLine->v1->y / 65536.0;
+	Portal.dX2 = pLine->v2->x / 65536.0;
+	Portal.dY2 = pLine->v2->y / 65536.0;
+	Portal.iFromSector = int( pFrom - sectors );
+	Portal.iToSector = int( pTo - sectors );
+	Portal.iLine = int( pLine - lines );
+	Portal.dFarSide = dFarSide;
+	g_Portals.Push( Portal );
+}
+
+//*****************************************************************************
+//
+static void rejectbuilder_FindPortals( void )
+{
+	int		iIdx;
+
+	g_Portals.Clear( );
+	for ( iIdx = 0; iIdx < numlines; iIdx++ )
+	{
+		line_t	*pLine = &lines[iIdx];
+
+		if (( pLine->frontsector == NULL ) || ( pLine->backsector == NULL ))
+			continue;
+
+		// The front side is on the right of the line, so the back side is on the left.
+		rejectbuilder_AddPortal( pLine, pLine->frontsector, pLine->backsector, 1.0 );
+		rejectbuilder_AddPortal( pLine, pLine->backsector, pLine->frontsector, -1.0 );
+	}
+
+	// Sort the portals by the sector they lead out of.
+	g_SectorPortalStart.Resize( numsectors + 1 );
+	for ( iIdx = 0; iIdx <= numsectors; iIdx++ )
+		g_SectorPortalStart[iIdx] = 0;
+	for ( iIdx = 0; iIdx < static_cast<int>( g_Portals.Size( )); iIdx++ )
+		g_SectorPortalStart[g_Portals[iIdx].iFromSector + 1]++;
+	for ( iIdx = 0; iIdx < numsectors; iIdx++ )
+		g_SectorPortalStart[iIdx + 1] += g_SectorPortalStart[iIdx];
+
+	TArray<int>	NextSlot( numsectors );
+	NextSlot.Resize( numsectors );
+	for ( iIdx = 0; iIdx < numsectors; iIdx++ )
+		NextSlot[iIdx] = g_SectorPortalStart[iIdx];
+
+	g_SectorPortals.Resize( g_Portals.Size( ));
+	for ( iIdx = 0; iIdx < static_cast<int>( g_Portals.Size( )); iIdx++ )
+		g_SectorPortals[NextSlot[g_Portals[iIdx].iFromSector]++] = iIdx;
+}
+
+//*****************************************************************************
+//
+// Lets the source sector see every sector it's connected to in any way.
+static void rejectbuilder_SetConnectedVisible( int iSourceSector )
+{
+	TArray<int>	Pending;
+
+	memset( g_pbVisible, 0, ( numsectors + 7 ) >> 3 );
+	rejectbuilder_SetVisible( iSourceSector );
+	Pending.Push( iSourceSector );
+
+	while ( Pending.Size( ) > 0 )
+	{
+		int iSector;
+
+		Pending.Pop( iSector );
+		for ( int iIdx = g_SectorPortalStart[iSector]; iIdx < g_SectorPortalStart[iSector + 1]; iIdx++ )
+		{
+			const int iToSector = g_Portals[g_SectorPortals[iIdx]].iToSector;
+
+			if ( g_pbVisible[iToSector >> 3] & ( 1 << ( iToSector & 7 )))
+				continue;
+
+			rejectbuilder_SetVisible( iToSector );
+			Pending.Push( iToSector );
+		}
+	}
+}
+
+//*****************************************************************************
+//
+static FString rejectbuilder_GetCacheFileName( MapData *map )
+{
+	FString	Path = *reject_cachedir;
+	BYTE	abChecksum[16];
+
+	if ( Path.IsEmpty( ))
+	{
+#if defined(unix) || defined(__APPLE__)
+		Path = "~/" GAME_DIR "/rejectcache/";
+#else
+		Path = progdir + "rejectcache/";
+#endif
+	}
+	else if (( Path[Path.Len( ) - 1] != '/' ) && ( Path[Path.Len( ) - 1] != '\\' ))
+		Path += '/';
+
+	Path = NicePath( Path );
+
+	map->GetChecksum( abChecksum );
+	for ( ULONG ulIdx = 0; ulIdx < sizeof( abChecksum ); ulIdx++ )
+		Path.AppendFormat( "%02x", abChecksum[ulIdx] );
+	Path += ".rej";
+
+	return ( Path );
+}
+
+//*****************************************************************************
+//
+static bool rejectbuilder_LoadFromCache( const FString &FileName, BYTE *pbReject, ULONG ulSize )
+{
+	FILE	*pFile = fopen( FileName, "rb" );
+	char	szMagic[4];
+	DWORD	adwCounts[2];
+	bool	bLoaded = false;
+
+	if ( pFile == NULL )
+		return ( false );
+
+	if (( fread( szMagic, sizeof( szMagic ), 1, pFile ) == 1 ) &&
+		( memcmp( szMagic, REJECTCACHE_MAGIC, sizeof( szMagic )) == 0 ) &&
+		( fread( adwCounts, sizeof( adwCounts ), 1, pFile ) == 1 ) &&
+		( adwCounts[0] == static_cast<DWORD>( numsectors )) &&
+		( adwCounts[1] == static_cast<DWORD>( numlines )) &&
+		( fread( pbReject, ulSize, 1, pFile ) == 1 ))
+	{
+		bLoaded = true;
+	}
+
+	fclose( pFile );
+	return ( bLoaded );
+}
+
+//*****************************************************************************
+//
+static void rejectbuilder_SaveToCache( const FString &FileName, const BYTE *pbReject, ULONG ulSize )
+{
+	const DWORD	adwCounts[2] = { static_cast<DWORD>( numsectors ), static_cast<DWORD>( numlines ) };
+
+	CreatePath( FileName.Left( FileName.LastIndexOfAny( "/\\" ) + 1 ));
+
+	FILE *pFile = fopen( FileName, "wb" );
+	if ( pFile == NULL )
+		return;
+
+	const bool bWritten = ( fwrite( REJECTCACHE_MAGIC, 4, 1, pFile ) == 1 ) &&
+		( fwrite( adwCounts, sizeof( adwCounts ), 1, pFile ) == 1 ) &&
+		( fwrite( pbReject, ulSize, 1, pFile ) == 1 );
+
+	fclose( pFile );
+
+	// Don't leave a broken file behind, it would only be rejected the next time.
+	if ( bWritten == false )
+		remove( FileName );
+}
+
+//*****************************************************************************
+//
+void P_BuildReject( MapData *map )
+{
+	if (( reject_build == false ) || ( numsectors <= 0 ))
+		return;
+
+	const ULONG		ulSize = ( static_cast<ULONG>( numsectors ) * numsectors + 7 ) >> 3;
+	const FString	CacheFileName = rejectbuilder_GetCacheFileName( map );
+
+	rejectmatrix = new BYTE[ulSize];
+	if ( rejectbuilder_LoadFromCache( CacheFileName, rejectmatrix, ulSize ))
+		return;
+
+	const unsigned int	uStartTime = I_MSTime( );
+	const ULONG			ulRowSize = ( numsectors + 7 ) >> 3;
+	BYTE				*pbVisibility = new BYTE[ulRowSize * numsectors];
+	ULONG				ulNumOverBudget = 0;
+	int					iSource;
+	int					iTarget;
+
+	rejectbuilder_FindPortals( );
+	g_LineOnStack.Resize( numlines );
+	for ( int iIdx = 0; iIdx < numlines; iIdx++ )
+		g_LineOnStack[iIdx] = false;
+
+	for ( iSource = 0; iSource < numsectors; iSource++ )
+	{
+		g_pbVisible = pbVisibility + iSource * ulRowSize;
+		g_ulBudget = REJECTBUILDER_BUDGET;
+		memset( g_pbVisible, 0, ulRowSize );
+		rejectbuilder_SetVisible( iSource );
+
+		for ( int iIdx = g_SectorPortalStart[iSource]; iIdx < g_SectorPortalStart[iSource + 1]; iIdx++ )
+		{
+			const REJECTPORTAL_s	*pPortal = &g_Portals[g_SectorPortals[iIdx]];
+			const REJECTWINDOW_s	Window = { pPortal->dX1, pPortal->dY1, pPortal->dX2, pPortal->dY2 };
+
+			// The sectors right behind the source's portals can always be seen.
+			rejectbuilder_SetVisible( pPortal->iToSector );
+
+			g_LineOnStack[pPortal->iLine] = true;
+			rejectbuilder_Flood( pPortal, pPortal, Window );
+			g_LineOnStack[pPortal->iLine] = false;
+		}
+
+		if ( g_ulBudget == 0 )
+		{
+			rejectbuilder_SetConnectedVisible( iSource );
+			ulNumOverBudget++;
+		}
+	}
+
+	// Lines of sight work both ways.
+	memset( rejectmatrix, 0, ulSize );
+	for ( iSource = 0; iSource < numsectors; iSource++ )
+	{
+		for ( iTarget = 0; iTarget < numsectors; iTarget++ )
+		{
+			if (( pbVisibility[iSource * ulRowSize + ( iTarget >> 3 )] & ( 1 << ( iTarget & 7 ))) ||
+				( pbVisibility[iTarget * ulRowSize + ( iSource >> 3 )] & ( 1 << ( iSource & 7 ))))
+			{
+				continue;
+			}
+
+			const ULONG ulBit = static_cast<ULONG>( iSource ) * numsectors + iTarget;
+			rejectmatrix[ulBit >> 3] |= ( 1 << ( ulBit & 7 ));
+		}
+	}
+
+	delete[] pbVisibility;
+	g_Portals.Clear( );
+	g_SectorPortals.Clear( );
+	g_LineOnStack.Clear( );
+
+	DPrintf( "REJECT generation took %.3f sec (%lu of %d sectors over budget)\n", ( I_MSTime( ) - uStartTime ) * 0.001, ulNumOverBudget, numsectors );
+
+	rejectbuilder_SaveToCache( CacheFileName, rejectmatrix, ulSize );
+}
@@ -451,6 +451,10 @@ void P_SerializeWorld (FArchive &arc)
 		}
 	}
 
+	// The saved world may differ from the map anywhere, so treat everything as changed.
+	if (arc.IsLoading())
+		SERVER_LEVELCHANGES_MarkAll( );
+
 	// do zones
 	arc << numzones;
 
@@ -700,6 +700,7 @@ void sector_t::SetColor(int r, int g, int b, int desat, bool bInformClients, boo
 	PalEntry color = PalEntry (r,g,b);
 	ColorMap = GetSpecialLights (color, ColorMap->Fade, desat);
 	P_RecalculateAttachedLights(this);
+	SERVER_LEVELCHANGES_MarkSector( sectornum );
 
 	// Tell clients about the sector color update.
 	// [BB] Only if instructed to.
@@ -718,6 +719,7 @@ void sector_t::SetFade(int r, int g, int b, bool bInformClients, bool bExecuteOn
 	PalEntry fade = PalEntry (r,g,b);
 	ColorMap = GetSpecialLights (ColorMap->Color, fade, ColorMap->Desaturate);
 	P_RecalculateAttachedLights(this);
+	SERVER_LEVELCHANGES_MarkSector( sectornum );
 
 	// [BC] Tell clients about the sector fade update.
 	// [BB] Only if instructed to.
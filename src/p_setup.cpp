@@ -84,6 +84,7 @@
 #include "joinqueue.h"
 #include "cl_demo.h"
 #include "domination.h"
+#include "unlagged.h"
 
 #include "gl/gl_functions.h"
 #include "gl/gl_lights.h"
@@ -192,7 +193,7 @@ fixed_t 		bmaporgy;
 int				bmapnegx;		// min negs of block map before wrapping
 int				bmapnegy;
 
-FBlockNode**	blocklinks;		// for thing chains
+FBlockCell*		blocklinks;		// for thing chains
 			
 
 
@@ -2912,9 +2913,10 @@ void P_LoadBlockMap (MapData * map)
 	bmapnegy = bmapheight > 255 ? bmapheight - 512 : -257;
 
 	// clear out mobj chains
+	// Nodes actors still have from an earlier blockmap are ignored from now on.
 	count = bmapwidth*bmapheight;
-	blocklinks = new FBlockNode *[count];
-	memset (blocklinks, 0, count*sizeof(*blocklinks));
+	blocklinks = new FBlockCell[count];
+	FBlockNode::CurrentGeneration++;
 	blockmap = blockmaplump+4;
 
 	// [BC] Also, build the node list for the bot pathing module.
@@ -3685,6 +3687,7 @@ void P_FreeLevelData ()
 	{
 		delete[] blocklinks;
 		blocklinks = NULL;
+		FBlockNode::CurrentGeneration++;
 	}
 	if (PolyBlockMap != NULL)
 	{
@@ -3831,6 +3834,10 @@ void P_SetupLevel (char *lumpname, int position)
 		SERVER_ClearEditedTranslations( );
 		// [BB] And the stored sector links.
 		SERVER_ClearSectorLinks( );
+		// And the recorded sector positions of unlagged.
+		UNLAGGED_ResetSectors( );
+		// Launchers need to see the new map right away.
+		SERVER_MASTER_InvalidateServerInfoCache( );
 	}
 
 	// Initial height of PointOfView will be set by player think.
@@ -4090,6 +4097,10 @@ void P_SetupLevel (char *lumpname, int position)
 
 	times[11].Clock();
 	P_LoadReject (map, buildmap);
+	if (rejectmatrix == NULL)
+	{
+		P_BuildReject (map);
+	}
 	times[11].Unclock();
 
 	times[12].Clock();
@@ -4140,6 +4151,9 @@ void P_SetupLevel (char *lumpname, int position)
 		}
 	}
 
+	// The map structures are now as loaded, so start tracking changes to them from here on.
+	SERVER_LEVELCHANGES_Clear( );
+
 	// Spawn 3d floors - must be done before spawning things so it can't be done in P_SpawnSpecials
 	P_Spawn3DFloors();
 
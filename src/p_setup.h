@@ -99,6 +99,9 @@ void P_SetupLevel (char *mapname, int position);
 void P_FreeLevelData();
 void P_FreeExtraLevelData();
 
+// Builds a REJECT table for maps that don't have a usable one (p_rejectbuilder.cpp).
+void P_BuildReject (MapData *map);
+
 // Called by startup code.
 void P_Init (void);
 
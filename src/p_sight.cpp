@@ -23,6 +23,8 @@
 #include "r_state.h"
 
 #include "stats.h"
+#include "c_cvars.h"
+#include "sv_profiler.h"
 
 static FRandom pr_botchecksight ("BotCheckSight");
 static FRandom pr_checksight ("CheckSight");
@@ -44,6 +46,29 @@ static cycle_t MaxSightCycles;
 
 static TArray<intercept_t> intercepts (128);
 
+// Monsters ask the same sight questions over and over during a tic, so the
+// results of the traces are remembered until the end of the tic. The result
+// only depends on where both actors are and what the map looks like, so an
+// entry is only used if neither actor moved and nothing that could block sight
+// changed in between (see P_InvalidateSightCache).
+#define SIGHTCACHE_SIZE		4096
+
+struct FSightCacheEntry
+{
+	const AActor *t1, *t2;
+	fixed_t x1, y1, z1, height1;
+	fixed_t x2, y2, z2, height2;
+	DWORD epoch;
+	int flags;
+	bool result;
+};
+
+static FSightCacheEntry SightCache[SIGHTCACHE_SIZE];
+static DWORD SightCacheEpoch = 1;
+static int SightCacheHits, SightCacheMisses;
+
+CVAR (Bool, sightcache, true, 0)
+
 class SightCheck
 {
 	fixed_t sightzstart;				// eye z of looker
@@ -624,6 +649,36 @@ sightcounts[2]++;
 	return P_SightTraverseIntercepts ( );
 }
 
+//
+// P_InvalidateSightCache
+//
+// Must be called whenever something that could block sight changes: sector
+// heights, polyobjects and the blocking flags or specials of lines.
+//
+void P_InvalidateSightCache ()
+{
+	if (++SightCacheEpoch == 0)
+	{
+		// Make sure no entry from before the wrap matches the new epochs.
+		memset (SightCache, 0, sizeof(SightCache));
+		SightCacheEpoch = 1;
+	}
+}
+
+static FSightCacheEntry *P_FindSightCacheEntry (const AActor *t1, const AActor *t2, int flags)
+{
+	size_t hash = (size_t(t1) >> 3) * 31 + (size_t(t2) >> 3) + flags;
+	hash ^= hash >> 12;
+	return &SightCache[hash & (SIGHTCACHE_SIZE - 1)];
+}
+
+static bool P_SightCacheEntryMatches (const FSightCacheEntry *entry, const AActor *t1, const AActor *t2, int flags)
+{
+	return entry->epoch == SightCacheEpoch && entry->t1 == t1 && entry->t2 == t2 && entry->flags == flags &&
+		entry->x1 == t1->x && entry->y1 == t1->y && entry->z1 == t1->z && entry->height1 == t1->height &&
+		entry->x2 == t2->x && entry->y2 == t2->y && entry->z2 == t2->z && entry->height2 == t2->height;
+}
+
 /*
 =====================
 =
@@ -640,6 +695,7 @@ sightcounts[2]++;
 bool P_CheckSight (const AActor *t1, const AActor *t2, int flags)
 {
 	SightCycles.Clock();
+	SERVER_PROFILER_Clock( PROFILERPHASE_SIGHT );
 
 	bool res;
 
@@ -679,6 +735,24 @@ sightcounts[0]++;
 		}
 	}
 
+	// Everything from here on only depends on where the actors are and the map.
+	FSightCacheEntry *cacheentry;
+	if (sightcache)
+	{
+		cacheentry = P_FindSightCacheEntry (t1, t2, flags & 6);
+		if (P_SightCacheEntryMatches (cacheentry, t1, t2, flags & 6))
+		{
+			SightCacheHits++;
+			res = cacheentry->result;
+			goto done;
+		}
+		SightCacheMisses++;
+	}
+	else
+	{
+		cacheentry = NULL;
+	}
+
 	// killough 4/19/98: make fake floors and ceilings block monster view
 
 	if ((s1->heightsec && !(s1->heightsec->MoreFlags & SECF_IGNOREHEIGHTSEC) &&
@@ -694,19 +768,36 @@ sightcounts[0]++;
 		   t1->z + t2->height <= s2->heightsec->ceilingplane.ZatPoint (t1->x, t1->y)))))
 	{
 		res = false;
-		goto done;
 	}
-
-	// An unobstructed LOS is possible.
-	// Now look from eyes of t1 to any part of t2.
-
-	validcount++;
+	else
 	{
+		// An unobstructed LOS is possible.
+		// Now look from eyes of t1 to any part of t2.
+
+		validcount++;
 		SightCheck s(t1, t2, flags);
 		res = s.P_SightPathTraverse (t1->x, t1->y, t2->x, t2->y);
 	}
 
+	if (cacheentry != NULL)
+	{
+		cacheentry->t1 = t1;
+		cacheentry->t2 = t2;
+		cacheentry->x1 = t1->x;
+		cacheentry->y1 = t1->y;
+		cacheentry->z1 = t1->z;
+		cacheentry->height1 = t1->height;
+		cacheentry->x2 = t2->x;
+		cacheentry->y2 = t2->y;
+		cacheentry->z2 = t2->z;
+		cacheentry->height2 = t2->height;
+		cacheentry->epoch = SightCacheEpoch;
+		cacheentry->flags = flags & 6;
+		cacheentry->result = res;
+	}
+
 done:
+	SERVER_PROFILER_Unclock( PROFILERPHASE_SIGHT );
 	SightCycles.Unclock();
 	return res;
 }
@@ -714,9 +805,10 @@ done:
 ADD_STAT (sight)
 {
 	FString out;
-	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d%4d\n",
+	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d%4d, cache %d/%d\n",
 		SightCycles.TimeMS(), MaxSightCycles.TimeMS(),
-		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[3], sightcounts[4], sightcounts[5]);
+		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[3], sightcounts[4], sightcounts[5],
+		SightCacheHits, SightCacheHits + SightCacheMisses);
 	return out;
 }
 
@@ -732,6 +824,10 @@ void P_ResetSightCounters (bool full)
 	}
 	SightCycles.Reset();
 	memset (sightcounts, 0, sizeof(sightcounts));
+	SightCacheHits = SightCacheMisses = 0;
+
+	// The cache only lives for one tic.
+	P_InvalidateSightCache ();
 }
 
 
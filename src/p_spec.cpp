@@ -318,6 +318,7 @@ bool P_ActivateLine (line_t *line, AActor *mo, int side, int activationType)
 	if (!repeat && buttonSuccess)
 	{ // clear the special on non-retriggerable lines
 		line->special = 0;
+		P_InvalidateSightCache ();
 	}
 
 	if (buttonSuccess)
@@ -343,6 +344,7 @@ bool P_ActivateLine (line_t *line, AActor *mo, int side, int activationType)
 	{
 		P_ChangeSwitchTexture (&sides[line->sidenum[0]], repeat, special);
 		line->special = 0;
+		P_InvalidateSightCache ();
 
 		// [BC] Tell the clients of the switch texture change.
 //		if ( NETWORK_GetState( ) == NETSTATE_SERVER )
@@ -1615,6 +1617,7 @@ DScroller::DScroller (EScrollType type, fixed_t dx, fixed_t dy,
 
 	case sc_side:
 		sides[affectee].Flags |= WALLF_NOAUTODECALS;
+		SERVER_LEVELCHANGES_MarkSide( affectee );
 		if (m_Parts & scw_top)
 		{
 			m_Interpolations[0] = sides[m_Affectee].SetInterpolation(side_t::top);
@@ -1685,6 +1688,7 @@ DScroller::DScroller (fixed_t dx, fixed_t dy, const line_t *l,
 		m_LastHeight = sectors[control].CenterFloor() + sectors[control].CenterCeiling();
 	m_Affectee = *l->sidenum;
 	sides[m_Affectee].Flags |= WALLF_NOAUTODECALS;
+	SERVER_LEVELCHANGES_MarkSide( m_Affectee );
 	m_Interpolations[0] = m_Interpolations[1] = m_Interpolations[2] = NULL;
 
 	if (m_Parts & scw_top)
@@ -568,6 +568,7 @@ bool P_ChangeSwitchTexture (side_t *side, int useAgain, BYTE special, bool *ques
 			lines[side->linenum].ulTexChangeFlags |= 1 << ulShift;
 			ulShift += 3;
 			lines[side->linenum].ulTexChangeFlags |= 1 << ulShift;
+			SERVER_LEVELCHANGES_MarkLine( side->linenum );
 		}
 	}
 
@@ -149,6 +149,11 @@ void P_Ticker (void)
 		}
 		StatusBar->Tick ();		// [RH] moved this here
 	}
+	else
+	{
+		// The server doesn't reset the sight counters, but the sight cache only lives for one tic.
+		P_InvalidateSightCache ();
+	}
 
 	// Predict the console player's position.
 	if (( NETWORK_GetState( ) == NETSTATE_CLIENT ) || ( CLIENTDEMO_IsPlaying( )))
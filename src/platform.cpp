@@ -146,6 +146,12 @@ char *I_ConsoleInput (void)
 	stdin_ready = 0;
 
 	len = read(0, text, sizeof(text));
+	if (len == 0)
+	{
+		// End of file, there will never be any more input.
+		do_stdin = 0;
+		return NULL;
+	}
 	if (len < 1)
 	{ return NULL; }
 
@@ -1186,6 +1186,8 @@ bool PO_MovePolyobj (int num, int x, int y, bool force)
 
 	UnLinkPolyobj (po);
 	DoMovePolyobj (po, x, y);
+	// Thrusting the blockers checks sight against the moved lines.
+	P_InvalidateSightCache ();
 
 	if (!force)
 	{
@@ -1204,12 +1206,15 @@ bool PO_MovePolyobj (int num, int x, int y, bool force)
 		{
 			DoMovePolyobj (po, -x, -y);
 			LinkPolyobj(po);
+			// Thrusting the blockers may have checked sight against the moved polyobject.
+			P_InvalidateSightCache ();
 			return false;
 		}
 	}
 	po->startSpot[0] += x;
 	po->startSpot[1] += y;
 	LinkPolyobj (po);
+	P_InvalidateSightCache ();
 
 	// Polyobject has moved.
 	po->bMoved = true;
@@ -1315,6 +1320,8 @@ bool PO_RotatePolyobj (int num, angle_t angle)
 		RotatePt (an, &(*segList)->v1->x, &(*segList)->v1->y, po->startSpot[0],
 			po->startSpot[1]);
 	}
+	// Thrusting the blockers checks sight against the rotated lines.
+	P_InvalidateSightCache ();
 	segList = po->segs;
 	blocked = false;
 	validcount++;
@@ -1350,10 +1357,13 @@ bool PO_RotatePolyobj (int num, angle_t angle)
 			}
 		}
 		LinkPolyobj(po);
+		// Thrusting the blockers may have checked sight against the rotated polyobject.
+		P_InvalidateSightCache ();
 		return false;
 	}
 	po->angle += angle;
 	LinkPolyobj(po);
+	P_InvalidateSightCache ();
 
 	// [BC] Polyobject has rotated.
 	po->bRotated = true;
@@ -1491,9 +1501,9 @@ static void LinkPolyobj (FPolyObj *po)
 static bool CheckMobjBlocking (seg_t *seg, FPolyObj *po)
 {
 	static TArray<AActor *> checker;
-	FBlockNode *block;
+	FBlockCell *cell;
 	AActor *mobj;
-	int i, j, k;
+	int i, j, k, l;
 	int left, right, top, bottom;
 	line_t *ld;
 	bool blocked;
@@ -1521,13 +1531,21 @@ static bool CheckMobjBlocking (seg_t *seg, FPolyObj *po)
 	right = right < 0 ? 0 : right;
 	right = right >= bmapwidth ?  bmapwidth-1 : right;
 
+	// Thrusting an actor relinks it.
+	FBlockmapLock lock;
+
 	for (j = bottom*bmapwidth; j <= top*bmapwidth; j += bmapwidth)
 	{
 		for (i = left; i <= right; i++)
 		{
-			for (block = blocklinks[j+i]; block != NULL; block = block->NextActor)
+			cell = &blocklinks[j+i];
+			for (l = (int)cell->Things.Size()-1; l >= 0; --l)
 			{
-				mobj = block->Me;
+				mobj = cell->Things[l].Me;
+				if (mobj == NULL)
+				{
+					continue;
+				}
 				for (k = (int)checker.Size()-1; k >= 0; --k)
 				{
 					if (checker[k] == mobj)
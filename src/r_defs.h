@@ -38,6 +38,7 @@ struct FGLSection;
 
 #include "dthinker.h"
 #include "farchive.h"
+#include "sv_levelchanges.h"
 
 #define MAXWIDTH 2560
 #define MAXHEIGHT 1600
@@ -207,8 +208,8 @@ struct secplane_t
 
 	fixed_t a, b, c, d, ic;
 
-	// [Spleen] Store the old D's of the plane for unlagged support
-	fixed_t		unlaggedD[UNLAGGEDTICS];
+	// [Spleen] Store the old D of the plane for unlagged support
+	// (the history of moving sectors is kept in unlagged.cpp)
 	fixed_t		restoreD;
 
 	// Returns the value of z at (0,0) This is used by the 3D floor code which does not handle slopes
@@ -491,11 +492,13 @@ struct sector_t
 	void SetXOffset(int pos, fixed_t o)
 	{
 		planes[pos].xform.xoffs = o;
+		SERVER_LEVELCHANGES_MarkSector( sectornum );
 	}
 
 	void AddXOffset(int pos, fixed_t o)
 	{
 		planes[pos].xform.xoffs += o;
+		SERVER_LEVELCHANGES_MarkSector( sectornum );
 	}
 
 	fixed_t GetXOffset(int pos) const
@@ -506,11 +509,13 @@ struct sector_t
 	void SetYOffset(int pos, fixed_t o)
 	{
 		planes[pos].xform.yoffs = o;
+		SERVER_LEVELCHANGES_MarkSector( sectornum );
 	}
 
 	void AddYOffset(int pos, fixed_t o)
 	{
 		planes[pos].xform.yoffs += o;
+		SERVER_LEVELCHANGES_MarkSector( sectornum );
 	}
 
 	fixed_t GetYOffset(int pos, bool addbase = true) const
@@ -528,6 +533,7 @@ struct sector_t
 	void SetXScale(int pos, fixed_t o)
 	{
 		planes[pos].xform.xscale = o;
+		SERVER_LEVELCHANGES_MarkSector( sectornum );
 	}
 
 	fixed_t GetXScale(int pos) const
@@ -538,6 +544,7 @@ struct sector_t
 	void SetYScale(int pos, fixed_t o)
 	{
 		planes[pos].xform.yscale = o;
+		SERVER_LEVELCHANGES_MarkSector( sectornum );
 	}
 
 	fixed_t GetYScale(int pos) const
@@ -548,6 +555,7 @@ struct sector_t
 	void SetAngle(int pos, angle_t o)
 	{
 		planes[pos].xform.angle = o;
+		SERVER_LEVELCHANGES_MarkSector( sectornum );
 	}
 
 	angle_t GetAngle(int pos, bool addbase = true) const
@@ -566,6 +574,7 @@ struct sector_t
 	{
 		planes[pos].xform.base_yoffs = y;
 		planes[pos].xform.base_angle = o;
+		SERVER_LEVELCHANGES_MarkSector( sectornum );
 	}
 
 	int GetFlags(int pos) const 
@@ -56,6 +56,8 @@
 #include "sv_ban.h"
 #include "version.h"
 #include "v_text.h"
+#include "stats.h"
+#include "templates.h"
 
 //--------------------------------------------------------------------------------------------------------------------------------------------------
 //-- VARIABLES -------------------------------------------------------------------------------------------------------------------------------------
@@ -713,3 +715,94 @@ CCMD( reloadbans )
 {
 	serverban_LoadBansAndBanExemptions( );
 }
+
+//*****************************************************************************
+//
+// Compares the lookup tables of IPList to checking every entry on a made up list
+// that looks like the master server's ban list.
+CCMD( banlistbench )
+{
+	const ULONG ulNumEntries = ( argv.argc( ) > 1 ) ? MAX( atoi( argv[1] ), 1 ) : 100000;
+	const ULONG ulNumLookups = ( argv.argc( ) > 2 ) ? MAX( atoi( argv[2] ), 1 ) : 1000;
+	ULONG ulSeed = 0x12345678;
+	IPList List;
+	std::vector<NETADDRESS_s> Addresses;
+
+	// Most bans are single addresses, some are ranges.
+	for ( ULONG ulIdx = 0; ulIdx < ulNumEntries; ulIdx++ )
+	{
+		IPADDRESSBAN_s Entry;
+
+		ulSeed = ulSeed * 1664525 + 1013904223;
+		const ULONG ulType = ( ulSeed >> 8 ) % 20;
+		for ( ULONG ulOctet = 0; ulOctet < 4; ulOctet++ )
+		{
+			if ((( ulOctet == 3 ) && ( ulType >= 16 )) || (( ulOctet == 2 ) && ( ulType == 19 )))
+				sprintf( Entry.szIP[ulOctet], "*" );
+			else
+				sprintf( Entry.szIP[ulOctet], "%lu", ( ulSeed >> ( ulOctet * 8 )) & 0xFF );
+		}
+		Entry.szComment[0] = 0;
+		Entry.tExpirationDate = 0;
+		List.push_back( Entry );
+	}
+
+	// Half of the lookups are for banned addresses.
+	for ( ULONG ulIdx = 0; ulIdx < ulNumLookups; ulIdx++ )
+	{
+		NETADDRESS_s Address;
+		memset( &Address, 0, sizeof( Address ));
+
+		ulSeed = ulSeed * 1664525 + 1013904223;
+		if ( ulIdx & 1 )
+		{
+			const IPADDRESSBAN_s Entry = List.getEntry(( ulSeed >> 4 ) % ulNumEntries );
+			for ( ULONG ulOctet = 0; ulOctet < 4; ulOctet++ )
+				Address.abIP[ulOctet] = ( Entry.szIP[ulOctet][0] == '*' ) ? static_cast<BYTE>( ulSeed >> ulOctet ) : static_cast<BYTE>( atoi( Entry.szIP[ulOctet] ));
+		}
+		else
+		{
+			for ( ULONG ulOctet = 0; ulOctet < 4; ulOctet++ )
+				Address.abIP[ulOctet] = static_cast<BYTE>( ulSeed >> ( ulOctet * 8 ));
+		}
+		Addresses.push_back( Address );
+	}
+
+	cycle_t BuildClock, TableClock, LinearClock;
+	BuildClock.Reset( );
+	TableClock.Reset( );
+	LinearClock.Reset( );
+
+	// The first lookup builds the tables.
+	BuildClock.Clock( );
+	List.isIPInList( Addresses[0] );
+	BuildClock.Unclock( );
+
+	std::vector<ULONG> TableResults( ulNumLookups );
+	TableClock.Clock( );
+	for ( ULONG ulIdx = 0; ulIdx < ulNumLookups; ulIdx++ )
+		TableResults[ulIdx] = List.getFirstMatchingEntryIndex( Addresses[ulIdx] );
+	TableClock.Unclock( );
+
+	ULONG ulNumMatches = 0;
+	ULONG ulNumMismatches = 0;
+	LinearClock.Clock( );
+	for ( ULONG ulIdx = 0; ulIdx < ulNumLookups; ulIdx++ )
+	{
+		IPStringArray szAddress;
+		NETWORK_AddressToIPStringArray( Addresses[ulIdx], szAddress );
+		const ULONG ulResult = List.getFirstMatchingEntryIndexLinear( szAddress );
+
+		if ( ulResult != TableResults[ulIdx] )
+			ulNumMismatches++;
+		if ( ulResult != List.size( ))
+			ulNumMatches++;
+	}
+	LinearClock.Unclock( );
+
+	Printf( "%lu entries, %lu lookups (%lu banned), tables built in %.3f ms.\n", ulNumEntries, ulNumLookups, ulNumMatches, BuildClock.TimeMS( ));
+	Printf( "Lookup tables: %.3f us per lookup\n", TableClock.TimeMS( ) * 1000 / ulNumLookups );
+	Printf( "Linear search: %.3f us per lookup\n", LinearClock.TimeMS( ) * 1000 / ulNumLookups );
+	if ( ulNumMismatches > 0 )
+		Printf( TEXTCOLOR_RED "%lu lookups had different results!\n", ulNumMismatches );
+}
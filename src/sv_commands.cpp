@@ -75,6 +75,9 @@
 #include "p_acs.h"
 #include "templates.h"
 #include "a_movingcamera.h"
+#include "network/nettraffic.h"
+#include "sv_relevance.h"
+#include "sv_levelchanges.h"
 
 CVAR (Bool, sv_showwarnings, false, CVAR_GLOBALCONFIG|CVAR_ARCHIVE)
 
@@ -82,6 +85,28 @@ CVAR (Bool, sv_showwarnings, false, CVAR_GLOBALCONFIG|CVAR_ARCHIVE)
 FPolyObj	*GetPolyobj( int polyNum );
 
 EXTERN_CVAR( Float, sv_aircontrol )
+EXTERN_CVAR( Bool, sv_deltamoveplayer )
+
+// Size of a SVC_MOVEPLAYER command for a visible player.
+#define	MOVEPLAYER_FULL_SIZE	24
+
+// Size of a SVC_MOVEPLAYER command for a player the client isn't allowed to see.
+#define	MOVEPLAYER_HIDDEN_SIZE	3
+
+// The SVC_MOVEPLAYER command telling where a visible player is. It's the same for every
+// client that may see the player, so it's only written once per tic.
+typedef struct
+{
+	LONG			lTic;
+	const AActor	*pMo;
+	BYTE			abData[MOVEPLAYER_FULL_SIZE];
+
+} MOVEPLAYERCACHE_s;
+
+//*****************************************************************************
+//	VARIABLES
+
+static	MOVEPLAYERCACHE_s	g_MovePlayerCache[MAXPLAYERS];
 
 //*****************************************************************************
 //	CLASSES
@@ -144,6 +169,36 @@ public:
 	}
 };
 
+/**
+ * \brief Keeps the buffers of destroyed NetCommands for reuse, so that creating a
+ * command doesn't need to allocate and free MAX_UDP_PACKET bytes every time.
+ */
+class NetCommandBufferPool {
+	TArray<BYTE*> _freeBuffers;
+public:
+	~NetCommandBufferPool ( )
+	{
+		for ( unsigned int i = 0; i < _freeBuffers.Size(); ++i )
+			delete[] _freeBuffers[i];
+	}
+
+	BYTE *allocate ( )
+	{
+		BYTE *pbData;
+		if ( _freeBuffers.Pop ( pbData ) )
+			return pbData;
+
+		return new BYTE[MAX_UDP_PACKET];
+	}
+
+	void release ( BYTE *pbData )
+	{
+		_freeBuffers.Push ( pbData );
+	}
+};
+
+static NetCommandBufferPool g_NetCommandBufferPool;
+
 /**
  * \brief Creates and sends network commands to the clients.
  *
@@ -154,13 +209,16 @@ class NetCommand {
 public:
 	NetCommand ( const int Header )
 	{
-		NETWORK_InitBuffer( &_buffer, MAX_UDP_PACKET, BUFFERTYPE_WRITE );
+		memset( &_buffer, 0, sizeof( _buffer ));
+		_buffer.ulMaxSize = MAX_UDP_PACKET;
+		_buffer.pbData = g_NetCommandBufferPool.allocate ( );
+		_buffer.BufferType = BUFFERTYPE_WRITE;
 		NETWORK_ClearBuffer( &_buffer );
 		addInteger<BYTE> ( Header );
 	}
 	~NetCommand ( )
 	{
-		NETWORK_FreeBuffer ( &_buffer );
+		g_NetCommandBufferPool.release ( _buffer.pbData );
 	}
 
 	template <typename IntType>
@@ -232,6 +290,23 @@ public:
 			writeCommandToStream ( SERVER_GetClient( *it )->PacketBuffer.ByteStream );
 		}
 	}
+
+	// Like sendCommandToClients, but leaves out clients to whom the position of pActor
+	// is irrelevant (see sv_relevance.cpp). Only use this for position updates.
+	void sendPositionCommandToClients ( AActor *pActor, ULONG ulPlayerExtra = MAXPLAYERS, ULONG ulFlags = 0 ) const {
+		for ( ClientIterator it ( ulPlayerExtra, ulFlags ); it.notAtEnd(); ++it )
+		{
+			if ((( ulFlags & SVCF_ONLYTHISCLIENT ) == false ) && SERVER_RELEVANCE_SkipPositionUpdate( *it, pActor, _buffer.ulCurrentSize ))
+				continue;
+
+			SERVER_CheckClientBuffer( *it, _buffer.ulCurrentSize, true );
+			writeCommandToStream ( SERVER_GetClient( *it )->PacketBuffer.ByteStream );
+		}
+	}
+
+	ULONG getSize ( ) const {
+		return ( _buffer.ulCurrentSize );
+	}
 };
 
 //*****************************************************************************
@@ -549,6 +624,139 @@ void SERVERCOMMANDS_SpawnPlayer( ULONG ulPlayer, LONG lPlayerState, ULONG ulPlay
 		SERVERCOMMANDS_SetPlayerCheats( ulPlayer, ulPlayer, SVCF_ONLYTHISCLIENT );
 }
 
+//*****************************************************************************
+//
+// Writes the movement of ulPlayer as SVC2_MOVEPLAYERDELTA. The player's state is
+// encoded against the last snapshot the client acknowledged if possible, otherwise
+// it's sent in full.
+static void servercommands_MovePlayerDelta( ULONG ulClient, ULONG ulPlayer, ULONG ulPlayerAttackFlags )
+{
+	CLIENT_s				*pClient = SERVER_GetClient( ulClient );
+	const AActor			*pMo = players[ulPlayer].mo;
+	const MOVESNAPSHOTPLAYER_s	*pBase = NULL;
+	MOVESNAPSHOTPLAYER_s	State;
+	ULONG					ulAge = 0;
+	ULONG					ulBits = 0;
+	LONG					lDeltaX = 0;
+	LONG					lDeltaY = 0;
+
+	State.bValid = true;
+	State.X = pMo->x;
+	State.Y = pMo->y;
+	State.Angle = pMo->angle;
+	State.sZ = pMo->z >> FRACBITS;
+	State.sMomX = pMo->momx >> FRACBITS;
+	State.sMomY = pMo->momy >> FRACBITS;
+	State.sMomZ = pMo->momz >> FRACBITS;
+	State.bCrouching = ( players[ulPlayer].crouchdir >= 0 );
+
+	if ( pClient->lAckedMoveSnapshot != -1 )
+	{
+		ulAge = pClient->ulMoveSnapshot - pClient->lAckedMoveSnapshot;
+		pBase = &pClient->MoveSnapshots[pClient->lAckedMoveSnapshot % MOVESNAPSHOT_BACKUP][ulPlayer];
+		if (( ulAge == 0 ) || ( ulAge >= MOVESNAPSHOT_BACKUP ) || ( pBase->bValid == false ))
+			pBase = NULL;
+	}
+
+	if ( pBase != NULL )
+	{
+		const SQWORD qwDeltaX = static_cast<SQWORD>( State.X ) - pBase->X;
+		const SQWORD qwDeltaY = static_cast<SQWORD>( State.Y ) - pBase->Y;
+		const LONG lDeltaZ = State.sZ - pBase->sZ;
+		const LONG lDeltaMomX = State.sMomX - pBase->sMomX;
+		const LONG lDeltaMomY = State.sMomY - pBase->sMomY;
+		const LONG lDeltaMomZ = State.sMomZ - pBase->sMomZ;
+
+		// If any of the deltas doesn't fit, just send the full state.
+		if (( qwDeltaX < -MOVEDELTA_XY_LIMIT ) || ( qwDeltaX >= MOVEDELTA_XY_LIMIT ) ||
+			( qwDeltaY < -MOVEDELTA_XY_LIMIT ) || ( qwDeltaY >= MOVEDELTA_XY_LIMIT ) ||
+			( lDeltaZ < -128 ) || ( lDeltaZ > 127 ) ||
+			( lDeltaMomX < -128 ) || ( lDeltaMomX > 127 ) ||
+			( lDeltaMomY < -128 ) || ( lDeltaMomY > 127 ) ||
+			( lDeltaMomZ < -128 ) || ( lDeltaMomZ > 127 ))
+		{
+			pBase = NULL;
+		}
+		else
+		{
+			lDeltaX = static_cast<LONG>( qwDeltaX );
+			lDeltaY = static_cast<LONG>( qwDeltaY );
+			if ( lDeltaX != 0 )
+				ulBits |= MOVEDELTA_X;
+			if ( lDeltaY != 0 )
+				ulBits |= MOVEDELTA_Y;
+			if ( lDeltaZ != 0 )
+				ulBits |= MOVEDELTA_Z;
+			if (( State.Angle >> 16 ) != ( pBase->Angle >> 16 ))
+				ulBits |= MOVEDELTA_ANGLE;
+			if ( lDeltaMomX != 0 )
+				ulBits |= MOVEDELTA_MOMX;
+			if ( lDeltaMomY != 0 )
+				ulBits |= MOVEDELTA_MOMY;
+			if ( lDeltaMomZ != 0 )
+				ulBits |= MOVEDELTA_MOMZ;
+			if ( State.bCrouching )
+				ulBits |= MOVEDELTA_CROUCHING;
+
+			State.Angle = ( ulBits & MOVEDELTA_ANGLE ) ? (( State.Angle >> 16 ) << 16 ) : pBase->Angle;
+		}
+	}
+
+	if ( pBase == NULL )
+		ulAge = 0;
+
+	SERVER_CheckClientBuffer( ulClient, MOVEPLAYER_FULL_SIZE + 2, false );
+	BYTESTREAM_s *pByteStream = &pClient->UnreliablePacketBuffer.ByteStream;
+	const BYTE *pbStart = pByteStream->pbStream;
+
+	NETWORK_WriteHeader( pByteStream, SVC_EXTENDEDCOMMAND );
+	NETWORK_WriteByte( pByteStream, SVC2_MOVEPLAYERDELTA );
+	NETWORK_WriteByte( pByteStream, ulPlayer );
+	NETWORK_WriteByte( pByteStream, PLAYER_VISIBLE | ulPlayerAttackFlags | ( ulAge << MOVEDELTA_AGE_SHIFT ));
+	NETWORK_WriteByte( pByteStream, pClient->ulMoveSnapshot & 0xFF );
+
+	if ( pBase == NULL )
+	{
+		NETWORK_WriteLong( pByteStream, State.X );
+		NETWORK_WriteLong( pByteStream, State.Y );
+		NETWORK_WriteShort( pByteStream, State.sZ );
+		NETWORK_WriteLong( pByteStream, State.Angle );
+		NETWORK_WriteShort( pByteStream, State.sMomX );
+		NETWORK_WriteShort( pByteStream, State.sMomY );
+		NETWORK_WriteShort( pByteStream, State.sMomZ );
+		NETWORK_WriteByte( pByteStream, State.bCrouching );
+	}
+	else
+	{
+		NETWORK_WriteByte( pByteStream, ulBits );
+		if ( ulBits & MOVEDELTA_X )
+		{
+			NETWORK_WriteByte( pByteStream, lDeltaX & 0xFF );
+			NETWORK_WriteShort( pByteStream, lDeltaX >> 8 );
+		}
+		if ( ulBits & MOVEDELTA_Y )
+		{
+			NETWORK_WriteByte( pByteStream, lDeltaY & 0xFF );
+			NETWORK_WriteShort( pByteStream, lDeltaY >> 8 );
+		}
+		if ( ulBits & MOVEDELTA_Z )
+			NETWORK_WriteByte( pByteStream, State.sZ - pBase->sZ );
+		if ( ulBits & MOVEDELTA_ANGLE )
+			NETWORK_WriteShort( pByteStream, State.Angle >> 16 );
+		if ( ulBits & MOVEDELTA_MOMX )
+			NETWORK_WriteByte( pByteStream, State.sMomX - pBase->sMomX );
+		if ( ulBits & MOVEDELTA_MOMY )
+			NETWORK_WriteByte( pByteStream, State.sMomY - pBase->sMomY );
+		if ( ulBits & MOVEDELTA_MOMZ )
+			NETWORK_WriteByte( pByteStream, State.sMomZ - pBase->sMomZ );
+	}
+
+	NETTRAFFIC_AddMovePlayerTraffic( pBase != NULL, static_cast<int>( pByteStream->pbStream - pbStart ), MOVEPLAYER_FULL_SIZE );
+
+	// Remember what the client will know about the player once it gets this snapshot.
+	pClient->MoveSnapshots[pClient->ulMoveSnapshot % MOVESNAPSHOT_BACKUP][ulPlayer] = State;
+}
+
 //*****************************************************************************
 //
 void SERVERCOMMANDS_MovePlayer( ULONG ulPlayer, ULONG ulPlayerExtra, ULONG ulFlags )
@@ -576,37 +784,73 @@ void SERVERCOMMANDS_MovePlayer( ULONG ulPlayer, ULONG ulPlayerExtra, ULONG ulFla
 			continue;
 		}
 
-		SERVER_CheckClientBuffer( ulIdx, 24, false );
-		NETWORK_WriteHeader( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, SVC_MOVEPLAYER );
-		NETWORK_WriteByte( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, ulPlayer );
+		const bool bVisible = SERVER_IsPlayerVisible( ulIdx, ulPlayer );
+
+		// The client can't see the player from where it is, so it can do with fewer updates.
+		// Even the ones without the position tell it whether the player is attacking, so
+		// they are filtered too. Otherwise the filter couldn't know what the client has.
+		if ( SERVER_RELEVANCE_SkipPlayerUpdate( ulIdx, ulPlayer, ulPlayerAttackFlags, bVisible ? MOVEPLAYER_FULL_SIZE : MOVEPLAYER_HIDDEN_SIZE ))
+			continue;
+
+		if ( bVisible && sv_deltamoveplayer )
+		{
+			servercommands_MovePlayerDelta( ulIdx, ulPlayer, ulPlayerAttackFlags );
+			continue;
+		}
+
+		SERVER_CheckClientBuffer( ulIdx, MOVEPLAYER_FULL_SIZE, false );
+		const BYTE *pbStart = SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream.pbStream;
 
 		// If this player cannot be seen by (or is not allowed to be seen by) the
 		// player, don't send position information.
-		if ( SERVER_IsPlayerVisible( ulIdx, ulPlayer ) == false )
+		if ( bVisible == false )
+		{
+			NETWORK_WriteHeader( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, SVC_MOVEPLAYER );
+			NETWORK_WriteByte( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, ulPlayer );
 			NETWORK_WriteByte( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, ulPlayerAttackFlags );
+		}
 		else
 		{
-			// The player IS visible, so his info is coming!
-			NETWORK_WriteByte( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, PLAYER_VISIBLE|ulPlayerAttackFlags );
+			if (( g_MovePlayerCache[ulPlayer].lTic != gametic ) || ( g_MovePlayerCache[ulPlayer].pMo != players[ulPlayer].mo ))
+			{
+				BYTESTREAM_s	ByteStream;
+
+				ByteStream.pbStream = g_MovePlayerCache[ulPlayer].abData;
+				ByteStream.pbStreamEnd = ByteStream.pbStream + sizeof( g_MovePlayerCache[ulPlayer].abData );
 
-			// Write position.
-			// [BB] The x/y position has to be sent at full precision, otherwise the player may be rounded to a neighboring sector
-			// on the clients, potentially completely changing its Z position.
-			NETWORK_WriteLong( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, players[ulPlayer].mo->x );
-			NETWORK_WriteLong( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, players[ulPlayer].mo->y );
-			NETWORK_WriteShort( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, players[ulPlayer].mo->z >> FRACBITS );
+				NETWORK_WriteHeader( &ByteStream, SVC_MOVEPLAYER );
+				NETWORK_WriteByte( &ByteStream, ulPlayer );
 
-			// Write angle.
-			NETWORK_WriteLong( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, players[ulPlayer].mo->angle );
+				// The player IS visible, so his info is coming!
+				NETWORK_WriteByte( &ByteStream, PLAYER_VISIBLE|ulPlayerAttackFlags );
 
-			// Write velocity.
-			NETWORK_WriteShort( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, players[ulPlayer].mo->momx >> FRACBITS );
-			NETWORK_WriteShort( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, players[ulPlayer].mo->momy >> FRACBITS );
-			NETWORK_WriteShort( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, players[ulPlayer].mo->momz >> FRACBITS );
+				// Write position.
+				// [BB] The x/y position has to be sent at full precision, otherwise the player may be rounded to a neighboring sector
+				// on the clients, potentially completely changing its Z position.
+				NETWORK_WriteLong( &ByteStream, players[ulPlayer].mo->x );
+				NETWORK_WriteLong( &ByteStream, players[ulPlayer].mo->y );
+				NETWORK_WriteShort( &ByteStream, players[ulPlayer].mo->z >> FRACBITS );
 
-			// Write whether or not the player is crouching.
-			NETWORK_WriteByte( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, ( players[ulPlayer].crouchdir >= 0 ) ? true : false );
+				// Write angle.
+				NETWORK_WriteLong( &ByteStream, players[ulPlayer].mo->angle );
+
+				// Write velocity.
+				NETWORK_WriteShort( &ByteStream, players[ulPlayer].mo->momx >> FRACBITS );
+				NETWORK_WriteShort( &ByteStream, players[ulPlayer].mo->momy >> FRACBITS );
+				NETWORK_WriteShort( &ByteStream, players[ulPlayer].mo->momz >> FRACBITS );
+
+				// Write whether or not the player is crouching.
+				NETWORK_WriteByte( &ByteStream, ( players[ulPlayer].crouchdir >= 0 ) ? true : false );
+
+				g_MovePlayerCache[ulPlayer].lTic = gametic;
+				g_MovePlayerCache[ulPlayer].pMo = players[ulPlayer].mo;
+			}
+
+			NETWORK_WriteBuffer( &SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream, g_MovePlayerCache[ulPlayer].abData, MOVEPLAYER_FULL_SIZE );
 		}
+
+		const int iBytesUsed = static_cast<int>( SERVER_GetClient( ulIdx )->UnreliablePacketBuffer.ByteStream.pbStream - pbStart );
+		NETTRAFFIC_AddMovePlayerTraffic( false, iBytesUsed, iBytesUsed );
 	}
 }
 
@@ -2000,7 +2244,7 @@ void SERVERCOMMANDS_MoveThing( AActor *pActor, ULONG ulBits, ULONG ulPlayerExtra
 	if ( ulBits & CM_MOVEDIR )
 		command.addByte( pActor->movedir );
 
-	command.sendCommandToClients( ulPlayerExtra, ulFlags );
+	command.sendPositionCommandToClients( pActor, ulPlayerExtra, ulFlags );
 
 	// [BB] Only mark something as updated, if it the update was sent to all players.
 	if ( ulFlags == 0 )
@@ -2067,13 +2311,45 @@ void SERVERCOMMANDS_MoveThingExact( AActor *pActor, ULONG ulBits, ULONG ulPlayer
 	if ( ulBits & CM_MOVEDIR )
 		command.addByte( pActor->movedir );
 
-	command.sendCommandToClients( ulPlayerExtra, ulFlags );
+	command.sendPositionCommandToClients( pActor, ulPlayerExtra, ulFlags );
 
 	// [BB] Only mark something as updated, if it the update was sent to all players.
 	if ( ulFlags == 0 )
 		ActorNetPositionUpdated ( pActor, ulBits );
 }
 
+//*****************************************************************************
+//
+// Sends the full position of an actor to a client that missed some of its position
+// updates, including the last position the other clients know, which later updates may
+// tell the client to reuse.
+void SERVERCOMMANDS_ResyncThingPosition( AActor *pActor, ULONG ulClient )
+{
+	if ( !EnsureActorHasNetID (pActor) )
+		return;
+
+	const ULONG ulBits = CM_X|CM_Y|CM_Z|CM_LAST_X|CM_LAST_Y|CM_LAST_Z|CM_NOLAST|CM_ANGLE|CM_MOMX|CM_MOMY|CM_MOMZ|CM_PITCH|CM_MOVEDIR;
+
+	NetCommand command ( SVC_MOVETHINGEXACT );
+	command.addShort( pActor->lNetID );
+	command.addShort( ulBits );
+	command.addLong( pActor->x );
+	command.addLong( pActor->y );
+	command.addLong( pActor->z );
+	command.addLong( pActor->lastX );
+	command.addLong( pActor->lastY );
+	command.addLong( pActor->lastZ );
+	command.addLong( pActor->angle );
+	command.addLong( pActor->momx );
+	command.addLong( pActor->momy );
+	command.addLong( pActor->momz );
+	command.addLong( pActor->pitch );
+	command.addByte( pActor->movedir );
+	command.sendCommandToClients( ulClient, SVCF_ONLYTHISCLIENT );
+
+	NETTRAFFIC_AddRelevanceTraffic( ulClient, false, command.getSize( ));
+}
+
 //*****************************************************************************
 //
 void SERVERCOMMANDS_DamageThing( AActor *pActor )
@@ -4120,6 +4396,8 @@ void SERVERCOMMANDS_SetSectorFloorPlane( ULONG ulSector, ULONG ulPlayerExtra, UL
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4147,6 +4425,8 @@ void SERVERCOMMANDS_SetSectorCeilingPlane( ULONG ulSector, ULONG ulPlayerExtra,
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4234,6 +4514,8 @@ void SERVERCOMMANDS_SetSectorLightLevel( ULONG ulSector, ULONG ulPlayerExtra, UL
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4261,6 +4543,8 @@ void SERVERCOMMANDS_SetSectorColor( ULONG ulSector, ULONG ulPlayerExtra, ULONG u
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4318,6 +4602,8 @@ void SERVERCOMMANDS_SetSectorFade( ULONG ulSector, ULONG ulPlayerExtra, ULONG ul
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4371,6 +4657,8 @@ void SERVERCOMMANDS_SetSectorFlat( ULONG ulSector, ULONG ulPlayerExtra, ULONG ul
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4399,6 +4687,8 @@ void SERVERCOMMANDS_SetSectorPanning( ULONG ulSector, ULONG ulPlayerExtra, ULONG
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4429,6 +4719,8 @@ void SERVERCOMMANDS_SetSectorRotation( ULONG ulSector, ULONG ulPlayerExtra, ULON
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4482,6 +4774,8 @@ void SERVERCOMMANDS_SetSectorScale( ULONG ulSector, ULONG ulPlayerExtra, ULONG u
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4539,6 +4833,8 @@ void SERVERCOMMANDS_SetSectorFriction( ULONG ulSector, ULONG ulPlayerExtra, ULON
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4567,6 +4863,8 @@ void SERVERCOMMANDS_SetSectorAngleYOffset( ULONG ulSector, ULONG ulPlayerExtra,
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4597,6 +4895,8 @@ void SERVERCOMMANDS_SetSectorGravity( ULONG ulSector, ULONG ulPlayerExtra, ULONG
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4624,6 +4924,8 @@ void SERVERCOMMANDS_SetSectorReflection( ULONG ulSector, ULONG ulPlayerExtra, UL
 	if ( ulSector >= (ULONG)numsectors )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSector( ulSector );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4902,6 +5204,8 @@ void SERVERCOMMANDS_SetLineAlpha( ULONG ulLine, ULONG ulPlayerExtra, ULONG ulFla
 	if ( ulLine >= (ULONG)numlines )
 		return;
 
+	SERVER_LEVELCHANGES_MarkLine( ulLine );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
@@ -4929,6 +5233,8 @@ void SERVERCOMMANDS_SetLineTexture( ULONG ulLine, ULONG ulPlayerExtra, ULONG ulF
 	if ( ulLine >= (ULONG)numlines )
 		return;
 
+	SERVER_LEVELCHANGES_MarkLine( ulLine );
+
 	// No changed textures to update.
 	if ( lines[ulLine].ulTexChangeFlags == 0 )
 		return;
@@ -5043,6 +5349,8 @@ void SERVERCOMMANDS_SetSomeLineFlags( ULONG ulLine, ULONG ulPlayerExtra, ULONG u
 	if ( ulLine >= (ULONG)numlines )
 		return;
 
+	SERVER_LEVELCHANGES_MarkLine( ulLine );
+
 	// I bet there's a better way to do this... alas, my knowledge of bits is not
 	// wonderful.
 	lSelectedFlags = 0;
@@ -5149,6 +5457,8 @@ void SERVERCOMMANDS_SetSideFlags( ULONG ulSide, ULONG ulPlayerExtra, ULONG ulFla
 	if ( ulSide >= (ULONG)numsides )
 		return;
 
+	SERVER_LEVELCHANGES_MarkSide( ulSide );
+
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
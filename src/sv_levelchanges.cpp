@@ -0,0 +1,197 @@
+//-----------------------------------------------------------------------------
+//
+// Skulltag Source
+// Copyright (C) 2007-2012 Skulltag Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+// Filename: sv_levelchanges.cpp
+//
+// Description: Keeps track of the sectors, lines and sides that may differ from
+// the state they had when the level was loaded.
+//
+// Whenever something about a sector, line or side is changed that a joining
+// client needs to be told about, the object is marked. Every object is only
+// logged once, so that SERVER_UpdateSectors and friends only have to look at
+// the objects that actually changed instead of walking the whole level for
+// every client that connects. Marking is conservative: an object stays in the
+// log even if it's changed back, the update functions still check what exactly
+// is different.
+//
+//-----------------------------------------------------------------------------
+
+#include "c_dispatch.h"
+#include "doomstat.h"
+#include "network.h"
+#include "r_state.h"
+#include "sv_levelchanges.h"
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- TYPES -----------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct
+{
+	// Number of objects of this kind in the level.
+	ULONG			ulCount;
+
+	// One bit per object, set once the object is in the log.
+	TArray<DWORD>	Marked;
+
+	// Indices of the marked objects, in the order they were changed for the first time.
+	TArray<ULONG>	Log;
+
+} LEVELCHANGELOG_s;
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- VARIABLES -------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+static	LEVELCHANGELOG_s	g_SectorChanges;
+static	LEVELCHANGELOG_s	g_LineChanges;
+static	LEVELCHANGELOG_s	g_SideChanges;
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- FUNCTIONS -------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void levelchanges_Reset( LEVELCHANGELOG_s *pChanges, ULONG ulCount )
+{
+	pChanges->ulCount = ulCount;
+	pChanges->Marked.Resize(( ulCount + 31 ) / 32 );
+	for ( ULONG ulIdx = 0; ulIdx < pChanges->Marked.Size( ); ulIdx++ )
+		pChanges->Marked[ulIdx] = 0;
+	pChanges->Log.Clear( );
+}
+
+//*****************************************************************************
+//
+static void levelchanges_Mark( LEVELCHANGELOG_s *pChanges, ULONG ulIdx )
+{
+	// Clients have nothing to track, their counts are zero.
+	if ( ulIdx >= pChanges->ulCount )
+		return;
+
+	const DWORD dwMask = 1 << ( ulIdx & 31 );
+
+	if ( pChanges->Marked[ulIdx >> 5] & dwMask )
+		return;
+
+	pChanges->Marked[ulIdx >> 5] |= dwMask;
+	pChanges->Log.Push( ulIdx );
+}
+
+//*****************************************************************************
+//
+void SERVER_LEVELCHANGES_Clear( void )
+{
+	// Only the server needs to know this, so clients don't track anything.
+	const bool bTrack = ( NETWORK_GetState( ) == NETSTATE_SERVER );
+
+	levelchanges_Reset( &g_SectorChanges, bTrack ? numsectors : 0 );
+	levelchanges_Reset( &g_LineChanges, bTrack ? numlines : 0 );
+	levelchanges_Reset( &g_SideChanges, bTrack ? numsides : 0 );
+}
+
+//*****************************************************************************
+//
+void SERVER_LEVELCHANGES_MarkAll( void )
+{
+	for ( ULONG ulIdx = 0; ulIdx < g_SectorChanges.ulCount; ulIdx++ )
+		levelchanges_Mark( &g_SectorChanges, ulIdx );
+	for ( ULONG ulIdx = 0; ulIdx < g_LineChanges.ulCount; ulIdx++ )
+		levelchanges_Mark( &g_LineChanges, ulIdx );
+	for ( ULONG ulIdx = 0; ulIdx < g_SideChanges.ulCount; ulIdx++ )
+		levelchanges_Mark( &g_SideChanges, ulIdx );
+}
+
+//*****************************************************************************
+//
+void SERVER_LEVELCHANGES_MarkSector( ULONG ulSector )
+{
+	levelchanges_Mark( &g_SectorChanges, ulSector );
+}
+
+//*****************************************************************************
+//
+void SERVER_LEVELCHANGES_MarkLine( ULONG ulLine )
+{
+	levelchanges_Mark( &g_LineChanges, ulLine );
+}
+
+//*****************************************************************************
+//
+void SERVER_LEVELCHANGES_MarkSide( ULONG ulSide )
+{
+	levelchanges_Mark( &g_SideChanges, ulSide );
+}
+
+//*****************************************************************************
+//
+const TArray<ULONG> &SERVER_LEVELCHANGES_GetSectors( void )
+{
+	return ( g_SectorChanges.Log );
+}
+
+//*****************************************************************************
+//
+const TArray<ULONG> &SERVER_LEVELCHANGES_GetLines( void )
+{
+	return ( g_LineChanges.Log );
+}
+
+//*****************************************************************************
+//
+const TArray<ULONG> &SERVER_LEVELCHANGES_GetSides( void )
+{
+	return ( g_SideChanges.Log );
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- CCMDS -----------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+CCMD( levelchangestats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	Printf( "Changed sectors: %u of %lu\n", g_SectorChanges.Log.Size( ), g_SectorChanges.ulCount );
+	Printf( "Changed lines: %u of %lu\n", g_LineChanges.Log.Size( ), g_LineChanges.ulCount );
+	Printf( "Changed sides: %u of %lu\n", g_SideChanges.Log.Size( ), g_SideChanges.ulCount );
+}
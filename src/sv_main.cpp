@@ -53,6 +53,7 @@
 
 #include <stdarg.h>
 #include <time.h>
+#include <new>
 
 #include "networkheaders.h"
 
@@ -109,9 +110,15 @@
 #include "sv_commands.h"
 #include "sv_save.h"
 #include "sv_rcon.h"
+#include "sv_relevance.h"
+#include "sv_levelchanges.h"
+#include "sv_sendworkers.h"
+#include "sv_profiler.h"
+#include "statnums.h"
 #include "gamemode.h"
 #include "domination.h"
 #include "a_movingcamera.h"
+#include "unlagged.h"
 #include "cl_main.h"
 
 //*****************************************************************************
@@ -158,7 +165,31 @@ static	bool	server_Puke( BYTESTREAM_s *pByteStream );
 static	bool	server_MorphCheat( BYTESTREAM_s *pByteStream );
 static	bool	server_CheckForClientMinorCommandFlood( ULONG ulClient );
 static	bool	server_CheckJoinPassword( const FString& clientPassword );
+static	ULONG	server_HashClientAddress( const NETADDRESS_s &Address );
+static	void	server_RebuildClientAddressIndex( void );
+static	bool	server_IsUnknownSourceFlooding( const NETADDRESS_s &Address );
 static	bool	server_Linetarget( BYTESTREAM_s* pByteStream );
+static	bool	server_AckMoveSnapshot( BYTESTREAM_s *pByteStream );
+static	ULONG	server_GetReliableBytesWritten( ULONG ulClient );
+static	bool	server_IsActorPartOfFullUpdate( AActor *pActor );
+static	ULONG	server_GetFullUpdatePriority( const AActor *pActor, const AActor *pViewer );
+static	int		STACK_ARGS server_CompareFullUpdateActors( const void *pA, const void *pB );
+static	void	server_SendFullUpdateActor( ULONG ulClient, AActor *pActor );
+static	void	server_ContinueFullUpdate( ULONG ulClient );
+static	void	server_FinishFullUpdate( ULONG ulClient );
+static	void	server_AbortFullUpdate( ULONG ulClient );
+static	void	server_ClearFullUpdate( ULONG ulClient );
+static	void	server_AdvanceFullUpdates( void );
+static	void	server_ResetReliableChannel( ULONG ulClient );
+static	void	server_ForgetOverwrittenPackets( CLIENT_s *pClient, ULONG ulStart, ULONG ulEnd );
+static	void	server_ResendPackets( ULONG ulClient );
+static	void	server_LaunchClientPacket( CLIENT_s *pClient, NETBUFFER_s *pBuffer );
+static	void	server_PrepareFinalizedPackets( ULONG ulClient );
+static	void	server_FinalizeClientPackets( ULONG ulItem );
+static	void	server_SendFinalizedPackets( ULONG ulClient );
+static	void	server_ProcessBufferedCommands( ULONG ulClient );
+static	bool	server_DropOldestBufferedCommand( ULONG ulClient );
+static	void	server_ClearBufferedCommands( ULONG ulClient );
 
 // [RC]
 #ifdef CREATE_PACKET_LOG
@@ -185,8 +216,13 @@ static	TArray<FString>	g_ServerCommandQueue;
 // Timer for restarting the map.
 static	LONG			g_lMapRestartTimer;
 
-// Buffer that we use for handling packet loss.
-static	NETBUFFER_s		g_PacketLossBuffer;
+// Clients whose packets are finalized by the send workers right now.
+static	ULONG			g_aulFinalizingClients[MAXPLAYERS];
+static	ULONG			g_ulNumFinalizingClients = 0;
+
+// Are the send workers finalizing packets right now? Then packets are only encoded, the
+// game thread sends them afterwards.
+static	bool			g_bFinalizingPackets = false;
 
 // List of IP addresses that may connect to full servers.
 static	IPList			g_AdminIPList;
@@ -227,6 +263,30 @@ static	TArray<EDITEDTRANSLATION_s>		g_EditedTranslationList;
 // [BB] List of all sector links created by calls to Sector_SetLink.
 static	TArray<SECTORLINK_s>		g_SectorLinkList;
 
+// Statistics about how the main loop waits for the next tic.
+static	SERVERLOOPSTATS_s	g_LoopStats;
+
+// Open-addressed hash table mapping the addresses of all non-free clients to their slot (-1 marks an empty entry).
+static	LONG		g_alClientAddressIndex[CLIENT_ADDRESS_INDEX_SIZE];
+
+// Packet counts of senders that aren't connected clients, indexed by a hash of their IP.
+static	UNKNOWNPACKETSOURCE_s	g_UnknownPacketSources[UNKNOWN_PACKET_SOURCES];
+
+// Statistics about the full updates sent to joining clients.
+static	ULONG		g_ulFullUpdatesCompleted = 0;
+static	ULONG		g_ulFullUpdatesAborted = 0;
+static	QWORD		g_qwFullUpdateTotalBytes = 0;
+static	ULONG		g_ulFullUpdateMaxBytes = 0;
+static	ULONG		g_ulFullUpdateTotalTics = 0;
+static	ULONG		g_ulFullUpdateMaxTics = 0;
+
+// Statistics about the reliable packets sent to the clients.
+static	QWORD		g_qwReliablePacketsSent = 0;
+static	QWORD		g_qwReliablePacketsResent = 0;
+static	QWORD		g_qwReliableBytesSent = 0;
+static	QWORD		g_qwReliableBytesResent = 0;
+static	QWORD		g_qwResendRequestsIgnored = 0;
+
 // [RC] File to log packets to.
 #ifdef CREATE_PACKET_LOG
 static	FILE		*PacketLogFile = NULL;
@@ -264,7 +324,13 @@ CVAR( Bool, sv_pure, true, CVAR_SERVERINFO | CVAR_LATCH )
 CVAR( Int, sv_maxclientsperip, 2, CVAR_ARCHIVE )
 CVAR( Int, sv_afk2spec, 0, CVAR_ARCHIVE ) // [K6]
 CVAR( Bool, sv_useticbuffer, true, CVAR_ARCHIVE|CVAR_NOSETBYACS )
-
+CVAR( Bool, sv_eventloop, true, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+// Maximum number of packets per second accepted from an address that isn't a connected client (0 = unlimited).
+CVAR( Int, sv_unknownpacketlimit, 30, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+// Send player movement as deltas against the last snapshot the client acknowledged.
+CVAR( Bool, sv_deltamoveplayer, false, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+// Amount of bytes per tic a full update may send to a joining client (0 sends everything at once).
+CVAR( Int, sv_fullupdatebudget, 4096, CVAR_ARCHIVE|CVAR_NOSETBYACS )
 CUSTOM_CVAR( String, sv_adminlistfile, "adminlist.txt", CVAR_ARCHIVE|CVAR_NOSETBYACS )
 {
 	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
@@ -413,9 +479,6 @@ void SERVER_Construct( void )
 	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ++ulIdx )
 		playeringame[ulIdx] = false;
 
-	NETWORK_InitBuffer( &g_PacketLossBuffer, MAX_UDP_PACKET, BUFFERTYPE_WRITE );
-	NETWORK_ClearBuffer( &g_PacketLossBuffer );
-
 	// Initialize clients.
 	g_ulMaxPacketSize = sv_maxpacketsize;
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
@@ -434,6 +497,8 @@ void SERVER_Construct( void )
 		// This is currently an open slot.
 		g_aClients[ulIdx].State = CLS_FREE;
 	}
+	server_RebuildClientAddressIndex( );
+	memset( g_UnknownPacketSources, 0, sizeof( g_UnknownPacketSources ));
 
 	// If they used "-host <#>", make <#> the max number of players.
 	pszMaxClients = Args->CheckValue( "-host" );
@@ -500,8 +565,8 @@ void SERVER_Destruct( void )
 {
 	ULONG	ulIdx;
 
-	// Free the packet loss buffer.
-	NETWORK_FreeBuffer( &g_PacketLossBuffer );
+	// Stop the send workers.
+	SERVER_SENDWORKERS_Destruct( );
 
 	// Free the clients' buffers.
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
@@ -524,13 +589,22 @@ void SERVER_Destruct( void )
 #endif
 }
 
-//DWORD	g_LastMS, g_LastSec, g_FrameCount, g_LastCount, g_LastTic;
-
 void			SERVERCONSOLE_UpdateStatistics( void );
 
 //*****************************************************************************
 //
 void SERVERCONSOLE_UpdateScoreboard( void );
+
+#ifdef NO_SERVER_GUI
+static void server_ExecuteConsoleInput( void )
+{
+	char *cmd = I_ConsoleInput();
+	if (cmd)
+		AddCommandString (cmd);
+	fflush(stdout);
+}
+#endif
+
 void SERVER_Tick( void )
 {
 	LONG			lNowTime;
@@ -539,7 +613,12 @@ void SERVER_Tick( void )
 	LONG			lCurTics;
 	ULONG			ulIdx;
 
-	I_DoSelect();
+	// Wait on the socket, the console and a tic timer at once if possible. Otherwise
+	// fall back to polling the socket every millisecond.
+	const bool bEventLoop = sv_eventloop && NETWORK_InitEventWait( );
+
+	if ( bEventLoop == false )
+		I_DoSelect();
 	lPreviousTics = g_lGameTime / (( 1.0 / (double)35.75 ) * 1000.0 );
 
 	lNowTime = I_MSTime( );
@@ -552,18 +631,45 @@ void SERVER_Tick( void )
 		// for an accurate ping measurement.
 		SERVER_GetPackets( );
 
-		I_Sleep( 1 );
+		g_LoopStats.IdleCycles.Clock( );
+		if ( bEventLoop )
+		{
+			// Sleep until a packet arrives or the next tic is due.
+			LONG lTimeToNextTic = static_cast<LONG>( ceil(( lPreviousTics + 1 ) * (( 1.0 / (double)35.75 ) * 1000.0 ))) - lNowTime;
+			ULONG ulEvents = NETWORK_WaitForEvents( MAX<LONG>( lTimeToNextTic, 1 ) * 1000 );
+
+			if ( ulEvents & NETEVENT_PACKETS )
+				g_LoopStats.ulPacketWakeups++;
+			if ( ulEvents & NETEVENT_TIMER )
+				g_LoopStats.ulTimerWakeups++;
+
+#ifdef NO_SERVER_GUI
+			// stdin stays readable until it's read, so read it right away. Otherwise
+			// every wait would return immediately until the next tic is due.
+			if ( ulEvents & NETEVENT_CONSOLE )
+				server_ExecuteConsoleInput( );
+#endif
+		}
+		else
+			I_Sleep( 1 );
+		g_LoopStats.IdleCycles.Unclock( );
+		g_LoopStats.ulWakeups++;
+
 		lNowTime = I_MSTime( );
 		lNewTics = lNowTime / (( 1.0 / (double)35.75 ) * 1000.0 );
 		lCurTics = lNewTics - lPreviousTics;
 	}
 
+	// We are running more than one tic at once, so we missed at least one deadline.
+	if ( lCurTics > 1 )
+	{
+		g_LoopStats.ulTicOverruns += lCurTics - 1;
+		g_LoopStats.ulMaxTicBacklog = MAX<ULONG>( g_LoopStats.ulMaxTicBacklog, lCurTics - 1 );
+	}
+
 #ifdef NO_SERVER_GUI
 	// console input
-	char *cmd = I_ConsoleInput();
-	if (cmd)
-		AddCommandString (cmd);
-	fflush(stdout);
+	server_ExecuteConsoleInput( );
 #else
 	// Execute any commands that have been issued through server menus.
 	while ( g_ServerCommandQueue.Size( ))
@@ -575,33 +681,27 @@ void SERVER_Tick( void )
 	{
 		//DObject::BeginFrame ();
 
+		SERVER_PROFILER_BeginTic( );
+
 		// Recieve packets.
+		SERVER_PROFILER_Clock( PROFILERPHASE_RECEIVE );
 		SERVER_GetPackets( );
+		SERVER_PROFILER_Unclock( PROFILERPHASE_RECEIVE );
 
 		// [BB] Process up to two movement commands for each client.
+		SERVER_PROFILER_Clock( PROFILERPHASE_MOVES );
 		for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 		{
 			if ( SERVER_IsValidClient( ulIdx ) == false )
 				continue;
 
-			int numMoveCMDs = 0;
-			for ( unsigned int i = 0; i < g_aClients[ulIdx].MoveCMDs.Size(); ++i )
-			{
-				g_aClients[ulIdx].MoveCMDs[0]->process ( ulIdx );
-
-				// [BB] Only limit the amount of movement commands.
-				if ( g_aClients[ulIdx].MoveCMDs[0]->isMoveCmd() )
-					++numMoveCMDs;
-
-				delete g_aClients[ulIdx].MoveCMDs[0];
-				g_aClients[ulIdx].MoveCMDs.Delete(0);
-
-				if ( numMoveCMDs == 2 )
-					break;
-			}
+			server_ProcessBufferedCommands( ulIdx );
 		}
+		SERVER_PROFILER_Unclock( PROFILERPHASE_MOVES );
 
+		SERVER_PROFILER_Clock( PROFILERPHASE_TICKER );
 		G_Ticker ();
+		SERVER_PROFILER_Unclock( PROFILERPHASE_TICKER );
 
 		// Update the scoreboard if we have a new second to display.
 		if ( timelimit && (( level.time % TICRATE ) == 0 ) && ( level.time != iOldTime ))
@@ -636,10 +736,14 @@ void SERVER_Tick( void )
 		SERVER_CheckTimeouts( );
 
 		// Send out player's true position, etc.
+		SERVER_PROFILER_Clock( PROFILERPHASE_WRITECOMMANDS );
 		SERVER_WriteCommands( );
+		SERVER_PROFILER_Unclock( PROFILERPHASE_WRITECOMMANDS );
 
 		// Check everyone's PacketBuffer for anything that needs to be sent.
+		SERVER_PROFILER_Clock( PROFILERPHASE_SEND );
 		SERVER_SendOutPackets( );
+		SERVER_PROFILER_Unclock( PROFILERPHASE_SEND );
 
 		// Potentially send an update to the master server.
 		SERVER_MASTER_Tick( );
@@ -673,6 +777,8 @@ void SERVER_Tick( void )
 				SERVERCOMMANDS_MapAuthenticate ( level.mapname, ulIdx, SVCF_ONLYTHISCLIENT );
 		}
 
+		g_LoopStats.ulTics++;
+
 		gametic++;
 		maketic++;
 
@@ -701,6 +807,13 @@ void SERVER_Tick( void )
 			if ( g_lCurrentInboundDataTransfer > g_lMaxInboundDataTransfer )
 				g_lMaxInboundDataTransfer = g_lCurrentInboundDataTransfer;
 
+			// Update the main loop statistics of the last second.
+			g_LoopStats.ulWakeupsLastSecond = g_LoopStats.ulWakeups - g_LoopStats.ulWakeupsAtSecondStart;
+			g_LoopStats.ulWakeupsAtSecondStart = g_LoopStats.ulWakeups;
+			g_LoopStats.dIdleMSLastSecond = g_LoopStats.IdleCycles.TimeMS( );
+			g_LoopStats.dTotalIdleMS += g_LoopStats.dIdleMSLastSecond;
+			g_LoopStats.IdleCycles.Reset( );
+
 			// Update "current" outbound data.
 			g_lOutboundDataTransferLastSecond = g_lCurrentOutboundDataTransfer;
 			g_lCurrentOutboundDataTransfer = 0;
@@ -711,30 +824,11 @@ void SERVER_Tick( void )
 			SERVERCONSOLE_UpdateStatistics( );
 		}
 
+		SERVER_PROFILER_EndTic( );
+
 		//DObject::EndFrame ();
 	}
-/*
-	if ( 1 )
-	{
-		QWORD ms = I_MSTime ();
-		DWORD howlong = DWORD(ms - g_LastMS);
-		if (howlong > 0)
-		{
-			DWORD thisSec = ms/1000;
 
-			if (g_LastSec < thisSec)
-			{
-//					Printf( "%2lu ms (%3lu fps)\n", howlong, g_LastCount );
-
-				g_LastCount = g_FrameCount / (thisSec - g_LastSec);
-				g_LastSec = thisSec;
-				g_FrameCount = 0;
-			}
-			g_FrameCount++;
-		}
-		g_LastMS = ms;
-	}
-*/
 	g_lGameTime = lNowTime;
 
 	// [BB] Remove IP adresses from g_floodProtectionIPQueue that have been in there long enough.
@@ -757,17 +851,122 @@ void SERVER_SendOutPackets( void )
 {
 	ULONG	ulIdx;
 
+	g_ulNumFinalizingClients = 0;
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
 		if ( SERVER_IsValidClient( ulIdx ) == false )
 			continue;
 
-		if ( NETWORK_CalcBufferSize( &g_aClients[ulIdx].PacketBuffer ) > 0 )
-			SERVER_SendClientPacket( ulIdx, true );
+		server_PrepareFinalizedPackets( ulIdx );
+		g_aulFinalizingClients[g_ulNumFinalizingClients++] = ulIdx;
+	}
+
+	// Finalizing the packets of a client only touches the client's own data, so the send
+	// workers can do this for several clients at once. Once this returns, all are done.
+	g_bFinalizingPackets = true;
+	SERVER_SENDWORKERS_Run( server_FinalizeClientPackets, g_ulNumFinalizingClients );
+	g_bFinalizingPackets = false;
+
+	// Collect the packets of all clients and send them with as few system calls as possible.
+	// They are sent in the same order as if the game thread had done everything by itself.
+	NETWORK_BeginPacketBatch( );
+
+	for ( ulIdx = 0; ulIdx < g_ulNumFinalizingClients; ulIdx++ )
+		server_SendFinalizedPackets( g_aulFinalizingClients[ulIdx] );
+
+	NETWORK_EndPacketBatch( );
+}
+
+//*****************************************************************************
+//
+// Makes sure that the client's finalized packets fit without growing the arrays, since
+// the send workers must not allocate memory.
+static void server_PrepareFinalizedPackets( ULONG ulClient )
+{
+	CLIENT_s	*pClient = &g_aClients[ulClient];
+	ULONG		ulNumBytes;
+
+	// The headers take up to five bytes and the encoding adds one more at most.
+	ulNumBytes = NETWORK_CalcBufferSize( &pClient->PacketBuffer ) + NETWORK_CalcBufferSize( &pClient->UnreliablePacketBuffer ) + 2 * 6;
+	for ( ULONG ulIdx = 0; ulIdx < pClient->ResendQueue.Size( ); ulIdx++ )
+	{
+		const SAVEDPACKET_s	*pSaved = &pClient->SavedPackets[pClient->ResendQueue[ulIdx] % PACKET_BUFFER_SIZE];
+
+		if ( pSaved->lSequence == pClient->ResendQueue[ulIdx] )
+			ulNumBytes += pSaved->lSize + 6;
+	}
+
+	pClient->FinalizedData.Clear( );
+	pClient->FinalizedData.Grow( ulNumBytes );
+	pClient->FinalizedPackets.Clear( );
+	pClient->FinalizedPackets.Grow( pClient->ResendQueue.Size( ) + 2 );
+}
+
+//*****************************************************************************
+//
+// Called by the send workers.
+static void server_FinalizeClientPackets( ULONG ulItem )
+{
+	const ULONG	ulClient = g_aulFinalizingClients[ulItem];
+
+	// Resend what the client lost first.
+	server_ResendPackets( ulClient );
+
+	if ( NETWORK_CalcBufferSize( &g_aClients[ulClient].PacketBuffer ) > 0 )
+		SERVER_SendClientPacket( ulClient, true );
+
+	if ( NETWORK_CalcBufferSize( &g_aClients[ulClient].UnreliablePacketBuffer ) > 0 )
+		SERVER_SendClientPacket( ulClient, false );
+}
+
+//*****************************************************************************
+//
+static void server_SendFinalizedPackets( ULONG ulClient )
+{
+	CLIENT_s	*pClient = &g_aClients[ulClient];
+
+	for ( ULONG ulIdx = 0; ulIdx < pClient->FinalizedPackets.Size( ); ulIdx++ )
+	{
+		const FINALIZEDPACKET_s	&Packet = pClient->FinalizedPackets[ulIdx];
+
+		NETWORK_LaunchEncodedPacket( &pClient->FinalizedData[Packet.ulOffset], Packet.iSize, pClient->Address );
+	}
+
+	pClient->FinalizedData.Clear( );
+	pClient->FinalizedPackets.Clear( );
+
+	g_qwReliablePacketsSent += pClient->ulUncountedPacketsSent;
+	g_qwReliableBytesSent += pClient->ulUncountedBytesSent;
+	g_qwReliablePacketsResent += pClient->ulUncountedPacketsResent;
+	g_qwReliableBytesResent += pClient->ulUncountedBytesResent;
+	pClient->ulUncountedPacketsSent = 0;
+	pClient->ulUncountedBytesSent = 0;
+	pClient->ulUncountedPacketsResent = 0;
+	pClient->ulUncountedBytesResent = 0;
+}
+
+//*****************************************************************************
+//
+// Sends the packet right away, unless the send workers are finalizing packets. Then it's
+// only encoded and sent by the game thread in server_SendFinalizedPackets.
+static void server_LaunchClientPacket( CLIENT_s *pClient, NETBUFFER_s *pBuffer )
+{
+	FINALIZEDPACKET_s	Packet;
 
-		if ( NETWORK_CalcBufferSize( &g_aClients[ulIdx].UnreliablePacketBuffer ) > 0 )
-			SERVER_SendClientPacket( ulIdx, false );
+	if ( g_bFinalizingPackets == false )
+	{
+		NETWORK_LaunchPacket( pBuffer, pClient->Address );
+		return;
 	}
+
+	// server_PrepareFinalizedPackets made sure that this doesn't need to allocate anything.
+	Packet.ulOffset = pClient->FinalizedData.Size( );
+	pClient->FinalizedData.Resize( Packet.ulOffset + NETWORK_CalcBufferSize( pBuffer ) + 1 );
+	Packet.iSize = NETWORK_EncodePacket( pBuffer, &pClient->FinalizedData[Packet.ulOffset], pClient->FinalizedData.Size( ) - Packet.ulOffset );
+	pClient->FinalizedData.Resize( Packet.ulOffset + Packet.iSize );
+
+	if ( Packet.iSize > 0 )
+		pClient->FinalizedPackets.Push( Packet );
 }
 
 //*****************************************************************************
@@ -798,26 +997,40 @@ void SERVER_SendClientPacket( ULONG ulClient, bool bReliable )
 	pBuffer->ulCurrentSize = NETWORK_CalcBufferSize( pBuffer );
 	if ( bReliable )
 	{
+		SAVEDPACKET_s	*pSaved = &pClient->SavedPackets[pClient->ulPacketSequence % PACKET_BUFFER_SIZE];
+
 		pClient->SavedPacketBuffer.ulCurrentSize = NETWORK_CalcBufferSize( &pClient->SavedPacketBuffer );
 
 		// If we've reached the end of our reliable packets buffer, start writing at the beginning.
+		// The packets behind the current position are the oldest ones, forget them first.
 		if (( pClient->SavedPacketBuffer.ulCurrentSize + pClient->PacketBuffer.ulCurrentSize ) >= pClient->SavedPacketBuffer.ulMaxSize )
 		{
+			server_ForgetOverwrittenPackets( pClient, pClient->SavedPacketBuffer.ulCurrentSize, pClient->SavedPacketBuffer.ulMaxSize );
 			pClient->SavedPacketBuffer.ByteStream.pbStream = pClient->SavedPacketBuffer.pbData;
 			pClient->SavedPacketBuffer.ulCurrentSize = 0;
 		}
 
+		// Forget the packets we're about to overwrite, so that we never resend garbage.
+		server_ForgetOverwrittenPackets( pClient, pClient->SavedPacketBuffer.ulCurrentSize, pClient->SavedPacketBuffer.ulCurrentSize + pClient->PacketBuffer.ulCurrentSize );
+
 		// Save where the beginning is and the size of each packet within the reliable packets
 		// buffer.
-		pClient->lPacketBeginning[( pClient->ulPacketSequence ) % PACKET_BUFFER_SIZE] = pClient->SavedPacketBuffer.ulCurrentSize;
-		pClient->lPacketSize[( pClient->ulPacketSequence ) % PACKET_BUFFER_SIZE] = pClient->PacketBuffer.ulCurrentSize;
-		pClient->lPacketSequence[( pClient->ulPacketSequence ) % PACKET_BUFFER_SIZE] = pClient->ulPacketSequence;
+		pSaved->lSequence = pClient->ulPacketSequence;
+		pSaved->lBeginning = pClient->SavedPacketBuffer.ulCurrentSize;
+		pSaved->lSize = pClient->PacketBuffer.ulCurrentSize;
+		pSaved->ulLastSendTime = I_MSTime( );
+		pSaved->ulNumResends = 0;
+		pSaved->bQueued = false;
 
 		// Write what we want to send out to our reliable packets buffer, so that it can be
 		// retransmitted later if necessary.
 		if ( pClient->PacketBuffer.ulCurrentSize )
 			NETWORK_WriteBuffer( &pClient->SavedPacketBuffer.ByteStream, pClient->PacketBuffer.pbData, pClient->PacketBuffer.ulCurrentSize );
 
+		pClient->ulReliableBytesSent += pClient->PacketBuffer.ulCurrentSize;
+		pClient->ulUncountedPacketsSent++;
+		pClient->ulUncountedBytesSent += pClient->PacketBuffer.ulCurrentSize;
+
 		// Write the header to our temporary buffer.
 		NETWORK_WriteByte( &TempBuffer.ByteStream, SVC_HEADER );
 		NETWORK_WriteLong( &TempBuffer.ByteStream, pClient->ulPacketSequence );
@@ -836,7 +1049,7 @@ void SERVER_SendClientPacket( ULONG ulClient, bool bReliable )
 		NETWORK_WriteBuffer( &TempBuffer.ByteStream, pBuffer->pbData, pBuffer->ulCurrentSize );
 
 	// Finally, send the packet, and clear the buffer.
-	NETWORK_LaunchPacket( &TempBuffer, pClient->Address );
+	server_LaunchClientPacket( pClient, &TempBuffer );
 	NETWORK_ClearBuffer( pBuffer );
 }
 
@@ -869,6 +1082,120 @@ void SERVER_CheckClientBuffer( ULONG ulClient, ULONG ulSize, bool bReliable )
 	}
 }
 
+//*****************************************************************************
+//
+static void server_ResetReliableChannel( ULONG ulClient )
+{
+	CLIENT_s	*pClient = &g_aClients[ulClient];
+
+	NETWORK_ClearBuffer( &pClient->SavedPacketBuffer );
+	for ( ULONG ulIdx = 0; ulIdx < PACKET_BUFFER_SIZE; ulIdx++ )
+	{
+		pClient->SavedPackets[ulIdx].lSequence = -1;
+		pClient->SavedPackets[ulIdx].lBeginning = 0;
+		pClient->SavedPackets[ulIdx].lSize = 0;
+		pClient->SavedPackets[ulIdx].ulLastSendTime = 0;
+		pClient->SavedPackets[ulIdx].ulNumResends = 0;
+		pClient->SavedPackets[ulIdx].bQueued = false;
+	}
+	pClient->ulPacketSequence = 0;
+	pClient->ulOldestSavedPacket = 0;
+	pClient->ResendQueue.Clear( );
+	pClient->ulResendWindow = RESEND_WINDOW_INITIAL * SERVER_GetMaxPacketSize( );
+	pClient->FinalizedData.Clear( );
+	pClient->FinalizedPackets.Clear( );
+	pClient->ulUncountedPacketsSent = 0;
+	pClient->ulUncountedBytesSent = 0;
+	pClient->ulUncountedPacketsResent = 0;
+	pClient->ulUncountedBytesResent = 0;
+}
+
+//*****************************************************************************
+//
+// The packets are written one after another into SavedPacketBuffer, so the oldest one
+// is always the next one to be overwritten.
+static void server_ForgetOverwrittenPackets( CLIENT_s *pClient, ULONG ulStart, ULONG ulEnd )
+{
+	for ( ; pClient->ulOldestSavedPacket < pClient->ulPacketSequence; pClient->ulOldestSavedPacket++ )
+	{
+		SAVEDPACKET_s	*pSaved = &pClient->SavedPackets[pClient->ulOldestSavedPacket % PACKET_BUFFER_SIZE];
+
+		// Its slot was already reused by a newer packet.
+		if ( pSaved->lSequence != static_cast<LONG>( pClient->ulOldestSavedPacket ))
+			continue;
+
+		// Empty packets don't have any data that could be overwritten.
+		if ( pSaved->lSize == 0 )
+			continue;
+
+		if (( static_cast<ULONG>( pSaved->lBeginning ) >= ulEnd ) ||
+			( static_cast<ULONG>( pSaved->lBeginning + pSaved->lSize ) <= ulStart ))
+		{
+			break;
+		}
+
+		pSaved->lSequence = -1;
+	}
+}
+
+//*****************************************************************************
+//
+static void server_ResendPackets( ULONG ulClient )
+{
+	CLIENT_s		*pClient = &g_aClients[ulClient];
+	SAVEDPACKET_s	*pSaved;
+	NETBUFFER_s		TempBuffer;
+	BYTE			abData[MAX_UDP_PACKET];
+	ULONG			ulBudget;
+	ULONG			ulIdx;
+
+	// This may run on a send worker, so it can't use a shared buffer.
+	TempBuffer.pbData = abData;
+	TempBuffer.ulMaxSize = sizeof( abData );
+	TempBuffer.BufferType = BUFFERTYPE_WRITE;
+
+	const ULONG		ulTimeout = UNLAGGED_GetRetransmitTimeout( &players[ulClient] );
+
+	// Grow the window by one packet per round trip as long as the client doesn't report new losses.
+	if (( gametic - pClient->lLastPacketLossTick ) * 1000 >= static_cast<LONG>( ulTimeout * TICRATE ))
+	{
+		pClient->ulResendWindow += MAX<ULONG>( SERVER_GetMaxPacketSize( ) * 1000 / ( ulTimeout * TICRATE ), 1 );
+		pClient->ulResendWindow = MIN<ULONG>( pClient->ulResendWindow, RESEND_WINDOW_MAX * SERVER_GetMaxPacketSize( ));
+	}
+
+	ulBudget = pClient->ulResendWindow;
+	for ( ulIdx = 0; ulIdx < pClient->ResendQueue.Size( ); ulIdx++ )
+	{
+		const LONG	lPacket = pClient->ResendQueue[ulIdx];
+
+		// The packet was overwritten while it waited. If the client still misses it, it
+		// will tell us again.
+		pSaved = &pClient->SavedPackets[lPacket % PACKET_BUFFER_SIZE];
+		if ( pSaved->lSequence != lPacket )
+			continue;
+
+		// The rest has to wait for the next tic.
+		if ( static_cast<ULONG>( pSaved->lSize ) + 5 > ulBudget )
+			break;
+		ulBudget -= pSaved->lSize + 5;
+
+		NETWORK_ClearBuffer( &TempBuffer );
+		NETWORK_WriteHeader( &TempBuffer.ByteStream, SVC_HEADER );
+		NETWORK_WriteLong( &TempBuffer.ByteStream, lPacket );
+		if ( pSaved->lSize )
+			NETWORK_WriteBuffer( &TempBuffer.ByteStream, pClient->SavedPacketBuffer.pbData + pSaved->lBeginning, pSaved->lSize );
+		server_LaunchClientPacket( pClient, &TempBuffer );
+
+		pSaved->ulLastSendTime = I_MSTime( );
+		pSaved->bQueued = false;
+		pClient->ulUncountedPacketsResent++;
+		pClient->ulUncountedBytesResent += pSaved->lSize;
+	}
+
+	if ( ulIdx > 0 )
+		pClient->ResendQueue.Delete( 0, ulIdx );
+}
+
 //*****************************************************************************
 //
 LONG SERVER_FindFreeClientSlot( void )
@@ -901,17 +1228,82 @@ LONG SERVER_FindFreeClientSlot( void )
 //
 LONG SERVER_FindClientByAddress( NETADDRESS_s Address )
 {
+	// Every packet we receive goes through here, so probe the address index instead of comparing against every slot.
+	for ( ULONG ulProbe = server_HashClientAddress( Address ); ; ulProbe = ( ulProbe + 1 ) & ( CLIENT_ADDRESS_INDEX_SIZE - 1 ))
+	{
+		const LONG lClient = g_alClientAddressIndex[ulProbe];
+
+		// Reached an empty entry, so the address isn't in the table.
+		if ( lClient == -1 )
+			return ( -1 );
+
+		if (( g_aClients[lClient].State != CLS_FREE ) &&
+			( NETWORK_CompareAddress( g_aClients[lClient].Address, Address, false )))
+		{
+			return ( lClient );
+		}
+	}
+}
+
+//*****************************************************************************
+//
+static ULONG server_HashClientAddress( const NETADDRESS_s &Address )
+{
+	ULONG	ulHash = ( Address.abIP[0] << 24 ) | ( Address.abIP[1] << 16 ) | ( Address.abIP[2] << 8 ) | Address.abIP[3];
+
+	// Mix in the port (clients behind the same NAT only differ by it) and let the multiplication spread
+	// the result over the high bits, from which the table index is taken.
+	ulHash = ( ulHash ^ ( static_cast<ULONG> ( Address.usPort ) << 7 )) * 2654435761UL;
+	return ((( ulHash & 0xFFFFFFFF ) >> 16 ) & ( CLIENT_ADDRESS_INDEX_SIZE - 1 ));
+}
+
+//*****************************************************************************
+//
+static void server_RebuildClientAddressIndex( void )
+{
+	// Clients only come and go when they connect or disconnect, so just rebuild the whole table then.
+	for ( ULONG ulIdx = 0; ulIdx < CLIENT_ADDRESS_INDEX_SIZE; ulIdx++ )
+		g_alClientAddressIndex[ulIdx] = -1;
+
 	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
 	{
-	   if ( g_aClients[ulIdx].State == CLS_FREE )
-	       continue;
+		if ( g_aClients[ulIdx].State == CLS_FREE )
+			continue;
 
-	   // If the client's address matches the given IP, return the client's index.
-	   if ( NETWORK_CompareAddress( g_aClients[ulIdx].Address, Address, false ))
-	       return ( ulIdx );
+		ULONG ulProbe = server_HashClientAddress( g_aClients[ulIdx].Address );
+		while ( g_alClientAddressIndex[ulProbe] != -1 )
+			ulProbe = ( ulProbe + 1 ) & ( CLIENT_ADDRESS_INDEX_SIZE - 1 );
+
+		g_alClientAddressIndex[ulProbe] = ulIdx;
 	}
-	
-	return ( -1 );
+}
+
+//*****************************************************************************
+//
+static bool server_IsUnknownSourceFlooding( const NETADDRESS_s &Address )
+{
+	if ( sv_unknownpacketlimit <= 0 )
+		return ( false );
+
+	// The master server sends the ban list in many parts, never throttle it.
+	if ( NETWORK_CompareAddress( Address, SERVER_MASTER_GetMasterAddress( ), true ))
+		return ( false );
+
+	const ULONG		ulSecond = static_cast<ULONG> ( I_MSTime( ) / 1000 );
+	const ULONG		ulIP = ( Address.abIP[0] << 24 ) | ( Address.abIP[1] << 16 ) | ( Address.abIP[2] << 8 ) | Address.abIP[3];
+	UNKNOWNPACKETSOURCE_s	&Source = g_UnknownPacketSources[((( ulIP * 2654435761UL ) & 0xFFFFFFFF ) >> 16 ) & ( UNKNOWN_PACKET_SOURCES - 1 )];
+
+	// This entry belongs to a different sender or an older second, so start counting anew.
+	// A sender that hashes to an entry in use simply takes it over.
+	if (( memcmp( Source.abIP, Address.abIP, sizeof( Source.abIP )) != 0 ) || ( Source.ulSecond != ulSecond ))
+	{
+		memcpy( Source.abIP, Address.abIP, sizeof( Source.abIP ));
+		Source.ulSecond = ulSecond;
+		Source.ulNumPackets = 0;
+	}
+
+	Source.ulNumPackets++;
+	return ( Source.ulNumPackets > static_cast<ULONG> ( sv_unknownpacketlimit ));
 }
 
 //*****************************************************************************
@@ -1076,6 +1468,13 @@ void SERVER_GetPackets( void )
 		// Packet is not from an existing client; must be someone trying to connect!
 		if ( g_lCurrentClient == -1 )
 		{
+			// Drop it right away if this sender is flooding us.
+			if ( server_IsUnknownSourceFlooding( NETWORK_GetFromAddress( )))
+			{
+				g_LoopStats.ulRejectedUnknownPackets++;
+				continue;
+			}
+
 			SERVER_DetermineConnectionType( pByteStream );
 			continue;
 		}
@@ -1296,6 +1695,7 @@ void SERVER_ConnectNewPlayer( BYTESTREAM_s *pByteStream )
 
 	// This player is now in the game.
 	playeringame[g_lCurrentClient] = true;
+	SERVER_MASTER_InvalidateServerInfoCache( );
 
 	// [BB] If necessary, spawn a voodoo doll for the player.
 	if ( COOP_PlayersVoodooDollsNeedToBeSpawned ( g_lCurrentClient ) )
@@ -1486,8 +1886,11 @@ void SERVER_ConnectNewPlayer( BYTESTREAM_s *pByteStream )
 	// Send a snapshot of the level.
 	SERVER_SendFullUpdate( g_lCurrentClient );
 
-	// If we need to start this client's enter scripts, do that now.
-	if ( g_aClients[g_lCurrentClient].bRunEnterScripts )
+	// If we need to start this client's enter scripts, do that now. The scripts may
+	// refer to any actor, so wait for the full update to arrive.
+	if ( g_aClients[g_lCurrentClient].FullUpdate.bActive )
+		g_aClients[g_lCurrentClient].FullUpdate.bRunEnterScripts = true;
+	else if ( g_aClients[g_lCurrentClient].bRunEnterScripts )
 	{
 		FBehavior::StaticStartTypedScripts( SCRIPT_Enter, players[g_lCurrentClient].mo, true );
 		g_aClients[g_lCurrentClient].bRunEnterScripts = false;
@@ -1608,8 +2011,12 @@ void SERVER_ConnectNewPlayer( BYTESTREAM_s *pByteStream )
 	// [RC] Update clients using the RCON utility.
 	SERVER_RCON_UpdateInfo( SVRCU_PLAYERDATA );
 
-	// Tell the client that the snapshot is done.
-	SERVERCOMMANDS_EndSnapshot( g_lCurrentClient );
+	// Tell the client that the snapshot is done. If the full update is still being
+	// streamed, that happens once it is complete.
+	if ( g_aClients[g_lCurrentClient].FullUpdate.bActive )
+		g_aClients[g_lCurrentClient].FullUpdate.bEndSnapshot = true;
+	else
+		SERVERCOMMANDS_EndSnapshot( g_lCurrentClient );
 
 	// [RC] Clients may wish to ignore this new player.
 	SERVERCOMMANDS_PotentiallyIgnorePlayer( g_lCurrentClient );
@@ -1737,6 +2144,7 @@ void SERVER_DetermineConnectionType( BYTESTREAM_s *pByteStream )
 		case CLC_SUMMONFOECHEAT: 
 		case CLC_PUKE:
 		case CLC_MORPHEX:
+		case CLC_ACKMOVESNAPSHOT:
 
 			// [BB] After a map change with the CCMD map, legitimate clients may get caught by
 			// this. Since the packet is completely ignored anyway, there is no need to ban the
@@ -1897,15 +2305,13 @@ void SERVER_SetupNewConnection( BYTESTREAM_s *pByteStream, bool bNewPlayer )
 	lClientNetworkGameVersion = NETWORK_ReadByte( pByteStream );
 
 	NETWORK_ClearBuffer( &g_aClients[lClient].PacketBuffer );
-	NETWORK_ClearBuffer( &g_aClients[lClient].SavedPacketBuffer );
 	NETWORK_ClearBuffer( &g_aClients[lClient].UnreliablePacketBuffer );
-	for ( ulIdx = 0; ulIdx < PACKET_BUFFER_SIZE; ulIdx++ )
-	{
-		g_aClients[lClient].lPacketBeginning[ulIdx] = 0;
-		g_aClients[lClient].lPacketSize[ulIdx] = 0;
-		g_aClients[lClient].lPacketSequence[ulIdx] = 0;
-	}
-	g_aClients[lClient].ulPacketSequence = 0;
+	server_ResetReliableChannel( lClient );
+	server_ClearBufferedCommands( lClient );
+	g_aClients[lClient].ulMoveSnapshot = 0;
+	SERVER_ResetMoveSnapshots( lClient );
+	SERVER_RELEVANCE_ResetClient( lClient );
+	UNLAGGED_ResetLatency( &players[lClient] );
 
 	// Who is connecting?
 	Printf( "Connect (v%s): %s\n", clientVersion.GetChars(), NETWORK_AddressToString( NETWORK_GetFromAddress( )));
@@ -1913,6 +2319,7 @@ void SERVER_SetupNewConnection( BYTESTREAM_s *pByteStream, bool bNewPlayer )
 	// Setup the client.
 	g_aClients[lClient].State = CLS_CHALLENGE;
 	g_aClients[lClient].Address = AddressFrom;
+	server_RebuildClientAddressIndex( );
 
 	{
 		// Make sure the version matches.
@@ -2322,6 +2729,19 @@ void SERVER_SendFullUpdate( ULONG ulClient )
 	player_t*					pPlayer;
 	AInventory					*pInventory;
 	TThinkerIterator<AActor>	Iterator;
+	CLIENT_s					*pClient;
+
+	pClient = SERVER_GetClient( ulClient );
+	if ( pClient == NULL )
+		return;
+
+	// A full update that is still in progress is replaced by this one.
+	server_AbortFullUpdate( ulClient );
+
+	const ULONG	ulStartBytes = server_GetReliableBytesWritten( ulClient );
+
+	// The full update sends every actor, so nothing is stale for this client anymore.
+	SERVER_RELEVANCE_ResetClient( ulClient );
 
 	// Send active players to the client.
 	for ( ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
@@ -2481,174 +2901,320 @@ void SERVER_SendFullUpdate( ULONG ulClient )
 	if ( timelimit )
 		SERVERCOMMANDS_SetMapTime( ulClient, SVCF_ONLYTHISCLIENT );
 
-	// Go through all the items on the map, and tell the client to spawn those of which
-	// are important.
+	// Send out any translations that have been edited since the start of the level.
+	for ( ulIdx = 0; ulIdx < g_EditedTranslationList.Size( ); ulIdx++ )
+	{
+		if ( g_EditedTranslationList[ulIdx].ulType == DLevelScript::PCD_TRANSLATIONRANGE1 )
+			SERVERCOMMANDS_CreateTranslation( g_EditedTranslationList[ulIdx].ulIdx, g_EditedTranslationList[ulIdx].ulStart, g_EditedTranslationList[ulIdx].ulEnd, g_EditedTranslationList[ulIdx].ulPal1, g_EditedTranslationList[ulIdx].ulPal2 );
+		else
+			SERVERCOMMANDS_CreateTranslation( g_EditedTranslationList[ulIdx].ulIdx, g_EditedTranslationList[ulIdx].ulStart, g_EditedTranslationList[ulIdx].ulEnd, g_EditedTranslationList[ulIdx].ulR1, g_EditedTranslationList[ulIdx].ulG1, g_EditedTranslationList[ulIdx].ulB1, g_EditedTranslationList[ulIdx].ulR2, g_EditedTranslationList[ulIdx].ulG2, g_EditedTranslationList[ulIdx].ulB2 );
+	}
+
+	// Collect the actors the client has to know about. They are sent over the next tics
+	// (see server_ContinueFullUpdate), the ones close to the client and the ones it can
+	// interact with first, so that it can start playing before the rest arrived.
+	const AActor			*pViewer = ( players[ulClient].camera != NULL ) ? players[ulClient].camera : players[ulClient].mo;
+	TArray<FULLUPDATEACTOR_s>	Actors;
+
 	while (( pActor = Iterator.Next( )))
 	{
-		// If the actor doesn't have a network ID, don't spawn it (it
-		// probably isn't important).
-		if ( pActor->lNetID == -1 )
+		if ( server_IsActorPartOfFullUpdate( pActor ) == false )
 			continue;
 
-		// [BB] The other clients already have destroyed this actor, so don't spawn it.
-		if ( pActor->ulNetworkFlags & NETFL_DESTROYED_ON_CLIENT )
-			continue;
+		FULLUPDATEACTOR_s	Entry;
+		Entry.ulHandle = ACTOR_GetNetIDHandle( pActor );
+		Entry.ulPriority = server_GetFullUpdatePriority( pActor, pViewer );
+		Actors.Push( Entry );
+	}
+
+	if ( Actors.Size( ) > 0 )
+		qsort( &Actors[0], Actors.Size( ), sizeof( FULLUPDATEACTOR_s ), server_CompareFullUpdateActors );
+
+	FULLUPDATESTREAM_s	*pStream = &pClient->FullUpdate;
+
+	pStream->bActive = true;
+	pStream->ulNextActor = 0;
+	pStream->lStartGametic = gametic;
+	pStream->ulActorsSent = 0;
+	for ( ulIdx = 0; ulIdx < Actors.Size( ); ulIdx++ )
+		pStream->ActorHandles.Push( Actors[ulIdx].ulHandle );
+	pStream->ulBytesSent = server_GetReliableBytesWritten( ulClient ) - ulStartBytes;
+
+	// [BB] The client will let us know that it received the update.
+	pClient->bFullUpdateIncomplete = true;
+
+	// Send as much as this tic's budget allows right away.
+	server_ContinueFullUpdate( ulClient );
+}
 
-		// Don't spawn players, items about to be deleted, inventory items
-		// that have an owner, or items that the client spawns himself.
-		if (( pActor->IsKindOf( RUNTIME_CLASS( APlayerPawn ))) ||
-			( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HoldAndDestroy") ) ||	// S_HOLDANDDESTROY
-			( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("Held") ) || // S_HELD
-			( pActor->ulNetworkFlags & NETFL_ALLOWCLIENTSPAWN ))
+//*****************************************************************************
+//
+static ULONG server_GetReliableBytesWritten( ULONG ulClient )
+{
+	CLIENT_s	*pClient = SERVER_GetClient( ulClient );
+
+	return ( pClient->ulReliableBytesSent + NETWORK_CalcBufferSize( &pClient->PacketBuffer ));
+}
+
+//*****************************************************************************
+//
+static bool server_IsActorPartOfFullUpdate( AActor *pActor )
+{
+	// If the actor doesn't have a network ID, don't spawn it (it
+	// probably isn't important).
+	if ( pActor->lNetID == -1 )
+		return ( false );
+
+	// [BB] The other clients already have destroyed this actor, so don't spawn it.
+	if ( pActor->ulNetworkFlags & NETFL_DESTROYED_ON_CLIENT )
+		return ( false );
+
+	// Don't spawn players, items about to be deleted, inventory items
+	// that have an owner, or items that the client spawns himself.
+	if (( pActor->IsKindOf( RUNTIME_CLASS( APlayerPawn ))) ||
+		( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HoldAndDestroy") ) ||	// S_HOLDANDDESTROY
+		( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("Held") ) || // S_HELD
+		( pActor->ulNetworkFlags & NETFL_ALLOWCLIENTSPAWN ))
+	{
+		return ( false );
+	}
+
+	// [BB] Don't spawn things hidden by AActor::HideOrDestroyIfSafe().
+	// The clients don't need them at all, since the server will tell
+	// them to spawn a new actor during GAME_ResetMap anyway.
+	if ( !( pActor->IsKindOf( RUNTIME_CLASS( AInventory ) ) )
+	     && ( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HideIndefinitely") ) // S_HIDEINDEFINITELY 
+	   )
+	{
+		return ( false );
+	}
+
+	return ( true );
+}
+
+//*****************************************************************************
+//
+static ULONG server_GetFullUpdatePriority( const AActor *pActor, const AActor *pViewer )
+{
+	ULONG	ulPriority = 0;
+
+	// Without a body to look from, the actors are sent in the order they are in the thinker list.
+	if ( pViewer != NULL )
+	{
+		ulPriority = labs(( pActor->x >> FRACBITS ) - ( pViewer->x >> FRACBITS ))
+			+ labs(( pActor->y >> FRACBITS ) - ( pViewer->y >> FRACBITS ));
+	}
+
+	// Items, monsters, projectiles and things with specials matter more than decorations at the same distance.
+	if (( pActor->flags & ( MF_SPECIAL|MF_SHOOTABLE|MF_MISSILE )) || ( pActor->special != 0 ))
+		ulPriority /= 4;
+
+	return ( ulPriority );
+}
+
+//*****************************************************************************
+//
+static int STACK_ARGS server_CompareFullUpdateActors( const void *pA, const void *pB )
+{
+	const FULLUPDATEACTOR_s	*pActorA = static_cast<const FULLUPDATEACTOR_s *> ( pA );
+	const FULLUPDATEACTOR_s	*pActorB = static_cast<const FULLUPDATEACTOR_s *> ( pB );
+
+	if ( pActorA->ulPriority != pActorB->ulPriority )
+		return (( pActorA->ulPriority < pActorB->ulPriority ) ? -1 : 1 );
+
+	// Keep the order deterministic for actors with the same priority.
+	return ( static_cast<int> ( pActorA->ulHandle & 0xFFFF ) - static_cast<int> ( pActorB->ulHandle & 0xFFFF ));
+}
+
+//*****************************************************************************
+//
+static void server_SendFullUpdateActor( ULONG ulClient, AActor *pActor )
+{
+	// Spawn a missile. Missiles must be handled differently because they have
+	// velocity.
+	if ( pActor->flags & MF_MISSILE )
+	{
+		SERVERCOMMANDS_SpawnMissile( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+	}
+	// Tell the client to spawn this thing.
+	else
+	{
+		SERVERCOMMANDS_SpawnThing( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+		// [BB] If the thing is not at its spawn point, let the client know about the spawn point.
+		if ( ( pActor->x != pActor->SpawnPoint[0] )
+			|| ( pActor->y != pActor->SpawnPoint[1] )
+			|| ( pActor->z != pActor->SpawnPoint[2] )
+			)
 		{
-			continue;
+			SERVERCOMMANDS_SetThingSpawnPoint( pActor, ulClient, SVCF_ONLYTHISCLIENT );
 		}
 
-		// [BB] Don't spawn things hidden by AActor::HideOrDestroyIfSafe().
-		// The clients don't need them at all, since the server will tell
-		// them to spawn a new actor during GAME_ResetMap anyway.
-		if ( !( pActor->IsKindOf( RUNTIME_CLASS( AInventory ) ) )
-		     && ( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HideIndefinitely") ) // S_HIDEINDEFINITELY 
-		   )
+		// [BB] Since the monster movement is client side, the client needs to be
+		// informed about the momentum and the current state. If the frame is not
+		// set, the client thinks the actor is in its spawn state.
 		{
-			continue;
+
+			if ( (pActor->InSpawnState() == false)
+				 && !(( pActor->health <= 0 ) && ( pActor->flags & MF_COUNTKILL )) // [BB] Corpses are handled later.
+				 )
+			{
+				SERVERCOMMANDS_SetThingFrame( pActor, pActor->state, ulClient, SVCF_ONLYTHISCLIENT, false );
+			}
+
+			// [WS/BB] Always inform client of the actor's lastX/Y/Z.
+			ULONG ulBits = CM_LAST_X|CM_LAST_Y|CM_LAST_Z;
+
+			if ( pActor->momx != 0 )
+				ulBits |= CM_MOMX;
+
+			if ( pActor->momy != 0 )
+				ulBits |= CM_MOMY;
+
+			if ( pActor->momz != 0 )
+				ulBits |= CM_MOMZ;
+
+			if ( pActor->movedir != 0 )
+				ulBits |= CM_MOVEDIR;
+
+			if ( ulBits != 0 )
+				SERVERCOMMANDS_MoveThingExact( pActor, ulBits, ulClient, SVCF_ONLYTHISCLIENT );
 		}
 
-		// Spawn a missile. Missiles must be handled differently because they have
-		// velocity.
-		if ( pActor->flags & MF_MISSILE )
+		// If it's important to update this thing's arguments, do that now.
+		// [BB] Wouldn't it be better, if this is done for all things, for which
+		// at least one of the arguments is not equal to zero?
+		// [BC] It's not necessarily important for clients to know this, such
+		// as with invasion spawners. You can do it if you want, though! It would
+		// probably save headache later on.
+		//if ( pActor->ulNetworkFlags & NETFL_UPDATEARGUMENTS )
+		// [BB] I don't want to export NETFL_UPDATEARGUMENTS to DECORATE, so we have
+		// to tell the clients all the arguments.
+		if ( ( pActor->args[0] != 0 )
+			|| ( pActor->args[1] != 0 )
+			|| ( pActor->args[2] != 0 )
+			|| ( pActor->args[3] != 0 )
+			|| ( pActor->args[4] != 0 ) )
+			SERVERCOMMANDS_SetThingArguments( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+
+		// [BB] Clients need to know the SectorAction specials to predict them.
+		// [EP] Spectators need to know the allowed specials to use them.
+		if ( ( NETWORK_IsClientPredictedSpecial ( pActor->special ) || GAMEMODE_IsSpectatorAllowedSpecial ( pActor->special ) )
+			&& pActor->IsKindOf( PClass::FindClass( "SectorAction" ) ) )
+			SERVERCOMMANDS_SetThingSpecial ( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+
+		// [BB] Some things like AMovingCamera rely on the AActor tid.
+		// So tell it to the client. I have no idea if this has unwanted side
+		// effects. Has to be checked.
+		if ( pActor->tid != 0 )
+			SERVERCOMMANDS_SetThingTID( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+
+		// If this thing's translation has been altered, tell the client.
+		if ( pActor->Translation != 0 )
+			SERVERCOMMANDS_SetThingTranslation( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+
+		// This item has been picked up, and is in its hidden, respawn state. Let
+		// the client know that.
+		if (( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HideDoomish") ) ||	// S_HIDEDOOMISH
+			( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HideSpecial") ) ||	// S_HIDESPECIAL
+			( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HideIndefinitely") ))
 		{
-			SERVERCOMMANDS_SpawnMissile( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+			SERVERCOMMANDS_HideThing( pActor, ulClient, SVCF_ONLYTHISCLIENT );
 		}
-		// Tell the client to spawn this thing.
-		else
-		{
-			SERVERCOMMANDS_SpawnThing( pActor, ulClient, SVCF_ONLYTHISCLIENT );
-			// [BB] If the thing is not at its spawn point, let the client know about the spawn point.
-			if ( ( pActor->x != pActor->SpawnPoint[0] )
-				|| ( pActor->y != pActor->SpawnPoint[1] )
-				|| ( pActor->z != pActor->SpawnPoint[2] )
-				)
-			{
-				SERVERCOMMANDS_SetThingSpawnPoint( pActor, ulClient, SVCF_ONLYTHISCLIENT );
-			}
 
-			// [BB] Since the monster movement is client side, the client needs to be
-			// informed about the momentum and the current state. If the frame is not
-			// set, the client thinks the actor is in its spawn state.
-			{
+		// Let the clients know if an object is dormant or not.
+		if ( pActor->IsActive( ) == false )
+			SERVERCOMMANDS_ThingDeactivate( pActor, NULL, ulClient, SVCF_ONLYTHISCLIENT );
 
-				if ( (pActor->InSpawnState() == false)
-					 && !(( pActor->health <= 0 ) && ( pActor->flags & MF_COUNTKILL )) // [BB] Corpses are handled later.
-					 )
-				{
-					SERVERCOMMANDS_SetThingFrame( pActor, pActor->state, ulClient, SVCF_ONLYTHISCLIENT, false );
-				}
+		// [BB] Active ActorMovers need to be synced with the client.
+		// They refer to actors that may not have been sent yet, so this is done at the end.
+		if ( pActor->IsKindOf( PClass::FindClass( "ActorMover" ) ) && pActor->IsActive( ) )
+			SERVER_GetClient( ulClient )->FullUpdate.MoverHandles.Push( ACTOR_GetNetIDHandle( pActor ));
 
-				// [WS/BB] Always inform client of the actor's lastX/Y/Z.
-				ULONG ulBits = CM_LAST_X|CM_LAST_Y|CM_LAST_Z;
+		// Update the water level of the actor, but not if it's a player!
+		if (( pActor->waterlevel > 0 ) && ( pActor->player == NULL ))
+			SERVERCOMMANDS_SetThingWaterLevel( pActor, ulClient, SVCF_ONLYTHISCLIENT );
 
-				if ( pActor->momx != 0 )
-					ulBits |= CM_MOMX;
+		// [WS] Update the actor's properties if they changed.
+		SERVER_UpdateActorProperties( pActor, ulClient );
 
-				if ( pActor->momy != 0 )
-					ulBits |= CM_MOMY;
+		// If any of this actor's flags have changed during the course of the level, notify
+		// the client.
+		// [BB] InterpolationPoint abuses the MF_AMBUSH flag, so we have to exclude this class here.
+		if ( pActor->IsKindOf( PClass::FindClass( "InterpolationPoint" ) ) == false )
+			SERVERCOMMANDS_UpdateThingFlagsNotAtDefaults( pActor, ulClient, SVCF_ONLYTHISCLIENT );
 
-				if ( pActor->momz != 0 )
-					ulBits |= CM_MOMZ;
+		// [BB] Now that the ammo amount from weapon pickups is handled on the server
+		// this shouldn't be necessary anymore. Remove after thorough testing.
+		// If this is a weapon, tell the client how much ammo it gives.
+		//if ( pActor->IsKindOf( RUNTIME_CLASS( AWeapon )))
+		//	SERVERCOMMANDS_SetWeaponAmmoGive( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+	}
 
-				if ( pActor->movedir != 0 )
-					ulBits |= CM_MOVEDIR;
+	// Check and see if it's important that the client know the angle of the object.
+	if ( pActor->angle != 0 )
+		SERVERCOMMANDS_SetThingAngle( pActor, ulClient, SVCF_ONLYTHISCLIENT );
 
-				if ( ulBits != 0 )
-					SERVERCOMMANDS_MoveThingExact( pActor, ulBits, ulClient, SVCF_ONLYTHISCLIENT );
-			}
+	// Spawned monster is a corpse.
+	if (( pActor->health <= 0 ) && ( pActor->flags & MF_COUNTKILL ))
+	{
+		SERVERCOMMANDS_ThingIsCorpse( pActor, ulClient, SVCF_ONLYTHISCLIENT );
 
-			// If it's important to update this thing's arguments, do that now.
-			// [BB] Wouldn't it be better, if this is done for all things, for which
-			// at least one of the arguments is not equal to zero?
-			// [BC] It's not necessarily important for clients to know this, such
-			// as with invasion spawners. You can do it if you want, though! It would
-			// probably save headache later on.
-			//if ( pActor->ulNetworkFlags & NETFL_UPDATEARGUMENTS )
-			// [BB] I don't want to export NETFL_UPDATEARGUMENTS to DECORATE, so we have
-			// to tell the clients all the arguments.
-			if ( ( pActor->args[0] != 0 )
-				|| ( pActor->args[1] != 0 )
-				|| ( pActor->args[2] != 0 )
-				|| ( pActor->args[3] != 0 )
-				|| ( pActor->args[4] != 0 ) )
-				SERVERCOMMANDS_SetThingArguments( pActor, ulClient, SVCF_ONLYTHISCLIENT );
-
-			// [BB] Clients need to know the SectorAction specials to predict them.
-			// [EP] Spectators need to know the allowed specials to use them.
-			if ( ( NETWORK_IsClientPredictedSpecial ( pActor->special ) || GAMEMODE_IsSpectatorAllowedSpecial ( pActor->special ) )
-				&& pActor->IsKindOf( PClass::FindClass( "SectorAction" ) ) )
-				SERVERCOMMANDS_SetThingSpecial ( pActor, ulClient, SVCF_ONLYTHISCLIENT );
-
-			// [BB] Some things like AMovingCamera rely on the AActor tid.
-			// So tell it to the client. I have no idea if this has unwanted side
-			// effects. Has to be checked.
-			if ( pActor->tid != 0 )
-				SERVERCOMMANDS_SetThingTID( pActor, ulClient, SVCF_ONLYTHISCLIENT );
-
-			// If this thing's translation has been altered, tell the client.
-			if ( pActor->Translation != 0 )
-				SERVERCOMMANDS_SetThingTranslation( pActor, ulClient, SVCF_ONLYTHISCLIENT );
-
-			// This item has been picked up, and is in its hidden, respawn state. Let
-			// the client know that.
-			if (( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HideDoomish") ) ||	// S_HIDEDOOMISH
-				( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HideSpecial") ) ||	// S_HIDESPECIAL
-				( pActor->state == RUNTIME_CLASS ( AInventory )->ActorInfo->FindState("HideIndefinitely") ))
-			{
-				SERVERCOMMANDS_HideThing( pActor, ulClient, SVCF_ONLYTHISCLIENT );
-			}
+		// [Dusk/BB] Actor is not normally dead, let clients know the proper frame.
+		if ( pActor->InState (pActor->FindState (NAME_Death)) == false )
+			SERVERCOMMANDS_SetThingFrame( pActor, pActor->state, ulClient, SVCF_ONLYTHISCLIENT, false );
+	}
+}
 
-			// Let the clients know if an object is dormant or not.
-			if ( pActor->IsActive( ) == false )
-				SERVERCOMMANDS_ThingDeactivate( pActor, NULL, ulClient, SVCF_ONLYTHISCLIENT );
+//*****************************************************************************
+//
+static void server_ContinueFullUpdate( ULONG ulClient )
+{
+	AActor				*pActor;
+	CLIENT_s			*pClient = SERVER_GetClient( ulClient );
+	FULLUPDATESTREAM_s	*pStream = &pClient->FullUpdate;
+	const ULONG			ulStartBytes = server_GetReliableBytesWritten( ulClient );
 
-			// [BB] Active ActorMovers need to be synced with the client.
-			if ( pActor->IsKindOf( PClass::FindClass( "ActorMover" ) ) && pActor->IsActive( ) )
-			{
-				static_cast<APathFollower *> ( pActor )->SyncWithClient ( ulClient );
-				SERVERCOMMANDS_ThingActivate( pActor, NULL, ulClient, SVCF_ONLYTHISCLIENT );
-			}
+	while ( pStream->ulNextActor < pStream->ActorHandles.Size( ))
+	{
+		// Stop once this tic's budget is used up. At least one actor is sent per tic.
+		if (( sv_fullupdatebudget > 0 ) && (( server_GetReliableBytesWritten( ulClient ) - ulStartBytes ) >= static_cast<ULONG>( sv_fullupdatebudget )))
+			break;
 
-			// Update the water level of the actor, but not if it's a player!
-			if (( pActor->waterlevel > 0 ) && ( pActor->player == NULL ))
-				SERVERCOMMANDS_SetThingWaterLevel( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+		// The actor may have been destroyed, picked up or the like since the full update
+		// started. Since its current state is sent, the client doesn't need anything else.
+		pActor = ACTOR_FindThingByNetIDHandle( pStream->ActorHandles[pStream->ulNextActor++] );
+		if (( pActor == NULL ) || ( server_IsActorPartOfFullUpdate( pActor ) == false ))
+			continue;
 
-			// [WS] Update the actor's properties if they changed.
-			SERVER_UpdateActorProperties( pActor, ulClient );
+		server_SendFullUpdateActor( ulClient, pActor );
+		pStream->ulActorsSent++;
+	}
 
-			// If any of this actor's flags have changed during the course of the level, notify
-			// the client.
-			// [BB] InterpolationPoint abuses the MF_AMBUSH flag, so we have to exclude this class here.
-			if ( pActor->IsKindOf( PClass::FindClass( "InterpolationPoint" ) ) == false )
-				SERVERCOMMANDS_UpdateThingFlagsNotAtDefaults( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+	pStream->ulBytesSent += server_GetReliableBytesWritten( ulClient ) - ulStartBytes;
 
-			// [BB] Now that the ammo amount from weapon pickups is handled on the server
-			// this shouldn't be necessary anymore. Remove after thorough testing.
-			// If this is a weapon, tell the client how much ammo it gives.
-			//if ( pActor->IsKindOf( RUNTIME_CLASS( AWeapon )))
-			//	SERVERCOMMANDS_SetWeaponAmmoGive( pActor, ulClient, SVCF_ONLYTHISCLIENT );
-		}
+	if ( pStream->ulNextActor >= pStream->ActorHandles.Size( ))
+		server_FinishFullUpdate( ulClient );
+}
 
-		// Check and see if it's important that the client know the angle of the object.
-		if ( pActor->angle != 0 )
-			SERVERCOMMANDS_SetThingAngle( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+//*****************************************************************************
+//
+static void server_FinishFullUpdate( ULONG ulClient )
+{
+	AActor				*pActor;
+	ULONG				ulIdx;
+	CLIENT_s			*pClient = SERVER_GetClient( ulClient );
+	FULLUPDATESTREAM_s	*pStream = &pClient->FullUpdate;
+	const ULONG			ulStartBytes = server_GetReliableBytesWritten( ulClient );
 
-		// Spawned monster is a corpse.
-		if (( pActor->health <= 0 ) && ( pActor->flags & MF_COUNTKILL ))
-		{
-			SERVERCOMMANDS_ThingIsCorpse( pActor, ulClient, SVCF_ONLYTHISCLIENT );
+	// The client knows all actors now, so the active ActorMovers can be synced.
+	for ( ulIdx = 0; ulIdx < pStream->MoverHandles.Size( ); ulIdx++ )
+	{
+		pActor = ACTOR_FindThingByNetIDHandle( pStream->MoverHandles[ulIdx] );
+		if (( pActor == NULL ) || ( pActor->IsActive( ) == false ))
+			continue;
 
-			// [Dusk/BB] Actor is not normally dead, let clients know the proper frame.
-			if ( pActor->InState (pActor->FindState (NAME_Death)) == false )
-				SERVERCOMMANDS_SetThingFrame( pActor, pActor->state, ulClient, SVCF_ONLYTHISCLIENT, false );
-		}
+		static_cast<APathFollower *> ( pActor )->SyncWithClient ( ulClient );
+		SERVERCOMMANDS_ThingActivate( pActor, NULL, ulClient, SVCF_ONLYTHISCLIENT );
 	}
 
 	// Tell clients the found/total item count.
@@ -2661,15 +3227,6 @@ void SERVER_SendFullUpdate( ULONG ulClient )
 	// Also let the client know about any cameras set to textures.
 	FCanvasTextureInfo::UpdateToClient( ulClient );
 
-	// Send out any translations that have been edited since the start of the level.
-	for ( ulIdx = 0; ulIdx < g_EditedTranslationList.Size( ); ulIdx++ )
-	{
-		if ( g_EditedTranslationList[ulIdx].ulType == DLevelScript::PCD_TRANSLATIONRANGE1 )
-			SERVERCOMMANDS_CreateTranslation( g_EditedTranslationList[ulIdx].ulIdx, g_EditedTranslationList[ulIdx].ulStart, g_EditedTranslationList[ulIdx].ulEnd, g_EditedTranslationList[ulIdx].ulPal1, g_EditedTranslationList[ulIdx].ulPal2 );
-		else
-			SERVERCOMMANDS_CreateTranslation( g_EditedTranslationList[ulIdx].ulIdx, g_EditedTranslationList[ulIdx].ulStart, g_EditedTranslationList[ulIdx].ulEnd, g_EditedTranslationList[ulIdx].ulR1, g_EditedTranslationList[ulIdx].ulG1, g_EditedTranslationList[ulIdx].ulB1, g_EditedTranslationList[ulIdx].ulR2, g_EditedTranslationList[ulIdx].ulG2, g_EditedTranslationList[ulIdx].ulB2 );
-	}
-
 	// [BB] If the sky differs from the standard sky, let the client know about it.
 	if ( level.info 
 	     && ( ( stricmp( level.skypic1, level.info->skypic1 ) != 0 )
@@ -2681,8 +3238,120 @@ void SERVER_SendFullUpdate( ULONG ulClient )
 
 	// [BB] Let the client know that the full update is completed.
 	SERVERCOMMANDS_FullUpdateCompleted( ulClient );
-	// [BB] The client will let us know that it received the update.
-	SERVER_GetClient ( ulClient )->bFullUpdateIncomplete = true;
+
+	pStream->ulBytesSent += server_GetReliableBytesWritten( ulClient ) - ulStartBytes;
+
+	const ULONG	ulTics = gametic - pStream->lStartGametic;
+
+	g_ulFullUpdatesCompleted++;
+	g_qwFullUpdateTotalBytes += pStream->ulBytesSent;
+	g_ulFullUpdateMaxBytes = MAX( g_ulFullUpdateMaxBytes, pStream->ulBytesSent );
+	g_ulFullUpdateTotalTics += ulTics;
+	g_ulFullUpdateMaxTics = MAX( g_ulFullUpdateMaxTics, ulTics );
+
+	const bool	bRunEnterScripts = pStream->bRunEnterScripts;
+	const bool	bEndSnapshot = pStream->bEndSnapshot;
+
+	server_ClearFullUpdate( ulClient );
+
+	// Finish what the connection of the client had to postpone.
+	if ( bRunEnterScripts && pClient->bRunEnterScripts )
+	{
+		FBehavior::StaticStartTypedScripts( SCRIPT_Enter, players[ulClient].mo, true );
+		pClient->bRunEnterScripts = false;
+	}
+
+	if ( bEndSnapshot )
+		SERVERCOMMANDS_EndSnapshot( ulClient );
+}
+
+//*****************************************************************************
+//
+static void server_AbortFullUpdate( ULONG ulClient )
+{
+	if ( SERVER_GetClient( ulClient )->FullUpdate.bActive == false )
+		return;
+
+	g_ulFullUpdatesAborted++;
+	server_ClearFullUpdate( ulClient );
+}
+
+//*****************************************************************************
+//
+static void server_ClearFullUpdate( ULONG ulClient )
+{
+	FULLUPDATESTREAM_s	*pStream = &SERVER_GetClient( ulClient )->FullUpdate;
+
+	pStream->bActive = false;
+	pStream->ActorHandles.Clear( );
+	pStream->ulNextActor = 0;
+	pStream->MoverHandles.Clear( );
+	pStream->bRunEnterScripts = false;
+	pStream->bEndSnapshot = false;
+}
+
+//*****************************************************************************
+//
+static void server_AdvanceFullUpdates( void )
+{
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+	{
+		if ( g_aClients[ulIdx].FullUpdate.bActive == false )
+			continue;
+
+		// The client left or has to load a new map, so the actors we still wanted to send are gone.
+		if (( SERVER_IsValidClient( ulIdx ) == false ) || ( g_aClients[ulIdx].State != CLS_SPAWNED ))
+		{
+			server_AbortFullUpdate( ulIdx );
+			continue;
+		}
+
+		server_ContinueFullUpdate( ulIdx );
+	}
+}
+
+//*****************************************************************************
+//
+void SERVER_ResetMoveSnapshots( ULONG ulClient )
+{
+	CLIENT_s	*pClient = SERVER_GetClient( ulClient );
+
+	if ( pClient == NULL )
+		return;
+
+	// Don't use anything the client acknowledged so far as base for a delta.
+	pClient->lAckedMoveSnapshot = -1;
+	pClient->ulFirstAckableMoveSnapshot = pClient->ulMoveSnapshot + 1;
+
+	for ( ULONG ulIdx = 0; ulIdx < MOVESNAPSHOT_BACKUP; ulIdx++ )
+	{
+		for ( ULONG ulPlayer = 0; ulPlayer < MAXPLAYERS; ulPlayer++ )
+			pClient->MoveSnapshots[ulIdx][ulPlayer].bValid = false;
+	}
+}
+
+//*****************************************************************************
+//
+void SERVER_BeginMoveSnapshot( ULONG ulClient )
+{
+	CLIENT_s	*pClient = SERVER_GetClient( ulClient );
+
+	if ( pClient == NULL )
+		return;
+
+	pClient->ulMoveSnapshot++;
+
+	// The client only knows the base snapshot as long as it's in its backup.
+	if (( pClient->lAckedMoveSnapshot != -1 ) &&
+		(( pClient->ulMoveSnapshot - static_cast<ULONG>( pClient->lAckedMoveSnapshot )) >= MOVESNAPSHOT_BACKUP ))
+	{
+		pClient->lAckedMoveSnapshot = -1;
+	}
+
+	// Forget what we sent with the snapshot that used this slot before.
+	MOVESNAPSHOTPLAYER_s *pSnapshot = pClient->MoveSnapshots[pClient->ulMoveSnapshot % MOVESNAPSHOT_BACKUP];
+	for ( ULONG ulPlayer = 0; ulPlayer < MAXPLAYERS; ulPlayer++ )
+		pSnapshot[ulPlayer].bValid = false;
 }
 
 //*****************************************************************************
@@ -2692,6 +3361,12 @@ void SERVER_WriteCommands( void )
 	// Ping clients and stuff.
 	SERVER_SendHeartBeat( );
 
+	// Resync actors whose position updates some clients skipped.
+	SERVER_RELEVANCE_Tick( );
+
+	// Send the next part of the full updates that are still in progress.
+	server_AdvanceFullUpdates( );
+
 	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ++ulIdx )
 	{
 		// [BB] Only clients need to be informed about player movement.
@@ -2723,6 +3398,9 @@ void SERVER_WriteCommands( void )
 			SERVERCOMMANDS_UpdatePlayerExtraData( ulIdx, g_aClients[ulIdx].ulDisplayPlayer );
 		}
 
+		if ( sv_deltamoveplayer )
+			SERVER_BeginMoveSnapshot( ulIdx );
+
 		// See if any players need to be updated to clients.
 		for ( ULONG ulPlayer = 0; ulPlayer < MAXPLAYERS; ulPlayer++ )
 		{
@@ -2915,6 +3593,8 @@ void SERVER_DisconnectClient( ULONG ulClient, bool bBroadcast, bool bSaveInfo )
 	memset( &g_aClients[ulClient].Address, 0, sizeof( g_aClients[ulClient].Address ));
 	g_aClients[ulClient].State = CLS_FREE;
 	g_aClients[ulClient].ulLastGameTic = 0;
+	server_RebuildClientAddressIndex( );
+	SERVER_MASTER_InvalidateServerInfoCache( );
 	playeringame[ulClient] = false;
 
 	// Run the disconnect scripts now that the player is leaving.
@@ -2933,7 +3613,11 @@ void SERVER_DisconnectClient( ULONG ulClient, bool bBroadcast, bool bSaveInfo )
 	// Clear the client's buffers.
 	NETWORK_ClearBuffer( &g_aClients[ulClient].PacketBuffer );
 	NETWORK_ClearBuffer( &g_aClients[ulClient].UnreliablePacketBuffer );
-	NETWORK_ClearBuffer( &g_aClients[ulClient].SavedPacketBuffer );
+	server_ResetReliableChannel( ulClient );
+	server_ClearBufferedCommands( ulClient );
+
+	// There is no one left to send the rest of the full update to.
+	server_AbortFullUpdate( ulClient );
 
 	// Tell the join queue module that a player has left the game.
 	if ( PLAYER_IsTrueSpectator( &players[ulClient] ) == false )
@@ -3046,23 +3730,24 @@ void STACK_ARGS SERVER_PrintfPlayer( ULONG ulPrintLevel, ULONG ulPlayer, const c
 void SERVER_UpdateSectors( ULONG ulClient )
 {
 	ULONG							ulIdx;
+	ULONG							ulSector;
 	sector_t						*pSector;
 	FPolyObj						*pPoly;
-	TThinkerIterator<DPolyAction>	PolyActionIterator;
+	TThinkerClassIterator<DPolyAction>	PolyActionIterator;
 	DPolyAction						*pPolyAction;
-	TThinkerIterator<DFireFlicker>	FireFlickerIterator;
+	TThinkerIterator<DFireFlicker>	FireFlickerIterator( STAT_LIGHT );
 	DFireFlicker					*pFireFlicker;
-	TThinkerIterator<DFlicker>		FlickerIterator;
+	TThinkerIterator<DFlicker>		FlickerIterator( STAT_LIGHT );
 	DFlicker						*pFlicker;
-	TThinkerIterator<DLightFlash>	LightFlashIterator;
+	TThinkerIterator<DLightFlash>	LightFlashIterator( STAT_LIGHT );
 	DLightFlash						*pLightFlash;
-	TThinkerIterator<DStrobe>		StrobeIterator;
+	TThinkerIterator<DStrobe>		StrobeIterator( STAT_LIGHT );
 	DStrobe							*pStrobe;
-	TThinkerIterator<DGlow>			GlowIterator;
+	TThinkerIterator<DGlow>			GlowIterator( STAT_LIGHT );
 	DGlow							*pGlow;
-	TThinkerIterator<DGlow2>		Glow2Iterator;
+	TThinkerIterator<DGlow2>		Glow2Iterator( STAT_LIGHT );
 	DGlow2							*pGlow2;
-	TThinkerIterator<DPhased>		PhasedIterator;
+	TThinkerIterator<DPhased>		PhasedIterator( STAT_LIGHT );
 	DPhased							*pPhased;
 
 	if ( SERVER_IsValidClient( ulClient ) == false )
@@ -3072,8 +3757,11 @@ void SERVER_UpdateSectors( ULONG ulClient )
 	for ( ulIdx = 0; ulIdx < g_SectorLinkList.Size( ); ++ulIdx )
 		SERVERCOMMANDS_SetSectorLink( g_SectorLinkList[ulIdx].ulSector, g_SectorLinkList[ulIdx].iArg1, g_SectorLinkList[ulIdx].iArg2, g_SectorLinkList[ulIdx].iArg3, ulClient, SVCF_ONLYTHISCLIENT );
 
-	for ( ulIdx = 0; static_cast<signed> (ulIdx) < numsectors; ulIdx++ )
+	// Only the sectors that were touched since the level was loaded can differ from what the client loaded itself.
+	const TArray<ULONG> &ChangedSectors = SERVER_LEVELCHANGES_GetSectors( );
+	for ( ulSector = 0; ulSector < ChangedSectors.Size( ); ulSector++ )
 	{
+		ulIdx = ChangedSectors[ulSector];
 		pSector = &sectors[ulIdx];
 
 		// Check and see if flats need to be updated.
@@ -3208,14 +3896,14 @@ void SERVER_UpdateMovers( ULONG ulClient )
 	DPillar								*pPillar;
 	DCeiling							*pCeiling;
 	DScroller							*pScroller;
-	TThinkerIterator<DDoor>				DoorIterator;
-	TThinkerIterator<DPlat>				PlatIterator;
-	TThinkerIterator<DFloor>			FloorIterator;
-	TThinkerIterator<DElevator>			ElevatorIterator;
-	TThinkerIterator<DWaggleBase>		WaggleIterator;
-	TThinkerIterator<DPillar>			PillarIterator;
-	TThinkerIterator<DCeiling>			CeilingIterator;
-	TThinkerIterator<DScroller>			ScrollerIterator;
+	TThinkerClassIterator<DDoor>		DoorIterator;
+	TThinkerClassIterator<DPlat>		PlatIterator;
+	TThinkerClassIterator<DFloor>		FloorIterator;
+	TThinkerClassIterator<DElevator>	ElevatorIterator;
+	TThinkerClassIterator<DWaggleBase>	WaggleIterator;
+	TThinkerClassIterator<DPillar>		PillarIterator;
+	TThinkerClassIterator<DCeiling>		CeilingIterator;
+	TThinkerClassIterator<DScroller>	ScrollerIterator;
 
 	// Tell the client about any active doors.
 	while (( pDoor = DoorIterator.Next( )) != NULL )
@@ -3251,7 +3939,7 @@ void SERVER_UpdateMovers( ULONG ulClient )
 
 	// [BB] Tell the client about any active pusher.
 	DPusher *pPusher = NULL;
-	TThinkerIterator<DPusher> PusherIterator;
+	TThinkerClassIterator<DPusher> PusherIterator;
 	while (( pPusher = PusherIterator.Next( )) != NULL )
 		pPusher->UpdateToClient( ulClient );
 }
@@ -3260,13 +3948,17 @@ void SERVER_UpdateMovers( ULONG ulClient )
 //
 void SERVER_UpdateLines( ULONG ulClient )
 {
+	ULONG		ulIdx;
 	ULONG		ulLine;
 
 	if ( SERVER_IsValidClient( ulClient ) == false )
 		return;
 
-	for ( ulLine = 0; ulLine < (ULONG)numlines; ulLine++ )
+	const TArray<ULONG> &ChangedLines = SERVER_LEVELCHANGES_GetLines( );
+	for ( ulIdx = 0; ulIdx < ChangedLines.Size( ); ulIdx++ )
 	{
+		ulLine = ChangedLines[ulIdx];
+
 		// Have any of the textures changed?
 		if ( lines[ulLine].ulTexChangeFlags )
 			SERVERCOMMANDS_SetLineTexture( ulLine, ulClient, SVCF_ONLYTHISCLIENT );
@@ -3285,13 +3977,17 @@ void SERVER_UpdateLines( ULONG ulClient )
 //
 void SERVER_UpdateSides( ULONG ulClient )
 {
+	ULONG		ulIdx;
 	ULONG		ulSide;
 
 	if ( SERVER_IsValidClient( ulClient ) == false )
 		return;
 
-	for ( ulSide = 0; ulSide < (ULONG)numsides; ulSide++ )
+	const TArray<ULONG> &ChangedSides = SERVER_LEVELCHANGES_GetSides( );
+	for ( ulIdx = 0; ulIdx < ChangedSides.Size( ); ulIdx++ )
 	{
+		ulSide = ChangedSides[ulIdx];
+
 		// Have the side's flags changed?
 		if ( sides[ulSide].Flags != sides[ulSide].SavedFlags )
 			SERVERCOMMANDS_SetSideFlags( ulSide, ulClient, SVCF_ONLYTHISCLIENT );
@@ -4239,6 +4935,7 @@ bool SERVER_ProcessCommand( LONG lCommand, BYTESTREAM_s *pByteStream )
 	case CLC_SPECTATEINFO:
 	case CLC_CHANGEDISPLAYPLAYER:
 	case CLC_AUTHENTICATELEVEL:
+	case CLC_ACKMOVESNAPSHOT:
 		break;
 	default:
 		g_aClients[g_lCurrentClient].lLastActionTic = gametic;
@@ -4443,6 +5140,10 @@ bool SERVER_ProcessCommand( LONG lCommand, BYTESTREAM_s *pByteStream )
 
 		// [Dusk]
 		return ( server_Linetarget( pByteStream ));
+	case CLC_ACKMOVESNAPSHOT:
+
+		// The client received a move snapshot (or failed to decode a delta).
+		return ( server_AckMoveSnapshot( pByteStream ));
 	default:
 
 		Printf( PRINT_HIGH, "SERVER_ParseCommands: Unknown client message: %d\n", static_cast<int> (lCommand) );
@@ -4581,17 +5282,112 @@ void SERVER_UpdateThingMomentum( AActor *pActor, bool updateZ, bool updateXY )
 template <typename CommandType>
 static bool server_ParseBufferedCommand ( BYTESTREAM_s *pByteStream )
 {
-	CommandType *cmd = new CommandType ( pByteStream );
+	// Every command has to fit into a slot of the command buffer. This doesn't compile otherwise.
+	(void)sizeof( char[( sizeof( CommandType ) <= BUFFERED_COMMAND_SIZE ) ? 1 : -1] );
 
 	if ( sv_useticbuffer )
 	{
-		g_aClients[g_lCurrentClient].MoveCMDs.Push ( cmd );
+		CLIENT_s	*pClient = &g_aClients[g_lCurrentClient];
+
+		// Executing the dropped command may have kicked the client.
+		if (( pClient->ulNumBufferedCommands == MAX_BUFFERED_COMMANDS ) &&
+			server_DropOldestBufferedCommand( g_lCurrentClient ))
+		{
+			return true;
+		}
+
+		BUFFEREDCOMMAND_s	*pSlot = &pClient->BufferedCommands[( pClient->ulFirstBufferedCommand + pClient->ulNumBufferedCommands ) % MAX_BUFFERED_COMMANDS];
+
+		pSlot->pCommand = new ( pSlot->Storage.abData ) CommandType ( pByteStream );
+		pClient->ulNumBufferedCommands++;
+		pClient->ulMaxBufferedCommands = MAX( pClient->ulMaxBufferedCommands, pClient->ulNumBufferedCommands );
 		return false;
 	}
 
-	const bool retValue = cmd->process ( g_lCurrentClient );
-	delete cmd;
-	return retValue;
+	const CommandType cmd ( pByteStream );
+	return cmd.process ( g_lCurrentClient );
+}
+
+//*****************************************************************************
+//
+static void server_ProcessBufferedCommands( ULONG ulClient )
+{
+	CLIENT_s	*pClient = &g_aClients[ulClient];
+	ULONG		ulNumMoveCmds = 0;
+
+	// [BB] Process up to two movement commands.
+	while (( pClient->ulNumBufferedCommands > 0 ) && ( ulNumMoveCmds < 2 ))
+	{
+		ClientCommand	*pCommand = pClient->BufferedCommands[pClient->ulFirstBufferedCommand].pCommand;
+
+		pClient->BufferedCommands[pClient->ulFirstBufferedCommand].pCommand = NULL;
+		pClient->ulFirstBufferedCommand = ( pClient->ulFirstBufferedCommand + 1 ) % MAX_BUFFERED_COMMANDS;
+		pClient->ulNumBufferedCommands--;
+
+		// [BB] Only limit the amount of movement commands.
+		if ( pCommand->isMoveCmd( ))
+			ulNumMoveCmds++;
+
+		const bool bKicked = pCommand->process( ulClient );
+		pCommand->~ClientCommand( );
+
+		// Kicking the client got rid of the remaining commands.
+		if ( bKicked )
+			break;
+	}
+}
+
+//*****************************************************************************
+//
+// Makes room for a new command when the buffer is full. An old movement command is
+// simply dropped, the client sent more of them than we can execute anyway. Weapon
+// selections must not be lost though, so they are executed right away. Returns true
+// if executing the command kicked the client.
+static bool server_DropOldestBufferedCommand( ULONG ulClient )
+{
+	CLIENT_s	*pClient = &g_aClients[ulClient];
+	bool		bKicked = false;
+
+	if ( pClient->ulNumBufferedCommands == 0 )
+		return ( false );
+
+	ClientCommand	*pCommand = pClient->BufferedCommands[pClient->ulFirstBufferedCommand].pCommand;
+
+	pClient->BufferedCommands[pClient->ulFirstBufferedCommand].pCommand = NULL;
+	pClient->ulFirstBufferedCommand = ( pClient->ulFirstBufferedCommand + 1 ) % MAX_BUFFERED_COMMANDS;
+	pClient->ulNumBufferedCommands--;
+
+	if ( pCommand->isMoveCmd( ))
+	{
+		pClient->ulNumDroppedCommands++;
+		pClient->lOverMovementLevel++;
+	}
+	else
+		bKicked = pCommand->process( ulClient );
+
+	pCommand->~ClientCommand( );
+	return ( bKicked );
+}
+
+//*****************************************************************************
+//
+static void server_ClearBufferedCommands( ULONG ulClient )
+{
+	CLIENT_s	*pClient = &g_aClients[ulClient];
+
+	while ( pClient->ulNumBufferedCommands > 0 )
+	{
+		BUFFEREDCOMMAND_s	*pSlot = &pClient->BufferedCommands[pClient->ulFirstBufferedCommand];
+
+		pSlot->pCommand->~ClientCommand( );
+		pSlot->pCommand = NULL;
+		pClient->ulFirstBufferedCommand = ( pClient->ulFirstBufferedCommand + 1 ) % MAX_BUFFERED_COMMANDS;
+		pClient->ulNumBufferedCommands--;
+	}
+
+	pClient->ulFirstBufferedCommand = 0;
+	pClient->ulMaxBufferedCommands = 0;
+	pClient->ulNumDroppedCommands = 0;
 }
 
 //*****************************************************************************
@@ -5056,22 +5852,18 @@ bool ClientMoveCommand::process( const ULONG ulClient ) const
 //
 static bool server_MissingPacket( BYTESTREAM_s *pByteStream )
 {
-	ULONG	ulIdx;
-	LONG	lPacket;
-	LONG	lLastPacket;
-	bool	bFullUpdateRequired;
+	CLIENT_s		*pClient = &g_aClients[g_lCurrentClient];
+	SAVEDPACKET_s	*pSaved;
+	LONG			lPacket;
+	LONG			lLastPacket;
+	bool			bNewLoss;
 
-	// If this client just requested missing packets, ignore the request.
-	if ( gametic <= ( g_aClients[g_lCurrentClient].lLastPacketLossTick + ( TICRATE / 4 )))
-	{
-		while ( NETWORK_ReadLong( pByteStream ) != -1 )
-			;
-
-		return ( false );
-	}
+	const ULONG		ulNow = I_MSTime( );
+	const ULONG		ulTimeout = UNLAGGED_GetRetransmitTimeout( &players[g_lCurrentClient] );
 
 	// Keep reading in packets until we hit -1.
 	lLastPacket = -1;
+	bNewLoss = false;
 	while (( lPacket = NETWORK_ReadLong( pByteStream )) != -1 )
 	{
 		// The missing packet sequence must be sent to us in ascending order. If it's not,
@@ -5086,47 +5878,54 @@ static bool server_MissingPacket( BYTESTREAM_s *pByteStream )
 		}
 		lLastPacket = lPacket;
 
-		// Search through all PACKET_BUFFER_SIZE of the stored packets. We're looking for the packet that
-		// that we want to send to the client by matching the sequences. If we cannot find
-		// the packet, then we much send a full update to the client.
-		bFullUpdateRequired = true;
-		for ( ulIdx = 0; ulIdx < PACKET_BUFFER_SIZE; ulIdx++ )
+		// If we don't have the packet anymore, the client can't recover from this.
+		pSaved = &pClient->SavedPackets[lPacket % PACKET_BUFFER_SIZE];
+		if ( pSaved->lSequence != lPacket )
 		{
-			if ( g_aClients[g_lCurrentClient].lPacketSequence[ulIdx] == lPacket )
-			{
-				bFullUpdateRequired = false;
-				break;
-			}
-		}
+			while ( NETWORK_ReadLong( pByteStream ) != -1 )
+				;
 
-		// We could not find the correct packet to resend to the client. We must send him
-		// a full update.
-		if  ( bFullUpdateRequired )
-		{
-			// Do we really need to print this? Nah.
-//			Printf( "*** Sequence screwed for client %d, %s!\n", g_lCurrentClient, players[g_lCurrentClient].userinfo.netname );
 			SERVER_KickPlayer( g_lCurrentClient, "Too many missed packets." );
 			return ( true );
 		}
 
-		// Now that we've found the missed packet that we need to send to the client,
-		// send it.
-		NETWORK_ClearBuffer( &g_PacketLossBuffer );
-		NETWORK_WriteHeader( &g_PacketLossBuffer.ByteStream, SVC_HEADER );
-		NETWORK_WriteLong( &g_PacketLossBuffer.ByteStream, lPacket );
-		if ( g_aClients[g_lCurrentClient].lPacketSize[ulIdx] )
+		// The packet is still waiting for the resend window, queuing it again would only
+		// send it twice.
+		if ( pSaved->bQueued )
+		{
+			g_qwResendRequestsIgnored++;
+			continue;
+		}
+
+		// The first report of a loss is answered right away. If we already resent the packet
+		// and its round trip time hasn't passed yet, the copy is probably still on its way.
+		if ( pSaved->ulNumResends > 0 )
 		{
-			NETWORK_WriteBuffer( &g_PacketLossBuffer.ByteStream,
-				g_aClients[g_lCurrentClient].SavedPacketBuffer.pbData + g_aClients[g_lCurrentClient].lPacketBeginning[ulIdx],
-				g_aClients[g_lCurrentClient].lPacketSize[ulIdx] );
+			if ( ulNow - pSaved->ulLastSendTime < ulTimeout )
+			{
+				g_qwResendRequestsIgnored++;
+				continue;
+			}
 		}
-//		else
-//			Printf( "server_MissingPacket: WARNING! Packet %d has no size!\n", ulIdx );
-		NETWORK_LaunchPacket( &g_PacketLossBuffer, g_aClients[g_lCurrentClient].Address );
+		else
+			bNewLoss = true;
+
+		// Consider it sent already, so that the next request doesn't queue it again.
+		pSaved->ulLastSendTime = ulNow;
+		pSaved->ulNumResends++;
+		pSaved->bQueued = true;
+		pClient->ResendQueue.Push( lPacket );
 	}
 
-	// Mark this client as having requested missing packets.
-	g_aClients[g_lCurrentClient].lLastPacketLossTick = gametic;
+	// Every new loss means that we're sending faster than the link can handle. Shrink
+	// the resend window, but at most once per round trip.
+	if ( bNewLoss )
+	{
+		if (( gametic - pClient->lLastPacketLossTick ) * 1000 >= static_cast<LONG>( ulTimeout * TICRATE ))
+			pClient->ulResendWindow = MAX<ULONG>( pClient->ulResendWindow / 2, SERVER_GetMaxPacketSize( ));
+
+		pClient->lLastPacketLossTick = gametic;
+	}
 
 	return ( false );
 }
@@ -5163,6 +5962,9 @@ static bool server_UpdateClientPing( BYTESTREAM_s *pByteStream )
 			p->ulPingAverages++;
 	}
 
+	// The unlagged code keeps its own, finer estimate.
+	UNLAGGED_UpdateLatency( p, currentPing );
+
 	return ( false );
 }
 
@@ -6036,8 +6838,11 @@ static bool server_AuthenticateLevel( BYTESTREAM_s *pByteStream )
 	// [BB] Clear the weapon on the server. It will be brought up when the client tells us.
 	PLAYER_ClearWeapon( &players[g_lCurrentClient] );
 
-	// If we need to start this client's enter scripts, do that now.
-	if ( g_aClients[g_lCurrentClient].bRunEnterScripts )
+	// If we need to start this client's enter scripts, do that now. The scripts may
+	// refer to any actor, so wait for the full update to arrive.
+	if ( g_aClients[g_lCurrentClient].FullUpdate.bActive )
+		g_aClients[g_lCurrentClient].FullUpdate.bRunEnterScripts = true;
+	else if ( g_aClients[g_lCurrentClient].bRunEnterScripts )
 	{
 		FBehavior::StaticStartTypedScripts( SCRIPT_Enter, players[g_lCurrentClient].mo, true );
 		g_aClients[g_lCurrentClient].bRunEnterScripts = false;
@@ -6349,6 +7154,38 @@ static bool server_Linetarget( BYTESTREAM_s *pByteStream )
 	return false;
 }
 
+//*****************************************************************************
+//
+static bool server_AckMoveSnapshot( BYTESTREAM_s *pByteStream )
+{
+	CLIENT_s	*pClient = SERVER_GetClient( g_lCurrentClient );
+	const ULONG	ulSequence = NETWORK_ReadByte( pByteStream );
+	const bool	bMissingBase = !!NETWORK_ReadByte( pByteStream );
+
+	// The client only sends the lowest byte of the sequence. Assume that it refers to
+	// the latest snapshot with that lowest byte.
+	const ULONG ulSnapshot = pClient->ulMoveSnapshot - (( pClient->ulMoveSnapshot - ulSequence ) & 0xFF );
+
+	// The client couldn't decode a delta. Send full states till it acknowledges
+	// a snapshot sent from now on.
+	if ( bMissingBase )
+	{
+		SERVER_ResetMoveSnapshots( g_lCurrentClient );
+		return ( false );
+	}
+
+	if (( ulSnapshot < pClient->ulFirstAckableMoveSnapshot ) ||
+		(( pClient->ulMoveSnapshot - ulSnapshot ) >= MOVESNAPSHOT_BACKUP ))
+	{
+		return ( false );
+	}
+
+	if (( pClient->lAckedMoveSnapshot == -1 ) || ( ulSnapshot > static_cast<ULONG>( pClient->lAckedMoveSnapshot )))
+		pClient->lAckedMoveSnapshot = ulSnapshot;
+
+	return ( false );
+}
+
 //*****************************************************************************
 //	CONSOLE COMMANDS
 
@@ -6529,6 +7366,119 @@ CCMD( kickfromgame )
 	return;
 }
 
+//*****************************************************************************
+//
+CCMD( serverloopstats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	Printf( "Main loop: %s\n", ( sv_eventloop && NETWORK_IsEventWaitActive( )) ? "event driven" : "polling" );
+	Printf( "Tics run: %lu\n", g_LoopStats.ulTics );
+	Printf( "Wakeups: %lu total, %lu last second (%lu by packets, %lu by the tic timer)\n", g_LoopStats.ulWakeups, g_LoopStats.ulWakeupsLastSecond, g_LoopStats.ulPacketWakeups, g_LoopStats.ulTimerWakeups );
+	Printf( "Idle: %.1f ms last second, %.1f s total\n", g_LoopStats.dIdleMSLastSecond, g_LoopStats.dTotalIdleMS / 1000.0 );
+	Printf( "Tic overruns: %lu (largest backlog %lu tics)\n", g_LoopStats.ulTicOverruns, g_LoopStats.ulMaxTicBacklog );
+	Printf( "Packets from unknown senders rejected: %lu (limit %d per second)\n", g_LoopStats.ulRejectedUnknownPackets, static_cast<int> ( sv_unknownpacketlimit ));
+}
+
+//*****************************************************************************
+//
+CCMD( fullupdatestats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	if (( argv.argc( ) > 1 ) && ( stricmp( argv[1], "reset" ) == 0 ))
+	{
+		g_ulFullUpdatesCompleted = 0;
+		g_ulFullUpdatesAborted = 0;
+		g_qwFullUpdateTotalBytes = 0;
+		g_ulFullUpdateMaxBytes = 0;
+		g_ulFullUpdateTotalTics = 0;
+		g_ulFullUpdateMaxTics = 0;
+		return;
+	}
+
+	if ( sv_fullupdatebudget > 0 )
+		Printf( "Budget: %d bytes per tic\n", static_cast<int> ( sv_fullupdatebudget ));
+	else
+		Printf( "Budget: unlimited\n" );
+
+	Printf( "Full updates: %lu completed, %lu aborted\n", g_ulFullUpdatesCompleted, g_ulFullUpdatesAborted );
+	if ( g_ulFullUpdatesCompleted > 0 )
+	{
+		Printf( "Average: %lu bytes in %.1f tics (largest %lu bytes, longest %lu tics)\n",
+			static_cast<ULONG> ( g_qwFullUpdateTotalBytes / g_ulFullUpdatesCompleted ), static_cast<double> ( g_ulFullUpdateTotalTics ) / g_ulFullUpdatesCompleted,
+			g_ulFullUpdateMaxBytes, g_ulFullUpdateMaxTics );
+	}
+
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+	{
+		const FULLUPDATESTREAM_s	*pStream = &g_aClients[ulIdx].FullUpdate;
+
+		if ( pStream->bActive == false )
+			continue;
+
+		Printf( "%s: %lu of %u actors checked, %lu sent, %lu bytes in %ld tics\n", players[ulIdx].userinfo.netname, pStream->ulNextActor,
+			pStream->ActorHandles.Size( ), pStream->ulActorsSent, pStream->ulBytesSent, static_cast<LONG> ( gametic - pStream->lStartGametic ));
+	}
+}
+
+//*****************************************************************************
+//
+CCMD( movecmdstats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+	{
+		if ( SERVER_IsValidClient( ulIdx ) == false )
+			continue;
+
+		Printf( "%s: %lu of %d commands buffered (at most %lu), %lu movement commands dropped, overmovement level %ld\n", players[ulIdx].userinfo.netname,
+			g_aClients[ulIdx].ulNumBufferedCommands, MAX_BUFFERED_COMMANDS, g_aClients[ulIdx].ulMaxBufferedCommands, g_aClients[ulIdx].ulNumDroppedCommands,
+			g_aClients[ulIdx].lOverMovementLevel );
+	}
+}
+
+//*****************************************************************************
+//
+CCMD( reliablestats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	if (( argv.argc( ) > 1 ) && ( stricmp( argv[1], "reset" ) == 0 ))
+	{
+		g_qwReliablePacketsSent = 0;
+		g_qwReliablePacketsResent = 0;
+		g_qwReliableBytesSent = 0;
+		g_qwReliableBytesResent = 0;
+		g_qwResendRequestsIgnored = 0;
+		return;
+	}
+
+	Printf( "Reliable packets: %llu sent, %llu resent, %llu resend requests ignored\n", static_cast<unsigned long long>( g_qwReliablePacketsSent ),
+		static_cast<unsigned long long>( g_qwReliablePacketsResent ), static_cast<unsigned long long>( g_qwResendRequestsIgnored ));
+
+	// The share of the reliable traffic that was new data.
+	if ( g_qwReliableBytesSent > 0 )
+	{
+		Printf( "Reliable bytes: %llu sent, %llu resent (goodput %.1f%%)\n", static_cast<unsigned long long>( g_qwReliableBytesSent ), static_cast<unsigned long long>( g_qwReliableBytesResent ),
+			100.0 * g_qwReliableBytesSent / ( g_qwReliableBytesSent + g_qwReliableBytesResent ));
+	}
+
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+	{
+		if ( SERVER_IsValidClient( ulIdx ) == false )
+			continue;
+
+		Printf( "%s: resend window %lu bytes, %u packets waiting, timeout %d ms\n", players[ulIdx].userinfo.netname, g_aClients[ulIdx].ulResendWindow,
+			g_aClients[ulIdx].ResendQueue.Size( ), UNLAGGED_GetRetransmitTimeout( &players[ulIdx] ));
+	}
+}
+
 //*****************************************************************************
 #ifdef	_DEBUG
 CCMD( testchecksum )
@@ -56,6 +56,7 @@
 #include "i_net.h"
 #include "networkshared.h"
 #include "s_sndseq.h"
+#include "stats.h"
 #include <list>
 #include <queue>
 
@@ -80,6 +81,12 @@
 // Amount of time the client has to report his checksum of the level.
 #define	CLIENT_CHECKSUM_WAITTIME	( 15 * TICRATE )
 
+// Size of the open-addressed table that maps client addresses to client slots (a power of two, at least twice MAXPLAYERS).
+#define	CLIENT_ADDRESS_INDEX_SIZE	( 2 * MAXPLAYERS )
+
+// Number of unknown senders whose packet rate we keep track of (a power of two).
+#define	UNKNOWN_PACKET_SOURCES		1024
+
 // This is for the server console, but since we normally can't include that (win32 stuff),
 // we can just put it here.
 #define	UDF_NAME					0x00000001
@@ -89,6 +96,14 @@
 
 #define	MAX_OVERMOVEMENT_LEVEL		( 2 * TICRATE )
 
+// Size of the resend window (in packets of sv_maxpacketsize) of a new client and the most it can grow to.
+#define	RESEND_WINDOW_INITIAL		4
+#define	RESEND_WINDOW_MAX			16
+
+// Number of commands we buffer per client and the room each of them may take.
+#define	MAX_BUFFERED_COMMANDS		( 2 * TICRATE )
+#define	BUFFERED_COMMAND_SIZE		96
+
 #define	KILOBYTE					1024
 #define	MEGABYTE					( KILOBYTE * 1024 )
 #define	GIGABYTE					( MEGABYTE * 1024 )
@@ -134,7 +149,19 @@
 									  SQF_BOTSKILL|SQF_DMFLAGS|SQF_LIMITS|SQF_TEAMDAMAGE|SQF_TEAMSCORES|SQF_NUMPLAYERS|SQF_PLAYERDATA|SQF_TEAMINFO_NUMBER|SQF_TEAMINFO_NAME|SQF_TEAMINFO_COLOR|SQF_TEAMINFO_SCORE| \
 									  SQF_TESTING_SERVER|SQF_DATA_MD5SUM|SQF_ALL_DMFLAGS|SQF_SECURITY_SETTINGS )
 
-#define	MAX_STORED_QUERY_IPS		512
+// Number of launcher query replies (one per requested flag combination) that are kept for reuse.
+#define	MAX_CACHED_SERVERINFO_REPLIES	8
+
+// Maximum number of tics a cached launcher query reply is reused, even if nothing invalidated it.
+// This bounds how stale pings, frag counts and the remaining time can get.
+#define	SERVERINFO_CACHE_TICS		TICRATE
+
+// Number of token buckets that rate-limit launcher queries, indexed by a hash of the querying address (a power of two).
+#define	QUERY_TOKEN_BUCKETS			1024
+
+// Number of move snapshots the server and the client remember per client. A snapshot
+// can only be used as the base of a delta as long as it's not older than this.
+#define	MOVESNAPSHOT_BACKUP			16
 
 //*****************************************************************************
 typedef enum
@@ -163,6 +190,28 @@ typedef enum
 
 } CLIENTSTATE_e;
 
+//*****************************************************************************
+// The state of a player as a client knows it after receiving a MovePlayer update
+// that belongs to a certain snapshot.
+typedef struct
+{
+	// Was the position of this player sent with this snapshot?
+	bool			bValid;
+
+	fixed_t			X;
+	fixed_t			Y;
+	angle_t			Angle;
+
+	// Z and the momentum are sent in map units.
+	SHORT			sZ;
+	SHORT			sMomX;
+	SHORT			sMomY;
+	SHORT			sMomZ;
+
+	bool			bCrouching;
+
+} MOVESNAPSHOTPLAYER_s;
+
 //*****************************************************************************
 typedef struct
 {
@@ -174,6 +223,107 @@ typedef struct
 
 } STORED_QUERY_IP_s;
 
+//*****************************************************************************
+typedef struct
+{
+	// Is there a reply stored in this entry at all?
+	bool			bValid;
+
+	// The flags the launcher requested (already restricted to SQF_ALL).
+	ULONG			ulFlags;
+
+	// Gametic when the reply was built.
+	LONG			lBuiltGametic;
+
+	// The reply, starting with the version string (the header and the launcher's time are written per query).
+	NETBUFFER_s		Reply;
+
+} CACHEDSERVERINFO_s;
+
+//*****************************************************************************
+typedef struct
+{
+	// Address (IP and port) of the launcher this bucket currently belongs to.
+	NETADDRESS_s	Address;
+
+	// Is this bucket in use?
+	bool			bUsed;
+
+	// Accumulated credit in tics. Each query costs sv_queryignoretime seconds worth of it.
+	LONG			lCredit;
+
+	// Gametic when the credit was last refilled.
+	LONG			lLastGametic;
+
+} QUERYTOKENBUCKET_s;
+
+//*****************************************************************************
+typedef struct
+{
+	// Network ID handle of the actor.
+	ULONG			ulHandle;
+
+	// Actors with a lower value are sent first.
+	ULONG			ulPriority;
+
+} FULLUPDATEACTOR_s;
+
+//*****************************************************************************
+typedef struct
+{
+	// Is a full update currently being streamed to this client?
+	bool			bActive;
+
+	// Network ID handles of the actors the full update sends, in the order they are sent.
+	TArray<ULONG>	ActorHandles;
+
+	// Index of the next actor in ActorHandles.
+	ULONG			ulNextActor;
+
+	// Active actor movers refer to other actors, so they are synced once all actors were sent.
+	TArray<ULONG>	MoverHandles;
+
+	// Gametic the full update was started.
+	LONG			lStartGametic;
+
+	// Amount of bytes and actors sent so far.
+	ULONG			ulBytesSent;
+	ULONG			ulActorsSent;
+
+	// Steps that have to wait until the client knows all actors.
+	bool			bRunEnterScripts;
+	bool			bEndSnapshot;
+
+} FULLUPDATESTREAM_s;
+
+//*****************************************************************************
+typedef struct
+{
+	// Sequence of the packet saved in this slot, -1 if there is none or its data was overwritten.
+	LONG			lSequence;
+
+	// Position and size of the packet within SavedPacketBuffer.
+	LONG			lBeginning;
+	LONG			lSize;
+
+	// Time (in ms) we last sent this packet and how often we resent it.
+	ULONG			ulLastSendTime;
+	ULONG			ulNumResends;
+
+	// Is this packet waiting in the client's ResendQueue?
+	bool			bQueued;
+
+} SAVEDPACKET_s;
+
+//*****************************************************************************
+typedef struct
+{
+	// Position and size of the Huffman encoded packet within FinalizedData.
+	ULONG			ulOffset;
+	INT				iSize;
+
+} FINALIZEDPACKET_s;
+
 //*****************************************************************************
 struct CLIENT_MOVE_COMMAND_s
 {
@@ -195,6 +345,7 @@ class ClientCommand
 {
 public:
 	ClientCommand () {};
+	virtual ~ClientCommand () {};
 
 	virtual bool process ( const ULONG ulClient ) const = 0;
 
@@ -204,6 +355,25 @@ public:
 	}
 };
 
+//*****************************************************************************
+typedef struct
+{
+	// The command stored in this slot, NULL if there is none.
+	ClientCommand	*pCommand;
+
+	// The command is constructed right here, so buffering it doesn't allocate anything.
+	union
+	{
+		BYTE		abData[BUFFERED_COMMAND_SIZE];
+
+		// Only there to align abData for any command.
+		double		dAlign;
+		void		*pAlign;
+
+	} Storage;
+
+} BUFFEREDCOMMAND_s;
+
 //*****************************************************************************
 typedef struct
 {
@@ -223,14 +393,29 @@ typedef struct
 	// retransmit them if necessary.
 	NETBUFFER_s		SavedPacketBuffer;
 
-	// This is the position of each saved packet within SavedPacketBuffer.
-	LONG			lPacketBeginning[PACKET_BUFFER_SIZE];
+	// The saved packets, packet n is stored in slot n % PACKET_BUFFER_SIZE.
+	SAVEDPACKET_s	SavedPackets[PACKET_BUFFER_SIZE];
+
+	// Sequence of the oldest saved packet whose data may still be in SavedPacketBuffer.
+	ULONG			ulOldestSavedPacket;
 
-	// This is the packet size for each of the PACKET_BUFFER_SIZE stored packets.
-	LONG			lPacketSize[PACKET_BUFFER_SIZE];
+	// Lost packets we couldn't resend yet, because the resend window was used up.
+	TArray<LONG>	ResendQueue;
 
-	// This is the packet sequence for each of the PACKET_BUFFER_SIZE stored packets.
-	LONG			lPacketSequence[PACKET_BUFFER_SIZE];
+	// Bytes of lost packets we may resend per tic. Halved whenever the client reports new
+	// losses and slowly grown again while it doesn't.
+	ULONG			ulResendWindow;
+
+	// Packets finalized by the send workers, sent by the game thread in SERVER_SendOutPackets.
+	TArray<BYTE>				FinalizedData;
+	TArray<FINALIZEDPACKET_s>	FinalizedPackets;
+
+	// Reliable packet statistics that weren't added to the server's yet, since the send workers
+	// must not touch those.
+	ULONG			ulUncountedPacketsSent;
+	ULONG			ulUncountedBytesSent;
+	ULONG			ulUncountedPacketsResent;
+	ULONG			ulUncountedBytesResent;
 
 	// Last packet number sent to this client.
 	ULONG			ulPacketSequence;
@@ -263,6 +448,12 @@ typedef struct
 	// [BB] Did the client not yet acknowledge receiving the last full update?
 	bool			bFullUpdateIncomplete;
 
+	// The full update that is still being sent to the client.
+	FULLUPDATESTREAM_s	FullUpdate;
+
+	// Total size of all reliable packets sent to this client. Used to pace the full update.
+	ULONG			ulReliableBytesSent;
+
 	// [BB] A record of the gametics the client called protected commands, e.g. send_password.
 	RingBuffer<LONG, 6> commandInstances;
 
@@ -287,7 +478,7 @@ typedef struct
 	// doing it again.
 	ULONG			ulLastSuicideTime;
 
-	// Last tick the client requested missing packets.
+	// Last tick the client reported packets as missing that we hadn't resent yet.
 	LONG			lLastPacketLossTick;
 
 	// Last tick we received a movement command.
@@ -322,7 +513,28 @@ typedef struct
 	LONG			lLastActionTic;
 
 	// [BB] Buffer storing all movement commands received from the client we haven't executed yet.
-	TArray<ClientCommand*>	MoveCMDs;
+	// It's a ring, the oldest command is at ulFirstBufferedCommand.
+	BUFFEREDCOMMAND_s	BufferedCommands[MAX_BUFFERED_COMMANDS];
+	ULONG			ulFirstBufferedCommand;
+	ULONG			ulNumBufferedCommands;
+
+	// Most commands that were buffered at once and how many movement commands we dropped
+	// because the buffer was full.
+	ULONG			ulMaxBufferedCommands;
+	ULONG			ulNumDroppedCommands;
+
+	// Sequence number of the move snapshot that is currently being sent to this client.
+	ULONG			ulMoveSnapshot;
+
+	// Latest move snapshot the client acknowledged (-1 if there is none we can use as base).
+	LONG			lAckedMoveSnapshot;
+
+	// Acknowledgements of snapshots older than this are ignored. This is raised when the
+	// client reports that it couldn't decode a delta.
+	ULONG			ulFirstAckableMoveSnapshot;
+
+	// The player states we sent with the last MOVESNAPSHOT_BACKUP snapshots.
+	MOVESNAPSHOTPLAYER_s	MoveSnapshots[MOVESNAPSHOT_BACKUP][MAXPLAYERS];
 
 } CLIENT_s;
 
@@ -367,6 +579,45 @@ typedef struct
 
 } SECTORLINK_s;
 
+//*****************************************************************************
+typedef struct
+{
+	// How often did the main loop wake up while waiting for the next tic (and why)?
+	ULONG			ulWakeups;
+	ULONG			ulPacketWakeups;
+	ULONG			ulTimerWakeups;
+	ULONG			ulWakeupsAtSecondStart;
+	ULONG			ulWakeupsLastSecond;
+
+	// Time spent waiting for packets or the next tic.
+	cycle_t			IdleCycles;
+	double			dIdleMSLastSecond;
+	double			dTotalIdleMS;
+
+	// Number of tics run, and how many of them were late because the previous ones took too long.
+	ULONG			ulTics;
+	ULONG			ulTicOverruns;
+	ULONG			ulMaxTicBacklog;
+
+	// Packets from unknown addresses that were dropped because their sender exceeded sv_unknownpacketlimit.
+	ULONG			ulRejectedUnknownPackets;
+
+} SERVERLOOPSTATS_s;
+
+//*****************************************************************************
+typedef struct
+{
+	// Address of the sender (the port is ignored, so that a sender can't evade the limit by switching ports).
+	BYTE			abIP[4];
+
+	// The second this entry is counting packets for.
+	ULONG			ulSecond;
+
+	// Number of packets received from this sender during that second.
+	ULONG			ulNumPackets;
+
+} UNKNOWNPACKETSOURCE_s;
+
 //*****************************************************************************
 //	PROTOTYPES
 
@@ -398,6 +649,8 @@ void		SERVER_ConnectionError( NETADDRESS_s Address, const char *pszMessage, ULON
 void		SERVER_ClientError( ULONG ulClient, ULONG ulErrorCode );
 void		SERVER_SendFullUpdate( ULONG ulClient );
 void		SERVER_WriteCommands( void );
+void		SERVER_ResetMoveSnapshots( ULONG ulClient );
+void		SERVER_BeginMoveSnapshot( ULONG ulClient );
 bool		SERVER_IsValidClient( ULONG ulClient );
 void		SERVER_AdjustPlayersReactiontime( const ULONG ulPlayer );
 void		SERVER_DisconnectClient( ULONG ulClient, bool bBroadcast, bool bSaveInfo );
@@ -457,6 +710,7 @@ void		SERVER_MASTER_Destruct( void );
 void		SERVER_MASTER_Tick( void );
 void		SERVER_MASTER_Broadcast( void );
 void		SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ulTime, bool bBroadcasting );
+void		SERVER_MASTER_InvalidateServerInfoCache( void );
 const char	*SERVER_MASTER_GetGameName( void );
 NETADDRESS_s SERVER_MASTER_GetMasterAddress( void );
 void		SERVER_MASTER_HandleVerificationRequest( BYTESTREAM_s *pByteStream );
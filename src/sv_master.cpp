@@ -65,6 +65,7 @@
 #include "network.h"
 #include "sv_main.h"
 #include "sv_ban.h"
+#include "templates.h"
 #include "version.h"
 
 //--------------------------------------------------------------------------------------------------------------------------------------------------
@@ -80,17 +81,26 @@ static	NETBUFFER_s			g_MasterServerBuffer;
 // Port the master server is located on.
 static	USHORT				g_usMasterPort;
 
-// List of IP address that this server has been queried by recently.
-static	STORED_QUERY_IP_s	g_StoredQueryIPs[MAX_STORED_QUERY_IPS];
+// Token buckets limiting how often each address may query this server.
+static	QUERYTOKENBUCKET_s	g_QueryTokenBuckets[QUERY_TOKEN_BUCKETS];
 
-static	LONG				g_lStoredQueryIPHead;
-static	LONG				g_lStoredQueryIPTail;
+// Launcher query replies that can be sent again without rebuilding them.
+static	CACHEDSERVERINFO_s	g_CachedServerInfo[MAX_CACHED_SERVERINFO_REPLIES];
+
+// Statistics about the launcher query replies.
+static	ULONG				g_ulServerInfoCacheHits;
+static	ULONG				g_ulServerInfoCacheMisses;
+static	ULONG				g_ulServerInfoCacheInvalidations;
+static	ULONG				g_ulIgnoredQueries;
 
 extern	NETADDRESS_s		g_LocalAddress;
 
 //*****************************************************************************
 //	CONSOLE VARIABLES
 
+// How many queries a launcher may send in a row before sv_queryignoretime applies.
+CVAR( Int, sv_queryburst, 1, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
 //--------------------------------------------------------------------------------------------------------------------------------------------------
 //-- FUNCTIONS -------------------------------------------------------------------------------------------------------------------------------------
 //--------------------------------------------------------------------------------------------------------------------------------------------------
@@ -115,8 +125,14 @@ void SERVER_MASTER_Construct( void )
 	else 
 	   g_usMasterPort = DEFAULT_MASTER_PORT;
 
-	g_lStoredQueryIPHead = 0;
-	g_lStoredQueryIPTail = 0;
+	memset( g_QueryTokenBuckets, 0, sizeof( g_QueryTokenBuckets ));
+
+	for ( ULONG ulIdx = 0; ulIdx < MAX_CACHED_SERVERINFO_REPLIES; ulIdx++ )
+	{
+		NETWORK_InitBuffer( &g_CachedServerInfo[ulIdx].Reply, MAX_UDP_PACKET, BUFFERTYPE_WRITE );
+		NETWORK_ClearBuffer( &g_CachedServerInfo[ulIdx].Reply );
+		g_CachedServerInfo[ulIdx].bValid = false;
+	}
 
 	// Call SERVER_MASTER_Destruct() when Skulltag closes.
 	atterm( SERVER_MASTER_Destruct );
@@ -128,6 +144,9 @@ void SERVER_MASTER_Destruct( void )
 {
 	// Free our local buffer.
 	NETWORK_FreeBuffer( &g_MasterServerBuffer );
+
+	for ( ULONG ulIdx = 0; ulIdx < MAX_CACHED_SERVERINFO_REPLIES; ulIdx++ )
+		NETWORK_FreeBuffer( &g_CachedServerInfo[ulIdx].Reply );
 }
 
 //*****************************************************************************
@@ -136,12 +155,6 @@ void SERVER_MASTER_Tick( void )
 {
 	UCVarValue		Val;
 
-	while (( g_lStoredQueryIPHead != g_lStoredQueryIPTail ) && ( gametic >= g_StoredQueryIPs[g_lStoredQueryIPHead].lNextAllowedGametic ))
-	{
-		g_lStoredQueryIPHead++;
-		g_lStoredQueryIPHead = g_lStoredQueryIPHead % MAX_STORED_QUERY_IPS;
-	}
-
 	// Send an update to the master server every 30 seconds.
 	if ( gametic % ( TICRATE * 30 ))
 		return;
@@ -239,89 +252,14 @@ void SERVER_MASTER_Broadcast( void )
 
 //*****************************************************************************
 //
-void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ulTime, bool bBroadcasting )
+static void server_master_WriteServerInfo( BYTESTREAM_s *pByteStream, ULONG ulFlags )
 {
 	UCVarValue	Val;
-	char		szAddress[4][4];
 	ULONG		ulIdx;
 	ULONG		ulBits;
 
-	// Let's just use the master server buffer! It gets cleared again when we need it anyway!
-	NETWORK_ClearBuffer( &g_MasterServerBuffer );
-
-	if ( bBroadcasting == false )
-	{
-		// First, check to see if we've been queried by this address recently.
-		if ( g_lStoredQueryIPHead != g_lStoredQueryIPTail )
-		{
-			ulIdx = g_lStoredQueryIPHead;
-			while ( ulIdx != (ULONG)g_lStoredQueryIPTail )
-			{
-				// Check to see if this IP exists in our stored query IP list. If it does, then
-				// ignore it, since it queried us less than 10 seconds ago.
-				if ( NETWORK_CompareAddress( Address, g_StoredQueryIPs[ulIdx].Address, true ))
-				{
-					// Write our header.
-					NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, SERVER_LAUNCHER_IGNORING );
-
-					// Send the time the launcher sent to us.
-					NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, ulTime );
-
-					// Send the packet.
-	//				NETWORK_LaunchPacket( &g_MasterServerBuffer, Address, true );
-					NETWORK_LaunchPacket( &g_MasterServerBuffer, Address );
-
-					if ( sv_showlauncherqueries )
-						Printf( "Ignored IP launcher challenge.\n" );
-
-					// Nothing more to do here.
-					return;
-				}
-
-				ulIdx++;
-				ulIdx = ulIdx % MAX_STORED_QUERY_IPS;
-			}
-		}
-	
-		// Now, check to see if this IP has been banend from this server.
-		NETWORK_AddressToIPStringArray( Address, szAddress );
-		if ( SERVERBAN_IsIPBanned( szAddress ))
-		{
-			// Write our header.
-			NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, SERVER_LAUNCHER_BANNED );
-
-			// Send the time the launcher sent to us.
-			NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, ulTime );
-
-			// Send the packet.
-			NETWORK_LaunchPacket( &g_MasterServerBuffer, Address );
-
-			if ( sv_showlauncherqueries )
-				Printf( "Denied BANNED IP launcher challenge.\n" );
-
-			// Nothing more to do here.
-			return;
-		}
-
-		// This IP didn't exist in the list. and it wasn't banned. 
-		// So, add it, and keep it there for 10 seconds.
-		g_StoredQueryIPs[g_lStoredQueryIPTail].Address = Address;
-		g_StoredQueryIPs[g_lStoredQueryIPTail].lNextAllowedGametic = gametic + ( TICRATE * ( sv_queryignoretime ));
-
-		g_lStoredQueryIPTail++;
-		g_lStoredQueryIPTail = g_lStoredQueryIPTail % MAX_STORED_QUERY_IPS;
-		if ( g_lStoredQueryIPTail == g_lStoredQueryIPHead )
-			Printf( "SERVER_MASTER_SendServerInfo: WARNING! g_lStoredQueryIPTail == g_lStoredQueryIPHead\n" );
-	}
-
-	// Write our header.
-	NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, SERVER_LAUNCHER_CHALLENGE );
-
-	// Send the time the launcher sent to us.
-	NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, ulTime );
-
 	// Send our version.
-	NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, GetVersionString() );
+	NETWORK_WriteString( pByteStream, GetVersionString() );
 
 	// Send the information about the data that will be sent.
 	ulBits = ulFlags;
@@ -362,82 +300,82 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 	if ( ulBits & SQF_PLAYERDATA )
 		ulBits |= SQF_NUMPLAYERS;
 
-	NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, ulBits );
+	NETWORK_WriteLong( pByteStream, ulBits );
 
 	// Send the server name.
 	if ( ulBits & SQF_NAME )
 	{
 		Val = sv_hostname.GetGenericRep( CVAR_String );
-		NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, Val.String );
+		NETWORK_WriteString( pByteStream, Val.String );
 	}
 
 	// Send the website URL.
 	if ( ulBits & SQF_URL )
 	{
 		Val = sv_website.GetGenericRep( CVAR_String );
-		NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, Val.String );
+		NETWORK_WriteString( pByteStream, Val.String );
 	}
 
 	// Send the host's e-mail address.
 	if ( ulBits & SQF_EMAIL )
 	{
 		Val = sv_hostemail.GetGenericRep( CVAR_String );
-		NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, Val.String );
+		NETWORK_WriteString( pByteStream, Val.String );
 	}
 
 	if ( ulBits & SQF_MAPNAME )
-		NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, level.mapname );
+		NETWORK_WriteString( pByteStream, level.mapname );
 
 	if ( ulBits & SQF_MAXCLIENTS )
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, sv_maxclients );
+		NETWORK_WriteByte( pByteStream, sv_maxclients );
 
 	if ( ulBits & SQF_MAXPLAYERS )
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, sv_maxplayers );
+		NETWORK_WriteByte( pByteStream, sv_maxplayers );
 
 	// Send out the PWAD information.
 	if ( ulBits & SQF_PWADS )
 	{
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, NETWORK_GetPWADList( )->size( ));
+		NETWORK_WriteByte( pByteStream, NETWORK_GetPWADList( )->size( ));
 		for( std::list<std::pair<FString, FString> >::iterator i = NETWORK_GetPWADList( )->begin( ); i != NETWORK_GetPWADList( )->end(); ++i )
-			NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, i->first.GetChars( ));
+			NETWORK_WriteString( pByteStream, i->first.GetChars( ));
 	}
 
 	if ( ulBits & SQF_GAMETYPE )
 	{
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, GAMEMODE_GetCurrentMode( ));
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, instagib );
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, buckshot );
+		NETWORK_WriteByte( pByteStream, GAMEMODE_GetCurrentMode( ));
+		NETWORK_WriteByte( pByteStream, instagib );
+		NETWORK_WriteByte( pByteStream, buckshot );
 	}
 
 	if ( ulBits & SQF_GAMENAME )
-		NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, SERVER_MASTER_GetGameName( ));
+		NETWORK_WriteString( pByteStream, SERVER_MASTER_GetGameName( ));
 
 	if ( ulBits & SQF_IWAD )
-		NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, NETWORK_GetIWAD( ));
+		NETWORK_WriteString( pByteStream, NETWORK_GetIWAD( ));
 
 	if ( ulBits & SQF_FORCEPASSWORD )
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, sv_forcepassword );
+		NETWORK_WriteByte( pByteStream, sv_forcepassword );
 
 	if ( ulBits & SQF_FORCEJOINPASSWORD )
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, sv_forcejoinpassword );
+		NETWORK_WriteByte( pByteStream, sv_forcejoinpassword );
 
 	if ( ulBits & SQF_GAMESKILL )
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, gameskill );
+		NETWORK_WriteByte( pByteStream, gameskill );
 
 	if ( ulBits & SQF_BOTSKILL )
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, botskill );
+		NETWORK_WriteByte( pByteStream, botskill );
 
 	if ( ulBits & SQF_DMFLAGS )
 	{
-		NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, dmflags );
-		NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, dmflags2 );
-		NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, compatflags );
+		NETWORK_WriteLong( pByteStream, dmflags );
+		NETWORK_WriteLong( pByteStream, dmflags2 );
+		NETWORK_WriteLong( pByteStream, compatflags );
 	}
 
 	if ( ulBits & SQF_LIMITS )
 	{
-		NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, fraglimit );
-		NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, static_cast<SHORT>(timelimit) );
+		NETWORK_WriteShort( pByteStream, fraglimit );
+		NETWORK_WriteShort( pByteStream, static_cast<SHORT>(timelimit) );
 		// [BB] We have to base the decision on whether to send "time left" on the same rounded
 		// timelimit value we just sent to the client.
 		if ( static_cast<SHORT>(timelimit) )
@@ -447,18 +385,18 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 			lTimeLeft = (LONG)( timelimit - ( level.time / ( TICRATE * 60 )));
 			if ( lTimeLeft < 0 )
 				lTimeLeft = 0;
-			NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, lTimeLeft );
+			NETWORK_WriteShort( pByteStream, lTimeLeft );
 		}
-		NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, duellimit );
-		NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, pointlimit );
-		NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, winlimit );
+		NETWORK_WriteShort( pByteStream, duellimit );
+		NETWORK_WriteShort( pByteStream, pointlimit );
+		NETWORK_WriteShort( pByteStream, winlimit );
 	}
 
 	// Send the team damage scale.
 	if ( teamplay || teamgame || teamlms || teampossession || (( deathmatch == false ) && ( teamgame == false )))
 	{
 		if ( ulBits & SQF_TEAMDAMAGE )
-			NETWORK_WriteFloat( &g_MasterServerBuffer.ByteStream, teamdamage );
+			NETWORK_WriteFloat( pByteStream, teamdamage );
 	}
 
 	if ( GAMEMODE_GetFlags( GAMEMODE_GetCurrentMode( )) & GMF_PLAYERSONTEAMS )
@@ -470,17 +408,17 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 			for ( ulIdx = 0; ulIdx < 2; ulIdx++ )
 			{
 				if ( GAMEMODE_GetFlags(GAMEMODE_GetCurrentMode()) & GMF_PLAYERSEARNFRAGS )
-					NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, TEAM_GetFragCount( ulIdx ));
+					NETWORK_WriteShort( pByteStream, TEAM_GetFragCount( ulIdx ));
 				else if ( GAMEMODE_GetFlags(GAMEMODE_GetCurrentMode()) & GMF_PLAYERSEARNWINS )
-					NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, TEAM_GetWinCount( ulIdx ));
+					NETWORK_WriteShort( pByteStream, TEAM_GetWinCount( ulIdx ));
 				else
-					NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, TEAM_GetScore( ulIdx ));
+					NETWORK_WriteShort( pByteStream, TEAM_GetScore( ulIdx ));
 			}
 		}
 	}
 
 	if ( ulBits & SQF_NUMPLAYERS )
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, SERVER_CalcNumPlayers( ));
+		NETWORK_WriteByte( pByteStream, SERVER_CalcNumPlayers( ));
 
 	if ( ulBits & SQF_PLAYERDATA )
 	{
@@ -489,55 +427,55 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 			if ( playeringame[ulIdx] == false )
 				continue;
 
-			NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, players[ulIdx].userinfo.netname );
+			NETWORK_WriteString( pByteStream, players[ulIdx].userinfo.netname );
 			if ( GAMEMODE_GetFlags(GAMEMODE_GetCurrentMode()) & GMF_PLAYERSEARNPOINTS )
-				NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, players[ulIdx].lPointCount );
+				NETWORK_WriteShort( pByteStream, players[ulIdx].lPointCount );
 			else if ( GAMEMODE_GetFlags(GAMEMODE_GetCurrentMode()) & GMF_PLAYERSEARNWINS )
-				NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, players[ulIdx].ulWins );
+				NETWORK_WriteShort( pByteStream, players[ulIdx].ulWins );
 			else if ( GAMEMODE_GetFlags(GAMEMODE_GetCurrentMode()) & GMF_PLAYERSEARNFRAGS )
-				NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, players[ulIdx].fragcount );
+				NETWORK_WriteShort( pByteStream, players[ulIdx].fragcount );
 			else
-				NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, players[ulIdx].killcount );
+				NETWORK_WriteShort( pByteStream, players[ulIdx].killcount );
 
-			NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, players[ulIdx].ulPing );
-			NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, PLAYER_IsTrueSpectator( &players[ulIdx] ));
-			NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, players[ulIdx].bIsBot );
+			NETWORK_WriteShort( pByteStream, players[ulIdx].ulPing );
+			NETWORK_WriteByte( pByteStream, PLAYER_IsTrueSpectator( &players[ulIdx] ));
+			NETWORK_WriteByte( pByteStream, players[ulIdx].bIsBot );
 
 			if ( GAMEMODE_GetFlags( GAMEMODE_GetCurrentMode( )) & GMF_PLAYERSONTEAMS )
 			{
 				if ( players[ulIdx].bOnTeam == false )
-					NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, 255 );
+					NETWORK_WriteByte( pByteStream, 255 );
 				else
-					NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, players[ulIdx].ulTeam );
+					NETWORK_WriteByte( pByteStream, players[ulIdx].ulTeam );
 			}
 
-			NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, players[ulIdx].ulTime / ( TICRATE * 60 ));
+			NETWORK_WriteByte( pByteStream, players[ulIdx].ulTime / ( TICRATE * 60 ));
 		}
 	}
 
 	if ( GAMEMODE_GetFlags( GAMEMODE_GetCurrentMode( )) & GMF_PLAYERSONTEAMS )
 	{
 		if ( ulBits & SQF_TEAMINFO_NUMBER )
-			NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, TEAM_GetNumAvailableTeams( ));
+			NETWORK_WriteByte( pByteStream, TEAM_GetNumAvailableTeams( ));
 
 		if ( ulBits & SQF_TEAMINFO_NAME )
 			for ( ulIdx = 0; ulIdx < TEAM_GetNumAvailableTeams( ); ulIdx++ )
-				NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, TEAM_GetName( ulIdx ));
+				NETWORK_WriteString( pByteStream, TEAM_GetName( ulIdx ));
 
 		if ( ulBits & SQF_TEAMINFO_COLOR )
 			for ( ulIdx = 0; ulIdx < TEAM_GetNumAvailableTeams( ); ulIdx++ )
-				NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, TEAM_GetColor( ulIdx ));
+				NETWORK_WriteLong( pByteStream, TEAM_GetColor( ulIdx ));
 
 		if ( ulBits & SQF_TEAMINFO_SCORE )
 		{
 			for ( ulIdx = 0; ulIdx < TEAM_GetNumAvailableTeams( ); ulIdx++ )
 			{
 				if ( GAMEMODE_GetFlags(GAMEMODE_GetCurrentMode()) & GMF_PLAYERSEARNFRAGS )
-					NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, TEAM_GetFragCount( ulIdx ));
+					NETWORK_WriteShort( pByteStream, TEAM_GetFragCount( ulIdx ));
 				else if ( GAMEMODE_GetFlags(GAMEMODE_GetCurrentMode()) & GMF_PLAYERSEARNWINS )
-					NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, TEAM_GetWinCount( ulIdx ));
+					NETWORK_WriteShort( pByteStream, TEAM_GetWinCount( ulIdx ));
 				else
-					NETWORK_WriteShort( &g_MasterServerBuffer.ByteStream, TEAM_GetScore( ulIdx ));
+					NETWORK_WriteShort( pByteStream, TEAM_GetScore( ulIdx ));
 			}
 		}
 	}
@@ -546,40 +484,198 @@ void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ul
 	if ( ulBits & SQF_TESTING_SERVER )
 	{
 #if ( BUILD_ID == BUILD_RELEASE )
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, 0 );
-		NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, "" );
+		NETWORK_WriteByte( pByteStream, 0 );
+		NETWORK_WriteString( pByteStream, "" );
 #else
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, 1 );
+		NETWORK_WriteByte( pByteStream, 1 );
 		// [BB] Name of the testing binary archive found in http://zandronum.com/
 		FString testingBinary;
 		testingBinary.Format ( "downloads/testing/%s/ZandroDev%s-%swindows.zip", GAMEVER_STRING, GAMEVER_STRING, GetGitTime() );
-		NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, testingBinary.GetChars() );
+		NETWORK_WriteString( pByteStream, testingBinary.GetChars() );
 #endif
 	}
 
 	// [BB] We don't have a mandatory main data file anymore, so just send an empty string.
 	if ( ulBits & SQF_DATA_MD5SUM )
-		NETWORK_WriteString( &g_MasterServerBuffer.ByteStream, "" );
+		NETWORK_WriteString( pByteStream, "" );
 
 	// [BB] Send all dmflags and compatflags.
 	if ( ulBits & SQF_ALL_DMFLAGS )
 	{
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, 5 );
-		NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, dmflags );
-		NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, dmflags2 );
-		NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, dmflags3 );
-		NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, compatflags );
-		NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, compatflags2 );
+		NETWORK_WriteByte( pByteStream, 5 );
+		NETWORK_WriteLong( pByteStream, dmflags );
+		NETWORK_WriteLong( pByteStream, dmflags2 );
+		NETWORK_WriteLong( pByteStream, dmflags3 );
+		NETWORK_WriteLong( pByteStream, compatflags );
+		NETWORK_WriteLong( pByteStream, compatflags2 );
 	}
 
 	// [BB] Send special security settings like sv_enforcemasterbanlist.
 	if ( ulBits & SQF_SECURITY_SETTINGS )
-		NETWORK_WriteByte( &g_MasterServerBuffer.ByteStream, sv_enforcemasterbanlist );
+		NETWORK_WriteByte( pByteStream, sv_enforcemasterbanlist );
+}
+
+//*****************************************************************************
+//
+static bool server_master_TakeQueryToken( const NETADDRESS_s &Address )
+{
+	// Each query costs this many tics of credit, which is refilled one per tic.
+	const LONG	lCost = TICRATE * sv_queryignoretime;
+	if ( lCost <= 0 )
+		return ( true );
+
+	const LONG	lCapacity = lCost * MAX( 1, static_cast<int> ( sv_queryburst ));
+	const ULONG	ulIP = ( Address.abIP[0] << 24 ) | ( Address.abIP[1] << 16 ) | ( Address.abIP[2] << 8 ) | Address.abIP[3];
+	const ULONG	ulHash = (( ulIP ^ ( Address.usPort * 40503UL )) * 2654435761UL ) & 0xFFFFFFFF;
+	QUERYTOKENBUCKET_s	&Bucket = g_QueryTokenBuckets[( ulHash >> 16 ) & ( QUERY_TOKEN_BUCKETS - 1 )];
+
+	// A bucket has expired once its credit is full again (or gametic was reset), then
+	// there is nothing left to remember about its address.
+	const bool	bExpired = ( Bucket.bUsed == false ) || ( gametic < Bucket.lLastGametic ) || ( Bucket.lCredit + ( gametic - Bucket.lLastGametic ) >= lCapacity );
+
+	if ( NETWORK_CompareAddress( Bucket.Address, Address, false ) && ( bExpired == false ))
+		Bucket.lCredit += gametic - Bucket.lLastGametic;
+	else if ( bExpired )
+	{
+		// A new address starts with a full bucket.
+		Bucket.Address = Address;
+		Bucket.bUsed = true;
+		Bucket.lCredit = lCapacity;
+	}
+	else
+	{
+		// Another address that hashes to the same bucket still has to wait. Giving
+		// this one the bucket would let anyone reset the credit of other launchers.
+		return ( false );
+	}
+
+	Bucket.lLastGametic = gametic;
+
+	if ( Bucket.lCredit < lCost )
+		return ( false );
+
+	Bucket.lCredit -= lCost;
+	return ( true );
+}
+
+//*****************************************************************************
+//
+static CACHEDSERVERINFO_s *server_master_GetServerInfoReply( ULONG ulFlags )
+{
+	CACHEDSERVERINFO_s	*pReplace = NULL;
+
+	ulFlags &= SQF_ALL;
+
+	for ( ULONG ulIdx = 0; ulIdx < MAX_CACHED_SERVERINFO_REPLIES; ulIdx++ )
+	{
+		CACHEDSERVERINFO_s	*pEntry = &g_CachedServerInfo[ulIdx];
+
+		if (( pEntry->bValid ) && ( pEntry->ulFlags == ulFlags ))
+		{
+			if (( gametic >= pEntry->lBuiltGametic ) && ( gametic - pEntry->lBuiltGametic < SERVERINFO_CACHE_TICS ))
+			{
+				g_ulServerInfoCacheHits++;
+				return ( pEntry );
+			}
+
+			// Outdated, rebuild it in place.
+			pReplace = pEntry;
+			break;
+		}
+
+		// Otherwise prefer an unused entry, then the oldest one.
+		if (( pReplace == NULL ) || (( pReplace->bValid ) && (( pEntry->bValid == false ) || ( pEntry->lBuiltGametic < pReplace->lBuiltGametic ))))
+			pReplace = pEntry;
+	}
+
+	g_ulServerInfoCacheMisses++;
+
+	NETWORK_ClearBuffer( &pReplace->Reply );
+	server_master_WriteServerInfo( &pReplace->Reply.ByteStream, ulFlags );
+	pReplace->bValid = true;
+	pReplace->ulFlags = ulFlags;
+	pReplace->lBuiltGametic = gametic;
+
+	return ( pReplace );
+}
+
+//*****************************************************************************
+//
+void SERVER_MASTER_SendServerInfo( NETADDRESS_s Address, ULONG ulFlags, ULONG ulTime, bool bBroadcasting )
+{
+	char		szAddress[4][4];
+
+	// Let's just use the master server buffer! It gets cleared again when we need it anyway!
+	NETWORK_ClearBuffer( &g_MasterServerBuffer );
+
+	if ( bBroadcasting == false )
+	{
+		// First, check to see if we've been queried by this address too often recently.
+		if ( server_master_TakeQueryToken( Address ) == false )
+		{
+			g_ulIgnoredQueries++;
+
+			// Write our header.
+			NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, SERVER_LAUNCHER_IGNORING );
+
+			// Send the time the launcher sent to us.
+			NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, ulTime );
+
+			// Send the packet.
+			NETWORK_LaunchPacket( &g_MasterServerBuffer, Address );
+
+			if ( sv_showlauncherqueries )
+				Printf( "Ignored IP launcher challenge.\n" );
+
+			// Nothing more to do here.
+			return;
+		}
+	
+		// Now, check to see if this IP has been banend from this server.
+		NETWORK_AddressToIPStringArray( Address, szAddress );
+		if ( SERVERBAN_IsIPBanned( szAddress ))
+		{
+			// Write our header.
+			NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, SERVER_LAUNCHER_BANNED );
+
+			// Send the time the launcher sent to us.
+			NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, ulTime );
+
+			// Send the packet.
+			NETWORK_LaunchPacket( &g_MasterServerBuffer, Address );
+
+			if ( sv_showlauncherqueries )
+				Printf( "Denied BANNED IP launcher challenge.\n" );
+
+			// Nothing more to do here.
+			return;
+		}
+	}
+
+	// Write our header.
+	NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, SERVER_LAUNCHER_CHALLENGE );
+
+	// Send the time the launcher sent to us.
+	NETWORK_WriteLong( &g_MasterServerBuffer.ByteStream, ulTime );
+
+	// The rest of the reply only depends on the requested flags and the game state, so it's usually already built.
+	CACHEDSERVERINFO_s	*pReply = server_master_GetServerInfoReply( ulFlags );
+	NETWORK_WriteBuffer( &g_MasterServerBuffer.ByteStream, pReply->Reply.pbData, NETWORK_CalcBufferSize( &pReply->Reply ));
 
 //	NETWORK_LaunchPacket( &g_MasterServerBuffer, Address, true );
 	NETWORK_LaunchPacket( &g_MasterServerBuffer, Address );
 }
 
+//*****************************************************************************
+//
+void SERVER_MASTER_InvalidateServerInfoCache( void )
+{
+	for ( ULONG ulIdx = 0; ulIdx < MAX_CACHED_SERVERINFO_REPLIES; ulIdx++ )
+		g_CachedServerInfo[ulIdx].bValid = false;
+
+	g_ulServerInfoCacheInvalidations++;
+}
+
 //*****************************************************************************
 //
 const char *SERVER_MASTER_GetGameName( void )
@@ -666,6 +762,7 @@ CUSTOM_CVAR( Bool, sv_broadcast, true, CVAR_ARCHIVE )
 CUSTOM_CVAR( String, sv_hostname, "Unnamed " GAMENAME " server", CVAR_ARCHIVE )
 {
 	SERVERCONSOLE_UpdateTitleString( (const char *)self );
+	SERVER_MASTER_InvalidateServerInfoCache( );
 }
 
 // Website that has the wad this server is using, possibly with other info.
@@ -685,3 +782,27 @@ CCMD( wads )
 	for( std::list<std::pair<FString, FString> >::iterator i = NETWORK_GetPWADList( )->begin( ); i != NETWORK_GetPWADList( )->end( ); ++i )
 		Printf( "PWAD: %s - %s\n", i->first.GetChars(), i->second.GetChars() );
 }
+
+//*****************************************************************************
+//
+CCMD( querycachestats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	if (( argv.argc( ) > 1 ) && ( stricmp( argv[1], "reset" ) == 0 ))
+	{
+		g_ulServerInfoCacheHits = 0;
+		g_ulServerInfoCacheMisses = 0;
+		g_ulServerInfoCacheInvalidations = 0;
+		g_ulIgnoredQueries = 0;
+		return;
+	}
+
+	const ULONG	ulReplies = g_ulServerInfoCacheHits + g_ulServerInfoCacheMisses;
+
+	Printf( "Launcher replies: %lu (%lu cache hits, %lu misses, %.1f%% hit rate)\n", ulReplies, g_ulServerInfoCacheHits, g_ulServerInfoCacheMisses,
+		( ulReplies > 0 ) ? ( 100.0 * g_ulServerInfoCacheHits / ulReplies ) : 0.0 );
+	Printf( "Cache invalidations: %lu\n", g_ulServerInfoCacheInvalidations );
+	Printf( "Ignored queries: %lu (one per %d seconds, burst of %d)\n", g_ulIgnoredQueries, static_cast<int> ( sv_queryignoretime ), MAX( 1, static_cast<int> ( sv_queryburst )));
+}
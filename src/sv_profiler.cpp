@@ -0,0 +1,324 @@
+//-----------------------------------------------------------------------------
+//
+// Skulltag Source
+// Copyright (C) 2007-2012 Skulltag Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+//
+// Filename: sv_profiler.cpp
+//
+// Description: Measures how long the phases of the server's tics take.
+//
+// The time every phase took in a tic is added to a histogram with logarithmic
+// buckets, each power of two is split into 16 linear sub-buckets. So the
+// percentiles read from the histogram are never off by more than 6.25%, no
+// matter whether a phase takes a few microseconds or several seconds, and
+// recording a tic never allocates anything. There are two histograms per phase:
+// one since the server started (or the last "ticprofile reset") for the
+// ticprofile command, and one for the interval of the periodic log line.
+//
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "doomdef.h"
+#include "doomstat.h"
+#include "network.h"
+#include "stats.h"
+#include "sv_profiler.h"
+#include "templates.h"
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- DEFINES ---------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+// Number of linear sub-buckets per power of two is 1 << PROFILER_SUBBUCKET_BITS.
+#define	PROFILER_SUBBUCKET_BITS		4
+#define	PROFILER_NUM_SUBBUCKETS		( 1 << PROFILER_SUBBUCKET_BITS )
+
+// Values below 2 * PROFILER_NUM_SUBBUCKETS have a bucket of their own, every further
+// power of two up to 2^31 adds PROFILER_NUM_SUBBUCKETS buckets.
+#define	PROFILER_NUM_BUCKETS		(( 32 - PROFILER_SUBBUCKET_BITS ) * PROFILER_NUM_SUBBUCKETS )
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- TYPES -----------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct
+{
+	// Number of tics in each bucket. Values are in microseconds.
+	QWORD			aqwBuckets[PROFILER_NUM_BUCKETS];
+
+	QWORD			qwNumTics;
+	QWORD			qwTotalMicroseconds;
+	ULONG			ulMaxMicroseconds;
+
+} PROFILERHISTOGRAM_s;
+
+//*****************************************************************************
+typedef struct
+{
+	// Time spent in this phase during the current tic.
+	cycle_t				Cycles;
+
+	PROFILERHISTOGRAM_s	Total;
+	PROFILERHISTOGRAM_s	Interval;
+
+} PROFILERPHASE_s;
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- VARIABLES -------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+static	PROFILERPHASE_s	g_Phases[NUM_PROFILERPHASES];
+
+// Only the server's tics are timed, e.g. thinkers don't count while a level is loaded.
+static	bool			g_bInTic = false;
+
+// Number of tics since the last log line.
+static	ULONG			g_ulTicsSinceLogLine = 0;
+
+static	const char		*g_pszPhaseNames[NUM_PROFILERPHASES] =
+{
+	"tic",
+	"receive",
+	"moves",
+	"ticker",
+	"thinkers",
+	"acs",
+	"sight",
+	"writecommands",
+	"send",
+};
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- CONSOLE VARIABLES -----------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+// Print a line with the tic time percentiles of all phases every this many seconds (0 = never).
+CVAR( Int, sv_ticprofileloginterval, 0, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- FUNCTIONS -------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+static ULONG profiler_GetBucket( ULONG ulValue )
+{
+	ULONG	ulHighestBit = 0;
+
+	if ( ulValue < 2 * PROFILER_NUM_SUBBUCKETS )
+		return ( ulValue );
+
+	while (( ulValue >> ulHighestBit ) > 1 )
+		ulHighestBit++;
+
+	const ULONG ulShift = ulHighestBit - PROFILER_SUBBUCKET_BITS;
+	return (( ulShift + 1 ) * PROFILER_NUM_SUBBUCKETS + (( ulValue >> ulShift ) & ( PROFILER_NUM_SUBBUCKETS - 1 )));
+}
+
+//*****************************************************************************
+//
+// Returns the largest value that ends up in the given bucket.
+static ULONG profiler_GetBucketLimit( ULONG ulBucket )
+{
+	if ( ulBucket < 2 * PROFILER_NUM_SUBBUCKETS )
+		return ( ulBucket );
+
+	const ULONG ulShift = ulBucket / PROFILER_NUM_SUBBUCKETS - 1;
+	const ULONG ulLowest = ( PROFILER_NUM_SUBBUCKETS + ulBucket % PROFILER_NUM_SUBBUCKETS ) << ulShift;
+	return ( ulLowest + (( 1UL << ulShift ) - 1 ));
+}
+
+//*****************************************************************************
+//
+static void profiler_Record( PROFILERHISTOGRAM_s *pHistogram, ULONG ulMicroseconds )
+{
+	// Everything beyond half an hour ends up in the last bucket.
+	ulMicroseconds = MIN<ULONG>( ulMicroseconds, 0x7FFFFFFF );
+
+	pHistogram->aqwBuckets[profiler_GetBucket( ulMicroseconds )]++;
+	pHistogram->qwNumTics++;
+	pHistogram->qwTotalMicroseconds += ulMicroseconds;
+	pHistogram->ulMaxMicroseconds = MAX( pHistogram->ulMaxMicroseconds, ulMicroseconds );
+}
+
+//*****************************************************************************
+//
+static void profiler_Reset( PROFILERHISTOGRAM_s *pHistogram )
+{
+	memset( pHistogram, 0, sizeof( *pHistogram ));
+}
+
+//*****************************************************************************
+//
+// Returns the time (in microseconds) that the given fraction of the tics didn't exceed.
+static ULONG profiler_GetPercentile( const PROFILERHISTOGRAM_s *pHistogram, double dFraction )
+{
+	QWORD	qwCount = 0;
+
+	if ( pHistogram->qwNumTics == 0 )
+		return ( 0 );
+
+	const QWORD qwRank = MAX<QWORD>( static_cast<QWORD>( ceil( dFraction * pHistogram->qwNumTics )), 1 );
+	for ( ULONG ulIdx = 0; ulIdx < PROFILER_NUM_BUCKETS; ulIdx++ )
+	{
+		qwCount += pHistogram->aqwBuckets[ulIdx];
+		if ( qwCount >= qwRank )
+			return ( MIN( profiler_GetBucketLimit( ulIdx ), pHistogram->ulMaxMicroseconds ));
+	}
+
+	return ( pHistogram->ulMaxMicroseconds );
+}
+
+//*****************************************************************************
+//
+static void profiler_PrintLogLine( void )
+{
+	FString	Line;
+
+	Line.Format( "ticprofile: tics=%lu", g_ulTicsSinceLogLine );
+	for ( ULONG ulIdx = 0; ulIdx < NUM_PROFILERPHASES; ulIdx++ )
+	{
+		const PROFILERHISTOGRAM_s	*pHistogram = &g_Phases[ulIdx].Interval;
+
+		Line.AppendFormat( " %s_p50=%lu %s_p90=%lu %s_p99=%lu %s_p999=%lu %s_max=%lu",
+			g_pszPhaseNames[ulIdx], profiler_GetPercentile( pHistogram, 0.5 ),
+			g_pszPhaseNames[ulIdx], profiler_GetPercentile( pHistogram, 0.9 ),
+			g_pszPhaseNames[ulIdx], profiler_GetPercentile( pHistogram, 0.99 ),
+			g_pszPhaseNames[ulIdx], profiler_GetPercentile( pHistogram, 0.999 ),
+			g_pszPhaseNames[ulIdx], pHistogram->ulMaxMicroseconds );
+	}
+
+	Printf( "%s\n", Line.GetChars( ));
+}
+
+//*****************************************************************************
+//
+void SERVER_PROFILER_BeginTic( void )
+{
+	for ( ULONG ulIdx = 0; ulIdx < NUM_PROFILERPHASES; ulIdx++ )
+		g_Phases[ulIdx].Cycles.Reset( );
+
+	g_bInTic = true;
+	g_Phases[PROFILERPHASE_TIC].Cycles.Clock( );
+}
+
+//*****************************************************************************
+//
+void SERVER_PROFILER_EndTic( void )
+{
+	if ( g_bInTic == false )
+		return;
+
+	g_Phases[PROFILERPHASE_TIC].Cycles.Unclock( );
+	g_bInTic = false;
+
+	for ( ULONG ulIdx = 0; ulIdx < NUM_PROFILERPHASES; ulIdx++ )
+	{
+		const ULONG ulMicroseconds = static_cast<ULONG>( MAX( g_Phases[ulIdx].Cycles.TimeMS( ) * 1000.0, 0.0 ));
+
+		profiler_Record( &g_Phases[ulIdx].Total, ulMicroseconds );
+		profiler_Record( &g_Phases[ulIdx].Interval, ulMicroseconds );
+	}
+
+	g_ulTicsSinceLogLine++;
+	if (( sv_ticprofileloginterval > 0 ) && ( g_ulTicsSinceLogLine >= static_cast<ULONG>( sv_ticprofileloginterval * TICRATE )))
+	{
+		profiler_PrintLogLine( );
+
+		for ( ULONG ulIdx = 0; ulIdx < NUM_PROFILERPHASES; ulIdx++ )
+			profiler_Reset( &g_Phases[ulIdx].Interval );
+		g_ulTicsSinceLogLine = 0;
+	}
+}
+
+//*****************************************************************************
+//
+void SERVER_PROFILER_Clock( PROFILERPHASE_e Phase )
+{
+	if ( g_bInTic )
+		g_Phases[Phase].Cycles.Clock( );
+}
+
+//*****************************************************************************
+//
+void SERVER_PROFILER_Unclock( PROFILERPHASE_e Phase )
+{
+	if ( g_bInTic )
+		g_Phases[Phase].Cycles.Unclock( );
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- CCMDS -----------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+CCMD( ticprofile )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	if (( argv.argc( ) > 1 ) && ( stricmp( argv[1], "reset" ) == 0 ))
+	{
+		for ( ULONG ulIdx = 0; ulIdx < NUM_PROFILERPHASES; ulIdx++ )
+			profiler_Reset( &g_Phases[ulIdx].Total );
+
+		Printf( "Tic profile reset.\n" );
+		return;
+	}
+
+	Printf( "%-14s %9s %8s %8s %8s %8s %8s %8s\n", "Phase (ms)", "Tics", "Mean", "p50", "p90", "p99", "p99.9", "Max" );
+	for ( ULONG ulIdx = 0; ulIdx < NUM_PROFILERPHASES; ulIdx++ )
+	{
+		const PROFILERHISTOGRAM_s	*pHistogram = &g_Phases[ulIdx].Total;
+
+		if ( pHistogram->qwNumTics == 0 )
+			continue;
+
+		Printf( "%-14s %9llu %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n", g_pszPhaseNames[ulIdx],
+			static_cast<unsigned long long>( pHistogram->qwNumTics ),
+			pHistogram->qwTotalMicroseconds / 1000.0 / pHistogram->qwNumTics,
+			profiler_GetPercentile( pHistogram, 0.5 ) / 1000.0,
+			profiler_GetPercentile( pHistogram, 0.9 ) / 1000.0,
+			profiler_GetPercentile( pHistogram, 0.99 ) / 1000.0,
+			profiler_GetPercentile( pHistogram, 0.999 ) / 1000.0,
+			pHistogram->ulMaxMicroseconds / 1000.0 );
+	}
+}
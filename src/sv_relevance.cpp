@@ -0,0 +1,370 @@
+//-----------------------------------------------------------------------------
+//
+// Skulltag Source
+// Copyright (C) 2007-2012 Skulltag Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+// Filename: sv_relevance.cpp
+//
+// Description: Decides which clients need to know where an actor is, so that
+// position updates of far away actors don't need to be sent to every client.
+//
+// An actor is relevant to a client if it's close to the client's viewpoint, or
+// if it's a bit further away and the REJECT table says that it may be visible
+// or it's in the same sound zone. Position updates of irrelevant actors are not
+// sent to the client. Instead the actor is marked as stale for that client and
+// its full position is sent once it becomes relevant again (or every
+// sv_irrelevantupdateinterval tics).
+//
+//-----------------------------------------------------------------------------
+
+#include "c_dispatch.h"
+#include "doomstat.h"
+#include "network.h"
+#include "p_local.h"
+#include "r_state.h"
+#include "sv_commands.h"
+#include "sv_main.h"
+#include "sv_relevance.h"
+#include "templates.h"
+#include "network/nettraffic.h"
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- TYPES -----------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct
+{
+	// Does the client have a viewpoint? If not, everything is relevant.
+	bool			bHasView;
+
+	// Blockmap cell of the client's viewpoint.
+	LONG			lBlockX;
+	LONG			lBlockY;
+
+	// Sector of the client's viewpoint.
+	sector_t		*pSector;
+
+	// Actors (by net ID) whose position updates the client didn't get.
+	ULONG			aulStale[MAX_NETID / 32];
+
+	// Number of set bits in aulStale.
+	ULONG			ulNumStale;
+
+	// Movement updates of each player skipped since the last one that was sent.
+	ULONG			aulSkippedPlayerUpdates[MAXPLAYERS];
+
+	// PLAYER_ATTACK/PLAYER_ALTATTACK of each player in the last update that was sent
+	// (~0 if we don't know).
+	ULONG			aulSentAttackFlags[MAXPLAYERS];
+
+} RELEVANCECLIENT_s;
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- VARIABLES -------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+static	RELEVANCECLIENT_s	g_aRelevanceClients[MAXPLAYERS];
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- CONSOLE VARIABLES -----------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+// Only send position updates of actors to clients that care about them.
+// When turned off, the stale actors are resynced with the next tick.
+CVAR( Bool, sv_relevancefilter, false, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+// Actors closer than this (in map units) to the viewpoint are always relevant.
+CVAR( Int, sv_relevancenear, 1024, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+// Actors closer than this are relevant if they may be visible or audible.
+CVAR( Int, sv_relevancefar, 4096, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+// Irrelevant actors are resynced at most every this many tics (0 = never).
+CVAR( Int, sv_irrelevantupdateinterval, 2 * TICRATE, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+// Players a client can't possibly see only get their movement sent every this many tics
+// (0 or 1 = every tic).
+CVAR( Int, sv_hiddenplayerupdateinterval, 4, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- FUNCTIONS -------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+static void relevance_UpdateView( ULONG ulClient )
+{
+	RELEVANCECLIENT_s	*pClient = &g_aRelevanceClients[ulClient];
+	const AActor		*pView = players[ulClient].camera ? players[ulClient].camera : players[ulClient].mo;
+
+	if (( pView == NULL ) || ( pView->Sector == NULL ) || ( gamestate != GS_LEVEL ))
+	{
+		pClient->bHasView = false;
+		return;
+	}
+
+	pClient->bHasView = true;
+	pClient->lBlockX = ( pView->x - bmaporgx ) >> MAPBLOCKSHIFT;
+	pClient->lBlockY = ( pView->y - bmaporgy ) >> MAPBLOCKSHIFT;
+	pClient->pSector = pView->Sector;
+}
+
+//*****************************************************************************
+//
+// Checks the REJECT table (either the map's own or the one P_BuildReject built).
+static bool relevance_IsSectorVisible( const RELEVANCECLIENT_s *pClient, const sector_t *pSector )
+{
+	const int iRejectNum = int( pClient->pSector - sectors ) * numsectors + int( pSector - sectors );
+
+	return (( rejectmatrix == NULL ) || (( rejectmatrix[iRejectNum >> 3] & ( 1 << ( iRejectNum & 7 ))) == 0 ));
+}
+
+//*****************************************************************************
+//
+// Is the actor within sv_relevancenear of the client's viewpoint?
+static bool relevance_IsNear( const RELEVANCECLIENT_s *pClient, const AActor *pActor )
+{
+	const LONG lDistX = labs((( pActor->x - bmaporgx ) >> MAPBLOCKSHIFT ) - pClient->lBlockX );
+	const LONG lDistY = labs((( pActor->y - bmaporgy ) >> MAPBLOCKSHIFT ) - pClient->lBlockY );
+	const LONG lBlockSize = 1 << ( MAPBLOCKSHIFT - FRACBITS );
+
+	return ( MAX( lDistX, lDistY ) <= ( sv_relevancenear + lBlockSize - 1 ) / lBlockSize );
+}
+
+//*****************************************************************************
+//
+static void relevance_ClearStale( RELEVANCECLIENT_s *pClient, LONG lNetID )
+{
+	const ULONG ulMask = 1 << ( lNetID & 31 );
+
+	if ( pClient->aulStale[lNetID >> 5] & ulMask )
+	{
+		pClient->aulStale[lNetID >> 5] &= ~ulMask;
+		pClient->ulNumStale--;
+	}
+}
+
+//*****************************************************************************
+//
+void SERVER_RELEVANCE_Tick( void )
+{
+	const LONG lInterval = sv_irrelevantupdateinterval;
+
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+	{
+		RELEVANCECLIENT_s *pClient = &g_aRelevanceClients[ulIdx];
+
+		if ( SERVER_IsValidClient( ulIdx ) == false )
+		{
+			if ( pClient->ulNumStale > 0 )
+				SERVER_RELEVANCE_ResetClient( ulIdx );
+			continue;
+		}
+
+		relevance_UpdateView( ulIdx );
+
+		if ( pClient->ulNumStale == 0 )
+			continue;
+
+		// Resync the stale actors that became relevant (or all of them if the filter was turned off).
+		for ( ULONG ulWord = 0; ulWord < countof( pClient->aulStale ); ulWord++ )
+		{
+			if ( pClient->aulStale[ulWord] == 0 )
+				continue;
+
+			for ( ULONG ulBit = 0; ulBit < 32; ulBit++ )
+			{
+				if (( pClient->aulStale[ulWord] & ( 1 << ulBit )) == 0 )
+					continue;
+
+				const LONG lNetID = ( ulWord << 5 ) + ulBit;
+				AActor *pActor = g_NetIDList[lNetID].bFree ? NULL : g_NetIDList[lNetID].pActor;
+
+				// The actor is gone, the client will be told about a new actor using this ID when it's spawned.
+				if ( pActor == NULL )
+				{
+					relevance_ClearStale( pClient, lNetID );
+					continue;
+				}
+
+				if (( sv_relevancefilter == false ) ||
+					(( lInterval > 0 ) && ((( gametic + lNetID ) % lInterval ) == 0 )) ||
+					SERVER_RELEVANCE_IsActorRelevant( ulIdx, pActor ))
+				{
+					relevance_ClearStale( pClient, lNetID );
+					SERVERCOMMANDS_ResyncThingPosition( pActor, ulIdx );
+				}
+			}
+		}
+	}
+}
+
+//*****************************************************************************
+//
+void SERVER_RELEVANCE_ResetClient( ULONG ulClient )
+{
+	if ( ulClient >= MAXPLAYERS )
+		return;
+
+	memset( g_aRelevanceClients[ulClient].aulStale, 0, sizeof( g_aRelevanceClients[ulClient].aulStale ));
+	g_aRelevanceClients[ulClient].ulNumStale = 0;
+	memset( g_aRelevanceClients[ulClient].aulSkippedPlayerUpdates, 0, sizeof( g_aRelevanceClients[ulClient].aulSkippedPlayerUpdates ));
+	memset( g_aRelevanceClients[ulClient].aulSentAttackFlags, 0xFF, sizeof( g_aRelevanceClients[ulClient].aulSentAttackFlags ));
+}
+
+//*****************************************************************************
+//
+bool SERVER_RELEVANCE_IsActorRelevant( ULONG ulClient, const AActor *pActor )
+{
+	const RELEVANCECLIENT_s *pClient = &g_aRelevanceClients[ulClient];
+
+	if (( pClient->bHasView == false ) || ( pActor->Sector == NULL ))
+		return ( true );
+
+	// Players are always relevant, their movement is sent separately anyway.
+	if (( pActor->player != NULL ) || ( pActor == players[ulClient].camera ))
+		return ( true );
+
+	if ( relevance_IsNear( pClient, pActor ))
+		return ( true );
+
+	const LONG lDistX = labs((( pActor->x - bmaporgx ) >> MAPBLOCKSHIFT ) - pClient->lBlockX );
+	const LONG lDistY = labs((( pActor->y - bmaporgy ) >> MAPBLOCKSHIFT ) - pClient->lBlockY );
+	const LONG lBlockSize = 1 << ( MAPBLOCKSHIFT - FRACBITS );
+
+	if ( MAX( lDistX, lDistY ) > ( sv_relevancefar + lBlockSize - 1 ) / lBlockSize )
+		return ( false );
+
+	// Can the actor be seen from the client's sector?
+	if ( relevance_IsSectorVisible( pClient, pActor->Sector ))
+		return ( true );
+
+	// Can it be heard? On maps without zone boundaries, everything is one zone.
+	if (( numzones > 1 ) && ( pActor->Sector->ZoneNumber == pClient->pSector->ZoneNumber ))
+		return ( true );
+
+	return ( false );
+}
+
+//*****************************************************************************
+//
+bool SERVER_RELEVANCE_SkipPositionUpdate( ULONG ulClient, AActor *pActor, ULONG ulSize )
+{
+	if (( ulClient >= MAXPLAYERS ) || ( pActor->lNetID <= 0 ) || ( pActor->lNetID >= MAX_NETID ))
+		return ( false );
+
+	RELEVANCECLIENT_s *pClient = &g_aRelevanceClients[ulClient];
+	const ULONG ulMask = 1 << ( pActor->lNetID & 31 );
+
+	if ( sv_relevancefilter && ( SERVER_RELEVANCE_IsActorRelevant( ulClient, pActor ) == false ))
+	{
+		if (( pClient->aulStale[pActor->lNetID >> 5] & ulMask ) == 0 )
+		{
+			pClient->aulStale[pActor->lNetID >> 5] |= ulMask;
+			pClient->ulNumStale++;
+		}
+
+		NETTRAFFIC_AddRelevanceTraffic( ulClient, true, ulSize );
+		return ( true );
+	}
+
+	// The client missed some updates of this actor. Since the update may tell it to
+	// reuse the last position it got, it first needs the current state.
+	if ( pClient->aulStale[pActor->lNetID >> 5] & ulMask )
+	{
+		relevance_ClearStale( pClient, pActor->lNetID );
+		SERVERCOMMANDS_ResyncThingPosition( pActor, ulClient );
+	}
+
+	return ( false );
+}
+
+//*****************************************************************************
+//
+// Players are always relevant because the clients need them for their scoreboards, sounds
+// and camera textures. But the movement of players that can't be seen from the client's
+// sector doesn't need to be sent every tic. Updates that start or stop an attack are
+// always sent though, the client plays the attack sounds and animations from them.
+bool SERVER_RELEVANCE_SkipPlayerUpdate( ULONG ulClient, ULONG ulPlayer, ULONG ulAttackFlags, ULONG ulSize )
+{
+	if (( ulClient >= MAXPLAYERS ) || ( ulPlayer >= MAXPLAYERS ) || ( ulClient == ulPlayer ))
+		return ( false );
+
+	RELEVANCECLIENT_s		*pClient = &g_aRelevanceClients[ulClient];
+	const AActor			*pActor = players[ulPlayer].mo;
+	const LONG				lInterval = sv_hiddenplayerupdateinterval;
+
+	if (( sv_relevancefilter == false ) || ( lInterval <= 1 ) || ( pClient->bHasView == false ) ||
+		( pActor == NULL ) || ( pActor->Sector == NULL ) || ( pActor == players[ulClient].camera ) ||
+		relevance_IsNear( pClient, pActor ) || relevance_IsSectorVisible( pClient, pActor->Sector ) ||
+		( ulAttackFlags != pClient->aulSentAttackFlags[ulPlayer] ))
+	{
+		pClient->aulSkippedPlayerUpdates[ulPlayer] = 0;
+		pClient->aulSentAttackFlags[ulPlayer] = ulAttackFlags;
+		return ( false );
+	}
+
+	// Send every lInterval-th update. This counts the updates the client would have
+	// gotten, not the tics, since the client may not get an update every tic anyway.
+	if ( pClient->aulSkippedPlayerUpdates[ulPlayer] + 1 >= static_cast<ULONG>( lInterval ))
+	{
+		pClient->aulSkippedPlayerUpdates[ulPlayer] = 0;
+		return ( false );
+	}
+
+	pClient->aulSkippedPlayerUpdates[ulPlayer]++;
+	NETTRAFFIC_AddRelevanceTraffic( ulClient, true, ulSize );
+	return ( true );
+}
+
+//*****************************************************************************
+//	CONSOLE COMMANDS
+
+CCMD( relevancestats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ulIdx++ )
+	{
+		if ( SERVER_IsValidClient( ulIdx ) == false )
+			continue;
+
+		Printf( "%s: %lu stale actors\n", players[ulIdx].userinfo.netname, g_aRelevanceClients[ulIdx].ulNumStale );
+	}
+}
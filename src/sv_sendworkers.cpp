@@ -0,0 +1,396 @@
+//-----------------------------------------------------------------------------
+//
+// Skulltag Source
+// Copyright (C) 2007-2012 Skulltag Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//
+// Filename: sv_sendworkers.cpp
+//
+// Description: A small pool of threads that helps the game thread with work that
+// has to be done separately for every client.
+//
+// SERVER_SENDWORKERS_Run hands out the items of a job one at a time to the game
+// thread and the workers, and only returns once all items are done. So to the
+// rest of the code the workers are invisible, they only make the call return
+// sooner. A job must only touch what belongs to its item: neither the game state
+// nor the allocator (which counts the allocated bytes for the GC) are thread-safe.
+//
+//-----------------------------------------------------------------------------
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define USE_WINDOWS_DWORD
+#else
+#include <pthread.h>
+#endif
+
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "doomtype.h"
+#include "network.h"
+#include "huffman.h"
+#include "sv_sendworkers.h"
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- TYPES -----------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef struct
+{
+#ifdef _WIN32
+	HANDLE			hThread;
+
+	// Signaled when there is a new job to work on.
+	HANDLE			hStartEvent;
+#else
+	pthread_t		Thread;
+
+	// Number of the last job this worker worked on.
+	ULONG			ulLastJob;
+#endif
+
+} SENDWORKER_s;
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- VARIABLES -------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+static	SENDWORKER_s	g_Workers[SENDWORKERS_MAX];
+static	ULONG			g_ulNumWorkers = 0;
+
+// Number of workers sv_sendthreads asked for when they were started. There may be
+// less if some couldn't be started.
+static	ULONG			g_ulNumRequestedWorkers = 0;
+
+// The job that's done right now and its number of items.
+static	void			(*g_pfnJob)( ULONG ulItem ) = NULL;
+static	ULONG			g_ulNumItems = 0;
+
+// Next item of the job that wasn't handed out yet.
+static	volatile LONG	g_lNextItem = 0;
+
+// Number of workers that are still busy with the job.
+static	volatile LONG	g_lNumBusyWorkers = 0;
+
+// Are the workers supposed to exit?
+static	volatile bool	g_bQuit = false;
+
+#ifdef _WIN32
+// Signaled by the last worker that is done with the job.
+static	HANDLE			g_hDoneEvent = NULL;
+#else
+static	pthread_mutex_t	g_Mutex = PTHREAD_MUTEX_INITIALIZER;
+static	pthread_cond_t	g_StartCondition = PTHREAD_COND_INITIALIZER;
+static	pthread_cond_t	g_DoneCondition = PTHREAD_COND_INITIALIZER;
+
+// Incremented for every job, so that the workers can tell a new job from a spurious wakeup.
+static	ULONG			g_ulJobNumber = 0;
+#endif
+
+// How many jobs were done, with how many items, and how many of them were shared with the workers.
+static	QWORD			g_qwNumJobs = 0;
+static	QWORD			g_qwNumSharedJobs = 0;
+static	QWORD			g_qwNumItems = 0;
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- CONSOLE VARIABLES -----------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+// Number of threads that help the game thread to finalize the packets of the clients (0 = none).
+CUSTOM_CVAR( Int, sv_sendthreads, 0, CVAR_ARCHIVE|CVAR_NOSETBYACS )
+{
+	if ( self < 0 )
+		self = 0;
+	else if ( self > SENDWORKERS_MAX )
+	{
+		Printf( "sv_sendthreads cannot exceed %d.\n", SENDWORKERS_MAX );
+		self = SENDWORKERS_MAX;
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- PROTOTYPES ------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+static	void	sendworkers_Start( ULONG ulNumWorkers );
+static	void	sendworkers_Stop( void );
+static	LONG	sendworkers_ClaimItem( void );
+static	void	sendworkers_Work( void );
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- FUNCTIONS -------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+#ifdef _WIN32
+static DWORD WINAPI sendworkers_ThreadMain( LPVOID pParameter )
+{
+	SENDWORKER_s	*pWorker = static_cast<SENDWORKER_s *>( pParameter );
+
+	while ( true )
+	{
+		WaitForSingleObject( pWorker->hStartEvent, INFINITE );
+		if ( g_bQuit )
+			break;
+
+		sendworkers_Work( );
+
+		if ( InterlockedDecrement( &g_lNumBusyWorkers ) == 0 )
+			SetEvent( g_hDoneEvent );
+	}
+
+	return ( 0 );
+}
+#else
+static void *sendworkers_ThreadMain( void *pParameter )
+{
+	SENDWORKER_s	*pWorker = static_cast<SENDWORKER_s *>( pParameter );
+
+	pthread_mutex_lock( &g_Mutex );
+	while ( true )
+	{
+		while (( g_ulJobNumber == pWorker->ulLastJob ) && ( g_bQuit == false ))
+			pthread_cond_wait( &g_StartCondition, &g_Mutex );
+
+		if ( g_bQuit )
+			break;
+
+		pWorker->ulLastJob = g_ulJobNumber;
+		pthread_mutex_unlock( &g_Mutex );
+
+		sendworkers_Work( );
+
+		pthread_mutex_lock( &g_Mutex );
+		if ( --g_lNumBusyWorkers == 0 )
+			pthread_cond_signal( &g_DoneCondition );
+	}
+	pthread_mutex_unlock( &g_Mutex );
+
+	return ( NULL );
+}
+#endif
+
+//*****************************************************************************
+//
+static void sendworkers_Start( ULONG ulNumWorkers )
+{
+	g_ulNumRequestedWorkers = ulNumWorkers;
+	if ( ulNumWorkers == 0 )
+		return;
+
+	// Without its lookup tables, the Huffman codec encodes through a BitWriter all
+	// packets share, so the packets have to be finalized one after another.
+	if ( HUFFMAN_GetCodec( )->usesTables( ) == false )
+	{
+		Printf( "The Huffman codec cannot encode on several threads, sv_sendthreads is ignored.\n" );
+		return;
+	}
+
+#ifdef _WIN32
+	g_hDoneEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+	if ( g_hDoneEvent == NULL )
+	{
+		Printf( "Could not start the send threads.\n" );
+		return;
+	}
+#endif
+
+	for ( g_ulNumWorkers = 0; g_ulNumWorkers < ulNumWorkers; g_ulNumWorkers++ )
+	{
+		SENDWORKER_s	*pWorker = &g_Workers[g_ulNumWorkers];
+
+#ifdef _WIN32
+		pWorker->hStartEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+		if ( pWorker->hStartEvent == NULL )
+			break;
+
+		pWorker->hThread = CreateThread( NULL, 0, sendworkers_ThreadMain, pWorker, 0, NULL );
+		if ( pWorker->hThread == NULL )
+		{
+			CloseHandle( pWorker->hStartEvent );
+			break;
+		}
+#else
+		// No job is running, so the worker must wait for the next one.
+		pWorker->ulLastJob = g_ulJobNumber;
+		if ( pthread_create( &pWorker->Thread, NULL, sendworkers_ThreadMain, pWorker ) != 0 )
+			break;
+#endif
+	}
+
+	if ( g_ulNumWorkers < ulNumWorkers )
+		Printf( "Could only start %lu of %lu send threads.\n", g_ulNumWorkers, ulNumWorkers );
+}
+
+//*****************************************************************************
+//
+static void sendworkers_Stop( void )
+{
+	ULONG	ulIdx;
+
+#ifdef _WIN32
+	g_bQuit = true;
+	for ( ulIdx = 0; ulIdx < g_ulNumWorkers; ulIdx++ )
+		SetEvent( g_Workers[ulIdx].hStartEvent );
+
+	for ( ulIdx = 0; ulIdx < g_ulNumWorkers; ulIdx++ )
+	{
+		WaitForSingleObject( g_Workers[ulIdx].hThread, INFINITE );
+		CloseHandle( g_Workers[ulIdx].hThread );
+		CloseHandle( g_Workers[ulIdx].hStartEvent );
+	}
+
+	if ( g_hDoneEvent != NULL )
+	{
+		CloseHandle( g_hDoneEvent );
+		g_hDoneEvent = NULL;
+	}
+#else
+	pthread_mutex_lock( &g_Mutex );
+	g_bQuit = true;
+	pthread_cond_broadcast( &g_StartCondition );
+	pthread_mutex_unlock( &g_Mutex );
+
+	for ( ulIdx = 0; ulIdx < g_ulNumWorkers; ulIdx++ )
+		pthread_join( g_Workers[ulIdx].Thread, NULL );
+#endif
+
+	g_bQuit = false;
+	g_ulNumWorkers = 0;
+	g_ulNumRequestedWorkers = 0;
+}
+
+//*****************************************************************************
+//
+static LONG sendworkers_ClaimItem( void )
+{
+#ifdef _WIN32
+	return ( InterlockedIncrement( &g_lNextItem ) - 1 );
+#else
+	pthread_mutex_lock( &g_Mutex );
+	const LONG	lItem = g_lNextItem++;
+	pthread_mutex_unlock( &g_Mutex );
+
+	return ( lItem );
+#endif
+}
+
+//*****************************************************************************
+//
+static void sendworkers_Work( void )
+{
+	LONG	lItem;
+
+	while (( lItem = sendworkers_ClaimItem( )) < static_cast<LONG>( g_ulNumItems ))
+		g_pfnJob( lItem );
+}
+
+//*****************************************************************************
+//
+void SERVER_SENDWORKERS_Destruct( void )
+{
+	sendworkers_Stop( );
+}
+
+//*****************************************************************************
+//
+void SERVER_SENDWORKERS_Run( void (*pfnJob)( ULONG ulItem ), ULONG ulNumItems )
+{
+	// sv_sendthreads was changed since the workers were started.
+	if ( g_ulNumRequestedWorkers != static_cast<ULONG>( *sv_sendthreads ))
+	{
+		sendworkers_Stop( );
+		sendworkers_Start( sv_sendthreads );
+	}
+
+	g_pfnJob = pfnJob;
+	g_ulNumItems = ulNumItems;
+	g_lNextItem = 0;
+
+	g_qwNumJobs++;
+	g_qwNumItems += ulNumItems;
+
+	// Not worth waking anyone up.
+	if (( g_ulNumWorkers == 0 ) || ( ulNumItems < 2 ))
+	{
+		sendworkers_Work( );
+		return;
+	}
+
+	g_qwNumSharedJobs++;
+
+#ifdef _WIN32
+	g_lNumBusyWorkers = g_ulNumWorkers;
+	for ( ULONG ulIdx = 0; ulIdx < g_ulNumWorkers; ulIdx++ )
+		SetEvent( g_Workers[ulIdx].hStartEvent );
+
+	sendworkers_Work( );
+
+	WaitForSingleObject( g_hDoneEvent, INFINITE );
+#else
+	pthread_mutex_lock( &g_Mutex );
+	g_lNumBusyWorkers = g_ulNumWorkers;
+	g_ulJobNumber++;
+	pthread_cond_broadcast( &g_StartCondition );
+	pthread_mutex_unlock( &g_Mutex );
+
+	sendworkers_Work( );
+
+	pthread_mutex_lock( &g_Mutex );
+	while ( g_lNumBusyWorkers > 0 )
+		pthread_cond_wait( &g_DoneCondition, &g_Mutex );
+	pthread_mutex_unlock( &g_Mutex );
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+//-- CCMDS -----------------------------------------------------------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+
+CCMD( sendworkerstats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+		return;
+
+	Printf( "Send threads: %lu running, %d requested\n", g_ulNumWorkers, *sv_sendthreads );
+	Printf( "Jobs: %llu, %llu of them shared with the send threads\n", static_cast<unsigned long long>( g_qwNumJobs ),
+		static_cast<unsigned long long>( g_qwNumSharedJobs ));
+	if ( g_qwNumJobs > 0 )
+		Printf( "Average number of clients per job: %.1f\n", static_cast<double>( g_qwNumItems ) / g_qwNumJobs );
+}
@@ -60,6 +60,9 @@
 #include "i_system.h"
 #include "sv_commands.h"
 #include "templates.h"
+#include "m_bbox.h"
+#include "c_dispatch.h"
+#include "stats.h"
 
 CVAR(Flag, sv_nounlagged, dmflags3, DF3_NOUNLAGGED);
 CVAR( Bool, sv_unlagged_debugactors, false, 0 )
@@ -67,6 +70,66 @@ CVAR( Bool, sv_unlagged_debugactors, false, 0 )
 bool reconciledGame = false;
 int reconciliationBlockers = 0;
 
+// Recorded plane heights of a sector that moved within the last UNLAGGEDTICS tics.
+struct UnlaggedSectorHistory
+{
+	int			sectorNum;
+	int			lastMovedTic;
+	fixed_t		floorD[UNLAGGEDTICS];
+	fixed_t		ceilingD[UNLAGGEDTICS];
+};
+
+// The plane heights of a sector when it was last recorded and where its history is kept
+// (-1 if it didn't move within the last UNLAGGEDTICS tics).
+struct UnlaggedSectorState
+{
+	fixed_t		floorD;
+	fixed_t		ceilingD;
+	int			historyIndex;
+};
+
+// Only the sectors that moved recently have a history, all others are at the same height
+// during the whole window and don't need to be reconciled at all.
+static TArray<UnlaggedSectorHistory> movedSectors;
+static TArray<UnlaggedSectorState> sectorStates;
+
+// The players UNLAGGED_Reconcile moved and UNLAGGED_Restore has to move back.
+static bool rewoundPlayers[MAXPLAYERS];
+
+// Where UNLAGGED_Reconcile moved them to.
+static fixed_t rewoundX[MAXPLAYERS];
+static fixed_t rewoundY[MAXPLAYERS];
+static fixed_t rewoundZ[MAXPLAYERS];
+
+// Smoothed round trip time of a client, estimated from the pings like TCP does
+// (see RFC 6298). smoothedPing is stored in 1/8 ms, pingVariance in 1/4 ms.
+struct UnlaggedLatency
+{
+	int			numSamples;
+	int			smoothedPing;
+	int			pingVariance;
+};
+
+static UnlaggedLatency playerLatency[MAXPLAYERS];
+
+// How far the interpolated positions of the players a client shot at were from
+// the positions of the nearest recorded tic.
+struct UnlaggedErrorStats
+{
+	int			numReconciles;
+	int			numRewinds;
+	double		errorSum;
+	fixed_t		errorMax;
+};
+
+static UnlaggedErrorStats playerErrorStats[MAXPLAYERS];
+
+// Players moving more than this between two tics were teleported, their
+// positions must not be interpolated.
+static const fixed_t maxInterpolationStep = 256*FRACUNIT;
+
+static void unlagged_Reconcile( AActor *actor, const FBoundingBox *traceBox );
+
 void UNLAGGED_Tick( void )
 {
 	// [BB] Only the server has to do anything here.
@@ -88,6 +151,74 @@ void UNLAGGED_Tick( void )
 		UNLAGGED_SpawnDebugActors( );
 }
 
+//Figure out how far (in tics as fixed point number) to go back in time for the player
+static fixed_t unlagged_GetLag( const player_t *player )
+{
+	const UnlaggedLatency &latency = playerLatency[player - players];
+
+	//use the smoothed ping if there is one already
+	const SQWORD pingMS8 = ( latency.numSamples > 0 ) ? latency.smoothedPing : ( static_cast<SQWORD>( player->ulPing ) << 3 );
+	const SQWORD lag = pingMS8 * TICRATE * FRACUNIT / ( 1000 * 8 );
+
+	//don't look up tics that are too old
+	return static_cast<fixed_t>( MIN<SQWORD>( lag, ( UNLAGGEDTICS - 1 ) * FRACUNIT ) );
+}
+
+//The newest recorded tic that is at least lag tics old
+static int unlagged_GetNewerTic( const fixed_t lag )
+{
+	return MAX( gametic - ( lag >> FRACBITS ), 0 );
+}
+
+//Figure out where the player was lag tics ago
+//The position is interpolated between the two recorded tics around that time
+static void unlagged_GetPlayerPosition( const player_t *player, const fixed_t lag, fixed_t &x, fixed_t &y, fixed_t &z )
+{
+	int newerTic = unlagged_GetNewerTic( lag );
+	fixed_t frac = lag & ( FRACUNIT - 1 );
+
+	//the current tic isn't recorded before the moves are processed, its slot still
+	//holds the positions from UNLAGGEDTICS tics ago, so take the last recorded tic
+	if ( newerTic > gametic - 1 )
+	{
+		newerTic = MAX( gametic - 1, 0 );
+		frac = 0;
+	}
+
+	const int olderTic = MAX( newerTic - 1, 0 );
+	const int newerIndex = newerTic % UNLAGGEDTICS;
+	const int olderIndex = olderTic % UNLAGGEDTICS;
+
+	x = player->unlaggedX[newerIndex];
+	y = player->unlaggedY[newerIndex];
+	z = player->unlaggedZ[newerIndex];
+
+	if ( ( frac == 0 ) || ( newerTic == olderTic ) )
+		return;
+
+	const SQWORD dx = static_cast<SQWORD>( player->unlaggedX[olderIndex] ) - x;
+	const SQWORD dy = static_cast<SQWORD>( player->unlaggedY[olderIndex] ) - y;
+	const SQWORD dz = static_cast<SQWORD>( player->unlaggedZ[olderIndex] ) - z;
+
+	//don't interpolate teleports, just take the closer tic
+	if ( ( dx > maxInterpolationStep ) || ( dx < -maxInterpolationStep )
+		|| ( dy > maxInterpolationStep ) || ( dy < -maxInterpolationStep )
+		|| ( dz > maxInterpolationStep ) || ( dz < -maxInterpolationStep ) )
+	{
+		if ( frac >= FRACUNIT / 2 )
+		{
+			x = player->unlaggedX[olderIndex];
+			y = player->unlaggedY[olderIndex];
+			z = player->unlaggedZ[olderIndex];
+		}
+		return;
+	}
+
+	x += static_cast<fixed_t>( ( dx * frac ) >> FRACBITS );
+	y += static_cast<fixed_t>( ( dy * frac ) >> FRACBITS );
+	z += static_cast<fixed_t>( ( dz * frac ) >> FRACBITS );
+}
+
 //Figure out which tic to use for reconciliation
 int UNLAGGED_Gametic( player_t *player )
 {
@@ -95,22 +226,68 @@ int UNLAGGED_Gametic( player_t *player )
 	if ( player == NULL )
 		return gametic;
 
-	int unlaggedGametic = ( gametic - ( player->ulPing * TICRATE / 1000 ) );
+	//the same tic the player positions are interpolated from, so that sectors
+	//and players are rewound consistently; with less than a tic of lag, this
+	//is the current tic and nothing is rewound
+	return unlagged_GetNewerTic( unlagged_GetLag( player ) );
+}
 
-	//don't look up tics that are too old
-	if ( (gametic - unlaggedGametic) >= UNLAGGEDTICS)
-		unlaggedGametic = gametic - UNLAGGEDTICS + 1;
+// Is the sector moved by the current reconciliation?
+static bool unlagged_IsSectorRewound( const sector_t *sector )
+{
+	const unsigned int sectorNum = static_cast<unsigned int>( sector - sectors );
 
-	//don't look up negative tics
-	if (unlaggedGametic < 0)
-		unlaggedGametic = 0;
+	if ( ( sectorNum >= sectorStates.Size() ) || ( sectorStates[sectorNum].historyIndex < 0 ) )
+		return false;
 
-	return unlaggedGametic;
+	return ( sector->floorplane.restoreD != sector->floorplane.d ) || ( sector->ceilingplane.restoreD != sector->ceilingplane.d );
+}
+
+// Can a player with the given position and radius be hit by a trace within traceBox?
+static bool unlagged_IsInTraceBox( const FBoundingBox &traceBox, const fixed_t x, const fixed_t y, const fixed_t radius )
+{
+	return ( x + radius >= traceBox.Left() ) && ( x - radius <= traceBox.Right() )
+		&& ( y + radius >= traceBox.Bottom() ) && ( y - radius <= traceBox.Top() );
 }
 
 // Shift stuff back in time before doing hitscan calculations
 // Call UNLAGGED_Restore afterwards to restore everything
 void UNLAGGED_Reconcile( AActor *actor )
+{
+	unlagged_Reconcile( actor, NULL );
+}
+
+// Like UNLAGGED_Reconcile, but only rewinds the players that may be hit by
+// a shot reaching at most distance units in any direction.
+void UNLAGGED_ReconcileRange( AActor *actor, fixed_t distance )
+{
+	if ( actor == NULL )
+		return;
+
+	const FBoundingBox traceBox( actor->x, actor->y, distance );
+	unlagged_Reconcile( actor, &traceBox );
+}
+
+// Like UNLAGGED_Reconcile, but only rewinds the players that may be hit by
+// a shot along angle reaching distance units. margin accounts for shots that
+// don't start at the actor's position.
+void UNLAGGED_ReconcileLine( AActor *actor, angle_t angle, fixed_t distance, fixed_t margin )
+{
+	if ( actor == NULL )
+		return;
+
+	const int fineAngle = angle >> ANGLETOFINESHIFT;
+	FBoundingBox traceBox;
+	traceBox.AddToBox( actor->x, actor->y );
+	traceBox.AddToBox( actor->x + FixedMul( distance, finecosine[fineAngle] ), actor->y + FixedMul( distance, finesine[fineAngle] ) );
+	traceBox.Set( BOXLEFT, traceBox.Left() - margin );
+	traceBox.Set( BOXRIGHT, traceBox.Right() + margin );
+	traceBox.Set( BOXBOTTOM, traceBox.Bottom() - margin );
+	traceBox.Set( BOXTOP, traceBox.Top() + margin );
+	unlagged_Reconcile( actor, &traceBox );
+}
+
+static void unlagged_Reconcile( AActor *actor, const FBoundingBox *traceBox )
 {
 	//Only do anything if the actor to be reconciled is a player,
 	//it's on a server with unlagged on, and reconciliation is not being blocked
@@ -137,22 +314,31 @@ void UNLAGGED_Reconcile( AActor *actor )
 
 	reconciledGame = true;
 
+	const fixed_t lag = unlagged_GetLag( actor->player );
+	UnlaggedErrorStats &errorStats = playerErrorStats[actor->player - players];
+	errorStats.numReconciles++;
+
 	//find the index
 	const int unlaggedIndex = unlaggedGametic % UNLAGGEDTICS;
 
-	//reconcile the sectors
-	for (int i = 0; i < numsectors; ++i)
+	//reconcile the sectors that moved recently, all others were at the same height back then
+	for (unsigned int i = 0; i < movedSectors.Size(); ++i)
 	{
-		sectors[i].floorplane.restoreD = sectors[i].floorplane.d;
-		sectors[i].ceilingplane.restoreD = sectors[i].ceilingplane.d;
+		sector_t *sector = &sectors[movedSectors[i].sectorNum];
 
-		sectors[i].floorplane.d = sectors[i].floorplane.unlaggedD[unlaggedIndex];
-		sectors[i].ceilingplane.d = sectors[i].ceilingplane.unlaggedD[unlaggedIndex];
+		sector->floorplane.restoreD = sector->floorplane.d;
+		sector->ceilingplane.restoreD = sector->ceilingplane.d;
+
+		sector->floorplane.d = movedSectors[i].floorD[unlaggedIndex];
+		sector->ceilingplane.d = movedSectors[i].ceilingD[unlaggedIndex];
 	}
+	P_InvalidateSightCache ();
 
 	//reconcile the players
 	for (int i = 0; i < MAXPLAYERS; ++i)
 	{
+		rewoundPlayers[i] = false;
+
 		if (playeringame[i] && players[i].mo && !players[i].bSpectating)
 		{
 			players[i].restoreX = players[i].mo->x;
@@ -169,11 +355,30 @@ void UNLAGGED_Reconcile( AActor *actor )
 			//to predict him
 			if (players+i != actor->player)
 			{
-				players[i].mo->SetOrigin(
-					players[i].unlaggedX[unlaggedIndex],
-					players[i].unlaggedY[unlaggedIndex],
-					players[i].unlaggedZ[unlaggedIndex]
-				);
+				fixed_t unlaggedX, unlaggedY, unlaggedZ;
+				unlagged_GetPlayerPosition( &players[i], lag, unlaggedX, unlaggedY, unlaggedZ );
+
+				//Nothing to do if the player didn't move since then
+				if ( ( unlaggedX == players[i].restoreX ) && ( unlaggedY == players[i].restoreY ) && ( unlaggedZ == players[i].restoreZ ) )
+					continue;
+
+				//A player the shot can't reach, neither now nor back then, can stay where he is
+				if ( traceBox && !unlagged_IsInTraceBox( *traceBox, players[i].restoreX, players[i].restoreY, players[i].mo->radius )
+					&& !unlagged_IsInTraceBox( *traceBox, unlaggedX, unlaggedY, players[i].mo->radius ) )
+					continue;
+
+				players[i].mo->SetOrigin( unlaggedX, unlaggedY, unlaggedZ );
+				rewoundPlayers[i] = true;
+				rewoundX[i] = unlaggedX;
+				rewoundY[i] = unlaggedY;
+				rewoundZ[i] = unlaggedZ;
+
+				//how much did the interpolation change compared to just taking the nearest tic?
+				const fixed_t error = P_AproxDistance( P_AproxDistance( unlaggedX - players[i].unlaggedX[unlaggedIndex],
+					unlaggedY - players[i].unlaggedY[unlaggedIndex] ), unlaggedZ - players[i].unlaggedZ[unlaggedIndex] );
+				errorStats.numRewinds++;
+				errorStats.errorSum += FIXED2FLOAT( error );
+				errorStats.errorMax = MAX( errorStats.errorMax, error );
 			}
 			else
 				//However, the client sometimes mispredicts itself if it's on a moving sector.
@@ -199,7 +404,7 @@ void UNLAGGED_Reconcile( AActor *actor )
 				//floor moved up - a client might have mispredicted himself too low due to gravity
 				//and the client thinking the floor is lower than it actually is
 				// [BB] But only do this if the sector actually moved. Note: This adjustment seems to break on some kind of non-moving 3D floors.
-				if ( (serverFloorZ > actor->floorz) && (( actor->Sector->floorplane.restoreD != actor->Sector->floorplane.d ) || ( actor->Sector->ceilingplane.restoreD != actor->Sector->ceilingplane.d )) )
+				if ( (serverFloorZ > actor->floorz) && unlagged_IsSectorRewound( actor->Sector ) )
 				{
 					//shooter was standing on the floor, let's pull him down to his floor if
 					//he wasn't falling
@@ -210,6 +415,9 @@ void UNLAGGED_Reconcile( AActor *actor )
 				}
 
 				//todo: more correction for client misprediction
+
+				//the shooter only needs to be moved back if he was forced out of the floor/ceiling
+				rewoundPlayers[i] = ( actor->z != players[i].restoreZ );
 			}
 		}
 	}	
@@ -220,11 +428,14 @@ void UNLAGGED_SwapSectorUnlaggedStatus( )
 	if ( reconciledGame == false )
 		return;
 
-	for (int i = 0; i < numsectors; ++i)
+	for (unsigned int i = 0; i < movedSectors.Size(); ++i)
 	{
-		swap ( sectors[i].floorplane.d, sectors[i].floorplane.restoreD );
-		swap ( sectors[i].ceilingplane.d, sectors[i].ceilingplane.restoreD );
+		sector_t *sector = &sectors[movedSectors[i].sectorNum];
+
+		swap ( sector->floorplane.d, sector->floorplane.restoreD );
+		swap ( sector->ceilingplane.d, sector->ceilingplane.restoreD );
 	}
+	P_InvalidateSightCache ();
 }
 
 // Restore everything that has been shifted
@@ -239,18 +450,23 @@ void UNLAGGED_Restore( AActor *actor )
 		return;
 
 	//restore the sectors
-	for (int i = 0; i < numsectors; ++i)
+	for (unsigned int i = 0; i < movedSectors.Size(); ++i)
 	{
-		sectors[i].floorplane.d = sectors[i].floorplane.restoreD;
-		sectors[i].ceilingplane.d = sectors[i].ceilingplane.restoreD;
+		sector_t *sector = &sectors[movedSectors[i].sectorNum];
+
+		sector->floorplane.d = sector->floorplane.restoreD;
+		sector->ceilingplane.d = sector->ceilingplane.restoreD;
 	}
+	P_InvalidateSightCache ();
 
 	//restore the players
 	for (int i = 0; i < MAXPLAYERS; ++i)
 	{
 		if (playeringame[i] && players[i].mo && !players[i].bSpectating)
 		{
-			players[i].mo->SetOrigin( players[i].restoreX, players[i].restoreY, players[i].restoreZ );
+			if ( rewoundPlayers[i] )
+				players[i].mo->SetOrigin( players[i].restoreX, players[i].restoreY, players[i].restoreZ );
+			rewoundPlayers[i] = false;
 			players[i].mo->floorz = players[i].restoreFloorZ;
 			players[i].mo->ceilingz = players[i].restoreCeilingZ;
 		}
@@ -303,21 +519,143 @@ void UNLAGGED_ResetPlayer( player_t *player )
 }
 
 
+// Update the smoothed ping of a player with a new measurement (in ms)
+void UNLAGGED_UpdateLatency( player_t *player, ULONG ulPing )
+{
+	// [BB] Sanity check.
+	if ( player == NULL )
+		return;
+
+	UnlaggedLatency &latency = playerLatency[player - players];
+	const int ping = static_cast<int>( MIN<ULONG>( ulPing, 60000 ) );
+
+	//take the first measurement as it is, all later ones are smoothed, so that
+	//a single lag spike only moves the estimate by an eighth
+	if ( latency.numSamples == 0 )
+	{
+		latency.smoothedPing = ping << 3;
+		latency.pingVariance = ping << 1;
+		latency.numSamples = 1;
+		return;
+	}
+
+	int delta = ping - ( latency.smoothedPing >> 3 );
+	latency.smoothedPing += delta;
+	if ( delta < 0 )
+		delta = -delta;
+	latency.pingVariance += delta - ( latency.pingVariance >> 2 );
+	latency.numSamples++;
+}
+
+// Forget the smoothed ping of a player
+// Should be called when a client connects
+void UNLAGGED_ResetLatency( player_t *player )
+{
+	// [BB] Sanity check.
+	if ( player == NULL )
+		return;
+
+	const int playerNum = static_cast<int>( player - players );
+	memset( &playerLatency[playerNum], 0, sizeof( playerLatency[playerNum] ));
+	memset( &playerErrorStats[playerNum], 0, sizeof( playerErrorStats[playerNum] ));
+}
+
+// How long (in ms) to wait for a packet sent to the player to arrive before
+// sending it again: the smoothed ping plus four times its mean deviation,
+// just like TCP's retransmission timeout.
+int UNLAGGED_GetRetransmitTimeout( const player_t *player )
+{
+	const UnlaggedLatency &latency = playerLatency[player - players];
+
+	//without any measurement, wait a quarter second
+	const int timeout = ( latency.numSamples > 0 )
+		? ( latency.smoothedPing >> 3 ) + latency.pingVariance
+		: 1000 / 4;
+
+	return clamp( timeout, 2 * 1000 / TICRATE, 1000 );
+}
+
+// Forget the recorded sector positions
+// Should be called when a new map is loaded
+void UNLAGGED_ResetSectors( )
+{
+	movedSectors.Clear();
+	sectorStates.Clear();
+}
+
 // Record the positions of the sectors
+// Only the sectors that moved within the last UNLAGGEDTICS tics are kept
 void UNLAGGED_RecordSectors( )
 {
 	//Only do anything if it's on a server
 	if (NETWORK_GetState() != NETSTATE_SERVER)
 		return;
 
+	//start without any history on a new map
+	if ( sectorStates.Size() != static_cast<unsigned int>( numsectors ) )
+	{
+		movedSectors.Clear();
+		sectorStates.Resize( numsectors );
+		for (int i = 0; i < numsectors; ++i)
+		{
+			sectorStates[i].floorD = sectors[i].floorplane.d;
+			sectorStates[i].ceilingD = sectors[i].ceilingplane.d;
+			sectorStates[i].historyIndex = -1;
+		}
+	}
+
 	//find the index
 	const int unlaggedIndex = gametic % UNLAGGEDTICS;
 
-	//record the sectors
+	//find the sectors that started moving
 	for (int i = 0; i < numsectors; ++i)
 	{
-		sectors[i].floorplane.unlaggedD[unlaggedIndex] = sectors[i].floorplane.d;
-		sectors[i].ceilingplane.unlaggedD[unlaggedIndex] = sectors[i].ceilingplane.d;
+		UnlaggedSectorState &state = sectorStates[i];
+
+		if ( ( state.floorD == sectors[i].floorplane.d ) && ( state.ceilingD == sectors[i].ceilingplane.d ) )
+			continue;
+
+		if ( state.historyIndex < 0 )
+		{
+			//the sector didn't move during the whole window until now
+			UnlaggedSectorHistory history;
+			history.sectorNum = i;
+			for (int tic = 0; tic < UNLAGGEDTICS; ++tic)
+			{
+				history.floorD[tic] = state.floorD;
+				history.ceilingD[tic] = state.ceilingD;
+			}
+			state.historyIndex = movedSectors.Push( history );
+		}
+
+		movedSectors[state.historyIndex].lastMovedTic = gametic;
+		state.floorD = sectors[i].floorplane.d;
+		state.ceilingD = sectors[i].ceilingplane.d;
+	}
+
+	//record the moving sectors
+	for (unsigned int i = 0; i < movedSectors.Size(); )
+	{
+		UnlaggedSectorHistory &history = movedSectors[i];
+
+		//a sector that didn't move during the whole window can't be reconciled anymore
+		if ( gametic - history.lastMovedTic >= UNLAGGEDTICS )
+		{
+			sectorStates[history.sectorNum].historyIndex = -1;
+
+			const unsigned int last = movedSectors.Size() - 1;
+			if ( i != last )
+			{
+				movedSectors[i] = movedSectors[last];
+				sectorStates[movedSectors[i].sectorNum].historyIndex = i;
+			}
+			movedSectors.Resize( last );
+			continue;
+		}
+
+		history.floorD[unlaggedIndex] = sectors[history.sectorNum].floorplane.d;
+		history.ceilingD[unlaggedIndex] = sectors[history.sectorNum].ceilingplane.d;
+		++i;
 	}
 }
 
@@ -346,21 +684,18 @@ void UNLAGGED_GetHitOffset ( const AActor *attacker, const FTraceResults &trace,
 	if ( ( reconciledGame == false ) || ( attacker == NULL ) )
 		return;
 
-	const int unlaggedGametic = UNLAGGED_Gametic( attacker->player );
-
-	// [BB] No reconciliation no offset.
-	if ( unlaggedGametic == gametic )
-		return;
-
 	if ( ( trace.HitType == TRACE_HitActor ) && trace.Actor && trace.Actor->player )
 	{
-		const int unlaggedIndex = unlaggedGametic % UNLAGGEDTICS;
-
 		const player_t *hitPlayer = trace.Actor->player;
+		const int hitPlayerNum = static_cast<int>( hitPlayer - players );
+
+		// A player that wasn't moved has no offset.
+		if ( rewoundPlayers[hitPlayerNum] == false )
+			return;
 
-		hitOffset[0] = hitPlayer->restoreX - hitPlayer->unlaggedX[unlaggedIndex];
-		hitOffset[1] = hitPlayer->restoreY - hitPlayer->unlaggedY[unlaggedIndex];
-		hitOffset[2] = hitPlayer->restoreZ - hitPlayer->unlaggedZ[unlaggedIndex];
+		hitOffset[0] = hitPlayer->restoreX - rewoundX[hitPlayerNum];
+		hitOffset[1] = hitPlayer->restoreY - rewoundY[hitPlayerNum];
+		hitOffset[2] = hitPlayer->restoreZ - rewoundZ[hitPlayerNum];
 	}
 }
 
@@ -405,16 +740,14 @@ void UNLAGGED_SpawnDebugActors ( )
 			if ( unlaggedGametic == gametic )
 				continue;
 
-			const int unlaggedIndex = unlaggedGametic % UNLAGGEDTICS;
+			const fixed_t lag = unlagged_GetLag( &players[ulPlayer] );
 
 			for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ++ulIdx )
 			{
 				if ( ( ulPlayer == ulIdx ) || ( PLAYER_IsValidPlayer ( ulIdx ) == false ) || players[ulIdx].bSpectating )
 					continue;
 
-				pActor->x = players[ulIdx].unlaggedX[unlaggedIndex];
-				pActor->y = players[ulIdx].unlaggedY[unlaggedIndex];
-				pActor->z = players[ulIdx].unlaggedZ[unlaggedIndex];
+				unlagged_GetPlayerPosition( &players[ulIdx], lag, pActor->x, pActor->y, pActor->z );
 
 				SERVERCOMMANDS_SpawnThingNoNetID( pActor, ulPlayer, SVCF_ONLYTHISCLIENT );
 			}
@@ -423,3 +756,115 @@ void UNLAGGED_SpawnDebugActors ( )
 		pActor->Destroy();
 	}
 }
+
+static int unlagged_CountRewoundPlayers( )
+{
+	int count = 0;
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ++ulIdx )
+	{
+		if ( rewoundPlayers[ulIdx] )
+			++count;
+	}
+	return count;
+}
+
+// Measures the cost of reconciling the game for shotgun blasts of all players,
+// once rewinding everything and once only what the pellets can reach.
+CCMD( unlaggedbench )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+	{
+		Printf( "This command can only be used by the server.\n" );
+		return;
+	}
+
+	if ( reconciledGame )
+		return;
+
+	const int iterations = ( argv.argc( ) > 1 ) ? MAX( atoi( argv[1] ), 1 ) : 1000;
+	cycle_t fullClock, traceClock;
+	int numReconciles = 0;
+	int numRewoundFull = 0;
+	int numRewoundTrace = 0;
+
+	fullClock.Reset( );
+	traceClock.Reset( );
+
+	for ( int iteration = 0; iteration < iterations; ++iteration )
+	{
+		for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ++ulIdx )
+		{
+			if ( ( PLAYER_IsValidPlayerWithMo( ulIdx ) == false ) || players[ulIdx].bSpectating )
+				continue;
+
+			AActor *mo = players[ulIdx].mo;
+
+			// Seven pellets spread around the player's angle like a shotgun blast.
+			for ( int pellet = -3; pellet <= 3; ++pellet )
+			{
+				fullClock.Clock( );
+				UNLAGGED_Reconcile( mo );
+				if ( reconciledGame )
+				{
+					++numReconciles;
+					numRewoundFull += unlagged_CountRewoundPlayers( );
+				}
+				UNLAGGED_Restore( mo );
+				fullClock.Unclock( );
+
+				traceClock.Clock( );
+				UNLAGGED_ReconcileLine( mo, mo->angle + ( pellet << 19 ), PLAYERMISSILERANGE );
+				numRewoundTrace += unlagged_CountRewoundPlayers( );
+				UNLAGGED_Restore( mo );
+				traceClock.Unclock( );
+			}
+		}
+	}
+
+	if ( numReconciles == 0 )
+	{
+		Printf( "No player could be reconciled (unlagged is off or nobody has a ping).\n" );
+		return;
+	}
+
+	Printf( "%d reconciles, %u of %d sectors moved recently.\n", numReconciles, movedSectors.Size( ), numsectors );
+	Printf( "Whole map: %.3f us per reconcile, %.2f players moved\n", fullClock.TimeMS( ) * 1000 / numReconciles, static_cast<double>( numRewoundFull ) / numReconciles );
+	Printf( "Shot line: %.3f us per reconcile, %.2f players moved\n", traceClock.TimeMS( ) * 1000 / numReconciles, static_cast<double>( numRewoundTrace ) / numReconciles );
+}
+
+// Shows the latency the server reconciles each client with and how far the
+// interpolated positions were from the nearest recorded tic.
+CCMD( unlaggedstats )
+{
+	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
+	{
+		Printf( "This command can only be used by the server.\n" );
+		return;
+	}
+
+	if ( ( argv.argc( ) > 1 ) && ( stricmp( argv[1], "reset" ) == 0 ) )
+	{
+		memset( playerErrorStats, 0, sizeof( playerErrorStats ));
+		return;
+	}
+
+	for ( ULONG ulIdx = 0; ulIdx < MAXPLAYERS; ++ulIdx )
+	{
+		if ( SERVER_IsValidClient( ulIdx ) == false )
+			continue;
+
+		const UnlaggedLatency &latency = playerLatency[ulIdx];
+		const UnlaggedErrorStats &errorStats = playerErrorStats[ulIdx];
+
+		Printf( "%s: ping %lu ms, smoothed %.2f ms (+/- %.2f ms, %.2f tics)\n", players[ulIdx].userinfo.netname, players[ulIdx].ulPing,
+			latency.smoothedPing / 8.0, latency.pingVariance / 4.0, FIXED2FLOAT( unlagged_GetLag( &players[ulIdx] )));
+
+		if ( errorStats.numRewinds > 0 )
+		{
+			Printf( "  %d reconciles, %d players moved, interpolation offset avg %.2f max %.2f units\n", errorStats.numReconciles,
+				errorStats.numRewinds, errorStats.errorSum / errorStats.numRewinds, FIXED2FLOAT( errorStats.errorMax ));
+		}
+		else
+			Printf( "  %d reconciles, no players moved\n", errorStats.numReconciles );
+	}
+}
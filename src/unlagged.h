@@ -58,10 +58,16 @@
 void	UNLAGGED_Tick( void );
 int		UNLAGGED_Gametic( player_t *player );
 void	UNLAGGED_Reconcile( AActor *actor );
+void	UNLAGGED_ReconcileRange( AActor *actor, fixed_t distance );
+void	UNLAGGED_ReconcileLine( AActor *actor, angle_t angle, fixed_t distance, fixed_t margin = 0 );
 void	UNLAGGED_SwapSectorUnlaggedStatus( );
 void	UNLAGGED_Restore( AActor *actor );
 void	UNLAGGED_RecordPlayer( player_t *player );
 void	UNLAGGED_ResetPlayer( player_t *player );
+void	UNLAGGED_UpdateLatency( player_t *player, ULONG ulPing );
+void	UNLAGGED_ResetLatency( player_t *player );
+int		UNLAGGED_GetRetransmitTimeout( const player_t *player );
+void	UNLAGGED_ResetSectors( );
 void	UNLAGGED_RecordSectors( );
 bool	UNLAGGED_DrawRailClientside ( AActor *attacker );
 void	UNLAGGED_GetHitOffset ( const AActor *attacker, const FTraceResults &trace, TVector3<fixed_t> &hitOffset );
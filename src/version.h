@@ -50,7 +50,7 @@ const char *GetVersionString();
 #define ZDVER_STRING "2.3.1"
 #define ZD_SVN_REVISION_STRING "1551"
 #define ZD_SVN_REVISION_NUMBER 1551
-#define NET_REVISION_NUMBER 3500 // for NETGAMEVERSION
+#define NET_REVISION_NUMBER 3501 // for NETGAMEVERSION
 
 // [BC] What version of ZDoom is this based off of?
 #define	ZDOOMVERSIONSTR		ZDVER_STRING"-"ZD_SVN_REVISION_STRING
@@ -0,0 +1,190 @@
+/*
+** huffbench.cpp
+**
+** Usage: huffbench [-n <iterations>] [corpus file] ...
+**
+** Compares the lookup table based Huffman encoder / decoder of HuffmanCodec
+** with the original bit by bit implementation (encodeWithTree / decodeWithTree)
+** and verifies that both produce identical output.
+**
+** A corpus file contains captured, not yet encoded packets. Each packet is
+** stored as a 16 bit little endian length followed by the packet data. If no
+** corpus is given, a synthetic one is generated.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "huffman.h"
+
+using namespace skulltag;
+
+// Largest packet the engine sends (MAX_UDP_PACKET in networkshared.h).
+#define MAX_PACKET		8192
+
+struct Packet
+{
+	std::vector<unsigned char> data;
+	std::vector<unsigned char> encoded;
+};
+
+static bool LoadCorpus( const char *filename, std::vector<Packet> &packets )
+{
+	FILE *f = fopen( filename, "rb" );
+	if ( f == NULL )
+	{
+		fprintf( stderr, "Can't open %s\n", filename );
+		return false;
+	}
+
+	unsigned char header[2];
+	while ( fread( header, 1, 2, f ) == 2 )
+	{
+		Packet packet;
+		size_t len = header[0] | ( header[1] << 8 );
+		if ( len > MAX_PACKET )
+		{
+			fprintf( stderr, "%s: packet of %u bytes is too large\n", filename, (unsigned)len );
+			fclose( f );
+			return false;
+		}
+		packet.data.resize( len );
+		if ( len > 0 && fread( &packet.data[0], 1, len, f ) != len )
+		{
+			fprintf( stderr, "%s: truncated packet\n", filename );
+			fclose( f );
+			return false;
+		}
+		packets.push_back( packet );
+	}
+	fclose( f );
+	return true;
+}
+
+// Small packets dominated by a few command bytes and mostly zero bytes of
+// coordinates, with the occasional large packet of random data.
+static void MakeSyntheticCorpus( std::vector<Packet> &packets )
+{
+	srand( 1 );
+	for ( int i = 0; i < 4096; i++ )
+	{
+		Packet packet;
+		size_t len = ( i % 64 == 0 ) ? 512 + rand() % 1024 : 8 + rand() % 120;
+		packet.data.resize( len );
+		for ( size_t j = 0; j < len; j++ )
+		{
+			switch ( rand() % 4 )
+			{
+			case 0:  packet.data[j] = rand() % 256; break;
+			case 1:  packet.data[j] = rand() % 16; break;
+			default: packet.data[j] = 0; break;
+			}
+		}
+		packets.push_back( packet );
+	}
+}
+
+static double Seconds( clock_t start )
+{
+	return double( clock() - start ) / CLOCKS_PER_SEC;
+}
+
+int main( int argc, char **argv )
+{
+	std::vector<Packet> packets;
+	int iterations = 200;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[i], "-n" ) == 0 && i + 1 < argc )
+			iterations = atoi( argv[++i] );
+		else if ( !LoadCorpus( argv[i], packets ) )
+			return 1;
+	}
+	if ( packets.empty() )
+		MakeSyntheticCorpus( packets );
+
+	HUFFMAN_Construct();
+	HuffmanCodec *codec = HUFFMAN_GetCodec();
+
+	unsigned char encodedTable[MAX_PACKET + 1], encodedTree[MAX_PACKET + 1];
+	unsigned char decodedTable[( MAX_PACKET * 8 ) / 3 + 1], decodedTree[( MAX_PACKET * 8 ) / 3 + 1];
+	double totalBytes = 0, totalEncoded = 0;
+
+	// Check that both implementations agree and keep the encoded packets for the decode runs.
+	for ( size_t i = 0; i < packets.size(); i++ )
+	{
+		const int len = int( packets[i].data.size() );
+		const unsigned char *data = len ? &packets[i].data[0] : encodedTable;
+		int outTable = codec->encode( data, encodedTable, len, sizeof( encodedTable ));
+		int outTree = codec->encodeWithTree( data, encodedTree, len, sizeof( encodedTree ));
+		if ( outTable != outTree || ( outTable > 0 && memcmp( encodedTable, encodedTree, outTable ) != 0 ))
+		{
+			fprintf( stderr, "Encoder mismatch on packet %u\n", (unsigned)i );
+			return 1;
+		}
+
+		// Packets that don't compress are sent unencoded, just like HUFFMAN_Encode does.
+		if ( outTable < 0 )
+			continue;
+
+		packets[i].encoded.assign( encodedTable, encodedTable + outTable );
+		int inTable = codec->decode( encodedTable, decodedTable, outTable, sizeof( decodedTable ));
+		int inTree = codec->decodeWithTree( encodedTable, decodedTree, outTable, sizeof( decodedTree ));
+		if ( inTable != len || inTree != len || memcmp( decodedTable, data, len ) != 0 || memcmp( decodedTree, data, len ) != 0 )
+		{
+			fprintf( stderr, "Decoder mismatch on packet %u\n", (unsigned)i );
+			return 1;
+		}
+
+		totalBytes += len;
+		totalEncoded += outTable;
+	}
+
+	printf( "%u packets, %.0f bytes, compressed to %.1f%%\n", (unsigned)packets.size(), totalBytes, totalBytes > 0 ? 100.0 * totalEncoded / totalBytes : 0.0 );
+
+	for ( int pass = 0; pass < 2; pass++ )
+	{
+		const bool useTable = ( pass == 0 );
+		clock_t start = clock();
+		for ( int it = 0; it < iterations; it++ )
+		{
+			for ( size_t i = 0; i < packets.size(); i++ )
+			{
+				if ( packets[i].encoded.empty() )
+					continue;
+				const int len = int( packets[i].data.size() );
+				if ( useTable )
+					codec->encode( &packets[i].data[0], encodedTable, len, sizeof( encodedTable ));
+				else
+					codec->encodeWithTree( &packets[i].data[0], encodedTree, len, sizeof( encodedTree ));
+			}
+		}
+		double encodeTime = Seconds( start );
+
+		start = clock();
+		for ( int it = 0; it < iterations; it++ )
+		{
+			for ( size_t i = 0; i < packets.size(); i++ )
+			{
+				if ( packets[i].encoded.empty() )
+					continue;
+				const int len = int( packets[i].encoded.size() );
+				if ( useTable )
+					codec->decode( &packets[i].encoded[0], decodedTable, len, sizeof( decodedTable ));
+				else
+					codec->decodeWithTree( &packets[i].encoded[0], decodedTree, len, sizeof( decodedTree ));
+			}
+		}
+		double decodeTime = Seconds( start );
+
+		const double megabytes = totalBytes * iterations / ( 1024.0 * 1024.0 );
+		printf( "%-6s encode: %8.1f MB/s   decode: %8.1f MB/s\n", useTable ? "table" : "tree",
+			encodeTime > 0 ? megabytes / encodeTime : 0.0, decodeTime > 0 ? megabytes / decodeTime : 0.0 );
+	}
+
+	return 0;
+}
@@ -0,0 +1,12 @@
+// Minimal replacements for the engine functions huffman.cpp uses, so that it can
+// be built outside of the engine (see masterserver/i_system.h).
+
+#ifndef __I_SYSTEM__
+#define __I_SYSTEM__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define atterm atexit
+
+#endif